@@ -105,7 +105,7 @@ typedef void (*AdpDataConfirm)(struct TAdpDataConfirm *pDataConfirm);
 /** The AdpDataIndication primitive is used to transfer received data from the adaptation sublayer to the upper layer.
  ***********************************************************************************************************************
  * @param m_u16NsduLength The size of the NSDU, in bytes; Up to 1280 bytes
- * @param m_pNsdu The received NSDU
+ * @param m_pNsdu The received NSDU. Valid until the callback returns, unless it is kept with usi_RxFrameRetain()
  * @param m_u8LinkQualityIndicator The value of the link quality during reception of the frame.
  **********************************************************************************************************************/
 struct TAdpDataIndication {
@@ -260,6 +260,22 @@ void AdpGetRequest(uint32_t u32AttributeId, uint16_t u16AttributeIndex);
 
 /**********************************************************************************************************************/
 
+/** Attribute of a multiple request (AdpGetRequestMulti, AdpSetRequestMulti...).
+ ***********************************************************************************************************************
+ * @param m_u32AttributeId The identifier of the IB attribute.
+ * @param m_u16AttributeIndex The index within the table of the specified IB attribute.
+ * @param m_u8AttributeLength The length of the value of the attribute to set (set requests only).
+ * @param m_pu8AttributeValue The value of the attribute to set (set requests only).
+ **********************************************************************************************************************/
+struct TAdpPibRequest {
+	uint32_t m_u32AttributeId;
+	uint16_t m_u16AttributeIndex;
+	uint8_t m_u8AttributeLength;
+	const uint8_t *m_pu8AttributeValue;
+};
+
+/**********************************************************************************************************************/
+
 /** The AdpGetConfirm primitive allows the upper layer to be notified of the completion of an AdpGetRequest.
  ***********************************************************************************************************************
  * @param m_u8Status The status of the request.
@@ -294,6 +310,18 @@ void AdpGetRequestSync(uint32_t u32AttributeId, uint16_t u16AttributeIndex,
 
 /**********************************************************************************************************************/
 
+/** The AdpGetRequestMulti primitive allows the upper layer to get several attributes from the ADP information base
+ * synchronously. Requests are sent back-to-back, without waiting for the confirm of the previous one.
+ ***********************************************************************************************************************
+ * @param pRequests The ADP IB attributes to get.
+ * @param u16Count Number of attributes.
+ * @param pGetConfirms Get results, one per attribute.
+ **********************************************************************************************************************/
+void AdpGetRequestMulti(const struct TAdpPibRequest *pRequests, uint16_t u16Count,
+		struct TAdpGetConfirm *pGetConfirms);
+
+/**********************************************************************************************************************/
+
 /** The AdpMacGetRequest primitive allows the upper layer to get the value of an attribute from the MAC information base.
  * The upper layer cannot access directly the MAC layer while ADP is running
  ***********************************************************************************************************************
@@ -338,6 +366,18 @@ void AdpMacGetRequestSync(uint32_t u32AttributeId, uint16_t u16AttributeIndex,
 
 /**********************************************************************************************************************/
 
+/** The AdpMacGetRequestMulti primitive allows the upper layer to get several attributes from the MAC information base
+ * synchronously. Requests are sent back-to-back, without waiting for the confirm of the previous one.
+ ***********************************************************************************************************************
+ * @param pRequests The MAC IB attributes to get.
+ * @param u16Count Number of attributes.
+ * @param pGetConfirms Get results, one per attribute.
+ **********************************************************************************************************************/
+void AdpMacGetRequestMulti(const struct TAdpPibRequest *pRequests, uint16_t u16Count,
+		struct TAdpMacGetConfirm *pGetConfirms);
+
+/**********************************************************************************************************************/
+
 /** The AdpSetRequest primitive allows the upper layer to set the value of an attribute in the ADP information base.
  ***********************************************************************************************************************
  * @param u32AttributeId The identifier of the ADP IB attribute set
@@ -380,6 +420,18 @@ void AdpSetRequestSync(uint32_t u32AttributeId, uint16_t u16AttributeIndex,
 
 /**********************************************************************************************************************/
 
+/** The AdpSetRequestMulti primitive allows the upper layer to set several attributes in the ADP information base
+ * synchronously. Requests are sent back-to-back, without waiting for the confirm of the previous one.
+ ***********************************************************************************************************************
+ * @param pRequests The ADP IB attributes to set.
+ * @param u16Count Number of attributes.
+ * @param pSetConfirms Set results, one per attribute.
+ **********************************************************************************************************************/
+void AdpSetRequestMulti(const struct TAdpPibRequest *pRequests, uint16_t u16Count,
+		struct TAdpSetConfirm *pSetConfirms);
+
+/**********************************************************************************************************************/
+
 /** The AdpMacSetRequest primitive allows the upper layer to set the value of an attribute in the MAC information base.
 * The upper layer cannot access directly the MAC layer while ADP is running
 ***********************************************************************************************************************
@@ -423,6 +475,32 @@ void AdpMacSetRequestSync(uint32_t u32AttributeId, uint16_t u16AttributeIndex,
 
 /**********************************************************************************************************************/
 
+/** The AdpMacSetRequestMulti primitive allows the upper layer to set several attributes in the MAC information base
+ * synchronously. Requests are sent back-to-back, without waiting for the confirm of the previous one.
+ ***********************************************************************************************************************
+ * @param pRequests The MAC IB attributes to set.
+ * @param u16Count Number of attributes.
+ * @param pSetConfirms Set results, one per attribute.
+ **********************************************************************************************************************/
+void AdpMacSetRequestMulti(const struct TAdpPibRequest *pRequests, uint16_t u16Count,
+		struct TAdpMacSetConfirm *pSetConfirms);
+
+/**********************************************************************************************************************/
+
+/** The AdpMibSetRequestMulti primitive allows the upper layer to set several attributes of the ADP and MAC information
+ * bases synchronously, in a single pipeline. Requests are sent back-to-back in the given order, without waiting for the
+ * confirm of the previous one, also when the layer changes.
+ ***********************************************************************************************************************
+ * @param pRequests The IB attributes to set.
+ * @param pbMac For each attribute, true if it belongs to the MAC information base.
+ * @param u16Count Number of attributes.
+ * @param pSetConfirms Set results, one per attribute (TAdpMacSetConfirm has the same layout).
+ **********************************************************************************************************************/
+void AdpMibSetRequestMulti(const struct TAdpPibRequest *pRequests, const bool *pbMac, uint16_t u16Count,
+		struct TAdpSetConfirm *pSetConfirms);
+
+/**********************************************************************************************************************/
+
 /** The AdpNetworkStatusIndication primitive allows the next higher layer of a PAN coordinator or a coordinator to be
  * notified when a particular event occurs on the PAN.
  ***********************************************************************************************************************
@@ -52,7 +52,7 @@ extern "C" {
 //#define USE_PROTOCOL_SNIF_PRIME_PORT        0
 //#define USE_PROTOCOL_PRIME_API              0
 
-#define USE_PROTOCOL_ADP_G3_PORT                       1
+#define USE_PROTOCOL_ADP_G3_PORT                       0
 //#define USE_PROTOCOL_COORD_G3_PORT                      0
 
 #ifdef __cplusplus
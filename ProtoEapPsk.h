@@ -48,6 +48,9 @@
 #define __EAP_PSK_H__
 
 #include <stdint.h>
+#include <stdbool.h>
+#include <crypto/eax.h>
+#include <crypto/cipher_wrapper.h>
 
 /* todo: remove code needed by LBS (ifdef?) */
 
@@ -173,6 +176,10 @@ struct TEapPskContext {
 	struct TEapPskNetworkAccessIdentifier m_IdS;
 	struct TEapPskRand m_RandP;
 	struct TEapPskRand m_RandS;
+	/* Crypto contexts of the session, keyed once when AK and TEK are derived */
+	cipher_wrapper_aes_cmac_context m_AkCmac;
+	eax_ctx m_TekEax[1];
+	bool m_bTekKeyed;
 };
 
 /**********************************************************************************************************************/
@@ -241,7 +248,7 @@ bool EAP_PSK_Decode_Message1(uint16_t u16MessageLength, uint8_t *pMessage, struc
  *                              allocated; requested size being at least 62 bytes
  * @return encoded length or 0 if encoding failed
  **********************************************************************************************************************/
-uint16_t EAP_PSK_Encode_Message2(const struct TEapPskContext *pPskContext, uint8_t u8Identifier,
+uint16_t EAP_PSK_Encode_Message2(struct TEapPskContext *pPskContext, uint8_t u8Identifier,
 		const struct TEapPskRand *pRandS, const struct TEapPskRand *pRandP, const struct TEapPskNetworkAccessIdentifier *pIdS,
 		const struct TEapPskNetworkAccessIdentifier *pIdP, uint16_t u16MemoryBufferLength, uint8_t *pMemoryBuffer);
 
@@ -263,7 +270,7 @@ uint16_t EAP_PSK_Encode_Message2(const struct TEapPskContext *pPskContext, uint8
  * @param au8PrecGMK OUT parameter; upon successful return contains the 16 byte value of the preceding GMK
  * @return true if the message can be decoded; false otherwise
  **********************************************************************************************************************/
-bool EAP_PSK_Decode_Message3(uint16_t u16MessageLength, uint8_t *pMessage, const struct TEapPskContext *pPskContext,
+bool EAP_PSK_Decode_Message3(uint16_t u16MessageLength, uint8_t *pMessage, struct TEapPskContext *pPskContext,
 		uint16_t u16HeaderLength, uint8_t *pHeader, struct TEapPskRand *pRandS, uint32_t *pu32Nonce,
 		uint8_t *pu8PChannelResult, uint16_t *pu16PChannelDataLength, uint8_t **pPChannelData);
 
@@ -281,7 +288,7 @@ bool EAP_PSK_Decode_Message3(uint16_t u16MessageLength, uint8_t *pMessage, const
  *                              allocated; requested size being at least 62 bytes
  * @return encoded length or 0 if encoding failed
  **********************************************************************************************************************/
-uint16_t EAP_PSK_Encode_Message4(const struct TEapPskContext *pPskContext, uint8_t u8Identifier,
+uint16_t EAP_PSK_Encode_Message4(struct TEapPskContext *pPskContext, uint8_t u8Identifier,
 		const struct TEapPskRand *pRandS, uint32_t u32Nonce, uint8_t u8PChannelResult, uint16_t u16PChannelDataLength,
 		uint8_t *pPChannelData, uint16_t u16MemoryBufferLength, uint8_t *pMemoryBuffer);
 
@@ -326,7 +333,7 @@ bool EAP_PSK_Decode_Message2(
 		uint8_t u8BandId,
 		uint16_t u16MessageLength,
 		uint8_t *pMessage,
-		const struct TEapPskContext *pPskContext,
+		struct TEapPskContext *pPskContext,
 		const struct TEapPskNetworkAccessIdentifierS *pIdS,
 		struct TEapPskRand *pRandS, /* out */
 		struct TEapPskRand *pRandP /* out */
@@ -368,7 +375,7 @@ bool EAP_PSK_Decode_Message2(
  *
  **********************************************************************************************************************/
 uint16_t EAP_PSK_Encode_Message3(
-		const struct TEapPskContext *pPskContext,
+		struct TEapPskContext *pPskContext,
 		uint8_t u8Identifier,
 		const struct TEapPskRand *pRandS,
 		const struct TEapPskRand *pRandP,
@@ -393,7 +400,7 @@ uint16_t EAP_PSK_Encode_Message3(
 bool EAP_PSK_Decode_Message4(
 		uint16_t u16MessageLength,
 		uint8_t *pMessage,
-		const struct TEapPskContext *pPskContext,
+		struct TEapPskContext *pPskContext,
 		uint16_t u16HeaderLength,
 		uint8_t *pHeader,
 		struct TEapPskRand *pRandS,
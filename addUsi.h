@@ -73,6 +73,12 @@ extern "C" {
 #define KC51_CODE const
 #define KC51_REENT
 
+/* Storage of the USI state. Applications running several USI instances in one
+ * process, one per thread, define it as __thread */
+#ifndef PAN_LOCAL
+#define PAN_LOCAL
+#endif
+
 /* --- Types */
 typedef int8_t Int8;
 typedef uint8_t Uint8;
@@ -92,6 +98,16 @@ void addUsi_Process(void);
 
 void addUsi_WaitProcessing(uint8_t seconds, Bool *flag);
 
+void addUsi_WaitProcessingMs(uint32_t ms, Bool *flag);
+
+void addUsi_SignalProcessing(Bool *flag);
+
+int addUsi_GetEventFd(void);
+
+void addUsi_RunLoop(void);
+
+void addUsi_Wakeup(void);
+
 void addUsi_ConfigurePort(uint8_t logPort, uint8_t port_type, uint8_t chn, uint32_t speed);
 
 #ifdef __cplusplus
@@ -72,7 +72,9 @@ enum lbp_ib_attribute {
 	LBP_IB_GMK                         = 0x00000005,
 	LBP_IB_REKEY_GMK                   = 0x00000006,
 	LBP_IB_SHORT_ADDRESS_FROM_EXTENDED = 0x00000007,
-	LBP_IB_MSG_TIMEOUT                 = 0x00000008
+	LBP_IB_MSG_TIMEOUT                 = 0x00000008,
+	LBP_IB_REKEY_MAX_PARALLEL          = 0x00000009,
+	LBP_IB_REKEY_STATUS                = 0x0000000A
 };
 
 /* LBP status */
@@ -85,6 +87,25 @@ enum lbp_status {
 	LBP_STATUS_INVALID_VALUE
 };
 
+/* Rekeying campaign progress. Counters refer to the current phase: */
+/* GMK activation is safe once distribution has no pending devices. */
+struct t_bs_rekey_status {
+	bool b_running;
+	uint8_t uc_phase;    /* 0: GMK distribution, 1: GMK activation */
+	uint16_t us_total;
+	uint16_t us_done;
+	uint16_t us_pending;
+	uint16_t us_failed;
+};
+
+/* Bootstrap state items reported to the application (e.g. for persistent storage) */
+enum bs_state_item {
+	BS_STATE_ITEM_LBD = 0,                  /* Index: position in LBDs list */
+	BS_STATE_ITEM_BLACKLIST = 1,            /* Index: position in blacklist */
+	BS_STATE_ITEM_KEYS = 2,                 /* GMK or active key index */
+	BS_STATE_ITEM_INITIAL_SHORT_ADDRESS = 3
+};
+
 typedef struct {
 	AdpLbpConfirm fnctAdpLbpConfirm;
 	AdpLbpIndication fnctAdpLbpIndication;
@@ -99,6 +120,8 @@ typedef struct {
 typedef void (*pf_app_leave_ind_cb_t)(uint16_t u16SrcAddr, bool bSecurityEnabled, uint8_t u8LinkQualityIndicator, uint8_t *pNsdu, uint16_t u16NsduLength);
 /* User-defined callback for ADPM-NETWORK-JOIN indication */
 typedef void (*pf_app_join_ind_cb_t)(uint8_t *puc_extended_address, uint16_t us_short_address);
+/* User-defined callback for bootstrap state changes */
+typedef void (*pf_app_state_ind_cb_t)(enum bs_state_item e_item, uint16_t us_index);
 
 /* Bootstrap module initialization */
 void bs_init(TBootstrapConfiguration s_bs_conf);
@@ -110,7 +133,10 @@ TBootstrapAdpNotifications *bs_get_not_handlers(void);
 
 /* LBP control functions */
 void bs_lbp_launch_rekeying(void);
+void bs_lbp_get_rekey_status(struct t_bs_rekey_status *p_status);
 void bs_lbp_kick_device(uint16_t us_short_address);
+/* LBP messages are paced with ADP buffers state (AdpBufferIndication) */
+void bs_lbp_set_tx_ready(bool b_ready);
 
 /* LBP parameters external access */
 uint16_t bs_lbp_get_lbds_counter(void);
@@ -122,7 +148,20 @@ void bs_lbp_set_param(uint32_t ul_attribute_id, uint16_t us_attribute_idx, uint8
 bool bs_get_ext_addr_by_short(uint16_t us_short_address, uint8_t *puc_extended_address);
 bool bs_get_short_addr_by_ext(uint8_t *puc_extended_address, uint16_t *pus_short_address);
 
+/* Bootstrap state access, used to save and restore it across restarts */
+bool bs_get_lbd_entry(uint16_t us_index, uint8_t *puc_extended_address, uint8_t *puc_lbp_hops);
+bool bs_restore_lbd_entry(uint16_t us_index, const uint8_t *puc_extended_address, uint8_t uc_lbp_hops);
+uint16_t bs_get_blacklist(uint8_t (*puc_blacklist)[ADP_ADDRESS_64BITS], uint16_t us_max_entries);
+void bs_get_keys(uint8_t *puc_gmk, uint8_t *puc_key_index);
+void bs_restore_keys(const uint8_t *puc_gmk, uint8_t uc_key_index);
+
 void bs_lbp_leave_ind_set_cb(pf_app_leave_ind_cb_t pf_handler);
 void bs_lbp_join_ind_set_cb(pf_app_join_ind_cb_t pf_handler);
+void bs_lbp_state_ind_set_cb(pf_app_state_ind_cb_t pf_handler);
+
+/* Bootstrap state lock, taken by the functions above. Callbacks run with it taken,
+ * so it goes before any application lock */
+void bs_lock(void);
+void bs_unlock(void);
 
 #endif /* BS_API_H */
@@ -58,6 +58,7 @@
 #include <unistd.h>
 
 #include "addUsi.h"
+#include "Usi.h"
 #include "userFnc.h"
 
 #include "usi_cli.h"
@@ -104,6 +105,19 @@ static void catch_function(int signal)
 
 #endif
 
+/* Set by SIGUSR1, USI statistics are dumped from main loop */
+static volatile sig_atomic_t sb_dump_usi_stats;
+
+static void catch_usr1(int signal)
+{
+	sb_dump_usi_stats = 1;
+}
+
+static void print_usi_stats(void *ctx, const char *line)
+{
+	fprintf((FILE *)ctx, "%s\r\n", line);
+}
+
 int open_server(int _i_port)
 {
 	int i_listen_sd;
@@ -179,6 +193,12 @@ int main(int argc, char **argv)
 	}
 #endif
 
+	/* killall -USR1 g3proxy.exe dumps USI link statistics */
+	if (signal(SIGUSR1, catch_usr1) == SIG_ERR) {
+		PRINTF(PRINT_ERROR, "An error occurred while setting a signal handler.\n");
+		return EXIT_FAILURE;
+	}
+
 	if (argc >= 3) {
 		if (strlen(argv[1]) <= 3) {
 			/* Only port number, add linux TTY */
@@ -238,6 +258,11 @@ int main(int argc, char **argv)
 	while (1) {
 		int i_sel_ret;
 
+		if (sb_dump_usi_stats) {
+			sb_dump_usi_stats = 0;
+			usi_DumpStats(print_usi_stats, stderr);
+		}
+
 		memcpy(&g_working_set, &g_master_set, sizeof(g_master_set));
 
 		timeout.tv_sec  = 0;
@@ -246,7 +271,10 @@ int main(int argc, char **argv)
 		/* Wait on file descriptors for data available */
 		i_sel_ret = select(g_max_fd + 1, &g_working_set, NULL, NULL, &timeout);
 
-		if (i_sel_ret < 0) {
+		if ((i_sel_ret < 0) && (errno == EINTR)) {
+			/* Interrupted by a signal */
+			continue;
+		} else if (i_sel_ret < 0) {
 			PRINTF(PRINT_ERROR, "Error. Select failed\n");
 			/* Force close TCP connection */
 			if (g_concentrator_fd != 0) {
@@ -41,6 +41,7 @@
 #include <unistd.h>
 #include <string.h>
 
+#include <sys/uio.h>
 #include <termios.h> /* POSIX terminal control definitions */
 
 #include <netinet/in.h>
@@ -156,6 +157,31 @@ uint16_t addUsi_TxMsg(uint8_t port_type, uint8_t port, uint8_t *sz_msg, uint16_t
 	}
 }
 
+/**@brief Transmit several buffers through the interface in one call
+  @param port: port number configured in PrjCfg.h
+  @param iov: buffers to send, in order
+  @param iovcnt: number of buffers
+  @return the number of bytes written.
+*/
+uint16_t addUsi_TxMsgV(uint8_t port_type, uint8_t port, const struct iovec *iov, uint8_t iovcnt)
+{
+	struct msghdr x_msg;
+	ssize_t ret;
+
+	if (is_serial) {
+		/* write all buffers to tty */
+		ret = writev(g_usi_fd, iov, iovcnt);
+	} else {
+		/* write all buffers to socket */
+		memset(&x_msg, 0, sizeof(x_msg));
+		x_msg.msg_iov = (struct iovec *)iov;
+		x_msg.msg_iovlen = iovcnt;
+		ret = sendmsg(g_usi_fd, &x_msg, 0);
+	}
+
+	return (ret > 0) ? ret : 0;
+}
+
 /**@brief Read char from port
   @param port: port number configured in PrjCfg.h
   @param c: pointer to a character
@@ -182,6 +208,31 @@ int8_t addUsi_RxChar(uint8_t port_type, uint8_t port, uint8_t *c)
 	return -1;
 }
 
+/**@brief Read a block of chars from port
+  @param port: port number configured in PrjCfg.h
+  @param buf: buffer to store the chars
+  @param maxlen: buffer length
+  @return the number of chars read, 0 if there is nothing to read.
+*/
+uint16_t addUsi_RxBlock(uint8_t port_type, uint8_t port, uint8_t *buf, uint16_t maxlen)
+{
+	int i_recv;
+
+	if (is_serial) {
+		/* read all available bytes from tty */
+		i_recv = read(g_usi_fd, buf, maxlen);
+	} else {
+		/* read all available bytes from socket, without blocking */
+		i_recv = recv(g_usi_fd, buf, maxlen, MSG_DONTWAIT);
+	}
+
+	if (i_recv > 0) {
+		return i_recv;
+	}
+
+	return 0;
+}
+
 /*
  * @brief	Open TTY serial.
  * @param	_sz_port	tty to connect to.
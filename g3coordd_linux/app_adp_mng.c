@@ -50,7 +50,12 @@ extern "C" {
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <pthread.h>
+#include <stddef.h>
 #include <arpa/inet.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 #include "AdpApi.h"
 #include "AdpApiTypes.h"
@@ -69,12 +74,83 @@ extern "C" {
 #include "conf_bs.h"
 #include "oss_if.h"
 #include "bs_api.h"
+#include "../src/Usi.h"
 
-static uint8_t s_uc_G3_NET_PREFIX_LEN = 64;
-static uint8_t s_puc_G3_NET_IPV6[16] = {0xFD, 0x00, 0x00, 0x00, 0x00, 0x02, 0x78, 0x1D, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+static PAN_LOCAL uint8_t s_uc_G3_NET_PREFIX_LEN = 64;
+static PAN_LOCAL uint8_t s_puc_G3_NET_IPV6[16] = {0xFD, 0x00, 0x00, 0x00, 0x00, 0x02, 0x78, 0x1D, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
 
-static bool s_b_write_available = 1;
-static uint16_t s_us_panid;
+static PAN_LOCAL bool s_b_write_available = 1;
+static PAN_LOCAL uint16_t s_us_panid;
+/* Network prefix, set in the modem with the rest of the initialization plan */
+static PAN_LOCAL struct ipv6_prefix s_x_net_prefix;
+
+/* Downstream forwarding. Packets read from TUN are queued per destination and
+ * sent with up to ADP_TX_WINDOW AdpDataRequest waiting for confirm, at most
+ * ADP_TX_DEST_IN_FLIGHT per destination, so a slow node does not stall the rest */
+#define ADP_TX_NONE 0xFF
+
+typedef struct x_adp_tx_pkt {
+	uint16_t us_length;
+	bool b_set_dest;          /* Set ULA destination short address before request */
+	uint8_t uc_next;
+	uint8_t puc_data[G3_ADP_MAX_DATA_LENTHG];
+} x_adp_tx_pkt_t;
+
+typedef struct x_adp_tx_dest {
+	uint16_t us_short_addr;
+	uint8_t uc_head;
+	uint8_t uc_tail;
+	uint8_t uc_count;
+	uint8_t uc_in_flight;
+} x_adp_tx_dest_t;
+
+typedef struct x_adp_tx_slot {
+	bool b_used;
+	uint8_t uc_nsdu_handle;
+	uint8_t uc_dest;
+	uint32_t ui_start_ms;
+} x_adp_tx_slot_t;
+
+static PAN_LOCAL x_adp_tx_pkt_t s_x_tx_pool[ADP_TX_POOL_SIZE];
+static PAN_LOCAL x_adp_tx_dest_t s_x_tx_dest[ADP_TX_MAX_DESTS];
+static PAN_LOCAL x_adp_tx_slot_t s_x_tx_window[ADP_TX_WINDOW];
+static PAN_LOCAL uint8_t s_uc_tx_free = ADP_TX_NONE;
+static PAN_LOCAL uint8_t s_uc_tx_free_count;
+static PAN_LOCAL uint8_t s_uc_tx_in_flight;
+static PAN_LOCAL uint8_t s_uc_tx_next_dest;
+static PAN_LOCAL uint8_t s_uc_nsdu_handle;
+/* Handles of timed out requests, and when they can be used again */
+static PAN_LOCAL bool s_ab_handle_quarantine[256];
+static PAN_LOCAL uint32_t s_aui_handle_quarantine_end_ms[256];
+/* Confirms arrive in USI callbacks, requests are sent from the PAN loop */
+static PAN_LOCAL pthread_mutex_t s_tx_mutex = PTHREAD_MUTEX_INITIALIZER;
+/* Wakes up PAN loop when a request can be sent: buffers ready or window slot released */
+static PAN_LOCAL int s_i_tx_event_fd = -1;
+
+#ifdef ADP_FLOW_STATUS_SOCKET
+/* Processes notified of ADP buffers state changes */
+static PAN_LOCAL int s_i_flow_fd = -1;
+static PAN_LOCAL struct sockaddr_un s_x_flow_subs[ADP_FLOW_MAX_SUBSCRIBERS];
+static PAN_LOCAL socklen_t s_ax_flow_subs_len[ADP_FLOW_MAX_SUBSCRIBERS];
+static PAN_LOCAL uint8_t s_uc_flow_subs;
+static PAN_LOCAL pthread_mutex_t s_flow_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/* Upstream NSDUs waiting for room in the TUN queue, in reception order. They are */
+/* not copied: their USI frames are retained until written */
+typedef struct {
+	const uint8_t *puc_nsdu;
+	uint16_t us_length;
+} x_adp_rx_nsdu_t;
+
+static PAN_LOCAL x_adp_rx_nsdu_t s_x_rx_pending[ADP_RX_PENDING_NSDUS];
+static PAN_LOCAL uint8_t s_uc_rx_pending_head;
+static PAN_LOCAL uint8_t s_uc_rx_pending_count;
+
+static void adp_tx_init(void);
+static void adp_tx_signal(void);
+static void adp_flow_status_init(void);
+static void adp_flow_status_notify(bool b_ready);
 
 /* MAC include */
 #include "mac_wrapper.h"
@@ -82,7 +158,7 @@ static uint16_t s_us_panid;
 /* Avoid unwanted warnings */
 #define UNUSED(x) (void)(x)
 
-extern int tunfd;
+extern PAN_LOCAL int tunfd_usi;
 
 /* Check SPEC_COMPLIANCE definition */
 #ifndef SPEC_COMPLIANCE
@@ -95,10 +171,13 @@ extern int tunfd;
 #       define LOG_APP_DEBUG(...)   (void)0
 #endif
 
-#define ADP_DATA_BLOCKING_FILE     "/tmp/G3_AdpData_blocking"
-#define G3_PLC_NODE_LIST           "/tmp/g3plc_node_list"
+/* List of registered devices for IP applications, one per TUN device */
+#define G3_PLC_NODE_LIST_FMT       "/tmp/%s_node_list"
 
-#define NETWORK_START_TIMEOUT 10
+static PAN_LOCAL char s_sz_node_list[64];
+
+/* Initialization settings not confirmed (timeout, busy) are retried one by one */
+#define APP_MIB_INIT_RETRIES       2
 
 /* constants related to network join */
 enum NetworkJoinStatus {
@@ -115,12 +194,18 @@ enum NetworkStartStatus {
 };
 
 /* global variables */
-uint8_t g_u8NetworkJoinStatus = NETWORK_NOT_JOINED;
-uint8_t g_u8NetworkStartStatus = NETWORK_NOT_STARTED;
+PAN_LOCAL uint8_t g_u8NetworkJoinStatus = NETWORK_NOT_JOINED;
+PAN_LOCAL uint8_t g_u8NetworkStartStatus = NETWORK_NOT_STARTED;
+static PAN_LOCAL uint32_t s_ul_init_time;
+static PAN_LOCAL uint32_t s_ul_network_start_time;
+/* Set from USI callback when the modem rejects the network start */
+static PAN_LOCAL volatile bool s_b_network_start_failed;
+/* Modem was reset: initialization plan has to be sent again */
+static PAN_LOCAL bool s_b_modem_reinit;
 
 /* Context information, to be updated when PanId is known */
 #define CONTEXT_INFORMATION_0_SIZE   14
-static uint8_t au8ConfContextInformationTable0[CONTEXT_INFORMATION_0_SIZE];
+static PAN_LOCAL uint8_t au8ConfContextInformationTable0[CONTEXT_INFORMATION_0_SIZE];
 
 /* MIB types and definitions */
 enum MibType {
@@ -137,8 +222,6 @@ struct MibData {
 	const uint8_t *m_pu8Value;
 };
 
-uint8_t g_u8MibInitIndex = 0;
-
 #if (SPEC_COMPLIANCE >= 17)
 #define APP_MIB_TABLE_SIZE (sizeof(g_MibSettings) / sizeof(struct MibData))
 #endif
@@ -187,8 +270,23 @@ struct MibData g_MibSettings[] =
 	{ MIB_ADP, "ADP_IB_MAX_JOIN_WAIT_TIME", ADP_IB_MAX_JOIN_WAIT_TIME, 0, 2, CONF_MAX_JOIN_WAIT_TIME },
 	{ MIB_ADP, "ADP_IB_MAX_HOPS", ADP_IB_MAX_HOPS, 0, 1, CONF_MAX_HOPS },
   { MIB_ADP, "ADP_IB_MANUF_EAP_PRESHARED_KEY", ADP_IB_MANUF_EAP_PRESHARED_KEY, 0, 16, CONF_PSK_KEY },
+	/* Filled by InitializeNetworkParameters(), value of the PAN: see GetMibValue() */
+	{ MIB_ADP, "ADP_IB_PREFIX_TABLE", ADP_IB_PREFIX_TABLE, 0, sizeof(struct ipv6_prefix), NULL },
 };
 
+/**
+ * \brief Value of a setting
+ * Values of the PAN are thread local, their address is not constant: they are NULL in the table
+ */
+static const uint8_t *GetMibValue(const struct MibData *px_mib)
+{
+	if (px_mib->m_u32Id == ADP_IB_PREFIX_TABLE) {
+		return (const uint8_t *)&s_x_net_prefix;
+	}
+
+	return px_mib->m_pu8Value;
+}
+
 /**
  * \brief G3 ADP Set Confirm Callback Function for ADP and MAC
  *
@@ -198,24 +296,10 @@ struct MibData g_MibSettings[] =
  */
 static void SetConfirm(uint8_t u8Status, uint32_t u32AttributeId, uint16_t u16AttributeIndex)
 {
-	if (u8Status == G3_SUCCESS) {
-		/* initialization phase? */
-		if (g_u8MibInitIndex < APP_MIB_TABLE_SIZE) {
-			if ((g_MibSettings[g_u8MibInitIndex].m_u32Id == u32AttributeId) && (g_MibSettings[g_u8MibInitIndex].m_u16Index == u16AttributeIndex)) {
-				if (g_u8MibInitIndex == APP_MIB_TABLE_SIZE) {
-					LOG_INFO(Log("Modem fully initialized"));
-				}
-			} else {
-				LOG_ERR(Log("ERR[AppAdpSetConfirm] Invalid SetConfirm received during initialization. Expecting 0x%08X/%u but received 0x%08X/%u",
-						g_MibSettings[g_u8MibInitIndex].m_u32Id, g_MibSettings[g_u8MibInitIndex].m_u16Index,
-						u32AttributeId, u16AttributeIndex));
-			}
-		}
-	} else {
-		LOG_ERR(Log("ERR[AppAdpSetConfirm] status: %u\r\n", u8Status));
+	/* During initialization, requests are pipelined and each confirm is matched with its request by the ADP interface */
+	if (u8Status != G3_SUCCESS) {
+		LOG_ERR(Log("ERR[AppAdpSetConfirm] status: %u (0x%08X/%u)\r\n", u8Status, u32AttributeId, u16AttributeIndex));
 	}
-
-	/* g_u8MibInitIndex++; */
 }
 
 /**
@@ -227,7 +311,33 @@ static void SetConfirm(uint8_t u8Status, uint32_t u32AttributeId, uint16_t u16At
  */
 static void AppAdpDataConfirm(struct TAdpDataConfirm *pDataConfirm)
 {
-	UNUSED(pDataConfirm);
+	uint8_t uc_idx;
+	x_adp_tx_slot_t *px_slot;
+
+	if (pDataConfirm->m_u8Status != G3_SUCCESS) {
+		LOG_DBG(Log("AppAdpDataConfirm handle %u status: %u", pDataConfirm->m_u8NsduHandle, pDataConfirm->m_u8Status));
+	}
+
+	/* Release window slot, next request is sent from adp_tx_process() */
+	pthread_mutex_lock(&s_tx_mutex);
+	for (uc_idx = 0; uc_idx < ADP_TX_WINDOW; uc_idx++) {
+		px_slot = &s_x_tx_window[uc_idx];
+		if (px_slot->b_used && (px_slot->uc_nsdu_handle == pDataConfirm->m_u8NsduHandle)) {
+			px_slot->b_used = false;
+			s_x_tx_dest[px_slot->uc_dest].uc_in_flight--;
+			s_uc_tx_in_flight--;
+			adp_tx_signal();
+			break;
+		}
+	}
+
+	if ((uc_idx == ADP_TX_WINDOW) && s_ab_handle_quarantine[pDataConfirm->m_u8NsduHandle]) {
+		/* Late confirm of a timed out request: its handle can be used again */
+		LOG_DBG(Log("AppAdpDataConfirm late, handle %u", pDataConfirm->m_u8NsduHandle));
+		s_ab_handle_quarantine[pDataConfirm->m_u8NsduHandle] = false;
+	}
+
+	pthread_mutex_unlock(&s_tx_mutex);
 }
 
 /**
@@ -240,23 +350,37 @@ static void AppAdpDataConfirm(struct TAdpDataConfirm *pDataConfirm)
  */
 static void AppAdpDataIndication(struct TAdpDataIndication *pDataIndication)
 {
-	if (tunfd >= 0) {
-		int ret;
-		uint8_t buffer[1284];
+	x_adp_rx_nsdu_t *px_nsdu;
+
+	if (tunfd_usi >= 0) {
+		int ret = -1;
 
 		/* On this example the Data from G3 Network will be forwarded to TUN device */
-		/* TUN Frame Format (flag IFF_NO_PI not set): Flags [2bytes] + Proto[2 bytes - IPv6 0x86DD] + Raw Protocol [IPv6 Frame] */
-
-		buffer[0] = 0;
-		buffer[1] = 0;
-		buffer[2] = 0x86;
-		buffer[3] = 0xDD;
-		memcpy(buffer + 4, pDataIndication->m_pNsdu, pDataIndication->m_u16NsduLength );
-		ret = write(tunfd, buffer, pDataIndication->m_u16NsduLength + 4 );
-		if (ret >= 0) {
-			LOG_DBG(Log("AppAdpDataIndication DATA: %u LQI: %u", pDataIndication->m_u16NsduLength, pDataIndication->m_u8LinkQualityIndicator));
+		/* TUN opened with IFF_NO_PI: the NSDU is the raw IPv6 frame, written as it is from USI buffer */
+		/* Non blocking write: PAN loop is never held. Older NSDUs waiting for TUN go first */
+		adp_rx_process();
+		if (s_uc_rx_pending_count == 0) {
+			ret = write(tunfd_usi, pDataIndication->m_pNsdu, pDataIndication->m_u16NsduLength);
+			if (ret >= 0) {
+				LOG_DBG(Log("AppAdpDataIndication DATA: %u LQI: %u", pDataIndication->m_u16NsduLength, pDataIndication->m_u8LinkQualityIndicator));
+				return;
+			}
+
+			if (errno != EAGAIN) {
+				LOG_ERR(Log("AppAdpDataIndication ERROR LEN: %u LQI: %u", pDataIndication->m_u16NsduLength, pDataIndication->m_u8LinkQualityIndicator));
+				return;
+			}
+		}
+
+		/* TUN queue full: the NSDU is kept in its USI frame until TUN is writable */
+		if ((s_uc_rx_pending_count < ADP_RX_PENDING_NSDUS) && usi_RxFrameRetain(pDataIndication->m_pNsdu)) {
+			px_nsdu = &s_x_rx_pending[(s_uc_rx_pending_head + s_uc_rx_pending_count) % ADP_RX_PENDING_NSDUS];
+			px_nsdu->puc_nsdu = pDataIndication->m_pNsdu;
+			px_nsdu->us_length = pDataIndication->m_u16NsduLength;
+			s_uc_rx_pending_count++;
+			LOG_DBG(Log("AppAdpDataIndication DATA: %u LQI: %u delayed", pDataIndication->m_u16NsduLength, pDataIndication->m_u8LinkQualityIndicator));
 		} else {
-			LOG_ERR(Log("AppAdpDataIndication ERROR LEN: %u LQI: %u", pDataIndication->m_u16NsduLength, pDataIndication->m_u8LinkQualityIndicator));
+			LOG_ERR(Log("AppAdpDataIndication TUN full, dropped LEN: %u LQI: %u", pDataIndication->m_u16NsduLength, pDataIndication->m_u8LinkQualityIndicator));
 		}
 	}
 }
@@ -304,8 +428,13 @@ static void AppAdpNetworkStartConfirm(struct TAdpNetworkStartConfirm *pNetworkSt
 {
   /* Only used on Coordinator */
   LOG_DBG(Log("AppAdpNetworkStartConfirm: %d\r\n",pNetworkStartConfirm->m_u8Status));
-  if (pNetworkStartConfirm->m_u8Status == G3_SUCCESS)
+  if (pNetworkStartConfirm->m_u8Status == G3_SUCCESS) {
      g_u8NetworkStartStatus = NETWORK_STARTED;
+     LOG_INFO(Log("Network started, %u ms after initialization", oss_get_up_time_ms() - s_ul_init_time));
+  } else {
+     /* Do not wait for the timeout to start again */
+     s_b_network_start_failed = true;
+  }
 }
 
 /**
@@ -472,23 +601,19 @@ static void AppAdpBufferIndication(struct TAdpBufferIndication *pBufferIndicatio
 		if (pBufferIndication->m_bBufferReady) {
 			/* ADP Buffers ready */
 			LOG_DBG(Log("ADP Buffers ready now!"));
-			/* Remove ADP Data Blocking File */
-			unlink(ADP_DATA_BLOCKING_FILE);
+			/* Queued packets can be sent */
+			adp_tx_signal();
 			SET_LED_RED_OFF();
 		} else {
 			/* ADP Buffers NOT ready */
 			LOG_DBG(Log("ADP Buffers NOT ready!"));
-			/* Create ADP Data Blocking File */
-			int fd_block;
-			fd_block = open(ADP_DATA_BLOCKING_FILE, O_CREAT | O_RDONLY, S_IRUSR | S_IRGRP | S_IROTH);
-			if (fd_block == -1) {
-				LOG_ERR(Log("Impossible to create ADP Data Blocking File: %s", strerror(errno)));
-				exit(1);
-			}
-
-			close(fd_block);
 			SET_LED_RED_HEARTBEAT(LED_HEARTBEAT_NOT_INVERTED);
 		}
+
+		adp_flow_status_notify(pBufferIndication->m_bBufferReady);
+
+		/* Queued LBP messages are sent only while ADP has buffers */
+		bs_lbp_set_tx_ready(pBufferIndication->m_bBufferReady);
 	}
 }
 
@@ -499,9 +624,7 @@ static void AppAdpBufferIndication(struct TAdpBufferIndication *pBufferIndicatio
  */
 static void AppAdpNotification_UpdNonVolatileDataIndication(void)
 {
-#ifdef ENABLE_PIB_RESTORE
-  	store_persistent_info();
-#endif
+	store_persistent_info();
 }
 
 /**
@@ -539,7 +662,7 @@ static void AppBsJoinIndication(uint8_t *puc_extended_address, uint16_t us_short
 
 	/* This application propagate this information to file in order to be used by IP applications */
 	SET_LED_BLUE_HEARTBEAT(LED_HEARTBEAT_NOT_INVERTED)
-	fd = fopen(G3_PLC_NODE_LIST, "w");
+	fd = fopen(s_sz_node_list, "w");
 	if (fd == NULL) {
 		LOG_ERR(Log("file is created"));
 	}
@@ -576,7 +699,7 @@ static void AppBsLeaveIndication(uint16_t u16SrcAddr, bool bSecurityEnabled, uin
 	UNUSED(u16NsduLength);
 }
 
-static struct TAdpNotifications notifications;
+static PAN_LOCAL struct TAdpNotifications notifications;
 
 /**
  * \brief Initialize G3 Stack
@@ -619,31 +742,68 @@ static void InitializeStack(uint8_t uc_plc_band)
 
 /**
  * \brief Initialize G3 Modem Parameters
+ * The whole settings table is sent as one pipelined batch, keeping the table order. Confirms are verified when all
+ * of them are received, and the settings without confirm are retried one by one.
  */
 static void InitializeModemParameters(void)
 {
-	struct TAdpSetConfirm pSetConfirm;
-	struct TAdpMacSetConfirm pMacSetConfirm;
-
-	while (g_u8MibInitIndex < APP_MIB_TABLE_SIZE) {
-		if (g_u8MibInitIndex == 0) {
-			LOG_INFO(Log("Start modem initialization"));
+	struct TAdpPibRequest ax_requests[APP_MIB_TABLE_SIZE];
+	struct TAdpSetConfirm ax_confirms[APP_MIB_TABLE_SIZE];
+	struct TAdpMacSetConfirm x_mac_confirm;
+	bool ab_mac[APP_MIB_TABLE_SIZE];
+	const struct MibData *px_mib;
+	uint32_t ul_start_time;
+	uint8_t u8Count;
+	uint8_t u8Failed = 0;
+	uint8_t u8Retry;
+	uint8_t i;
+
+	LOG_INFO(Log("Start modem initialization"));
+	ul_start_time = oss_get_up_time_ms();
+
+	for (u8Count = 0; u8Count < APP_MIB_TABLE_SIZE; u8Count++) {
+		px_mib = &g_MibSettings[u8Count];
+		if ((px_mib->m_u8Type == 0) && (px_mib->m_szName == 0) && (px_mib->m_u16Index == 0)) {
+			/* End of table mark */
+			break;
 		}
 
-		LOG_DBG(Log("Setting command %02u: %s / %u", g_u8MibInitIndex, g_MibSettings[g_u8MibInitIndex].m_szName, g_MibSettings[g_u8MibInitIndex].m_u16Index));
-		if ((g_MibSettings[g_u8MibInitIndex].m_u8Type == 0) && (g_MibSettings[g_u8MibInitIndex].m_szName == 0) && (g_MibSettings[g_u8MibInitIndex].m_u16Index == 0)) {
-			return;
+		LOG_DBG(Log("Setting command %02u: %s / %u", u8Count, px_mib->m_szName, px_mib->m_u16Index));
+		ax_requests[u8Count].m_u32AttributeId = px_mib->m_u32Id;
+		ax_requests[u8Count].m_u16AttributeIndex = px_mib->m_u16Index;
+		ax_requests[u8Count].m_u8AttributeLength = px_mib->m_u8ValueLength;
+		ax_requests[u8Count].m_pu8AttributeValue = GetMibValue(px_mib);
+		ab_mac[u8Count] = (px_mib->m_u8Type == MIB_MAC);
+	}
+
+	AdpMibSetRequestMulti(ax_requests, ab_mac, u8Count, ax_confirms);
+
+	for (i = 0; i < u8Count; i++) {
+		px_mib = &g_MibSettings[i];
+		u8Retry = 0;
+		while (((ax_confirms[i].m_u8Status == G3_TIMEOUT) || (ax_confirms[i].m_u8Status == G3_BUSY)) && (u8Retry < APP_MIB_INIT_RETRIES)) {
+			LOG_DBG(Log("Retrying setting command %02u: %s / %u", i, px_mib->m_szName, px_mib->m_u16Index));
+			if (ab_mac[i]) {
+				AdpMacSetRequestSync(px_mib->m_u32Id, px_mib->m_u16Index, px_mib->m_u8ValueLength, GetMibValue(px_mib), &x_mac_confirm);
+				ax_confirms[i].m_u8Status = x_mac_confirm.m_u8Status;
+			} else {
+				AdpSetRequestSync(px_mib->m_u32Id, px_mib->m_u16Index, px_mib->m_u8ValueLength, GetMibValue(px_mib), &ax_confirms[i]);
+			}
+
+			u8Retry++;
 		}
 
-		if (g_MibSettings[g_u8MibInitIndex].m_u8Type == MIB_ADP) {
-			/* AdpSetRequest(g_MibSettings[g_u8MibInitIndex].m_u32Id, g_MibSettings[g_u8MibInitIndex].m_u16Index, g_MibSettings[g_u8MibInitIndex].m_u8ValueLength, g_MibSettings[g_u8MibInitIndex].m_pu8Value); */
-			AdpSetRequestSync(g_MibSettings[g_u8MibInitIndex].m_u32Id, g_MibSettings[g_u8MibInitIndex].m_u16Index, g_MibSettings[g_u8MibInitIndex].m_u8ValueLength, g_MibSettings[g_u8MibInitIndex].m_pu8Value, &pSetConfirm);
-		} else {
-			/* AdpMacSetRequest(g_MibSettings[g_u8MibInitIndex].m_u32Id, g_MibSettings[g_u8MibInitIndex].m_u16Index, g_MibSettings[g_u8MibInitIndex].m_u8ValueLength, g_MibSettings[g_u8MibInitIndex].m_pu8Value); */
-			AdpMacSetRequestSync(g_MibSettings[g_u8MibInitIndex].m_u32Id, g_MibSettings[g_u8MibInitIndex].m_u16Index, g_MibSettings[g_u8MibInitIndex].m_u8ValueLength, g_MibSettings[g_u8MibInitIndex].m_pu8Value, &pMacSetConfirm);
+		/* Modem errors are also reported by SetConfirm() */
+		if (ax_confirms[i].m_u8Status != G3_SUCCESS) {
+			LOG_ERR(Log("Setting command %02u: %s / %u failed, status %u", i, px_mib->m_szName, px_mib->m_u16Index, ax_confirms[i].m_u8Status));
+			u8Failed++;
 		}
+	}
 
-		g_u8MibInitIndex++;
+	if (u8Failed == 0) {
+		LOG_INFO(Log("Modem fully initialized in %u ms", oss_get_up_time_ms() - ul_start_time));
+	} else {
+		LOG_ERR(Log("Modem initialized in %u ms, %u settings failed", oss_get_up_time_ms() - ul_start_time, u8Failed));
 	}
 }
 
@@ -660,26 +820,22 @@ static void StartDiscovery(void)
 
 /**
  * \brief Initialize G3 Network Parameters
+ * Values are set in the modem by InitializeModemParameters()
  */
 static void InitializeNetworkParameters(uint16_t us_panid, uint8_t *ipv6addr, uint8_t uc_net_len)
 {
-	struct TAdpSetConfirm pSetConfirm;
-	struct ipv6_prefix net_prefix;
-
 	s_b_write_available = 1;
 	s_us_panid = us_panid;
 	s_uc_G3_NET_PREFIX_LEN = uc_net_len;
 	memcpy(s_puc_G3_NET_IPV6, ipv6addr, 16);
 
 	/* Set Network Parameters */
-	net_prefix.uc_prefix_len = s_uc_G3_NET_PREFIX_LEN; /* bits */
-	net_prefix.uc_on_link_flag = 1;
-	net_prefix.uc_auto_config_flag = 1;
-	net_prefix.ui_valid_life_time = 0x20C000; /* infinite */
-	net_prefix.ui_preferred_life_time = 0x20C000; /* infinite */
-	memcpy(net_prefix.puc_prefix, s_puc_G3_NET_IPV6, 16);
-	/* AdpSetRequest(ADP_IB_PREFIX_TABLE,0,sizeof(struct ipv6_prefix),(uint8_t*)&net_prefix); */
-	AdpSetRequestSync(ADP_IB_PREFIX_TABLE, 0, sizeof(struct ipv6_prefix), (uint8_t *)&net_prefix, &pSetConfirm);
+	s_x_net_prefix.uc_prefix_len = s_uc_G3_NET_PREFIX_LEN; /* bits */
+	s_x_net_prefix.uc_on_link_flag = 1;
+	s_x_net_prefix.uc_auto_config_flag = 1;
+	s_x_net_prefix.ui_valid_life_time = 0x20C000; /* infinite */
+	s_x_net_prefix.ui_preferred_life_time = 0x20C000; /* infinite */
+	memcpy(s_x_net_prefix.puc_prefix, s_puc_G3_NET_IPV6, 16);
 }
 
 static void StartCoordinator(uint8_t uc_plc_band, uint16_t us_panid)
@@ -691,9 +847,10 @@ static void StartCoordinator(uint8_t uc_plc_band, uint16_t us_panid)
 
 	LOG_INFO(Log("Starting coordinator..."));
 
-#ifdef ENABLE_PIB_RESTORE
+	/* Configured keys must not replace the stored ones */
+	bs_lbp_state_ind_set_cb(NULL);
+
 	load_persistent_info();
-#endif
 
 	s_bs_conf.m_u8BandInfo = uc_plc_band;
 	AdpGetRequestSync(ADP_IB_MAX_HOPS, 0, &pGetConfirm);
@@ -709,8 +866,11 @@ static void StartCoordinator(uint8_t uc_plc_band, uint16_t us_panid)
 
 	/* Init Bootstrap module */
 	bs_init(s_bs_conf); /*! Initialize GMK on ADP_MAC_SERIALIZED Layer */
+	/* Warm restart: devices joined before keep their addresses and keys */
+	storage_restore_bootstrap();
 	bs_lbp_join_ind_set_cb(AppBsJoinIndication);
 	bs_lbp_leave_ind_set_cb(AppBsLeaveIndication);
+	bs_lbp_state_ind_set_cb(storage_bs_state_ind);
 
 	/* Start G3 Network */
 	AdpNetworkStartRequest(s_us_panid);
@@ -728,15 +888,19 @@ void adp_init(uint8_t uc_plc_band, uint16_t us_panid, uint8_t *puc_ipaddr, uint8
 {
 	struct in6_addr ip6addr;
 
+	s_ul_init_time = oss_get_up_time_ms();
+
 	/* Init modules */
+	adp_tx_init();
+	snprintf(s_sz_node_list, sizeof(s_sz_node_list), G3_PLC_NODE_LIST_FMT, g_st_config.sz_tun_name);
+	storage_init(g_st_config.sz_tun_name);
 	InitializeStack(uc_plc_band);
-	InitializeModemParameters();
 	inet_pton(AF_INET6, puc_ipaddr, &ip6addr);
 	InitializeNetworkParameters(us_panid, (uint8_t *)&ip6addr, uc_net_len);
+	InitializeModemParameters();
 	/*! Remove List of G3 PLC devices registered */
-	unlink(G3_PLC_NODE_LIST);
-	/*! Remove ADP Buffers Blocking file */
-	unlink(ADP_DATA_BLOCKING_FILE);
+	unlink(s_sz_node_list);
+	adp_flow_status_init();
 }
 
 /**
@@ -747,10 +911,6 @@ void adp_init(uint8_t uc_plc_band, uint16_t us_panid, uint8_t *puc_ipaddr, uint8
  */
 void adp_process(uint8_t uc_plc_band, uint16_t us_panid)
 {
-  static uint32_t start_t = 0;
-  uint32_t end_t = 0;
-  uint32_t diff_t = 0;
-
     if(g_u8NetworkJoinStatus == NETWORK_NOT_JOINED) {
 #ifdef APP_CONFORMANCE_TEST
        if (g_st_config.b_conformance){
@@ -766,26 +926,33 @@ void adp_process(uint8_t uc_plc_band, uint16_t us_panid)
 	} else if(g_u8NetworkJoinStatus == NETWORK_JOINED) {
 		// network start will start only after the modem is initialized
 		if (g_u8NetworkStartStatus == NETWORK_NOT_STARTED) {
+	          if (s_b_modem_reinit) {
+	             s_b_modem_reinit = false;
+	             InitializeModemParameters();
+	          }
+
 	          /* Start node as coordinator */
-        	  StartCoordinator(uc_plc_band,us_panid);
+	          s_b_network_start_failed = false;
 	          g_u8NetworkStartStatus = NETWORK_START_PENDING;
 	          // Timer Waiting Network Initialization
-        	  start_t = oss_get_up_time_ms();
+	          s_ul_network_start_time = oss_get_up_time_ms();
+	          StartCoordinator(uc_plc_band,us_panid);
 		}else if (g_u8NetworkStartStatus == NETWORK_START_PENDING){
-	          end_t = oss_get_up_time_ms();
-        	  diff_t = (end_t-start_t) / 1000;
-	          if (diff_t > NETWORK_START_TIMEOUT){
-        	     LOG_INFO(Log("Coordinator Start Timeout %d\n", diff_t));
-	             // Something was wrong - Reset the Network
-        	     g_u8NetworkJoinStatus == NETWORK_NOT_JOINED;
-	             g_u8NetworkStartStatus == NETWORK_NOT_STARTED;
-        	     AdpResetRequest();
+	          if (s_b_network_start_failed || ((oss_get_up_time_ms() - s_ul_network_start_time) > NETWORK_START_TIMEOUT_MS)) {
+	             LOG_INFO(Log("Coordinator Start %s\n", s_b_network_start_failed ? "Failed" : "Timeout"));
+	             // Something was wrong - Reset the Network and initialize the modem again
+	             g_u8NetworkJoinStatus = NETWORK_NOT_JOINED;
+	             g_u8NetworkStartStatus = NETWORK_NOT_STARTED;
+	             s_b_modem_reinit = true;
+	             AdpResetRequest();
 	          }
 		}
 	}
 
 	/* Call bootstrap process*/
 	bs_process();
+
+	storage_process();
 }
 
 /**
@@ -837,16 +1004,413 @@ bool adp_write_buffers_available()
 	return s_b_write_available;
 }
 
+/**
+ * \brief Init downstream forwarding queues
+ *
+ */
+static void adp_tx_init(void)
+{
+	uint8_t uc_idx;
+
+	pthread_mutex_lock(&s_tx_mutex);
+	memset(s_x_tx_dest, 0, sizeof(s_x_tx_dest));
+	memset(s_x_tx_window, 0, sizeof(s_x_tx_window));
+	memset(s_ab_handle_quarantine, 0, sizeof(s_ab_handle_quarantine));
+	for (uc_idx = 0; uc_idx < ADP_TX_POOL_SIZE; uc_idx++) {
+		s_x_tx_pool[uc_idx].uc_next = (uc_idx + 1 < ADP_TX_POOL_SIZE) ? (uc_idx + 1) : ADP_TX_NONE;
+	}
+
+	s_uc_tx_free = 0;
+	s_uc_tx_free_count = ADP_TX_POOL_SIZE;
+	s_uc_tx_in_flight = 0;
+	s_uc_tx_next_dest = 0;
+	pthread_mutex_unlock(&s_tx_mutex);
+
+	if (s_i_tx_event_fd < 0) {
+		s_i_tx_event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (s_i_tx_event_fd < 0) {
+			LOG_ERR(Log("Error creating ADP TX event: %s", strerror(errno)));
+		}
+	}
+}
+
+/**
+ * \brief Wake up the thread sending queued packets
+ *
+ */
+static void adp_tx_signal(void)
+{
+	uint64_t ull_one = 1;
+
+	if (s_i_tx_event_fd >= 0) {
+		/* Only fails if counter would overflow: thread is already signalled */
+		if (write(s_i_tx_event_fd, &ull_one, sizeof(ull_one)) < 0) {
+			return;
+		}
+	}
+}
+
+/**
+ * \brief Descriptor readable when queued packets may be sent
+ *
+ * To be polled by the thread calling adp_tx_process(), -1 if not available.
+ */
+int adp_tx_event_fd(void)
+{
+	return s_i_tx_event_fd;
+}
+
+/**
+ * \brief Clear the event of adp_tx_event_fd()
+ *
+ */
+void adp_tx_event_clear(void)
+{
+	uint64_t ull_count;
+
+	if (s_i_tx_event_fd >= 0) {
+		if (read(s_i_tx_event_fd, &ull_count, sizeof(ull_count)) < 0) {
+			return;
+		}
+	}
+}
+
+/**
+ * \brief Upstream NSDUs are waiting for room in the TUN queue
+ *
+ * The PAN loop then watches the TUN descriptor for writing and calls adp_rx_process().
+ */
+bool adp_rx_pending(void)
+{
+	return (s_uc_rx_pending_count > 0);
+}
+
+/**
+ * \brief Write upstream NSDUs waiting for room in the TUN queue
+ *
+ * Their USI frames are released once written, or dropped on a TUN error.
+ */
+void adp_rx_process(void)
+{
+	x_adp_rx_nsdu_t *px_nsdu;
+
+	while (s_uc_rx_pending_count > 0) {
+		px_nsdu = &s_x_rx_pending[s_uc_rx_pending_head];
+		if (write(tunfd_usi, px_nsdu->puc_nsdu, px_nsdu->us_length) < 0) {
+			if (errno == EAGAIN) {
+				break;
+			}
+
+			LOG_ERR(Log("adp_rx_process ERROR LEN: %u", px_nsdu->us_length));
+		}
+
+		usi_RxFrameRelease(px_nsdu->puc_nsdu);
+		s_uc_rx_pending_head = (s_uc_rx_pending_head + 1) % ADP_RX_PENDING_NSDUS;
+		s_uc_rx_pending_count--;
+	}
+}
+
+/**
+ * \brief Open the ADP buffers state socket
+ *
+ */
+static void adp_flow_status_init(void)
+{
+#ifdef ADP_FLOW_STATUS_SOCKET
+	struct sockaddr_un x_addr;
+	int i_len;
+
+	if (s_i_flow_fd >= 0) {
+		return;
+	}
+
+	s_i_flow_fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (s_i_flow_fd < 0) {
+		LOG_ERR(Log("Error creating ADP flow status socket: %s", strerror(errno)));
+		return;
+	}
+
+	/* Abstract namespace: nothing is created in the filesystem */
+	memset(&x_addr, 0, sizeof(x_addr));
+	x_addr.sun_family = AF_UNIX;
+	/* One socket per coordinator instance */
+	i_len = snprintf(&x_addr.sun_path[1], sizeof(x_addr.sun_path) - 1, ADP_FLOW_STATUS_SOCKET "-%s", g_st_config.sz_tun_name);
+	if (bind(s_i_flow_fd, (struct sockaddr *)&x_addr,
+			offsetof(struct sockaddr_un, sun_path) + 1 + i_len) < 0) {
+		LOG_ERR(Log("Error binding ADP flow status socket: %s", strerror(errno)));
+		close(s_i_flow_fd);
+		s_i_flow_fd = -1;
+	}
+#endif
+}
+
+/**
+ * \brief Send ADP buffers state to subscribed processes
+ *
+ * Subscribers which can not be reached are removed.
+ */
+static void adp_flow_status_notify(bool b_ready)
+{
+#ifdef ADP_FLOW_STATUS_SOCKET
+	uint8_t uc_state = b_ready ? 1 : 0;
+	uint8_t uc_idx = 0;
+
+	pthread_mutex_lock(&s_flow_mutex);
+	while ((s_i_flow_fd >= 0) && (uc_idx < s_uc_flow_subs)) {
+		if ((sendto(s_i_flow_fd, &uc_state, 1, MSG_DONTWAIT, (struct sockaddr *)&s_x_flow_subs[uc_idx],
+				s_ax_flow_subs_len[uc_idx]) < 0) && (errno != EAGAIN)) {
+			s_uc_flow_subs--;
+			s_x_flow_subs[uc_idx] = s_x_flow_subs[s_uc_flow_subs];
+			s_ax_flow_subs_len[uc_idx] = s_ax_flow_subs_len[s_uc_flow_subs];
+		} else {
+			uc_idx++;
+		}
+	}
+	pthread_mutex_unlock(&s_flow_mutex);
+#else
+	UNUSED(b_ready);
+#endif
+}
+
+/**
+ * \brief Descriptor readable when a process queries ADP buffers state, -1 if not available
+ *
+ */
+int adp_flow_status_fd(void)
+{
+#ifdef ADP_FLOW_STATUS_SOCKET
+	return s_i_flow_fd;
+#else
+	return -1;
+#endif
+}
+
+/**
+ * \brief Answer ADP buffers state queries and subscribe their senders
+ *
+ */
+void adp_flow_status_process(void)
+{
+#ifdef ADP_FLOW_STATUS_SOCKET
+	struct sockaddr_un x_addr;
+	socklen_t x_addr_len;
+	uint8_t uc_buf[16];
+	uint8_t uc_state;
+	uint8_t uc_idx;
+
+	while (s_i_flow_fd >= 0) {
+		x_addr_len = sizeof(x_addr);
+		if (recvfrom(s_i_flow_fd, uc_buf, sizeof(uc_buf), 0, (struct sockaddr *)&x_addr, &x_addr_len) < 0) {
+			break;
+		}
+
+		/* Unbound senders can not be answered */
+		if (x_addr_len <= offsetof(struct sockaddr_un, sun_path)) {
+			continue;
+		}
+
+		pthread_mutex_lock(&s_flow_mutex);
+		for (uc_idx = 0; uc_idx < s_uc_flow_subs; uc_idx++) {
+			if ((s_ax_flow_subs_len[uc_idx] == x_addr_len) && !memcmp(&s_x_flow_subs[uc_idx], &x_addr, x_addr_len)) {
+				break;
+			}
+		}
+
+		if ((uc_idx == s_uc_flow_subs) && (s_uc_flow_subs < ADP_FLOW_MAX_SUBSCRIBERS)) {
+			s_x_flow_subs[uc_idx] = x_addr;
+			s_ax_flow_subs_len[uc_idx] = x_addr_len;
+			s_uc_flow_subs++;
+		}
+
+		uc_state = s_b_write_available ? 1 : 0;
+		sendto(s_i_flow_fd, &uc_state, 1, MSG_DONTWAIT, (struct sockaddr *)&x_addr, x_addr_len);
+		pthread_mutex_unlock(&s_flow_mutex);
+	}
+#endif
+}
+
+/**
+ * \brief Queue IPv6 Message to a destination
+ *
+ * \return 0 if queued, -3 if destination queue or packet pool is full
+ */
+static int adp_tx_enqueue(uint16_t us_short_addr, bool b_set_dest, uint8_t *puc_buffer, uint16_t us_length)
+{
+	uint8_t uc_idx;
+	uint8_t uc_dest = ADP_TX_NONE;
+	uint8_t uc_pkt;
+	x_adp_tx_dest_t *px_dest;
+
+	pthread_mutex_lock(&s_tx_mutex);
+
+	/* Look for destination queue, or a free one */
+	for (uc_idx = 0; uc_idx < ADP_TX_MAX_DESTS; uc_idx++) {
+		px_dest = &s_x_tx_dest[uc_idx];
+		if ((px_dest->uc_count == 0) && (px_dest->uc_in_flight == 0)) {
+			if (uc_dest == ADP_TX_NONE) {
+				uc_dest = uc_idx;
+			}
+		} else if (px_dest->us_short_addr == us_short_addr) {
+			uc_dest = uc_idx;
+			break;
+		}
+	}
+
+	if ((uc_dest == ADP_TX_NONE) || (s_uc_tx_free == ADP_TX_NONE) ||
+			(s_x_tx_dest[uc_dest].uc_count >= ADP_TX_DEST_QUEUE_DEPTH)) {
+		pthread_mutex_unlock(&s_tx_mutex);
+		LOG_ERR(Log("ADP TX queue full, packet to 0x%04X dropped", us_short_addr));
+		return -3;
+	}
+
+	/* Take packet from pool and append it to destination queue */
+	uc_pkt = s_uc_tx_free;
+	s_uc_tx_free = s_x_tx_pool[uc_pkt].uc_next;
+	s_uc_tx_free_count--;
+	s_x_tx_pool[uc_pkt].uc_next = ADP_TX_NONE;
+	s_x_tx_pool[uc_pkt].us_length = us_length;
+	s_x_tx_pool[uc_pkt].b_set_dest = b_set_dest;
+	memcpy(s_x_tx_pool[uc_pkt].puc_data, puc_buffer, us_length);
+
+	px_dest = &s_x_tx_dest[uc_dest];
+	if (px_dest->uc_count == 0) {
+		px_dest->uc_head = uc_pkt;
+	} else {
+		s_x_tx_pool[px_dest->uc_tail].uc_next = uc_pkt;
+	}
+
+	px_dest->uc_tail = uc_pkt;
+	px_dest->uc_count++;
+	px_dest->us_short_addr = us_short_addr;
+
+	pthread_mutex_unlock(&s_tx_mutex);
+	return 0;
+}
+
+/**
+ * \brief Downstream packets can be queued
+ *
+ * Used to stop reading TUN interface while the packet pool is exhausted.
+ */
+bool adp_tx_queue_available(void)
+{
+	return (s_uc_tx_free_count > 0);
+}
+
+/**
+ * \brief Get the next NSDU handle not in quarantine, s_tx_mutex must be held
+ *
+ * \return true if a handle is available in s_uc_nsdu_handle
+ */
+static bool adp_tx_next_handle(uint32_t ui_now)
+{
+	uint16_t us_tries;
+
+	for (us_tries = 0; us_tries < 256; us_tries++) {
+		if (s_ab_handle_quarantine[s_uc_nsdu_handle] &&
+				((int32_t)(s_aui_handle_quarantine_end_ms[s_uc_nsdu_handle] - ui_now) > 0)) {
+			s_uc_nsdu_handle++;
+			continue;
+		}
+
+		s_ab_handle_quarantine[s_uc_nsdu_handle] = false;
+		return true;
+	}
+
+	return false;
+}
+
+/**
+ * \brief Send queued IPv6 Messages while the window allows it
+ *
+ * Destinations are served round robin. Must be called from the thread reading
+ * TUN interface, periodically and after adp_send_ipv6_message().
+ */
+void adp_tx_process(void)
+{
+	uint8_t uc_idx;
+	uint8_t uc_slot;
+	uint8_t uc_dest;
+	uint8_t uc_pkt;
+	uint32_t ui_now;
+	x_adp_tx_dest_t *px_dest;
+	x_adp_tx_pkt_t *px_pkt;
+
+	ui_now = oss_get_up_time_ms();
+
+	pthread_mutex_lock(&s_tx_mutex);
+
+	/* Release requests whose confirm was lost */
+	for (uc_slot = 0; uc_slot < ADP_TX_WINDOW; uc_slot++) {
+		if (s_x_tx_window[uc_slot].b_used && ((ui_now - s_x_tx_window[uc_slot].ui_start_ms) > ADP_TX_CONFIRM_TIMEOUT_MS)) {
+			LOG_ERR(Log("AdpDataConfirm timeout, handle %u", s_x_tx_window[uc_slot].uc_nsdu_handle));
+			s_x_tx_window[uc_slot].b_used = false;
+			s_ab_handle_quarantine[s_x_tx_window[uc_slot].uc_nsdu_handle] = true;
+			s_aui_handle_quarantine_end_ms[s_x_tx_window[uc_slot].uc_nsdu_handle] = ui_now + ADP_TX_HANDLE_QUARANTINE_MS;
+			s_x_tx_dest[s_x_tx_window[uc_slot].uc_dest].uc_in_flight--;
+			s_uc_tx_in_flight--;
+		}
+	}
+
+	while (s_b_write_available && (s_uc_tx_in_flight < ADP_TX_WINDOW)) {
+		/* Next destination with packets and room in window */
+		uc_dest = ADP_TX_NONE;
+		for (uc_idx = 0; uc_idx < ADP_TX_MAX_DESTS; uc_idx++) {
+			px_dest = &s_x_tx_dest[(s_uc_tx_next_dest + uc_idx) % ADP_TX_MAX_DESTS];
+			if ((px_dest->uc_count > 0) && (px_dest->uc_in_flight < ADP_TX_DEST_IN_FLIGHT)) {
+				uc_dest = (s_uc_tx_next_dest + uc_idx) % ADP_TX_MAX_DESTS;
+				break;
+			}
+		}
+
+		if ((uc_dest == ADP_TX_NONE) || !adp_tx_next_handle(ui_now)) {
+			break;
+		}
+
+		s_uc_tx_next_dest = (uc_dest + 1) % ADP_TX_MAX_DESTS;
+
+		for (uc_slot = 0; s_x_tx_window[uc_slot].b_used; uc_slot++) {
+		}
+
+		/* Dequeue packet */
+		px_dest = &s_x_tx_dest[uc_dest];
+		uc_pkt = px_dest->uc_head;
+		px_pkt = &s_x_tx_pool[uc_pkt];
+		px_dest->uc_head = px_pkt->uc_next;
+		px_dest->uc_count--;
+		px_dest->uc_in_flight++;
+		s_uc_tx_in_flight++;
+
+		s_x_tx_window[uc_slot].b_used = true;
+		s_x_tx_window[uc_slot].uc_nsdu_handle = s_uc_nsdu_handle;
+		s_x_tx_window[uc_slot].uc_dest = uc_dest;
+		s_x_tx_window[uc_slot].ui_start_ms = ui_now;
+
+		/* Destination is set just before its request, both are queued in order to the modem */
+		if (px_pkt->b_set_dest) {
+			AdpSetRequest(ADP_IB_MANUF_IPV6_ULA_DEST_SHORT_ADDRESS, 0, sizeof(px_dest->us_short_addr), (uint8_t *)&px_dest->us_short_addr);
+		}
+
+		AdpDataRequest(px_pkt->us_length, px_pkt->puc_data, s_uc_nsdu_handle++, true, 0x00);
+
+		/* Request is copied to USI, packet can be reused */
+		px_pkt->uc_next = s_uc_tx_free;
+		s_uc_tx_free = uc_pkt;
+		s_uc_tx_free_count++;
+	}
+
+	pthread_mutex_unlock(&s_tx_mutex);
+}
+
 /**
  * \brief Sent IPv6 Message through G3 Stack
  *
+ * Message is queued to its destination and sent from adp_tx_process().
  */
 int  adp_send_ipv6_message(uint8_t *puc_buffer, uint16_t us_length)
 {
 	uint8_t puc_dest_extended_addr[EXT_ADDR_LEN];
 	uint16_t us_short_addr;
-	static uint8_t uc_nsdu_handle = 0;
-	struct TAdpSetConfirm pSetConfirm;
 
 	if ((!puc_buffer) || (us_length > G3_ADP_MAX_DATA_LENTHG)) {
 		LOG_ERR(Log("ERROR: MSG too large %d", us_length));
@@ -863,10 +1427,7 @@ int  adp_send_ipv6_message(uint8_t *puc_buffer, uint16_t us_length)
 	memcpy(puc_dest_extended_addr, puc_buffer + 24 + 8, EXT_ADDR_LEN);
 
 	if (bs_get_short_addr_by_ext(puc_dest_extended_addr, &us_short_addr) == true) {
-		/* AdpSetRequestSync(ADP_IB_MANUF_IPV6_ULA_DEST_SHORT_ADDRESS, 0, sizeof(us_short_addr),(uint8_t*)&us_short_addr, &pSetConfirm); */
-		AdpSetRequest(ADP_IB_MANUF_IPV6_ULA_DEST_SHORT_ADDRESS, 0, sizeof(us_short_addr), (uint8_t *)&us_short_addr);
-		AdpDataRequest(us_length, puc_buffer, uc_nsdu_handle++, true, 0x00);
-		return 0;
+		return adp_tx_enqueue(us_short_addr, true, puc_buffer, us_length);
 	} else if ((puc_dest_extended_addr[0] == ((uint8_t)(g_st_config.us_pan_id >> 8))) &&
 			(puc_dest_extended_addr[1] == ((uint8_t)(g_st_config.us_pan_id)))) {
 		/* ULA 2nd address,LL Address. */
@@ -874,9 +1435,8 @@ int  adp_send_ipv6_message(uint8_t *puc_buffer, uint16_t us_length)
 		us_short_addr += puc_dest_extended_addr[7];
 		/* Verify if this short address was registered before */
 		if (bs_get_ext_addr_by_short(us_short_addr, puc_dest_extended_addr) == true) {
-			/* AdpSetRequestSync(ADP_IB_MANUF_IPV6_ULA_DEST_SHORT_ADDRESS, 0, sizeof(us_short_addr),(uint8_t*)&us_short_addr, &pSetConfirm); */
-			/* AdpSetRequest(ADP_IB_MANUF_IPV6_ULA_DEST_SHORT_ADDRESS, 0, sizeof(us_short_addr),(uint8_t*)&us_short_addr); */
-			AdpDataRequest(us_length, puc_buffer, uc_nsdu_handle++, true, 0x00);
+			/* Destination short address is taken from IPv6 address by ADP */
+			return adp_tx_enqueue(us_short_addr, false, puc_buffer, us_length);
 		} else {
 			LOG_ERR(Log("Short Address 0x%X not registered\r\n", us_short_addr));
 		}
@@ -884,10 +1444,7 @@ int  adp_send_ipv6_message(uint8_t *puc_buffer, uint16_t us_length)
 		return 0;
 	} else if ((puc_buffer[24] == 0xFF)  && (puc_buffer[25] == 0x02)) {
 		/* Multicast, Link local scope */
-		us_short_addr = 0xFFFF;
-		/* AdpSetRequestSync(ADP_IB_MANUF_IPV6_ULA_DEST_SHORT_ADDRESS, 0, sizeof(us_short_addr),(uint8_t*)&us_short_addr, &pSetConfirm); */
-		AdpSetRequest(ADP_IB_MANUF_IPV6_ULA_DEST_SHORT_ADDRESS, 0, sizeof(us_short_addr), (uint8_t *)&us_short_addr);
-		AdpDataRequest(us_length, puc_buffer, uc_nsdu_handle++, true, 0x00);
+		return adp_tx_enqueue(0xFFFF, true, puc_buffer, us_length);
 	} else {
 		LOG_ERR(Log(stderr, "DEST IP ADDRESS not in BS database!"));
 		return -2;
@@ -36,7 +36,37 @@
 
 #define G3_ADP_MAX_DATA_LENTHG 1280
 
-#define NETWORK_START_TIMEOUT 5
+/* Time to wait for the network start confirm before resetting the modem */
+#define NETWORK_START_TIMEOUT_MS 10000
+
+/* Downstream (TUN to ADP) forwarding window */
+/* Max. AdpDataRequest waiting for AdpDataConfirm */
+#define ADP_TX_WINDOW               8
+/* Max. AdpDataRequest waiting for confirm to the same destination */
+#define ADP_TX_DEST_IN_FLIGHT       1
+/* Max. destinations with queued or in flight packets */
+#define ADP_TX_MAX_DESTS            32
+/* Max. packets queued to the same destination, newer ones are dropped */
+#define ADP_TX_DEST_QUEUE_DEPTH     4
+/* Packets buffered for all destinations */
+#define ADP_TX_POOL_SIZE            64
+/* In flight requests without confirm are released after this time */
+#define ADP_TX_CONFIRM_TIMEOUT_MS   20000
+/* NSDU handle of a timed out request is not reused until its late confirm */
+/* arrives or this time expires, so the confirm can't complete a newer request */
+#define ADP_TX_HANDLE_QUARANTINE_MS 60000
+
+/* Upstream (ADP to TUN) */
+/* NSDUs kept in their USI frame while the TUN queue is full, newer ones are */
+/* dropped. Every one holds a USI RX frame slot, so keep it under USI_RX_FRAME_SLOTS */
+#define ADP_RX_PENDING_NSDUS        2
+
+/* ADP buffers state for other processes, Unix datagram socket in abstract */
+/* namespace, named "<ADP_FLOW_STATUS_SOCKET>-<tun device>". A datagram from */
+/* a bound socket is answered with the state (1 byte, 1: buffers ready) and */
+/* its sender gets every later change. Undefine to disable. */
+#define ADP_FLOW_STATUS_SOCKET      "g3coordd-adp-flow"
+#define ADP_FLOW_MAX_SUBSCRIBERS    4
 
 
 /* Activate APP debug */
@@ -68,7 +98,15 @@ void adp_init(uint8_t uc_plc_band, uint16_t us_panid, uint8_t *puc_ipaddr, uint8
 void adp_process(uint8_t uc_plc_band, uint16_t us_panid);
 
 bool adp_write_buffers_available();
+bool adp_tx_queue_available(void);
 int  adp_send_ipv6_message(uint8_t *buffer, uint16_t length);
+void adp_tx_process(void);
+int  adp_tx_event_fd(void);
+void adp_tx_event_clear(void);
+int  adp_flow_status_fd(void);
+void adp_flow_status_process(void);
+bool adp_rx_pending(void);
+void adp_rx_process(void);
 
 uint16_t app_update_registered_nodes(void *pxNodeList);
 
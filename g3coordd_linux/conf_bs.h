@@ -37,6 +37,12 @@
 /* PAN ID */
 #define G3_COORDINATOR_PAN_ID 0x781D
 #define MAX_LBDS  2000
+/* Max. parallel bootstrap procedures */
+#define BOOTSTRAP_MAX_SLOTS  MAX_LBDS
+/* Max. devices rekeyed in parallel (default of LBP_IB_REKEY_MAX_PARALLEL) */
+#define BS_REKEY_MAX_PARALLEL  16
+/* Max. sum of LBP hops of devices rekeyed in parallel */
+#define BS_REKEY_MAX_HOPS_IN_FLIGHT  48
 #define LBS_INVALID_SHORT_ADDRESS 0
 #define INITIAL_KEY_INDEX 0
 
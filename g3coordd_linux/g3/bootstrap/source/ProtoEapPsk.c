@@ -95,6 +95,9 @@ void EAP_PSK_Initialize(const struct TEapPskKey *pKey, struct TEapPskContext *pP
 
 	/* Free the AES */
 	aes_wrapper_aes_free(&aes_eap_ctx);
+
+	/* AK is used for the MACs of every message of the session */
+	cipher_wrapper_aes_cmac_setkey(&pPskContext->m_AkCmac, pPskContext->m_Ak.m_au8Value, 8 * sizeof(pPskContext->m_Ak.m_au8Value));
 }
 
 /**********************************************************************************************************************/
@@ -121,6 +124,9 @@ void EAP_PSK_InitializeTEK(const struct TEapPskRand *pRandP, struct TEapPskConte
 
 	/* Free the AES */
 	aes_wrapper_aes_free(&aes_eap_ctx);
+
+	/* TEK protects the P-Channel of messages 3 and 4 */
+	pPskContext->m_bTekKeyed = (eax_init_and_key(pPskContext->m_Tek.m_au8Value, sizeof(pPskContext->m_Tek.m_au8Value), pPskContext->m_TekEax) == RETURN_GOOD);
 }
 
 /**********************************************************************************************************************/
@@ -179,7 +185,7 @@ bool EAP_PSK_Decode_Message1(uint16_t u16MessageLength, uint8_t *pMessage, struc
 
 /** The EAP_PSK_Encode_Message2 primitive is used to encode the second EAP-PSK message (type 1)
  **********************************************************************************************************************/
-uint16_t EAP_PSK_Encode_Message2(const struct TEapPskContext *pPskContext, uint8_t u8Identifier,
+uint16_t EAP_PSK_Encode_Message2(struct TEapPskContext *pPskContext, uint8_t u8Identifier,
 		const struct TEapPskRand *pRandS, const struct TEapPskRand *pRandP, const struct TEapPskNetworkAccessIdentifier *pIdS,
 		const struct TEapPskNetworkAccessIdentifier *pIdP, uint16_t u16MemoryBufferLength, uint8_t *pMemoryBuffer)
 {
@@ -187,24 +193,12 @@ uint16_t EAP_PSK_Encode_Message2(const struct TEapPskContext *pPskContext, uint8
 
 	/* check the size of the buffer */
 	if (u16MemoryBufferLength >= 62) {
-		int16_t ret;
 		/* compute first MacP = CMAC-AES-128(AK, IdP||IdS||RandS||RandP) */
 		uint8_t au8MacP[16];
 		uint8_t au8Seed[2 * member_size(struct TEapPskNetworkAccessIdentifier, m_au8Value)
 		+ 2 * member_size(struct TEapPskRand, m_au8Value)];
 		uint16_t u16SeedUsedSize = 0;
 
-		cipher_wrapper_cipher_context_t m_ctx;
-		const cipher_wrapper_cipher_info_t *cipher_info;
-		/* Initialize CMAC */
-		cipher_info = cipher_wrapper_cipher_info_from_type(CIPHER_WRAPPER_CIPHER_AES_128_ECB);
-		if (cipher_info == NULL) {
-			LOG_DBG(Log("\ncipher_wrapper_cipher_info_from_type failed"));
-		}
-
-		ret = cipher_wrapper_cipher_setup( &m_ctx, cipher_info );
-		LOG_DBG(Log("\n cipher_wrapper_cipher_setup returned %d %d", ret, m_ctx.cipher_info->type));
-
 		memcpy(au8Seed, pIdP->m_au8Value, pIdP->m_u8Length);
 		u16SeedUsedSize += pIdP->m_u8Length;
 
@@ -217,19 +211,8 @@ uint16_t EAP_PSK_Encode_Message2(const struct TEapPskContext *pPskContext, uint8
 		memcpy(&au8Seed[u16SeedUsedSize], pRandP->m_au8Value, sizeof(pRandP->m_au8Value));
 		u16SeedUsedSize += sizeof(pRandP->m_au8Value);
 
-		ret = cipher_wrapper_cipher_cmac_starts(&m_ctx, pPskContext->m_Ak.m_au8Value, 8 * sizeof(pPskContext->m_Ak.m_au8Value));
-		LOG_DBG(Log("\n cipher_wrapper_cipher_cmac_starts returned %d", ret));
-
-		ret = cipher_wrapper_cipher_cmac_update(&m_ctx, au8Seed, u16SeedUsedSize);
-		LOG_DBG(Log("\n cipher_wrapper_cipher_cmac_update returned %d", ret));
-
-		ret = cipher_wrapper_cipher_cmac_finish(&m_ctx, au8MacP);
-		LOG_DBG(Log("\n cipher_wrapper_cipher_cmac_finish returned %d", ret));
-
-		ret = cipher_wrapper_cipher_cmac_reset(&m_ctx);
-		LOG_DBG(Log("\n cipher_wrapper_cipher_cmac_reset returned %d", ret));
-
-		cipher_wrapper_cipher_free( &m_ctx);
+		/* AK CMAC context of the session */
+		cipher_wrapper_aes_cmac(&pPskContext->m_AkCmac, au8Seed, u16SeedUsedSize, au8MacP);
 
 		LOG_DBG(LogBuffer(pPskContext->m_Ak.m_au8Value, sizeof(pPskContext->m_Ak.m_au8Value), "Seed "));
 		LOG_DBG(LogBuffer(au8Seed, u16SeedUsedSize, "Seed "));
@@ -255,8 +238,6 @@ uint16_t EAP_PSK_Encode_Message2(const struct TEapPskContext *pPskContext, uint8
 		/* now update the EAP header length field */
 		pMemoryBuffer[2] = (uint8_t)((u16Ret >> 8) & 0x00FF);
 		pMemoryBuffer[3] = (uint8_t)(u16Ret & 0x00FF);
-
-		UNUSED(ret);
 	}
 
 	return u16Ret;
@@ -266,7 +247,7 @@ uint16_t EAP_PSK_Encode_Message2(const struct TEapPskContext *pPskContext, uint8
 
 /** The EAP_PSK_Decode_Message3 primitive is used to decode the third EAP-PSK message (type 2)
  **********************************************************************************************************************/
-bool EAP_PSK_Decode_Message3(uint16_t u16MessageLength, uint8_t *pMessage, const struct TEapPskContext *pPskContext,
+bool EAP_PSK_Decode_Message3(uint16_t u16MessageLength, uint8_t *pMessage, struct TEapPskContext *pPskContext,
 		uint16_t u16HeaderLength, uint8_t *pHeader, struct TEapPskRand *pRandS, uint32_t *pu32Nonce,
 		uint8_t *pu8PChannelResult, uint16_t *pu16PChannelDataLength, uint8_t **pPChannelData)
 {
@@ -274,8 +255,6 @@ bool EAP_PSK_Decode_Message3(uint16_t u16MessageLength, uint8_t *pMessage, const
 
 	if (u16MessageLength >= 59) {
 		uint8_t au8MacS[16];
-		eax_ctx eaxCtx[1];
-		int16_t ret;
 
 		memcpy(pRandS->m_au8Value, pMessage, sizeof(pRandS->m_au8Value));
 
@@ -284,42 +263,19 @@ bool EAP_PSK_Decode_Message3(uint16_t u16MessageLength, uint8_t *pMessage, const
 		+ member_size(struct TEapPskRand, m_au8Value)];
 		uint16_t u16SeedUsedSize = 0;
 
-		cipher_wrapper_cipher_context_t m_ctx;
-		const cipher_wrapper_cipher_info_t *cipher_info;
-		/* Initialize CMAC */
-		cipher_info = cipher_wrapper_cipher_info_from_type(CIPHER_WRAPPER_CIPHER_AES_128_ECB);
-		if (cipher_info == NULL) {
-			LOG_DBG(Log("\ncipher_wrapper_cipher_info_from_type failed"));
-		}
-
-		ret = cipher_wrapper_cipher_setup( &m_ctx, cipher_info );
-		LOG_DBG(Log("\n cipher_wrapper_cipher_setup returned %d %d", ret, m_ctx.cipher_info->type));
-
 		memcpy(au8Seed, pPskContext->m_IdS.m_au8Value, pPskContext->m_IdS.m_u8Length);
 		u16SeedUsedSize += pPskContext->m_IdS.m_u8Length;
 
 		memcpy(&au8Seed[u16SeedUsedSize], pPskContext->m_RandP.m_au8Value, sizeof(pPskContext->m_RandP.m_au8Value));
 		u16SeedUsedSize += sizeof(pPskContext->m_RandP.m_au8Value);
 
-		ret = cipher_wrapper_cipher_cmac_starts(&m_ctx, pPskContext->m_Ak.m_au8Value, 8 * sizeof(pPskContext->m_Ak.m_au8Value));
-		LOG_DBG(Log("\n cipher_wrapper_cipher_cmac_starts returned %d", ret));
-
-		ret = cipher_wrapper_cipher_cmac_update(&m_ctx, au8Seed, u16SeedUsedSize);
-		LOG_DBG(Log("\n cipher_wrapper_cipher_cmac_update returned %d", ret));
-
-		ret = cipher_wrapper_cipher_cmac_finish(&m_ctx, au8MacS);
-		LOG_DBG(Log("\n cipher_wrapper_cipher_cmac_finish returned %d", ret));
-
-		ret = cipher_wrapper_cipher_cmac_reset(&m_ctx);
-		LOG_DBG(Log("\n cipher_wrapper_cipher_cmac_reset returned %d", ret));
-
-		cipher_wrapper_cipher_free( &m_ctx);
+		/* AK CMAC context of the session */
+		cipher_wrapper_aes_cmac(&pPskContext->m_AkCmac, au8Seed, u16SeedUsedSize, au8MacS);
 
 		if (memcmp(au8MacS, &pMessage[sizeof(pRandS->m_au8Value)], sizeof(au8MacS)) == 0) {
 			/* decrypt P-CHANNEL */
 			/* P-CHANNEL uses the TEK key */
-			if (RETURN_GOOD
-					== eax_init_and_key(pPskContext->m_Tek.m_au8Value, sizeof(pPskContext->m_Tek.m_au8Value), eaxCtx)) {
+			if (pPskContext->m_bTekKeyed) {
 				uint8_t au8Nonce[16];
 				uint8_t *pNonce = &pMessage[32];
 				uint8_t *pTag = &pMessage[36];
@@ -359,7 +315,7 @@ bool EAP_PSK_Decode_Message3(uint16_t u16MessageLength, uint8_t *pMessage, const
 						u16ProtectedDataLength, /* and its length in bytes      */
 						pTag, /* the buffer for the tag       */
 						16, /* and its length in bytes      */
-						eaxCtx) /* the mode context             */
+						pPskContext->m_TekEax) /* the mode context             */
 						) {
 					/* retrieve protected parameters */
 					/* uint8_t u8ExtField = ((pProtectedData[0] & 0x20) >> 5); */
@@ -382,11 +338,7 @@ bool EAP_PSK_Decode_Message3(uint16_t u16MessageLength, uint8_t *pMessage, const
 
 				/* Fix EAP header: left shift Code field with 2 bits as indicated in the G3 specification */
 				pHeader[0] <<= 2;
-
-				eax_end(eaxCtx);
 			}
-
-			UNUSED(ret);
 		} else {
 			/* cannot verify MacS */
 			LOG_ERR(Log("Cannot verify MAC_S"));
@@ -400,7 +352,7 @@ bool EAP_PSK_Decode_Message3(uint16_t u16MessageLength, uint8_t *pMessage, const
 
 /** The EAP_PSK_Encode_Message4 primitive is used to encode the second EAP-PSK message (type 3)
  **********************************************************************************************************************/
-uint16_t EAP_PSK_Encode_Message4(const struct TEapPskContext *pPskContext, uint8_t u8Identifier,
+uint16_t EAP_PSK_Encode_Message4(struct TEapPskContext *pPskContext, uint8_t u8Identifier,
 		const struct TEapPskRand *pRandS, uint32_t u32Nonce, uint8_t u8PChannelResult, uint16_t u16PChannelDataLength,
 		uint8_t *pPChannelData, uint16_t u16MemoryBufferLength, uint8_t *pMemoryBuffer)
 {
@@ -409,7 +361,6 @@ uint16_t EAP_PSK_Encode_Message4(const struct TEapPskContext *pPskContext, uint8
 	/* check the size of the buffer */
 	if (u16MemoryBufferLength >= 43 + u16PChannelDataLength) {
 		uint8_t *pTag = 0L;
-		eax_ctx eaxCtx[1];
 		uint8_t au8Nonce[16];
 		uint8_t *pProtectedData = 0L;
 		uint16_t u16ProtectedDataLength = 0;
@@ -458,7 +409,7 @@ uint16_t EAP_PSK_Encode_Message4(const struct TEapPskContext *pPskContext, uint8
 
 		/* protect data in P-Channel (actually it's just the last byte) */
 		/* P-CHANNEL uses the TEK key */
-		if (RETURN_GOOD == eax_init_and_key(pPskContext->m_Tek.m_au8Value, sizeof(pPskContext->m_Tek.m_au8Value), eaxCtx)) {
+		if (pPskContext->m_bTekKeyed) {
 			/* update the EAP header length field */
 			pMemoryBuffer[2] = (uint8_t)((u16Ret >> 8) & 0x00FF);
 			pMemoryBuffer[3] = (uint8_t)(u16Ret & 0x00FF);
@@ -486,7 +437,7 @@ uint16_t EAP_PSK_Encode_Message4(const struct TEapPskContext *pPskContext, uint8
 					u16ProtectedDataLength, /* and its length in bytes      */
 					pTag, /* the buffer for the tag       */
 					16, /* and its length in bytes      */
-					eaxCtx) /* the mode context             */
+					pPskContext->m_TekEax) /* the mode context             */
 					) {
 				u16Ret = 0;
 			}
@@ -496,8 +447,6 @@ uint16_t EAP_PSK_Encode_Message4(const struct TEapPskContext *pPskContext, uint8
 
 			/* Fix EAP header: left shift Code field with 2 bits as indicated in the G3 specification */
 			pMemoryBuffer[0] <<= 2;
-
-			eax_end(eaxCtx);
 		} else {
 			u16Ret = 0;
 		}
@@ -570,7 +519,7 @@ bool EAP_PSK_Decode_Message2(
 		uint8_t u8BandId,
 		uint16_t u16MessageLength,
 		uint8_t *pMessage,
-		const struct TEapPskContext *pPskContext,
+		struct TEapPskContext *pPskContext,
 		const struct TEapPskNetworkAccessIdentifierS *pIdS,
 		struct TEapPskRand *pRandS,
 		struct TEapPskRand *pRandP
@@ -598,7 +547,6 @@ bool EAP_PSK_Decode_Message2(
 		uint8_t au8MacP[16];
 		uint8_t au8ExpectedMacP[16];
 		struct TEapPskNetworkAccessIdentifierP idP;
-		int16_t ret;
 
 		/* if (x_pib_value.m_au8Value[0] == MAC_WRP_BAND_ARIB) { */
 		/*  // In ARIB, ID_P can be range between 8 and 36 bytes, its length depends on the message length */
@@ -618,17 +566,6 @@ bool EAP_PSK_Decode_Message2(
 		uint16_t u16DecodeOffset = 0;
 		uint16_t u16SeedOffset = 0;
 
-		cipher_wrapper_cipher_context_t m_ctx;
-		const cipher_wrapper_cipher_info_t *cipher_info;
-		/* Initialize CMAC */
-		cipher_info = cipher_wrapper_cipher_info_from_type(CIPHER_WRAPPER_CIPHER_AES_128_ECB);
-		if (cipher_info == NULL) {
-			LOG_DBG(Log("\ncipher_wrapper_cipher_info_from_type failed"));
-		}
-
-		ret = cipher_wrapper_cipher_setup( &m_ctx, cipher_info );
-		LOG_DBG(Log("\n cipher_wrapper_cipher_setup returned %d", ret));
-
 		memcpy(pRandS->m_au8Value, &pMessage[u16DecodeOffset], sizeof(pRandS->m_au8Value));
 		u16DecodeOffset += sizeof(pRandS->m_au8Value);
 
@@ -654,26 +591,13 @@ bool EAP_PSK_Decode_Message2(
 		memcpy(&au8Seed[u16SeedOffset], pRandP->m_au8Value, sizeof(pRandP->m_au8Value));
 		u16SeedOffset += sizeof(pRandP->m_au8Value);
 
-		ret = cipher_wrapper_cipher_cmac_starts(&m_ctx, pPskContext->m_Ak.m_au8Value, 8 * sizeof(pPskContext->m_Ak.m_au8Value));
-		LOG_DBG(Log("\n cipher_wrapper_cipher_cmac_starts returned %d", ret));
-
-		ret = cipher_wrapper_cipher_cmac_update(&m_ctx, au8Seed, au8Seed_size);
-		LOG_DBG(Log("\n cipher_wrapper_cipher_cmac_update returned %d", ret));
-
-		ret = cipher_wrapper_cipher_cmac_finish(&m_ctx, au8ExpectedMacP);
-		LOG_DBG(Log("\n cipher_wrapper_cipher_cmac_finish returned %d", ret));
-
-		ret = cipher_wrapper_cipher_cmac_reset(&m_ctx);
-		LOG_DBG(Log("\n cipher_wrapper_cipher_cmac_reset returned %d", ret));
-
-		cipher_wrapper_cipher_free( &m_ctx);
+		/* AK CMAC context of the session */
+		cipher_wrapper_aes_cmac(&pPskContext->m_AkCmac, au8Seed, au8Seed_size, au8ExpectedMacP);
 
 		LOG_DBG(Log("\n u16DecodeOffset: %d, u16SeedOffset: %d, au8Seed_size: %d, idP.uc_size: %d, pIdS->uc_size: %d\n", u16DecodeOffset, u16SeedOffset, au8Seed_size,
 				idP.uc_size, pIdS->uc_size));
 
 		bRet = (memcmp(au8ExpectedMacP, au8MacP, sizeof(au8MacP)) == 0);
-
-		UNUSED(ret);
 	}
 
 	return bRet;
@@ -686,7 +610,7 @@ bool EAP_PSK_Decode_Message2(
  *
  **********************************************************************************************************************/
 uint16_t EAP_PSK_Encode_Message3(
-		const struct TEapPskContext *pPskContext,
+		struct TEapPskContext *pPskContext,
 		uint8_t u8Identifier,
 		const struct TEapPskRand *pRandS,
 		const struct TEapPskRand *pRandP,
@@ -704,46 +628,20 @@ uint16_t EAP_PSK_Encode_Message3(
 	/* check the size of the buffer */
 	if (u16MemoryBufferLength >= 59 + u16PChannelDataLength) {
 		/* compute first MAC_S = CMAC-AES-128(AK, ID_S||RAND_P) */
-		eax_ctx eaxCtx[1];
 		uint8_t au8MacS[16];
 		uint8_t *pProtectedData = 0L;
 		uint16_t u16ProtectedDataLength = 0;
 		uint8_t *pTag = 0L;
 		uint8_t au8Nonce[16];
-		int16_t ret;
 
 		uint8_t au8Seed[NETWORK_ACCESS_IDENTIFIER_MAX_SIZE_S + member_size(struct TEapPskRand, m_au8Value)];
 		uint8_t au8Seed_size = pIdS->uc_size + member_size(struct TEapPskRand, m_au8Value);
 
-		cipher_wrapper_cipher_context_t m_ctx;
-		const cipher_wrapper_cipher_info_t *cipher_info;
-		/* Initialize CMAC */
-		cipher_info = cipher_wrapper_cipher_info_from_type(CIPHER_WRAPPER_CIPHER_AES_128_ECB);
-		if (cipher_info == NULL) {
-			LOG_DBG(Log("\ncipher_wrapper_cipher_info_from_type failed"));
-		}
-
-		ret = cipher_wrapper_cipher_setup( &m_ctx, cipher_info );
-		LOG_DBG(Log("\n cipher_wrapper_cipher_setup returned %d %d", ret, m_ctx.cipher_info->type));
-
 		memcpy(au8Seed, pIdS->m_au8Value, pIdS->uc_size);
 		memcpy(&au8Seed[pIdS->uc_size], pRandP->m_au8Value, sizeof(pRandP->m_au8Value));
 
-		ret = cipher_wrapper_cipher_cmac_starts(&m_ctx, pPskContext->m_Ak.m_au8Value, 8 * sizeof(pPskContext->m_Ak.m_au8Value));
-		LOG_DBG(Log("\n cipher_wrapper_cipher_cmac_starts returned %d", ret));
-
-		ret = cipher_wrapper_cipher_cmac_update(&m_ctx, au8Seed, au8Seed_size);
-		LOG_DBG(Log("\n cipher_wrapper_cipher_cmac_update returned %d", ret));
-
-		ret = cipher_wrapper_cipher_cmac_finish(&m_ctx, au8MacS);
-		LOG_DBG(Log("\n cipher_wrapper_cipher_cmac_finish returned %d", ret));
-
-		ret = cipher_wrapper_cipher_cmac_reset(&m_ctx);
-		LOG_DBG(Log("\n cipher_wrapper_cipher_cmac_reset returned %d", ret));
-
-		UNUSED(ret);
-
-		cipher_wrapper_cipher_free( &m_ctx);
+		/* AK CMAC context of the session */
+		cipher_wrapper_aes_cmac(&pPskContext->m_AkCmac, au8Seed, au8Seed_size, au8MacS);
 
 		/* encode the EAP header; length field will be set at the end of the block */
 		pMemoryBuffer[0] = EAP_REQUEST;
@@ -790,7 +688,7 @@ uint16_t EAP_PSK_Encode_Message3(
 		u16Ret += u16ProtectedDataLength;
 
 		/* encrypt P-Channel using TEK key */
-		if (RETURN_GOOD == eax_init_and_key(pPskContext->m_Tek.m_au8Value, sizeof(pPskContext->m_Tek.m_au8Value), eaxCtx)) {
+		if (pPskContext->m_bTekKeyed) {
 			/* now update the EAP header length field */
 			pMemoryBuffer[2] = (uint8_t)((u16Ret >> 8) & 0x00FF);
 			pMemoryBuffer[3] = (uint8_t)(u16Ret & 0x00FF);
@@ -810,7 +708,6 @@ uint16_t EAP_PSK_Encode_Message3(
 			LOG_DBG(LogBuffer(au8Nonce, 16, "Nonce/IV: "));
 			LOG_DBG(LogBuffer(pMemoryBuffer, 22, "Header: "));
 			LOG_DBG(LogBuffer(pProtectedData, u16ProtectedDataLength, "Data-plain: "));
-			LOG_DBG(LogBuffer(eaxCtx, sizeof(eaxCtx), "EaxCtx: "));
 
 			if (RETURN_GOOD != eax_encrypt_message(
 					au8Nonce, /* the initialization vector    */
@@ -821,7 +718,7 @@ uint16_t EAP_PSK_Encode_Message3(
 					u16ProtectedDataLength, /* and its length in bytes      */
 					pTag, /* the buffer for the tag       */
 					16, /* and its length in bytes      */
-					eaxCtx) /* the mode context             */
+					pPskContext->m_TekEax) /* the mode context             */
 					) {
 				u16Ret = 0;
 			}
@@ -831,8 +728,6 @@ uint16_t EAP_PSK_Encode_Message3(
 
 			/* Fix EAP header: left shift Code field with 2 bits as indicated in the G3 specification */
 			pMemoryBuffer[0] <<= 2;
-
-			eax_end(eaxCtx);
 		} else {
 			u16Ret = 0;
 		}
@@ -850,7 +745,7 @@ uint16_t EAP_PSK_Encode_Message3(
 bool EAP_PSK_Decode_Message4(
 		uint16_t u16MessageLength,
 		uint8_t *pMessage,
-		const struct TEapPskContext *pPskContext,
+		struct TEapPskContext *pPskContext,
 		uint16_t u16HeaderLength,
 		uint8_t *pHeader,
 		struct TEapPskRand *pRandS,
@@ -864,13 +759,11 @@ bool EAP_PSK_Decode_Message4(
 
 	/* TODO: review size (ARIB) */
 	if (u16MessageLength >= 41) {
-		eax_ctx eaxCtx[1];
-
 		memcpy(pRandS->m_au8Value, pMessage, sizeof(pRandS->m_au8Value));
 
 		/* decrypt P-CHANNEL */
 		/* P-CHANNEL uses the TEK key */
-		if (RETURN_GOOD == eax_init_and_key(pPskContext->m_Tek.m_au8Value, sizeof(pPskContext->m_Tek.m_au8Value), eaxCtx)) {
+		if (pPskContext->m_bTekKeyed) {
 			uint8_t au8Nonce[16];
 			uint8_t *pNonce = &pMessage[16];
 			uint8_t *pTag = &pMessage[20];
@@ -911,7 +804,7 @@ bool EAP_PSK_Decode_Message4(
 					u16ProtectedDataLength, /* and its length in bytes      */
 					pTag, /* the buffer for the tag       */
 					16, /* and its length in bytes      */
-					eaxCtx) /* the mode context             */
+					pPskContext->m_TekEax) /* the mode context             */
 					) {
 				LOG_DBG(Log("Decode SUCCESS"));
 				/* retrieve protected parameters */
@@ -934,8 +827,6 @@ bool EAP_PSK_Decode_Message4(
 
 			/* Fix EAP header: left shift Code field with 2 bits as indicated in the G3 specification */
 			pHeader[0] <<= 2;
-
-			eax_end(eaxCtx);
 		}
 	}
 
@@ -51,8 +51,8 @@ extern "C" {
 #include <ProtoLbp.h>
 #include <ProtoEapPsk.h>
 
-#include "bs_functions.h"
 #include "bs_api.h"
+#include "bs_functions.h"
 #include "conf_bs.h"
 
 #include <oss_if.h>
@@ -64,33 +64,75 @@ extern "C" {
 
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
 
 /* unsigned char m_Data[400]; */
 /* unsigned short m_u16Length; */
 
-uint8_t uc_nsdu_handle = 0;
+/* Bootstrap state is changed from USI callbacks (LBP indications and confirms,
+ * buffer indications) and from the PAN loop (slot timeouts, queued messages).
+ * Every PAN has its own state and lock.
+ * Recursive: application callbacks run with it taken and read back the state */
+static PAN_LOCAL pthread_mutex_t sx_bs_mutex;
+static PAN_LOCAL pthread_once_t sx_bs_mutex_once = PTHREAD_ONCE_INIT;
+
+PAN_LOCAL uint8_t uc_nsdu_handle = 0;
 
-bool m_bRekey;
+PAN_LOCAL bool m_bRekey;
 
-static bool bGetShortAddressFromExtended;
+static PAN_LOCAL bool bGetShortAddressFromExtended;
 
-static uint16_t us_msg_timeout_in_s = 40;
+static PAN_LOCAL uint16_t us_msg_timeout_in_s = 40;
 
-uint16_t us_blacklist_size = 0;
-uint8_t puc_blacklist[MAX_LBDS][ADP_ADDRESS_64BITS];
+PAN_LOCAL uint16_t us_blacklist_size = 0;
+PAN_LOCAL uint8_t puc_blacklist[MAX_LBDS][ADP_ADDRESS_64BITS];
 
-t_context g_current_context;
+PAN_LOCAL t_context g_current_context;
 
-t_bootstrap_slot bootstrap_slots[BOOTSTRAP_NUM_SLOTS];
+/* Bootstrap slots pool, allocated on demand in chunks. Chunks are never freed, so slot pointers stay valid */
+#define BOOTSTRAP_NO_SLOT 0xFFFF
+#define BOOTSTRAP_SLOTS_CHUNKS ((BOOTSTRAP_MAX_SLOTS + BOOTSTRAP_SLOTS_CHUNK - 1) / BOOTSTRAP_SLOTS_CHUNK)
+static PAN_LOCAL t_bootstrap_slot *bootstrap_slot_chunks[BOOTSTRAP_SLOTS_CHUNKS];
+static PAN_LOCAL uint16_t us_bootstrap_slots_allocated = 0;
+static PAN_LOCAL uint16_t us_bootstrap_slots_free = BOOTSTRAP_NO_SLOT;
+
+/* Extended address index of slots in use */
+#define BOOTSTRAP_SLOTS_HASH_SIZE 4096
+#if (BOOTSTRAP_SLOTS_HASH_SIZE < 2 * BOOTSTRAP_MAX_SLOTS)
+  #error "BOOTSTRAP_SLOTS_HASH_SIZE must be at least twice BOOTSTRAP_MAX_SLOTS"
+#endif
+static PAN_LOCAL uint16_t bootstrap_slots_hash[BOOTSTRAP_SLOTS_HASH_SIZE];
+
+/* Slot waiting for confirm of every NSDU handle (slot index + 1, 0 if none) */
+static PAN_LOCAL uint16_t bootstrap_handle_slot[256];
+static PAN_LOCAL uint16_t us_bootstrap_pending_lbp = 0;
+
+/* Slots with a message waiting to be sent */
+static PAN_LOCAL uint16_t us_bootstrap_tx_head = BOOTSTRAP_NO_SLOT;
+static PAN_LOCAL uint16_t us_bootstrap_tx_tail = BOOTSTRAP_NO_SLOT;
+static PAN_LOCAL uint16_t us_bootstrap_tx_count = 0;
+static PAN_LOCAL bool b_bootstrap_tx_ready = true;
+
+/* Slot timeouts, binary min-heap. Entries are not removed when a slot timeout
+ * changes, stale ones are discarded when they expire */
+typedef struct {
+	uint32_t ul_timeout;
+	uint16_t us_slot;
+} t_bootstrap_timer;
+
+static PAN_LOCAL t_bootstrap_timer *bootstrap_timers = NULL;
+static PAN_LOCAL uint32_t ul_bootstrap_timers_count = 0;
+static PAN_LOCAL uint32_t ul_bootstrap_timers_size = 0;
 #ifdef BS_LEVEL_STRATEGY_ENABLED
-uint32_t ul_level_startegy_timeout = 0;
-uint8_t uc_level_startegy_last_level_reg = 0;
+PAN_LOCAL uint32_t ul_level_startegy_timeout = 0;
+PAN_LOCAL uint8_t uc_level_startegy_last_level_reg = 0;
 #endif
-static struct TEapPskKey g_EapPskKey = {
+static PAN_LOCAL struct TEapPskKey g_EapPskKey = {
 	{0xAB, 0x10, 0x34, 0x11, 0x45, 0x11, 0x1B, 0xC3, 0xC1, 0x2D, 0xE8, 0xFF, 0x11, 0x14, 0x22, 0x04}
 };
 
-struct TEapPskNetworkAccessIdentifierS g_IdS;
+PAN_LOCAL struct TEapPskNetworkAccessIdentifierS g_IdS;
 
 const struct TEapPskNetworkAccessIdentifierS x_ids_arib = { NETWORK_ACCESS_IDENTIFIER_SIZE_S_ARIB,
 							    {0x53, 0x4D, 0xAD, 0xB2, 0xC4, 0xD5, 0xE6, 0xFA, 0x53, 0x4D, 0xAD, 0xB2, 0xC4, 0xD5, 0xE6, 0xFA,
@@ -100,20 +142,33 @@ const struct TEapPskNetworkAccessIdentifierS x_ids_arib = { NETWORK_ACCESS_IDENT
 const struct TEapPskNetworkAccessIdentifierS x_ids_cenelec_fcc = { NETWORK_ACCESS_IDENTIFIER_SIZE_S_CENELEC_FCC,
 								   {0x81, 0x72, 0x63, 0x54, 0x45, 0x36, 0x27, 0x18} };
 
-static uint8_t g_au8CurrKeyIndex = 0;
-static uint8_t g_au8CurrGMK[16]  = {0xAF, 0x4D, 0x6D, 0xCC, 0xF1, 0x4D, 0xE7, 0xC1, 0xC4, 0x23, 0x5E, 0x6F, 0xEF, 0x6C, 0x15, 0x1F};
-static uint8_t g_au8RekeyGMK[16] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16};
+static PAN_LOCAL uint8_t g_au8CurrKeyIndex = 0;
+static PAN_LOCAL uint8_t g_au8CurrGMK[16]  = {0xAF, 0x4D, 0x6D, 0xCC, 0xF1, 0x4D, 0xE7, 0xC1, 0xC4, 0x23, 0x5E, 0x6F, 0xEF, 0x6C, 0x15, 0x1F};
+static PAN_LOCAL uint8_t g_au8RekeyGMK[16] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16};
 
-static TBootstrapConfiguration g_s_bs_conf;
+static PAN_LOCAL TBootstrapConfiguration g_s_bs_conf;
 /************************************************************************************/
 
 /** LBDs table
  ************************************************************************************/
 /* LBDs table */
-lbds_list_entry_t g_lbds_list[MAX_LBDS];
+PAN_LOCAL lbds_list_entry_t g_lbds_list[MAX_LBDS];
 /* Active LBDs counter */
-static uint16_t g_lbds_counter = 0;
-static uint16_t g_lbds_list_size = 0;
+static PAN_LOCAL uint16_t g_lbds_counter = 0;
+static PAN_LOCAL uint16_t g_lbds_list_size = 0;
+
+/* Extended address indexes, see _eui64_hash_find() */
+#define EUI64_HASH_EMPTY 0
+typedef const uint8_t *(*pf_eui64_key_t)(uint16_t us_position);
+
+/* Extended address index of LBDs table */
+#define LBDS_HASH_SIZE 4096
+
+#if (LBDS_HASH_SIZE < 2 * MAX_LBDS)
+  #error "LBDS_HASH_SIZE must be at least twice MAX_LBDS"
+#endif
+
+static PAN_LOCAL uint16_t g_lbds_hash[LBDS_HASH_SIZE];
 
 /************************************************************************************/
 
@@ -174,6 +229,83 @@ bool is_null_address(uint8_t *puc_extended_address)
 	return(true);
 }
 
+/**
+ * \brief Hash of an extended address, as slot in a table of us_size (power of 2) entries
+ *
+ */
+static uint16_t _eui64_hash_slot(const uint8_t *puc_extended_address, uint16_t us_size)
+{
+	uint64_t ull_key;
+
+	memcpy(&ull_key, puc_extended_address, ADP_ADDRESS_64BITS);
+	/* Fibonacci hashing: high bits of the product are well mixed */
+	ull_key *= 0x9E3779B97F4A7C15ULL;
+	return (uint16_t)(ull_key >> 48) & (us_size - 1);
+}
+
+/**
+ * \brief Look for an extended address in an index
+ *
+ * Indexes are open addressing tables with linear probing. Each entry holds
+ * the indexed position + 1, 0 means empty.
+ *
+ * \param pus_table index table
+ * \param us_size number of entries in table (power of 2)
+ * \param pf_key returns extended address of an indexed position
+ * \param puc_extended_address extended address
+ * \param pus_slot table slot where the address is (found) or can be inserted (not found)
+ *
+ * \return true if found
+ */
+static bool _eui64_hash_find(const uint16_t *pus_table, uint16_t us_size, pf_eui64_key_t pf_key,
+		const uint8_t *puc_extended_address, uint16_t *pus_slot)
+{
+	uint16_t us_slot;
+
+	us_slot = _eui64_hash_slot(puc_extended_address, us_size);
+	while (pus_table[us_slot] != EUI64_HASH_EMPTY) {
+		if (memcmp(pf_key(pus_table[us_slot] - 1), puc_extended_address, ADP_ADDRESS_64BITS) == 0) {
+			*pus_slot = us_slot;
+			return true;
+		}
+
+		us_slot = (us_slot + 1) & (us_size - 1);
+	}
+
+	*pus_slot = us_slot;
+	return false;
+}
+
+/**
+ * \brief Remove an entry from an index
+ *
+ * Following entries of the probe sequence are moved back, so no deleted marks are needed.
+ */
+static void _eui64_hash_remove(uint16_t *pus_table, uint16_t us_size, pf_eui64_key_t pf_key, uint16_t us_slot)
+{
+	uint16_t us_next;
+	uint16_t us_home;
+
+	pus_table[us_slot] = EUI64_HASH_EMPTY;
+	us_next = (us_slot + 1) & (us_size - 1);
+	while (pus_table[us_next] != EUI64_HASH_EMPTY) {
+		us_home = _eui64_hash_slot(pf_key(pus_table[us_next] - 1), us_size);
+		/* Move back if the hole is between its home slot and its current slot */
+		if (((us_next - us_home) & (us_size - 1)) >= ((us_next - us_slot) & (us_size - 1))) {
+			pus_table[us_slot] = pus_table[us_next];
+			pus_table[us_next] = EUI64_HASH_EMPTY;
+			us_slot = us_next;
+		}
+
+		us_next = (us_next + 1) & (us_size - 1);
+	}
+}
+
+static const uint8_t *_lbds_hash_key(uint16_t us_position)
+{
+	return g_lbds_list[us_position].puc_extended_address;
+}
+
 /**
  * \brief Returns the number of active LBDs
  *
@@ -263,6 +395,8 @@ uint8_t get_lbp_hops_from_short_address(uint16_t us_short_address)
  */
 void remove_lbds_list_entry(uint16_t us_short_address)
 {
+	uint16_t us_slot;
+
 	/* Check if the short address is out of the range */
 	if (!_is_valid_address(us_short_address)) {
 		LOG_BOOTSTRAP(("[BS] Error: attempted to deactivate an address out of range [0x%04x]\r\n", us_short_address));
@@ -271,9 +405,15 @@ void remove_lbds_list_entry(uint16_t us_short_address)
 		/* Check if the address is active */
 		if (!is_null_address(g_lbds_list[us_short_address - g_current_context.initialShortAddr].puc_extended_address)) {
 			/* Deactivate address */
+			if (_eui64_hash_find(g_lbds_hash, LBDS_HASH_SIZE, _lbds_hash_key,
+					g_lbds_list[us_short_address - g_current_context.initialShortAddr].puc_extended_address, &us_slot)) {
+				_eui64_hash_remove(g_lbds_hash, LBDS_HASH_SIZE, _lbds_hash_key, us_slot);
+			}
+
 			memset(&g_lbds_list[us_short_address -
 					g_current_context.initialShortAddr].puc_extended_address, 0, ADP_ADDRESS_64BITS * sizeof(uint8_t));
 			g_lbds_counter--;
+			bs_state_changed(BS_STATE_ITEM_LBD, us_short_address - g_current_context.initialShortAddr);
 		} else {
 			/* The address is not active -> The device hasn't joined */
 			LOG_BOOTSTRAP(("[BS] Error: attempted to deactivate an inactive address [0x%04x]\r\n", us_short_address));
@@ -350,7 +490,7 @@ bool add_lbds_list_entry(const uint8_t *puc_extended_address, uint16_t us_short_
 	}
 
 	uint16_t us_position = us_short_address - g_current_context.initialShortAddr;
-	uint16_t us_dummy_short_address;
+	uint16_t us_slot;
 
 	/* Check if the short address is already in use */
 	if (!is_null_address(g_lbds_list[us_position].puc_extended_address)) {
@@ -359,7 +499,7 @@ bool add_lbds_list_entry(const uint8_t *puc_extended_address, uint16_t us_short_
 	}
 
 	/* Check if the extended address is already in use */
-	if (bs_get_short_addr_by_ext((uint8_t *)puc_extended_address, &us_dummy_short_address)) {
+	if (_eui64_hash_find(g_lbds_hash, LBDS_HASH_SIZE, _lbds_hash_key, puc_extended_address, &us_slot)) {
 		LOG_BOOTSTRAP(("[BS] Extended address already in use [%02X:%02X:%02X:%02X:%02X:%02X:%02X:%02X]\r\n",
 				*puc_extended_address, *(puc_extended_address + 1), *(puc_extended_address + 2),
 				*(puc_extended_address + 3), *(puc_extended_address + 4), *(puc_extended_address + 5),
@@ -368,11 +508,47 @@ bool add_lbds_list_entry(const uint8_t *puc_extended_address, uint16_t us_short_
 	}
 
 	memcpy(g_lbds_list[us_position].puc_extended_address, puc_extended_address, 8);
+	if (!is_null_address(g_lbds_list[us_position].puc_extended_address)) {
+		g_lbds_hash[us_slot] = us_position + 1;
+	}
 	g_lbds_list[us_position].uc_lbp_hops = uc_lbp_hops;
 	LOG_BOOTSTRAP(("[BS] Added address [0x%04x]  LBP HOPS = %d\r\n", us_short_address, uc_lbp_hops));
 	g_lbds_counter++;
 	LOG_BOOTSTRAP(("[BS] Total num. devices: %d.\r\n", g_lbds_counter));
+	bs_state_changed(BS_STATE_ITEM_LBD, us_position);
+
+	return(true);
+}
+
+/**
+ * \brief Adds a LBD recovered from persistent storage to the devices' list
+ *
+ * \param us_index position in the devices' list
+ * \param puc_extended_address extended address
+ * \param uc_lbp_hops LBP hops
+ *
+ * \return true / false. A null extended address (empty slot) is not added
+ */
+bool bs_restore_lbd_entry(uint16_t us_index, const uint8_t *puc_extended_address, uint8_t uc_lbp_hops)
+{
+	if (is_null_address((uint8_t *)puc_extended_address)) {
+		return(false);
+	}
+
+	bs_lock();
+	if ((us_index >= MAX_LBDS) || !add_lbds_list_entry(puc_extended_address, us_index + g_current_context.initialShortAddr, uc_lbp_hops)) {
+		bs_unlock();
+		return(false);
+	}
 
+	/* Keep new address assignment away from restored entries */
+	if (bGetShortAddressFromExtended) {
+		g_lbds_list_size++;
+	} else if (us_index >= g_lbds_list_size) {
+		g_lbds_list_size = us_index + 1;
+	}
+
+	bs_unlock();
 	return(true);
 }
 
@@ -389,6 +565,7 @@ bool bs_get_ext_addr_by_short(uint16_t us_short_address, uint8_t *puc_extended_a
 	uint16_t us_index;
 	bool found = false;
 
+	bs_lock();
 	us_index = us_short_address - g_current_context.initialShortAddr;
 
 	if (!is_null_address(g_lbds_list[us_index].puc_extended_address)) {
@@ -398,6 +575,7 @@ bool bs_get_ext_addr_by_short(uint16_t us_short_address, uint8_t *puc_extended_a
 		LOG_BOOTSTRAP(("[BS] Error: tried to access joined devices list by not-joined short address.\r\n"));
 	}
 
+	bs_unlock();
 	return found;
 }
 
@@ -411,39 +589,105 @@ bool bs_get_ext_addr_by_short(uint16_t us_short_address, uint8_t *puc_extended_a
  */
 bool bs_get_short_addr_by_ext(uint8_t *puc_extended_address, uint16_t *pus_short_address)
 {
-	uint16_t i = 0;
-	uint16_t j = 0;
+	uint16_t us_slot;
 	bool found = false;
 
-	while (j < g_lbds_list_size) {
-		if (!is_null_address(g_lbds_list[j].puc_extended_address)) {
-			/* Check if the short address matches */
-			found = true;
-			for (i = 0; i < ADP_ADDRESS_64BITS; i++) {
-				/* If any of the bytes of the address isn't null, go on. */
-				if (puc_extended_address[i] != g_lbds_list[j].puc_extended_address[i]) {
-					found = false;
-					break;
-				}
-			}
-		}
-
-		if (found) {
-			*pus_short_address = j + g_current_context.initialShortAddr;
-			break;
-		}
-
-		j++;
-	}
-	if (found) {
-		LOG_BOOTSTRAP(("[BS] Extended address found in joined devices list with short address 0x%04X.\r\n", *pus_short_address));
+	bs_lock();
+	if (_eui64_hash_find(g_lbds_hash, LBDS_HASH_SIZE, _lbds_hash_key, puc_extended_address, &us_slot)) {
+		*pus_short_address = g_lbds_hash[us_slot] - 1 + g_current_context.initialShortAddr;
+		found = true;
 	} else {
 		LOG_BOOTSTRAP(("[BS] Error: extended address not found in joined devices list.\r\n"));
 	}
 
+	bs_unlock();
 	return found;
 }
 
+/**
+ * \brief Gets an entry of the joined devices list by its position
+ *
+ * \param us_index position in the devices' list
+ * \param puc_extended_address extended address (all zero if entry is free)
+ * \param puc_lbp_hops LBP hops
+ *
+ * \return false if index is out of range.
+ */
+bool bs_get_lbd_entry(uint16_t us_index, uint8_t *puc_extended_address, uint8_t *puc_lbp_hops)
+{
+	if (us_index >= MAX_LBDS) {
+		return false;
+	}
+
+	bs_lock();
+	memcpy(puc_extended_address, g_lbds_list[us_index].puc_extended_address, ADP_ADDRESS_64BITS);
+	*puc_lbp_hops = g_lbds_list[us_index].uc_lbp_hops;
+	bs_unlock();
+	return true;
+}
+
+/**
+ * \brief Copies the blacklist
+ *
+ * \return number of entries copied (removed entries are all zero)
+ */
+uint16_t bs_get_blacklist(uint8_t (*puc_blacklist_out)[ADP_ADDRESS_64BITS], uint16_t us_max_entries)
+{
+	uint16_t us_size;
+
+	bs_lock();
+	us_size = us_blacklist_size;
+	if (us_size > us_max_entries) {
+		us_size = us_max_entries;
+	}
+
+	memcpy(puc_blacklist_out, puc_blacklist, us_size * ADP_ADDRESS_64BITS);
+	bs_unlock();
+	return us_size;
+}
+
+/**
+ * \brief Gets current GMK and active key index
+ *
+ */
+void bs_get_keys(uint8_t *puc_gmk, uint8_t *puc_key_index)
+{
+	bs_lock();
+	memcpy(puc_gmk, g_au8CurrGMK, 16);
+	*puc_key_index = g_au8CurrKeyIndex;
+	bs_unlock();
+}
+
+static void _bs_mutex_init(void)
+{
+	pthread_mutexattr_t x_attr;
+
+	pthread_mutexattr_init(&x_attr);
+	pthread_mutexattr_settype(&x_attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&sx_bs_mutex, &x_attr);
+	pthread_mutexattr_destroy(&x_attr);
+}
+
+/**
+ * \brief Takes the bootstrap state lock. Every bs_ entry point takes it,
+ *        it can be taken again by the same thread
+ *
+ */
+void bs_lock(void)
+{
+	pthread_once(&sx_bs_mutex_once, _bs_mutex_init);
+	pthread_mutex_lock(&sx_bs_mutex);
+}
+
+/**
+ * \brief Releases the bootstrap state lock
+ *
+ */
+void bs_unlock(void)
+{
+	pthread_mutex_unlock(&sx_bs_mutex);
+}
+
 /* / ** */
 /* * AdpRoutingTable. */
 /* * */
@@ -496,6 +740,7 @@ bool set_initial_short_address(uint16_t us_short_addr)
 			return(false);
 		} else {
 			g_current_context.initialShortAddr = us_short_addr;
+			bs_state_changed(BS_STATE_ITEM_INITIAL_SHORT_ADDRESS, 0);
 			return(true);
 		}
 	}
@@ -535,6 +780,7 @@ uint8_t GetKeyIndex(void)
 void SetKeyIndex(uint8_t u8KeyIndex)
 {
 	g_au8CurrKeyIndex = u8KeyIndex;
+	bs_state_changed(BS_STATE_ITEM_KEYS, 0);
 }
 
 /**
@@ -554,6 +800,7 @@ void set_gmk(uint8_t *puc_new_gmk)
 {
 	if (puc_new_gmk != NULL) {
 		memcpy(g_au8CurrGMK, puc_new_gmk, 16);
+		bs_state_changed(BS_STATE_ITEM_KEYS, 0);
 	}
 }
 
@@ -619,6 +866,7 @@ void lbp_init_functions(void)
 	g_lbds_counter = 0;
 	g_lbds_list_size = 0;
 	memset(g_lbds_list, 0, MAX_LBDS * sizeof(lbds_list_entry_t));
+	memset(g_lbds_hash, 0, sizeof(g_lbds_hash));
 
 	if (g_s_bs_conf.m_u8BandInfo == ADP_BAND_ARIB) {
 		g_IdS.uc_size = NETWORK_ACCESS_IDENTIFIER_MAX_SIZE_S;
@@ -686,7 +934,7 @@ void Process_Joining0(struct TAdpExtendedAddress pLBPEUI64Address, t_bootstrap_s
 			pMemoryBuffer
 			);
 
-	if (!m_bRekey) {
+	if (p_bs_slot->us_rekey_idx == BS_REKEY_NO_LBD) {
 		/* If extended address is already in list, remove it and give a new short address */
 		if (bs_get_short_addr_by_ext(pLBPEUI64Address.m_au8Value, &u16DummyShortAddress)) {
 			remove_lbds_list_entry(u16DummyShortAddress);
@@ -744,17 +992,24 @@ uint8_t process_accepted_GMK_activation(struct TAdpExtendedAddress au8LBPEUI64Ad
 
 void log_show_slots_status(void)
 {
-	uint8_t uc_i;
-	for (uc_i = 0; uc_i < BOOTSTRAP_NUM_SLOTS; uc_i++) {
+	uint16_t us_i;
+	t_bootstrap_slot *p_slot;
+
+	for (us_i = 0; us_i < us_bootstrap_slots_allocated; us_i++) {
+		p_slot = get_bootstrap_slot_by_index(us_i);
+		if (!p_slot->b_in_use) {
+			continue;
+		}
+
 		LOG_BOOTSTRAP((
 					"[BS] Updating slot %hu with LBD_ADDR: %02X:%02X:%02X:%02X:%02X:%02X:%02X:%02X, \
 					state: %hu, handler: %hu  pending_cfrms: %hu  Timeout: %u, Current_Time: %u \r\n",
-					uc_i, bootstrap_slots[uc_i].m_LbdAddress.m_au8Value[0], bootstrap_slots[uc_i].m_LbdAddress.m_au8Value[1],
-					bootstrap_slots[uc_i].m_LbdAddress.m_au8Value[2], bootstrap_slots[uc_i].m_LbdAddress.m_au8Value[3],
-					bootstrap_slots[uc_i].m_LbdAddress.m_au8Value[4], bootstrap_slots[uc_i].m_LbdAddress.m_au8Value[5],
-					bootstrap_slots[uc_i].m_LbdAddress.m_au8Value[6], bootstrap_slots[uc_i].m_LbdAddress.m_au8Value[7],
-					bootstrap_slots[uc_i].e_state, bootstrap_slots[uc_i].uc_tx_handle, bootstrap_slots[uc_i].uc_pending_confirms,
-					bootstrap_slots[uc_i].ul_timeout, oss_get_up_time_ms()));
+					us_i, p_slot->m_LbdAddress.m_au8Value[0], p_slot->m_LbdAddress.m_au8Value[1],
+					p_slot->m_LbdAddress.m_au8Value[2], p_slot->m_LbdAddress.m_au8Value[3],
+					p_slot->m_LbdAddress.m_au8Value[4], p_slot->m_LbdAddress.m_au8Value[5],
+					p_slot->m_LbdAddress.m_au8Value[6], p_slot->m_LbdAddress.m_au8Value[7],
+					p_slot->e_state, p_slot->uc_tx_handle, p_slot->uc_pending_confirms,
+					p_slot->ul_timeout, oss_get_up_time_ms()));
 	}
 }
 
@@ -794,7 +1049,7 @@ static uint8_t Process_Joining_EAP_T1(struct TAdpExtendedAddress au8LBPEUI64Addr
 		/* prepare the protected data carring the key and short addr */
 		pdata[u16PDataLen++] = 0x02; /* ext field */
 
-		if (!m_bRekey) {
+		if (p_bs_slot->us_rekey_idx == BS_REKEY_NO_LBD) {
 			pdata[u16PDataLen++] = CONF_PARAM_SHORT_ADDR;
 			pdata[u16PDataLen++] = 2;
 			pdata[u16PDataLen++] = (unsigned char)((u16ShortAddr & 0xFF00) >> 8);
@@ -938,6 +1193,7 @@ uint8_t add_to_blacklist(uint8_t *puc_address)
 	if (us_blacklist_size < MAX_LBDS) {
 		memcpy(puc_blacklist[us_blacklist_size], puc_address, ADP_ADDRESS_64BITS);
 		us_blacklist_size++;
+		bs_state_changed(BS_STATE_ITEM_BLACKLIST, us_blacklist_size - 1);
 	} else {
 		/* Blacklist full - error */
 		uc_status = 0;
@@ -958,6 +1214,7 @@ uint8_t remove_from_blacklist(uint16_t us_index)
 	if (us_index < MAX_LBDS) {
 		memset(puc_blacklist[us_index], 0, ADP_ADDRESS_64BITS);
 		uc_status = 1;
+		bs_state_changed(BS_STATE_ITEM_BLACKLIST, us_index);
 	}
 
 	return uc_status;
@@ -990,11 +1247,10 @@ static uint8_t _dev_is_in_blacklist(uint8_t *puc_address)
  */
 enum lbp_indications ProcessLBPMessage(struct TAdpLbpIndication *pLbpIndication)
 {
-	static struct TAdpExtendedAddress ext_address_in_process;
+	static PAN_LOCAL struct TAdpExtendedAddress ext_address_in_process;
 	unsigned char u8MessageType;
 	unsigned char *pBootStrappingData;
 	unsigned short u16BootStrappingDataLength;
-	struct TAddress dstAddr;
 
 	/* Embedded EAP message */
 	unsigned char u8Code = 0;
@@ -1056,7 +1312,11 @@ enum lbp_indications ProcessLBPMessage(struct TAdpLbpIndication *pLbpIndication)
 							sizeof(m_current_LbdAddress.m_au8Value));
 					LOG_BOOTSTRAP(("[BS] Slot updated to BS_STATE_SENT_EAP_MSG_DECLINED\r\n"));
 				} else {
-					if (p_bs_slot->e_state == BS_STATE_WAITING_JOINNING) {
+					if ((p_bs_slot->e_state == BS_STATE_WAITING_JOINNING) &&
+							(!b_bootstrap_tx_ready || (us_bootstrap_tx_count >= BOOTSTRAP_MAX_QUEUED_LBP))) {
+						/* Too many LBP messages waiting, LBD will retry joining later */
+						LOG_BOOTSTRAP(("[BS] LBP JOINNING IGNORED, LBP TX congested\r\n"));
+					} else if (p_bs_slot->e_state == BS_STATE_WAITING_JOINNING) {
 						uint8_t uc_num_hops;
 						if (pLbpIndication->m_u16SrcAddr == 0xFFFF) {
 							uc_num_hops = 1;
@@ -1188,34 +1448,12 @@ enum lbp_indications ProcessLBPMessage(struct TAdpLbpIndication *pLbpIndication)
 
 	if (p_bs_slot != NULL) {
 		if (p_bs_slot->us_data_length > 0) {
-			if (pLbpIndication->m_u16SrcAddr == 0xFFFF) {
-				dstAddr.m_u8AddrLength = 8;
-				memcpy(dstAddr.m_u8ExtendedAddr, &p_bs_slot->m_LbdAddress.m_au8Value, 8);
-			} else {
-				dstAddr.m_u8AddrLength = 2;
-				dstAddr.m_u16ShortAddr = pLbpIndication->m_u16SrcAddr;
-			}
-
-			if (p_bs_slot->uc_pending_confirms > 0) {
-				p_bs_slot->uc_pending_tx_handler = p_bs_slot->uc_tx_handle;
-			}
-
-			p_bs_slot->uc_tx_handle = get_next_nsdu_handler();
-			p_bs_slot->ul_timeout = oss_get_up_time_ms() + 1000 * us_msg_timeout_in_s * 10;
 			p_bs_slot->uc_tx_attemps = 0;
-			p_bs_slot->uc_pending_confirms++;
-
-			log_show_slots_status();
-			LOG_BOOTSTRAP(("[BS] AdpLbpRequest Called, handler: %d \r\n", p_bs_slot->uc_tx_handle));
-			AdpLbpRequest((struct TAdpAddress const *)&dstAddr,     /* Destination address */
-					p_bs_slot->us_data_length,                                /* NSDU length */
-					&p_bs_slot->auc_data[0],                                  /* NSDU */
-					p_bs_slot->uc_tx_handle,                            /* NSDU handle */
-					g_s_bs_conf.m_u8MaxHop,          						/* Max. Hops */
-					true,                                       /* Discover route */
-					0,                                          /* QoS */
-					false);                                     /* Security enable */
+			send_bootstrap_slot_msg(p_bs_slot, pLbpIndication->m_u16SrcAddr, g_s_bs_conf.m_u8MaxHop);
 		}
+
+		/* Slot is not kept if no bootstrap is in progress */
+		release_bootstrap_slot_if_idle(p_bs_slot);
 	}
 
 	return(lbp_indication);
@@ -1281,46 +1519,200 @@ uint16_t Encode_decline(uint8_t *p_ext_addr, t_bootstrap_slot *p_bs_slot)
 
 uint8_t get_next_nsdu_handler(void)
 {
+	uint16_t us_i;
+
+	/* Skip handles still waiting for confirm */
+	for (us_i = 0; us_i < 256; us_i++) {
+		if (bootstrap_handle_slot[uc_nsdu_handle] == 0) {
+			break;
+		}
+
+		uc_nsdu_handle++;
+	}
+
 	return uc_nsdu_handle++;
 }
 
-void  init_bootstrap_slots(void)
+static const uint8_t *_bootstrap_slots_hash_key(uint16_t us_index)
+{
+	return get_bootstrap_slot_by_index(us_index)->m_LbdAddress.m_au8Value;
+}
+
+static bool _bootstrap_timeout_before(uint32_t ul_a, uint32_t ul_b)
 {
-	uint8_t uc_i;
+	return ((int32_t)(ul_a - ul_b) < 0);
+}
 
-	for (uc_i = 0; uc_i < BOOTSTRAP_NUM_SLOTS; uc_i++) {
-		bootstrap_slots[uc_i].e_state =  BS_STATE_WAITING_JOINNING;
-		bootstrap_slots[uc_i].uc_pending_confirms = 0;
-		bootstrap_slots[uc_i].uc_tx_handle =  0xff;
-		bootstrap_slots[uc_i].ul_nonce =  0;
-		bootstrap_slots[uc_i].uc_lbp_hops =  0;
+/**
+ * \brief Add a slot timeout to the timers heap
+ *
+ */
+static void _bootstrap_timer_push(uint32_t ul_timeout, uint16_t us_slot)
+{
+	uint32_t ul_pos;
+	uint32_t ul_parent;
+	t_bootstrap_timer *p_timers;
+
+	if (ul_bootstrap_timers_count == ul_bootstrap_timers_size) {
+		p_timers = realloc(bootstrap_timers, (ul_bootstrap_timers_size + BOOTSTRAP_SLOTS_CHUNK) * sizeof(t_bootstrap_timer));
+		if (p_timers == NULL) {
+			LOG_BOOTSTRAP(("[BS] Error: no memory for slot timeout\r\n"));
+			return;
+		}
 
-		memset(bootstrap_slots[uc_i].m_LbdAddress.m_au8Value, 0xff, 8);
+		bootstrap_timers = p_timers;
+		ul_bootstrap_timers_size += BOOTSTRAP_SLOTS_CHUNK;
+	}
+
+	ul_pos = ul_bootstrap_timers_count++;
+	while (ul_pos > 0) {
+		ul_parent = (ul_pos - 1) / 2;
+		if (!_bootstrap_timeout_before(ul_timeout, bootstrap_timers[ul_parent].ul_timeout)) {
+			break;
+		}
+
+		bootstrap_timers[ul_pos] = bootstrap_timers[ul_parent];
+		ul_pos = ul_parent;
+	}
+
+	bootstrap_timers[ul_pos].ul_timeout = ul_timeout;
+	bootstrap_timers[ul_pos].us_slot = us_slot;
+}
+
+/**
+ * \brief Remove the earliest timeout from the timers heap
+ *
+ */
+static void _bootstrap_timer_pop(void)
+{
+	uint32_t ul_pos = 0;
+	uint32_t ul_child;
+	t_bootstrap_timer x_last;
+
+	x_last = bootstrap_timers[--ul_bootstrap_timers_count];
+	while ((ul_child = 2 * ul_pos + 1) < ul_bootstrap_timers_count) {
+		if ((ul_child + 1 < ul_bootstrap_timers_count) &&
+				_bootstrap_timeout_before(bootstrap_timers[ul_child + 1].ul_timeout, bootstrap_timers[ul_child].ul_timeout)) {
+			ul_child++;
+		}
+
+		if (!_bootstrap_timeout_before(bootstrap_timers[ul_child].ul_timeout, x_last.ul_timeout)) {
+			break;
+		}
+
+		bootstrap_timers[ul_pos] = bootstrap_timers[ul_child];
+		ul_pos = ul_child;
+	}
+
+	bootstrap_timers[ul_pos] = x_last;
+}
+
+/**
+ * \brief Take a slot from the free list, allocating a new chunk if needed
+ *
+ */
+static t_bootstrap_slot *_alloc_bootstrap_slot(void)
+{
+	uint16_t us_i;
+	t_bootstrap_slot *p_chunk;
+	t_bootstrap_slot *p_slot;
+
+	if (us_bootstrap_slots_free == BOOTSTRAP_NO_SLOT) {
+		if (us_bootstrap_slots_allocated >= BOOTSTRAP_MAX_SLOTS) {
+			return NULL;
+		}
+
+		p_chunk = calloc(BOOTSTRAP_SLOTS_CHUNK, sizeof(t_bootstrap_slot));
+		if (p_chunk == NULL) {
+			return NULL;
+		}
+
+		bootstrap_slot_chunks[us_bootstrap_slots_allocated / BOOTSTRAP_SLOTS_CHUNK] = p_chunk;
+		for (us_i = 0; (us_i < BOOTSTRAP_SLOTS_CHUNK) && (us_bootstrap_slots_allocated < BOOTSTRAP_MAX_SLOTS); us_i++) {
+			p_chunk[us_i].us_index = us_bootstrap_slots_allocated++;
+			p_chunk[us_i].us_next = us_bootstrap_slots_free;
+			us_bootstrap_slots_free = p_chunk[us_i].us_index;
+		}
+	}
+
+	p_slot = get_bootstrap_slot_by_index(us_bootstrap_slots_free);
+	us_bootstrap_slots_free = p_slot->us_next;
+
+	p_slot->b_in_use = true;
+	p_slot->b_tx_queued = false;
+	p_slot->e_state =  BS_STATE_WAITING_JOINNING;
+	p_slot->uc_pending_confirms = 0;
+	p_slot->uc_tx_handle =  0xff;
+	p_slot->uc_pending_tx_handler =  0xff;
+	p_slot->uc_tx_attemps = 0;
+	p_slot->ul_nonce =  0;
+	p_slot->uc_lbp_hops =  0;
+	p_slot->ul_timeout = 0xFFFFFFFF;
+	p_slot->us_data_length = 0;
+	p_slot->us_rekey_idx = BS_REKEY_NO_LBD;
+
+	return p_slot;
+}
+
+/**
+ * \brief Forget the slot waiting for confirm of a handle
+ *
+ */
+static void _release_bootstrap_handle(uint8_t uc_handle, uint16_t us_index)
+{
+	if (bootstrap_handle_slot[uc_handle] == us_index + 1) {
+		bootstrap_handle_slot[uc_handle] = 0;
+		us_bootstrap_pending_lbp--;
 	}
 }
 
+void  init_bootstrap_slots(void)
+{
+	uint16_t us_i;
+	t_bootstrap_slot *p_slot;
+
+	/* Slots already allocated are kept, all of them become free */
+	us_bootstrap_slots_free = BOOTSTRAP_NO_SLOT;
+	for (us_i = us_bootstrap_slots_allocated; us_i > 0; us_i--) {
+		p_slot = get_bootstrap_slot_by_index(us_i - 1);
+		p_slot->b_in_use = false;
+		p_slot->b_tx_queued = false;
+		p_slot->e_state =  BS_STATE_WAITING_JOINNING;
+		p_slot->us_next = us_bootstrap_slots_free;
+		us_bootstrap_slots_free = us_i - 1;
+	}
+
+	memset(bootstrap_slots_hash, 0, sizeof(bootstrap_slots_hash));
+	memset(bootstrap_handle_slot, 0, sizeof(bootstrap_handle_slot));
+	us_bootstrap_pending_lbp = 0;
+	us_bootstrap_tx_head = BOOTSTRAP_NO_SLOT;
+	us_bootstrap_tx_tail = BOOTSTRAP_NO_SLOT;
+	us_bootstrap_tx_count = 0;
+	ul_bootstrap_timers_count = 0;
+}
+
+/**
+ * \brief Slot of a LBD under bootstrap. A free slot is assigned if the LBD has none.
+ *
+ * \return NULL if no slot is available
+ */
 t_bootstrap_slot *get_bootstrap_slot_by_addr(uint8_t *p_eui64)
 {
-	uint8_t uc_i;
+	uint16_t us_hash_slot;
 	t_bootstrap_slot *p_out_slot = NULL;
 
 	LOG_BOOTSTRAP(("[BS] get_bootstrap_slot_by_addr\r\n"));
 	/* Check if the lbd is already started */
-	for (uc_i = 0; uc_i < BOOTSTRAP_NUM_SLOTS; uc_i++) {
-		if (!memcmp(bootstrap_slots[uc_i].m_LbdAddress.m_au8Value, p_eui64, 8)) {
-			p_out_slot = &bootstrap_slots[uc_i];
-			LOG_BOOTSTRAP(("[BS] get_bootstrap_slot_by_addr --> Slot in use found: %d \r\n", uc_i));
-			break;
-		}
-	}
-	/* If lbd not in progress find free slot */
-	if (!p_out_slot) {
-		for (uc_i = 0; uc_i < BOOTSTRAP_NUM_SLOTS; uc_i++) {
-			if (bootstrap_slots[uc_i].e_state ==  BS_STATE_WAITING_JOINNING) {
-				p_out_slot = &bootstrap_slots[uc_i];
-				LOG_BOOTSTRAP(("[BS] get_bootstrap_slot_by_addr --> Slot free found: %d \r\n", uc_i));
-				break;
-			}
+	if (_eui64_hash_find(bootstrap_slots_hash, BOOTSTRAP_SLOTS_HASH_SIZE, _bootstrap_slots_hash_key, p_eui64, &us_hash_slot)) {
+		p_out_slot = get_bootstrap_slot_by_index(bootstrap_slots_hash[us_hash_slot] - 1);
+		LOG_BOOTSTRAP(("[BS] get_bootstrap_slot_by_addr --> Slot in use found: %d \r\n", p_out_slot->us_index));
+	} else {
+		/* If lbd not in progress take a free slot */
+		p_out_slot = _alloc_bootstrap_slot();
+		if (p_out_slot) {
+			memcpy(p_out_slot->m_LbdAddress.m_au8Value, p_eui64, 8);
+			bootstrap_slots_hash[us_hash_slot] = p_out_slot->us_index + 1;
+			LOG_BOOTSTRAP(("[BS] get_bootstrap_slot_by_addr --> Slot free found: %d \r\n", p_out_slot->us_index));
 		}
 	}
 
@@ -1331,95 +1723,251 @@ t_bootstrap_slot *get_bootstrap_slot_by_addr(uint8_t *p_eui64)
 	return p_out_slot;
 }
 
-t_bootstrap_slot *get_bootstrap_slot_by_index(uint8_t uc_index)
+t_bootstrap_slot *get_bootstrap_slot_by_index(uint16_t us_index)
 {
-	return &bootstrap_slots[uc_index];
+	return &bootstrap_slot_chunks[us_index / BOOTSTRAP_SLOTS_CHUNK][us_index % BOOTSTRAP_SLOTS_CHUNK];
 }
 
-void  update_bootstrap_slots(void)
+/**
+ * \brief Slot waiting for confirm of a LBP request. The handle is no longer pending.
+ *
+ * \return NULL if handle is not pending
+ */
+t_bootstrap_slot *confirm_bootstrap_slot_handle(uint8_t uc_handle)
 {
-	uint8_t uc_i;
-
-	for (uc_i = 0; uc_i < BOOTSTRAP_NUM_SLOTS; uc_i++) {
-		/* log_show_slots_status(); */
-		if (bootstrap_slots[uc_i].e_state != BS_STATE_WAITING_JOINNING) {
-			if (timeout_is_past(bootstrap_slots[uc_i].ul_timeout)) {
-				LOG_BOOTSTRAP(("[BS] timeout_is_past for %d\r\n",uc_i));
-				if (bootstrap_slots[uc_i].uc_pending_confirms == 0) {
-					if (bootstrap_slots[uc_i].uc_tx_attemps < BOOTSTRAP_MSG_MAX_RETRIES) {
-						bootstrap_slots[uc_i].uc_tx_attemps++;
-						if (bootstrap_slots[uc_i].e_state == BS_STATE_WAITING_EAP_MSG_2) {
-							bootstrap_slots[uc_i].e_state = BS_STATE_SENT_EAP_MSG_1;
-							LOG_BOOTSTRAP(("[BS] Slot updated to BS_STATE_SENT_EAP_MSG_1\r\n"));
-							log_show_slots_status();
-						} else if (bootstrap_slots[uc_i].e_state == BS_STATE_WAITING_EAP_MSG_4) {
-							bootstrap_slots[uc_i].e_state = BS_STATE_SENT_EAP_MSG_3;
-							LOG_BOOTSTRAP(("[BS] Slot updated to BS_STATE_SENT_EAP_MSG_3\r\n"));
-							log_show_slots_status();
-						}
+	uint16_t us_index;
 
-						struct TAddress dstAddr;
-						struct TAdpGetConfirm getConfirm;
+	if (bootstrap_handle_slot[uc_handle] == 0) {
+		return NULL;
+	}
 
-						if (bootstrap_slots[uc_i].us_data_length > 0) {
-							if (bootstrap_slots[uc_i].us_lba_src_addr == 0xFFFF) {
-								dstAddr.m_u8AddrLength = 8;
-								memcpy(dstAddr.m_u8ExtendedAddr, &bootstrap_slots[uc_i].m_LbdAddress.m_au8Value, 8);
-							} else {
-								dstAddr.m_u8AddrLength = 2;
-								dstAddr.m_u16ShortAddr = bootstrap_slots[uc_i].us_lba_src_addr;
-							}
+	us_index = bootstrap_handle_slot[uc_handle] - 1;
+	_release_bootstrap_handle(uc_handle, us_index);
+	return get_bootstrap_slot_by_index(us_index);
+}
 
-							if (bootstrap_slots[uc_i].uc_pending_confirms > 0) {
-								bootstrap_slots[uc_i].uc_pending_tx_handler = bootstrap_slots[uc_i].uc_tx_handle;
-							}
+/**
+ * \brief Return a slot to the free list if its bootstrap is not in progress
+ *
+ */
+void release_bootstrap_slot_if_idle(t_bootstrap_slot *p_bs_slot)
+{
+	uint16_t us_hash_slot;
+	uint16_t us_rekey_idx;
 
-							bootstrap_slots[uc_i].uc_tx_handle = get_next_nsdu_handler();
-							bootstrap_slots[uc_i].ul_timeout = oss_get_up_time_ms() + 1000 * us_msg_timeout_in_s * 10;
-							bootstrap_slots[uc_i].uc_pending_confirms++;
-
-							LOG_BOOTSTRAP(("[BS] Timeout detected. Re-sending MSG for slot: %d Attempt: %d \r\n", uc_i,
-									bootstrap_slots[uc_i].uc_tx_attemps));
-							log_show_slots_status();
-							LOG_BOOTSTRAP(("[BS] AdpLbpRequest Called, handler: %d \r\n", bootstrap_slots[uc_i].uc_tx_handle));
-							AdpLbpRequest((struct TAdpAddress const *)&dstAddr,     /* Destination address */
-									bootstrap_slots[uc_i].us_data_length,                              /* NSDU length */
-									&bootstrap_slots[uc_i].auc_data[0],                                  /* NSDU */
-									bootstrap_slots[uc_i].uc_tx_handle,                            /* NSDU handle */
-									g_s_bs_conf.m_u8MaxHop,          						/* Max. Hops */
-									true,                                       /* Discover route */
-									0,                                          /* QoS */
-									false);                                     /* Security enable */
-						}
-					} else {
-						LOG_BOOTSTRAP(("[BS] Reset slot %d:  \r\n", uc_i));
-						bootstrap_slots[uc_i].e_state = BS_STATE_WAITING_JOINNING;
-						bootstrap_slots[uc_i].uc_pending_confirms = 0;
-						bootstrap_slots[uc_i].ul_nonce =  0;
-						bootstrap_slots[uc_i].ul_timeout = 0xFFFFFFFF;
-					}
-				} else { /* Pending confirm then increase timeout time */
-					LOG_BOOTSTRAP(("[BS] NEVER SHOUL BE HERE --> Reset slot %d:  \r\n", uc_i));
-					bootstrap_slots[uc_i].e_state = BS_STATE_WAITING_JOINNING;
-					bootstrap_slots[uc_i].uc_pending_confirms = 0;
-					bootstrap_slots[uc_i].ul_nonce =  0;
-					bootstrap_slots[uc_i].ul_timeout = 0xFFFFFFFF;
-				}
+	if ((p_bs_slot == NULL) || !p_bs_slot->b_in_use || p_bs_slot->b_tx_queued ||
+			(p_bs_slot->e_state != BS_STATE_WAITING_JOINNING)) {
+		return;
+	}
+
+	if (_eui64_hash_find(bootstrap_slots_hash, BOOTSTRAP_SLOTS_HASH_SIZE, _bootstrap_slots_hash_key,
+			p_bs_slot->m_LbdAddress.m_au8Value, &us_hash_slot)) {
+		_eui64_hash_remove(bootstrap_slots_hash, BOOTSTRAP_SLOTS_HASH_SIZE, _bootstrap_slots_hash_key, us_hash_slot);
+	}
+
+	/* Late confirms of this slot are ignored */
+	_release_bootstrap_handle(p_bs_slot->uc_tx_handle, p_bs_slot->us_index);
+	_release_bootstrap_handle(p_bs_slot->uc_pending_tx_handler, p_bs_slot->us_index);
+
+	p_bs_slot->b_in_use = false;
+	p_bs_slot->us_next = us_bootstrap_slots_free;
+	us_bootstrap_slots_free = p_bs_slot->us_index;
+
+	/* Rekeying of the LBD ended without GMK accepted */
+	if (p_bs_slot->us_rekey_idx != BS_REKEY_NO_LBD) {
+		us_rekey_idx = p_bs_slot->us_rekey_idx;
+		p_bs_slot->us_rekey_idx = BS_REKEY_NO_LBD;
+		rekey_lbd_finished(us_rekey_idx, false);
+	}
+}
+
+/**
+ * \brief Set slot timeout, update_bootstrap_slots() handles it when expired
+ *
+ */
+void arm_bootstrap_slot_timeout(t_bootstrap_slot *p_bs_slot, uint32_t ul_timeout)
+{
+	p_bs_slot->ul_timeout = ul_timeout;
+	_bootstrap_timer_push(ul_timeout, p_bs_slot->us_index);
+}
+
+/**
+ * \brief Queue the slot message (auc_data) to be sent
+ *
+ * \param us_dst_addr destination short address, 0xFFFF to send to LBD extended address
+ * \param uc_max_hops max. hops of the LBP request
+ */
+void send_bootstrap_slot_msg(t_bootstrap_slot *p_bs_slot, uint16_t us_dst_addr, uint8_t uc_max_hops)
+{
+	p_bs_slot->us_tx_dst_addr = us_dst_addr;
+	p_bs_slot->uc_tx_max_hops = uc_max_hops;
+
+	/* Already queued: latest message is sent */
+	if (!p_bs_slot->b_tx_queued) {
+		p_bs_slot->b_tx_queued = true;
+		p_bs_slot->us_next = BOOTSTRAP_NO_SLOT;
+		if (us_bootstrap_tx_head == BOOTSTRAP_NO_SLOT) {
+			us_bootstrap_tx_head = p_bs_slot->us_index;
+		} else {
+			get_bootstrap_slot_by_index(us_bootstrap_tx_tail)->us_next = p_bs_slot->us_index;
+		}
+
+		us_bootstrap_tx_tail = p_bs_slot->us_index;
+		us_bootstrap_tx_count++;
+	}
+
+	process_bootstrap_tx();
+}
+
+/**
+ * \brief Send queued slot messages while ADP has buffers and the number of
+ *        LBP requests waiting for confirm is below BOOTSTRAP_MAX_PENDING_LBP
+ *
+ */
+void process_bootstrap_tx(void)
+{
+	struct TAddress dstAddr;
+	t_bootstrap_slot *p_slot;
+
+	while (b_bootstrap_tx_ready && (us_bootstrap_tx_head != BOOTSTRAP_NO_SLOT) &&
+			(us_bootstrap_pending_lbp < BOOTSTRAP_MAX_PENDING_LBP)) {
+		p_slot = get_bootstrap_slot_by_index(us_bootstrap_tx_head);
+		us_bootstrap_tx_head = p_slot->us_next;
+		us_bootstrap_tx_count--;
+		p_slot->b_tx_queued = false;
+
+		/* Bootstrap aborted while the message was queued */
+		if ((p_slot->e_state == BS_STATE_WAITING_JOINNING) || (p_slot->us_data_length == 0)) {
+			release_bootstrap_slot_if_idle(p_slot);
+			continue;
+		}
+
+		if (p_slot->us_tx_dst_addr == 0xFFFF) {
+			dstAddr.m_u8AddrLength = 8;
+			memcpy(dstAddr.m_u8ExtendedAddr, &p_slot->m_LbdAddress.m_au8Value, 8);
+		} else {
+			dstAddr.m_u8AddrLength = 2;
+			dstAddr.m_u16ShortAddr = p_slot->us_tx_dst_addr;
+		}
+
+		if (p_slot->uc_pending_confirms > 0) {
+			p_slot->uc_pending_tx_handler = p_slot->uc_tx_handle;
+		}
+
+		p_slot->uc_tx_handle = get_next_nsdu_handler();
+		bootstrap_handle_slot[p_slot->uc_tx_handle] = p_slot->us_index + 1;
+		us_bootstrap_pending_lbp++;
+		arm_bootstrap_slot_timeout(p_slot, oss_get_up_time_ms() + 1000 * us_msg_timeout_in_s * 10);
+		p_slot->uc_pending_confirms++;
+
+		log_show_slots_status();
+		LOG_BOOTSTRAP(("[BS] AdpLbpRequest Called, handler: %d \r\n", p_slot->uc_tx_handle));
+		AdpLbpRequest((struct TAdpAddress const *)&dstAddr,     /* Destination address */
+				p_slot->us_data_length,                                /* NSDU length */
+				&p_slot->auc_data[0],                                  /* NSDU */
+				p_slot->uc_tx_handle,                            /* NSDU handle */
+				p_slot->uc_tx_max_hops,                         /* Max. Hops */
+				true,                                       /* Discover route */
+				0,                                          /* QoS */
+				false);                                     /* Security enable */
+	}
+}
+
+/**
+ * \brief ADP buffers state, queued messages are not sent while not ready
+ *
+ */
+void set_bootstrap_tx_ready(bool b_ready)
+{
+	b_bootstrap_tx_ready = b_ready;
+	process_bootstrap_tx();
+}
+
+/**
+ * \brief Reset a slot, its bootstrap is aborted
+ *
+ */
+static void _reset_bootstrap_slot(t_bootstrap_slot *p_slot)
+{
+	p_slot->e_state = BS_STATE_WAITING_JOINNING;
+	p_slot->uc_pending_confirms = 0;
+	p_slot->ul_nonce =  0;
+	p_slot->ul_timeout = 0xFFFFFFFF;
+	release_bootstrap_slot_if_idle(p_slot);
+}
+
+/**
+ * \brief Handle an expired slot timeout: the last message is sent again or the bootstrap is aborted
+ *
+ */
+static void _expire_bootstrap_slot(t_bootstrap_slot *p_slot)
+{
+	LOG_BOOTSTRAP(("[BS] timeout_is_past for %d\r\n", p_slot->us_index));
+	if (p_slot->uc_pending_confirms == 0) {
+		if (p_slot->uc_tx_attemps < BOOTSTRAP_MSG_MAX_RETRIES) {
+			p_slot->uc_tx_attemps++;
+			if (p_slot->e_state == BS_STATE_WAITING_EAP_MSG_2) {
+				p_slot->e_state = BS_STATE_SENT_EAP_MSG_1;
+				LOG_BOOTSTRAP(("[BS] Slot updated to BS_STATE_SENT_EAP_MSG_1\r\n"));
+				log_show_slots_status();
+			} else if (p_slot->e_state == BS_STATE_WAITING_EAP_MSG_4) {
+				p_slot->e_state = BS_STATE_SENT_EAP_MSG_3;
+				LOG_BOOTSTRAP(("[BS] Slot updated to BS_STATE_SENT_EAP_MSG_3\r\n"));
+				log_show_slots_status();
 			}
+
+			if (p_slot->us_data_length > 0) {
+				LOG_BOOTSTRAP(("[BS] Timeout detected. Re-sending MSG for slot: %d Attempt: %d \r\n", p_slot->us_index,
+						p_slot->uc_tx_attemps));
+				send_bootstrap_slot_msg(p_slot, p_slot->us_lba_src_addr, g_s_bs_conf.m_u8MaxHop);
+			} else {
+				/* Nothing to send, checked again in next process */
+				arm_bootstrap_slot_timeout(p_slot, oss_get_up_time_ms());
+			}
+		} else {
+			LOG_BOOTSTRAP(("[BS] Reset slot %d:  \r\n", p_slot->us_index));
+			_reset_bootstrap_slot(p_slot);
 		}
+	} else { /* Pending confirm then increase timeout time */
+		LOG_BOOTSTRAP(("[BS] NEVER SHOUL BE HERE --> Reset slot %d:  \r\n", p_slot->us_index));
+		_reset_bootstrap_slot(p_slot);
 	}
 }
 
+void  update_bootstrap_slots(void)
+{
+	t_bootstrap_timer x_timer;
+	t_bootstrap_slot *p_slot;
+
+	while ((ul_bootstrap_timers_count > 0) && timeout_is_past(bootstrap_timers[0].ul_timeout)) {
+		x_timer = bootstrap_timers[0];
+		_bootstrap_timer_pop();
+
+		/* Discard timeouts changed after being set, or of slots not in bootstrap */
+		p_slot = get_bootstrap_slot_by_index(x_timer.us_slot);
+		if (!p_slot->b_in_use || p_slot->b_tx_queued || (p_slot->ul_timeout != x_timer.ul_timeout) ||
+				(p_slot->e_state == BS_STATE_WAITING_JOINNING)) {
+			continue;
+		}
+
+		_expire_bootstrap_slot(p_slot);
+	}
+
+	process_bootstrap_tx();
+}
+
 uint8_t  get_max_hops_from_nodes_under_registering(void)
 {
-	uint8_t uc_i;
+	uint16_t us_i;
 	uint8_t uc_result = 0;
-	for (uc_i = 0; uc_i < BOOTSTRAP_NUM_SLOTS; uc_i++) {
-		/* log_show_slots_status(); */
-		if (bootstrap_slots[uc_i].e_state != BS_STATE_WAITING_JOINNING) {
-			if (!timeout_is_past(bootstrap_slots[uc_i].ul_timeout)) {
-				if (bootstrap_slots[uc_i].uc_lbp_hops > uc_result) {
-					uc_result = bootstrap_slots[uc_i].uc_lbp_hops;
+	t_bootstrap_slot *p_slot;
+
+	for (us_i = 0; us_i < us_bootstrap_slots_allocated; us_i++) {
+		p_slot = get_bootstrap_slot_by_index(us_i);
+		if (p_slot->b_in_use && (p_slot->e_state != BS_STATE_WAITING_JOINNING)) {
+			if (!timeout_is_past(p_slot->ul_timeout)) {
+				if (p_slot->uc_lbp_hops > uc_result) {
+					uc_result = p_slot->uc_lbp_hops;
 				}
 			}
 		}
@@ -80,9 +80,13 @@ enum e_bootstrap_slot_state {
 	BS_STATE_SENT_EAP_MSG_DECLINED,
 };
 
-/* BOOTSTRAP_NUM_SLOTS defines the number of parallel bootstrap procedures that must be carried out */
-#define BOOTSTRAP_NUM_SLOTS 5
+/* Bootstrap slots are allocated on demand, BOOTSTRAP_SLOTS_CHUNK at a time, up to BOOTSTRAP_MAX_SLOTS (conf_bs.h) */
+#define BOOTSTRAP_SLOTS_CHUNK 64
 #define BOOTSTRAP_MSG_MAX_RETRIES 1
+/* Max. LBP requests waiting for confirm, further messages wait in slots TX queue */
+#define BOOTSTRAP_MAX_PENDING_LBP 32
+/* New bootstrap procedures are not started while more messages wait in TX queue */
+#define BOOTSTRAP_MAX_QUEUED_LBP 64
 
 typedef struct {
 	enum e_bootstrap_slot_state e_state;
@@ -104,6 +108,13 @@ typedef struct {
   	uint8_t m_u8MediaType;
   	uint8_t m_u8DisableBackupMedium;
 #endif
+	uint16_t us_index;          /* Position in slots pool */
+	bool b_in_use;
+	bool b_tx_queued;
+	uint16_t us_next;           /* Next slot in free list or TX queue */
+	uint16_t us_tx_dst_addr;    /* 0xFFFF: message is sent to m_LbdAddress */
+	uint8_t uc_tx_max_hops;
+	uint16_t us_rekey_idx;      /* LBDs list index of the LBD under rekeying, BS_REKEY_NO_LBD if none */
 } t_bootstrap_slot;
 struct TAddress {
 	uint8_t m_u8AddrLength;
@@ -219,6 +230,7 @@ typedef struct {
 #define LBP_REKEYING_OFF   0
 #define LBP_REKEYING_PHASE_DISTRIBUTE    0
 #define LBP_REKEYING_PHASE_ACTIVATE      1
+#define BS_REKEY_NO_LBD                  0xFFFF
 
 uint16_t get_lbds_count(void);
 bool is_null_address(uint8_t *puc_extended_address);
@@ -259,11 +271,19 @@ void set_ids(const uint8_t *puc_ids, uint8_t uc_size);
 void set_psk(uint8_t *puc_new_psk);
 void lbp_set_rekeying(uint8_t on_off);
 uint16_t lbp_get_rekeying(void);
+void rekey_lbd_finished(uint16_t us_lbd_idx, bool b_success);
+void bs_state_changed(enum bs_state_item e_item, uint16_t us_index);
 uint8_t get_next_nsdu_handler(void);
 
 void  init_bootstrap_slots(void);
 t_bootstrap_slot *get_bootstrap_slot_by_addr(uint8_t *p_eui64);
-t_bootstrap_slot *get_bootstrap_slot_by_index(uint8_t uc_index);
+t_bootstrap_slot *get_bootstrap_slot_by_index(uint16_t us_index);
+t_bootstrap_slot *confirm_bootstrap_slot_handle(uint8_t uc_handle);
+void release_bootstrap_slot_if_idle(t_bootstrap_slot *p_bs_slot);
+void arm_bootstrap_slot_timeout(t_bootstrap_slot *p_bs_slot, uint32_t ul_timeout);
+void send_bootstrap_slot_msg(t_bootstrap_slot *p_bs_slot, uint16_t us_dst_addr, uint8_t uc_max_hops);
+void process_bootstrap_tx(void);
+void set_bootstrap_tx_ready(bool b_ready);
 
 void  update_bootstrap_slots(void);
 bool timeout_is_past(uint32_t ul_timeout_value);
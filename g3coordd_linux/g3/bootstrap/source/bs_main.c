@@ -56,21 +56,40 @@ extern "C" {
 #include "bs_functions.h"
 #include "conf_bs.h"
 
-int g_lbs_join_finished = 0;
-
-uint16_t us_rekey_idx = 0;
-uint16_t us_rekey_phase = LBP_REKEYING_PHASE_DISTRIBUTE;
+PAN_LOCAL int g_lbs_join_finished = 0;
+
+PAN_LOCAL uint16_t us_rekey_phase = LBP_REKEYING_PHASE_DISTRIBUTE;
+
+/* Rekeying state of each LBDs list entry */
+#define REKEY_LBD_NONE       0
+#define REKEY_LBD_PENDING    1
+#define REKEY_LBD_IN_FLIGHT  2
+#define REKEY_LBD_DONE       3
+#define REKEY_LBD_FAILED     4
+
+static PAN_LOCAL uint8_t s_auc_rekey_state[MAX_LBDS];
+/* Pacing weight of LBDs in flight (LBP hops, at least 1) */
+static PAN_LOCAL uint8_t s_auc_rekey_weight[MAX_LBDS];
+static PAN_LOCAL uint16_t s_us_rekey_next = 0;
+static PAN_LOCAL uint16_t s_us_rekey_in_flight = 0;
+static PAN_LOCAL uint16_t s_us_rekey_weight_in_flight = 0;
+static PAN_LOCAL uint16_t s_us_rekey_max_parallel = BS_REKEY_MAX_PARALLEL;
+/* ADP_IB_MAX_HOPS, read once per campaign */
+static PAN_LOCAL uint8_t s_uc_rekey_max_hops;
+static PAN_LOCAL bool s_b_rekey_pumping = false;
+static PAN_LOCAL struct t_bs_rekey_status s_x_rekey_status;
 
 /* Buffer and length for non-bootstrap messages (i.e., KICK, etc...) */
-uint8_t g_puc_data[100];
-uint16_t g_us_length;
+PAN_LOCAL uint8_t g_puc_data[100];
+PAN_LOCAL uint16_t g_us_length;
 
-static TBootstrapAdpNotifications ss_notifications;
+static PAN_LOCAL TBootstrapAdpNotifications ss_notifications;
 
-extern lbds_list_entry_t g_lbds_list[MAX_LBDS];
+extern PAN_LOCAL lbds_list_entry_t g_lbds_list[MAX_LBDS];
 
-static pf_app_leave_ind_cb_t pf_app_leave_ind_cb;
-static pf_app_join_ind_cb_t pf_app_join_ind_cb;
+static PAN_LOCAL pf_app_leave_ind_cb_t pf_app_leave_ind_cb;
+static PAN_LOCAL pf_app_join_ind_cb_t pf_app_join_ind_cb;
+static PAN_LOCAL pf_app_state_ind_cb_t pf_app_state_ind_cb;
 
 static void _set_keying_table(uint8_t u8KeyIndex, uint8_t *key)
 {
@@ -96,68 +115,171 @@ static void _activate_new_key(void)
 	_set_keying_table(u8NewKeyIndex, (uint8_t *)GetGMK());
 }
 
-static void _rekeying_process(void)
+/**
+ * \brief Send the rekeying message of the current phase to a LBD
+ *
+ * \return false if no bootstrap slot is available
+ */
+static bool _rekey_start_lbd(uint16_t us_lbd_idx)
 {
-	struct TAddress dstAddr;
 	struct TAdpExtendedAddress x_ext_address;
-	struct TAdpGetConfirm getConfirm;
-	uint8_t uc_handle;
+	t_bootstrap_slot *p_bs_slot;
 
-	memcpy(x_ext_address.m_au8Value, g_lbds_list[us_rekey_idx].puc_extended_address, ADP_ADDRESS_64BITS);
+	memcpy(x_ext_address.m_au8Value, g_lbds_list[us_lbd_idx].puc_extended_address, ADP_ADDRESS_64BITS);
+
+	p_bs_slot = get_bootstrap_slot_by_addr(g_lbds_list[us_lbd_idx].puc_extended_address);
+	if (p_bs_slot == NULL) {
+		return false;
+	}
 
-	t_bootstrap_slot *p_bs_slot = get_bootstrap_slot_by_addr( g_lbds_list[us_rekey_idx].puc_extended_address);
+	s_auc_rekey_state[us_lbd_idx] = REKEY_LBD_IN_FLIGHT;
+	s_auc_rekey_weight[us_lbd_idx] = (g_lbds_list[us_lbd_idx].uc_lbp_hops > 0) ? g_lbds_list[us_lbd_idx].uc_lbp_hops : 1;
+	s_us_rekey_in_flight++;
+	s_us_rekey_weight_in_flight += s_auc_rekey_weight[us_lbd_idx];
 
-	if (p_bs_slot) {
-		initialize_bootstrap_message(p_bs_slot);
+	initialize_bootstrap_message(p_bs_slot);
+	p_bs_slot->us_rekey_idx = us_lbd_idx;
 #ifdef G3_HYBRID_PROFILE
-		/* DISABLE_BACKUP_FLAG and MediaType set to 0x0 in Rekeying frames */
-		p_bs_slot->m_u8DisableBackupMedium = 0;
-		p_bs_slot->m_u8MediaType = 0;
+	/* DISABLE_BACKUP_FLAG and MediaType set to 0x0 in Rekeying frames */
+	p_bs_slot->m_u8DisableBackupMedium = 0;
+	p_bs_slot->m_u8MediaType = 0;
 #endif
-		/* GMK distribution phase */
-		if (us_rekey_phase == LBP_REKEYING_PHASE_DISTRIBUTE) {
-			/* If re-keying in GMK distribution phase */
-			/* Send ADPM-LBP.Request(EAPReq(mes1)) to each registered device */
-			Process_Joining0(x_ext_address, p_bs_slot);
-			p_bs_slot->e_state = BS_STATE_SENT_EAP_MSG_1;
-			memcpy(p_bs_slot->m_LbdAddress.m_au8Value, g_lbds_list[us_rekey_idx].puc_extended_address, ADP_ADDRESS_64BITS);
-		} else { /* GMK activation phase (LBP_REKEYING_PHASE_ACTIVATE) */
-			process_accepted_GMK_activation(x_ext_address, p_bs_slot);
-			p_bs_slot->e_state = BS_STATE_SENT_EAP_MSG_ACCEPTED;
+	/* GMK distribution phase */
+	if (us_rekey_phase == LBP_REKEYING_PHASE_DISTRIBUTE) {
+		/* If re-keying in GMK distribution phase */
+		/* Send ADPM-LBP.Request(EAPReq(mes1)) to each registered device */
+		Process_Joining0(x_ext_address, p_bs_slot);
+		p_bs_slot->e_state = BS_STATE_SENT_EAP_MSG_1;
+	} else { /* GMK activation phase (LBP_REKEYING_PHASE_ACTIVATE) */
+		process_accepted_GMK_activation(x_ext_address, p_bs_slot);
+		p_bs_slot->e_state = BS_STATE_SENT_EAP_MSG_ACCEPTED;
+	}
+
+	/* Send the previously prepared message */
+	p_bs_slot->uc_tx_attemps = 0;
+	/* The short address is calculated using the index and the initial short address */
+	send_bootstrap_slot_msg(p_bs_slot, us_lbd_idx + get_initial_short_address(), s_uc_rekey_max_hops);
+	return true;
+}
+
+/**
+ * \brief Rekeying phase finished: start GMK activation or end the campaign
+ *
+ */
+static void _rekeying_phase_end(void)
+{
+	uint16_t us_i;
+
+	LOG_BOOTSTRAP(("[BS] Re-keying phase %hu finished: %hu done, %hu failed\r\n", us_rekey_phase,
+			s_x_rekey_status.us_done, s_x_rekey_status.us_failed));
+
+	if ((us_rekey_phase == LBP_REKEYING_PHASE_DISTRIBUTE) && (s_x_rekey_status.us_done > 0)) {
+		/* Devices provided with the new GMK -> activation phase. Failed ones are not activated. */
+		us_rekey_phase = LBP_REKEYING_PHASE_ACTIVATE;
+		s_x_rekey_status.uc_phase = LBP_REKEYING_PHASE_ACTIVATE;
+		s_x_rekey_status.us_total = s_x_rekey_status.us_done;
+		s_x_rekey_status.us_pending = s_x_rekey_status.us_done;
+		s_x_rekey_status.us_done = 0;
+		s_x_rekey_status.us_failed = 0;
+		for (us_i = 0; us_i < MAX_LBDS; us_i++) {
+			if (s_auc_rekey_state[us_i] == REKEY_LBD_DONE) {
+				s_auc_rekey_state[us_i] = REKEY_LBD_PENDING;
+			} else {
+				s_auc_rekey_state[us_i] = REKEY_LBD_NONE;
+			}
+		}
+
+		s_us_rekey_next = 0;
+	} else {
+		/* End of re-keying process. New GMK is not used if no device got it */
+		if (us_rekey_phase == LBP_REKEYING_PHASE_ACTIVATE) {
+			_activate_new_key();
 		}
 
-		/* Send the previously prepared message */
-		dstAddr.m_u8AddrLength = 2;
-		/* The short address is calculated using the index and the initial short address */
-		dstAddr.m_u16ShortAddr = us_rekey_idx + get_initial_short_address();
+		s_x_rekey_status.b_running = false;
+		lbp_set_rekeying(LBP_REKEYING_OFF);
+		LOG_BOOTSTRAP(("[BS] Re-keying finished.\r\n"));
+	}
+}
+
+/**
+ * \brief Start rekeying of pending LBDs, up to the parallel and hops limits
+ *
+ */
+static void _rekeying_process(void)
+{
+	uint16_t us_lbd_idx;
+	uint8_t uc_weight;
+
+	/* Called again when a slot ends while starting a LBD: outer loop continues */
+	if (s_b_rekey_pumping) {
+		return;
+	}
+
+	s_b_rekey_pumping = true;
+	while (lbp_get_rekeying()) {
+		while ((s_us_rekey_next < MAX_LBDS) && (s_us_rekey_in_flight < s_us_rekey_max_parallel)) {
+			us_lbd_idx = s_us_rekey_next;
+			if (s_auc_rekey_state[us_lbd_idx] != REKEY_LBD_PENDING) {
+				s_us_rekey_next++;
+				continue;
+			}
+
+			/* Far devices use the medium longer: pace by number of hops */
+			uc_weight = (g_lbds_list[us_lbd_idx].uc_lbp_hops > 0) ? g_lbds_list[us_lbd_idx].uc_lbp_hops : 1;
+			if ((s_us_rekey_in_flight > 0) && (s_us_rekey_weight_in_flight + uc_weight > BS_REKEY_MAX_HOPS_IN_FLIGHT)) {
+				break;
+			}
+
+			s_us_rekey_next++;
+			if (!_rekey_start_lbd(us_lbd_idx)) {
+				LOG_BOOTSTRAP(("[BS] Re-keying of LBD %hu failed: no bootstrap slot\r\n", us_lbd_idx));
+				s_auc_rekey_state[us_lbd_idx] = REKEY_LBD_FAILED;
+				s_x_rekey_status.us_pending--;
+				s_x_rekey_status.us_failed++;
+			}
+		}
 
-		AdpGetRequestSync(ADP_IB_MAX_HOPS, 0, &getConfirm);
-		/* AdpGetRequest(ADP_IB_MAX_HOPS, 0); */
-		if (p_bs_slot->uc_pending_confirms > 0) {
-			p_bs_slot->uc_pending_tx_handler = p_bs_slot->uc_tx_handle;
+		if ((s_us_rekey_in_flight > 0) || (s_us_rekey_next < MAX_LBDS)) {
+			break;
 		}
 
-		uc_handle = get_next_nsdu_handler();
-		p_bs_slot->ul_timeout = oss_get_up_time_ms() + 1000 * get_msg_timeout_value() * 10;
-		p_bs_slot->uc_tx_handle = uc_handle;
-		p_bs_slot->uc_tx_attemps = 0;
-		p_bs_slot->uc_pending_confirms++;
-		LOG_BOOTSTRAP(("[BS] AdpLbpRequest Called, handler: %d \r\n", p_bs_slot->uc_tx_handle));
-		AdpLbpRequest((struct TAdpAddress const *)&dstAddr,      /* Destination address */
-				p_bs_slot->us_data_length,                                /* NSDU length */
-				&p_bs_slot->auc_data[0],                                  /* NSDU */
-				uc_handle,                            /* NSDU handle */
-				getConfirm.m_au8AttributeValue[0],           /* Max. Hops */
-				true,                                        /* Discover route */
-				0,                                           /* QoS */
-				false);                                      /* Security enable */
+		_rekeying_phase_end();
+	}
+
+	s_b_rekey_pumping = false;
+}
+
+/**
+ * \brief A LBD rekeying step ended, with the GMK (de)activation accepted or not
+ *
+ */
+void rekey_lbd_finished(uint16_t us_lbd_idx, bool b_success)
+{
+	if ((us_lbd_idx >= MAX_LBDS) || (s_auc_rekey_state[us_lbd_idx] != REKEY_LBD_IN_FLIGHT)) {
+		return;
+	}
+
+	s_us_rekey_in_flight--;
+	s_us_rekey_weight_in_flight -= s_auc_rekey_weight[us_lbd_idx];
+	s_x_rekey_status.us_pending--;
+	if (b_success) {
+		s_auc_rekey_state[us_lbd_idx] = REKEY_LBD_DONE;
+		s_x_rekey_status.us_done++;
+	} else {
+		LOG_BOOTSTRAP(("[BS] Re-keying of LBD %hu failed\r\n", us_lbd_idx));
+		s_auc_rekey_state[us_lbd_idx] = REKEY_LBD_FAILED;
+		s_x_rekey_status.us_failed++;
 	}
+
+	_rekeying_process();
 }
 
 static void AdpNotification_LbpIndication(struct TAdpLbpIndication *pLbpIndication)
 {
 	enum lbp_indications indication = LBS_NONE;
 
+	bs_lock();
 	LOG_BOOTSTRAP(("[BS] pLbpIndication->m_u16NsduLength %hu.\r\n", pLbpIndication->m_u16NsduLength));
 	LOG_BOOTSTRAP(("[BS] TAdpLbpIndication: SrcAddr: 0x%04X LinkQualityIndicator: %hu SecurityEnabled: %hu NsduLength: %hu.\r\n",
 			pLbpIndication->m_u16SrcAddr, pLbpIndication->m_u8LinkQualityIndicator,
@@ -179,19 +301,21 @@ static void AdpNotification_LbpIndication(struct TAdpLbpIndication *pLbpIndicati
 	}
 
 	LOG_BOOTSTRAP(("[BS] pLbpIndication ends\n"));
+	bs_unlock();
 }
 
 static void AdpNotification_LbpConfirm(struct TAdpLbpConfirm *pLbpConfirm)
 {
-	uint8_t uc_i;
-
 	t_bootstrap_slot *p_current_slot = NULL;
 
 	bool b_is_accepted_confirm = false;
+	t_bootstrap_slot *p_slot;
 
-	for (uc_i = 0; uc_i < BOOTSTRAP_NUM_SLOTS; uc_i++) {
-		t_bootstrap_slot *p_slot = get_bootstrap_slot_by_index(uc_i);
+	bs_lock();
+	/* Slot which sent the request */
+	p_slot = confirm_bootstrap_slot_handle(pLbpConfirm->m_u8NsduHandle);
 
+	if (p_slot != NULL) {
 		if (p_slot->uc_pending_confirms == 1 && pLbpConfirm->m_u8NsduHandle == p_slot->uc_tx_handle && p_slot->e_state != BS_STATE_WAITING_JOINNING) {
 			LOG_BOOTSTRAP(("[BS] AdpNotification_LbpConfirm (%02X:%02X:%02X:%02X:%02X:%02X:%02X:%02X).\r\n",
 					p_slot->m_LbdAddress.m_au8Value[0], p_slot->m_LbdAddress.m_au8Value[1],
@@ -271,33 +395,20 @@ static void AdpNotification_LbpConfirm(struct TAdpLbpConfirm *pLbpConfirm)
 		LOG_BOOTSTRAP(("[BS] AdpNotification_LbpConfirm from unkown node, status: %d  handler: %d \r\n",
 				pLbpConfirm->m_u8Status, pLbpConfirm->m_u8NsduHandle));
 		log_show_slots_status();
+		process_bootstrap_tx();
+		bs_unlock();
 		return;
 	} else {
-		p_current_slot->ul_timeout = oss_get_up_time_ms() + 1000 * get_msg_timeout_value();
+		arm_bootstrap_slot_timeout(p_current_slot, oss_get_up_time_ms() + 1000 * get_msg_timeout_value());
 	}
 
 	if (pLbpConfirm->m_u8Status == G3_SUCCESS && b_is_accepted_confirm) {
-		if (lbp_get_rekeying()) {
-			/* If a re-keying phase is in progress */
-			if (us_rekey_idx < bs_lbp_get_lbds_counter() - 1) {
-				us_rekey_idx++;
-				/* Continue rekeying process with next node */
-				_rekeying_process();
-			} else {
-				if (us_rekey_phase == LBP_REKEYING_PHASE_DISTRIBUTE) {
-					/* All devices have been provided with the new GMK -> next phase */
-					us_rekey_phase = LBP_REKEYING_PHASE_ACTIVATE;
-					/* Reset the index to send GMK activation to all joined devices. */
-					us_rekey_idx = 0;
-					/* Call process to start activation phase */
-					_rekeying_process();
-				} else {
-					/* End of re-keying process */
-					us_rekey_idx = 0;
-					lbp_set_rekeying(LBP_REKEYING_OFF);
-					_activate_new_key();
-				}
-			}
+		if (p_current_slot->us_rekey_idx != BS_REKEY_NO_LBD) {
+			uint16_t us_rekey_idx = p_current_slot->us_rekey_idx;
+
+			/* Re-keying step accepted, continue with next nodes */
+			p_current_slot->us_rekey_idx = BS_REKEY_NO_LBD;
+			rekey_lbd_finished(us_rekey_idx, true);
 		} else {
 			uint8_t *puc_ext_addr;
 			uint16_t us_short_addr;
@@ -318,6 +429,11 @@ static void AdpNotification_LbpConfirm(struct TAdpLbpConfirm *pLbpConfirm)
 			}
 		}
 	}
+
+	/* Bootstrap finished: slot can be reused. A confirm frees room for queued messages */
+	release_bootstrap_slot_if_idle(p_current_slot);
+	process_bootstrap_tx();
+	bs_unlock();
 }
 
 /**
@@ -326,6 +442,10 @@ static void AdpNotification_LbpConfirm(struct TAdpLbpConfirm *pLbpConfirm)
  */
 void bs_init(TBootstrapConfiguration s_bs_conf)
 {
+	bs_lock();
+	/* State changes done while initializing are not reported */
+	pf_app_state_ind_cb = NULL;
+
 	lbp_init_functions();
 
 	set_bs_configuration(s_bs_conf);
@@ -335,6 +455,7 @@ void bs_init(TBootstrapConfiguration s_bs_conf)
 	/* Init function pointers */
 	pf_app_leave_ind_cb = NULL;
 	pf_app_join_ind_cb = NULL;
+	bs_unlock();
 }
 
 /**
@@ -343,7 +464,20 @@ void bs_init(TBootstrapConfiguration s_bs_conf)
  */
 void bs_process(void)
 {
+	bs_lock();
 	update_bootstrap_slots();
+	bs_unlock();
+}
+
+/**
+ * bs_lbp_set_tx_ready.
+ *
+ */
+void bs_lbp_set_tx_ready(bool b_ready)
+{
+	bs_lock();
+	set_bootstrap_tx_ready(b_ready);
+	bs_unlock();
 }
 
 /**
@@ -365,19 +499,62 @@ TBootstrapAdpNotifications *bs_get_not_handlers(void)
  */
 void bs_lbp_launch_rekeying(void)
 {
+	struct TAdpGetConfirm getConfirm;
+	uint16_t us_i;
+
+	/* Out of the lock: the confirm may be processed by a USI thread waiting for it */
+	AdpGetRequestSync(ADP_IB_MAX_HOPS, 0, &getConfirm);
+	/* AdpGetRequest(ADP_IB_MAX_HOPS, 0); */
+
+	bs_lock();
+	if (lbp_get_rekeying()) {
+		LOG_BOOTSTRAP(("[BS] Re-keying NOT launched: already in progress.\r\n"));
+		bs_unlock();
+		return;
+	}
+
 	/* If there are devices that joined the network */
 	if (bs_lbp_get_lbds_counter() > 0) {
+		s_uc_rekey_max_hops = getConfirm.m_au8AttributeValue[0];
+
+		memset(&s_x_rekey_status, 0, sizeof(s_x_rekey_status));
+		for (us_i = 0; us_i < MAX_LBDS; us_i++) {
+			if (device_is_in_list(us_i + get_initial_short_address())) {
+				s_auc_rekey_state[us_i] = REKEY_LBD_PENDING;
+				s_x_rekey_status.us_total++;
+			} else {
+				s_auc_rekey_state[us_i] = REKEY_LBD_NONE;
+			}
+		}
+
 		/* Start the re-keying process */
+		s_x_rekey_status.b_running = true;
+		s_x_rekey_status.uc_phase = LBP_REKEYING_PHASE_DISTRIBUTE;
+		s_x_rekey_status.us_pending = s_x_rekey_status.us_total;
+		s_us_rekey_next = 0;
+		s_us_rekey_in_flight = 0;
+		s_us_rekey_weight_in_flight = 0;
 		lbp_set_rekeying(LBP_REKEYING_ON);
 		us_rekey_phase = LBP_REKEYING_PHASE_DISTRIBUTE;
-		/* Send the first re-keying process */
-		us_rekey_idx = 0;
+		LOG_BOOTSTRAP(("[BS] Re-keying launched for %hu devices.\r\n", s_x_rekey_status.us_total));
 		_rekeying_process();
-		LOG_BOOTSTRAP(("[BS] Re-keying launched.\r\n"));
 	} else {
 		/* Error: no device in the network */
 		LOG_BOOTSTRAP(("[BS] Re-keying NOT launched: no device in the network.\r\n"));
 	}
+
+	bs_unlock();
+}
+
+/**
+ * bs_lbp_get_rekey_status.
+ *
+ */
+void bs_lbp_get_rekey_status(struct t_bs_rekey_status *p_status)
+{
+	bs_lock();
+	*p_status = s_x_rekey_status;
+	bs_unlock();
 }
 
 /**
@@ -386,10 +563,16 @@ void bs_lbp_launch_rekeying(void)
  */
 void bs_lbp_kick_device(uint16_t us_short_address)
 {
+	struct TAdpGetConfirm getConfirm;
+
+	/* Out of the lock: the confirm may be processed by a USI thread waiting for it */
+	AdpGetRequestSync(ADP_IB_MAX_HOPS, 0, &getConfirm);
+	/* AdpGetRequest(ADP_IB_MAX_HOPS, 0); */
+
+	bs_lock();
 	/* Check if the device had joined the network */
 	if (device_is_in_list(us_short_address)) {
 		struct TAdpAddress dstAddr;
-		struct TAdpGetConfirm getConfirm;
 		uint8_t puc_extended_address[ADP_ADDRESS_64BITS];
 
 		/* Send KICK to the device */
@@ -402,8 +585,6 @@ void bs_lbp_kick_device(uint16_t us_short_address)
 
 		/* If message was properly encoded, send it */
 		if (g_us_length) {
-			AdpGetRequestSync(ADP_IB_MAX_HOPS, 0, &getConfirm);
-			/* AdpGetRequest(ADP_IB_MAX_HOPS, 0); */
 			AdpLbpRequest((struct TAdpAddress const *)&dstAddr,     /* Destination address */
 					g_us_length,                            /* NSDU length */
 					g_puc_data,                             /* NSDU */
@@ -421,6 +602,8 @@ void bs_lbp_kick_device(uint16_t us_short_address)
 	} else {
 		LOG_BOOTSTRAP(("[BS] Error: attempted KICK of not joined device [0x%04x]\r\n", us_short_address));
 	}
+
+	bs_unlock();
 }
 
 /**
@@ -429,7 +612,12 @@ void bs_lbp_kick_device(uint16_t us_short_address)
  */
 uint16_t bs_lbp_get_lbds_counter(void)
 {
-	return get_lbds_count();
+	uint16_t us_count;
+
+	bs_lock();
+	us_count = get_lbds_count();
+	bs_unlock();
+	return us_count;
 }
 
 /**
@@ -438,7 +626,12 @@ uint16_t bs_lbp_get_lbds_counter(void)
  */
 uint16_t bs_lbp_get_lbds_address(uint16_t i)
 {
-	return get_lbd_address(i);
+	uint16_t us_address;
+
+	bs_lock();
+	us_address = get_lbd_address(i);
+	bs_unlock();
+	return us_address;
 }
 
 /**
@@ -461,6 +654,7 @@ void bs_lbp_get_param(uint32_t ul_attribute_id, uint16_t us_attribute_idx, struc
 	p_get_confirm->uc_attribute_length = 0;
 	p_get_confirm->uc_status = LBP_STATUS_UNSUPPORTED_PARAMETER;
 
+	bs_lock();
 	if (ul_attribute_id == LBP_IB_DEVICE_LIST) {
 		if (us_attribute_idx < MAX_LBDS) {
 			uint16_t us_short_address = us_attribute_idx + get_initial_short_address();
@@ -500,9 +694,30 @@ void bs_lbp_get_param(uint32_t ul_attribute_id, uint16_t us_attribute_idx, struc
 		p_get_confirm->uc_attribute_length = 2;
 		p_get_confirm->uc_attribute_value[0] = (uint8_t)(us_timeout >> 8);
 		p_get_confirm->uc_attribute_value[1] = (uint8_t)(us_timeout & 0x00FF);
+	} else if (ul_attribute_id == LBP_IB_REKEY_MAX_PARALLEL) {
+		p_get_confirm->uc_status = LBP_STATUS_OK;
+		p_get_confirm->uc_attribute_length = 2;
+		p_get_confirm->uc_attribute_value[0] = (uint8_t)(s_us_rekey_max_parallel >> 8);
+		p_get_confirm->uc_attribute_value[1] = (uint8_t)(s_us_rekey_max_parallel & 0x00FF);
+	} else if (ul_attribute_id == LBP_IB_REKEY_STATUS) {
+		/* Running (1 byte), phase (1 byte), total, done, pending, failed (2 bytes each) */
+		p_get_confirm->uc_status = LBP_STATUS_OK;
+		p_get_confirm->uc_attribute_length = 10;
+		p_get_confirm->uc_attribute_value[0] = (uint8_t)s_x_rekey_status.b_running;
+		p_get_confirm->uc_attribute_value[1] = s_x_rekey_status.uc_phase;
+		p_get_confirm->uc_attribute_value[2] = (uint8_t)(s_x_rekey_status.us_total >> 8);
+		p_get_confirm->uc_attribute_value[3] = (uint8_t)(s_x_rekey_status.us_total & 0x00FF);
+		p_get_confirm->uc_attribute_value[4] = (uint8_t)(s_x_rekey_status.us_done >> 8);
+		p_get_confirm->uc_attribute_value[5] = (uint8_t)(s_x_rekey_status.us_done & 0x00FF);
+		p_get_confirm->uc_attribute_value[6] = (uint8_t)(s_x_rekey_status.us_pending >> 8);
+		p_get_confirm->uc_attribute_value[7] = (uint8_t)(s_x_rekey_status.us_pending & 0x00FF);
+		p_get_confirm->uc_attribute_value[8] = (uint8_t)(s_x_rekey_status.us_failed >> 8);
+		p_get_confirm->uc_attribute_value[9] = (uint8_t)(s_x_rekey_status.us_failed & 0x00FF);
 	} else {
 		/* Unknown LBS parameter */
 	}
+
+	bs_unlock();
 }
 
 /**
@@ -514,11 +729,13 @@ void bs_lbp_set_param(uint32_t ul_attribute_id, uint16_t us_attribute_idx, uint8
 {
 	uint16_t us_tmp_short_addr;
 	uint16_t us_tmp_timeout;
+	uint16_t us_tmp_parallel;
 
 	p_set_confirm->ul_attribute_id = ul_attribute_id;
 	p_set_confirm->us_attribute_idx = us_attribute_idx;
 	p_set_confirm->uc_status = LBP_STATUS_UNSUPPORTED_PARAMETER;
 
+	bs_lock();
 	switch (ul_attribute_id) {
 	case LBP_IB_IDS:
 		if ((uc_attribute_len == NETWORK_ACCESS_IDENTIFIER_SIZE_S_ARIB) || (uc_attribute_len == NETWORK_ACCESS_IDENTIFIER_SIZE_S_CENELEC_FCC)) {
@@ -636,10 +853,30 @@ void bs_lbp_set_param(uint32_t ul_attribute_id, uint16_t us_attribute_idx, uint8
 
 		break;
 
+	case LBP_IB_REKEY_MAX_PARALLEL:
+		if (uc_attribute_len == 2) {
+			us_tmp_parallel = ((puc_attribute_value[1] << 8) | puc_attribute_value[0]);
+			if (us_tmp_parallel > 0) {
+				/* Applies to next LBDs started, also in a running campaign */
+				s_us_rekey_max_parallel = us_tmp_parallel;
+				p_set_confirm->uc_status = LBP_STATUS_OK;
+				_rekeying_process();
+			} else {
+				p_set_confirm->uc_status = LBP_STATUS_INVALID_VALUE;
+			}
+		} else {
+			/* Wrong parameter size */
+			p_set_confirm->uc_status = LBP_STATUS_INVALID_LENGTH;
+		}
+
+		break;
+
 	default:
 		/* Unknown LBS parameter */
 		break;
 	}
+
+	bs_unlock();
 }
 
 /**
@@ -648,7 +885,9 @@ void bs_lbp_set_param(uint32_t ul_attribute_id, uint16_t us_attribute_idx, uint8
  */
 void bs_lbp_leave_ind_set_cb(pf_app_leave_ind_cb_t pf_handler)
 {
+	bs_lock();
 	pf_app_leave_ind_cb = pf_handler;
+	bs_unlock();
 }
 
 /**
@@ -657,7 +896,43 @@ void bs_lbp_leave_ind_set_cb(pf_app_leave_ind_cb_t pf_handler)
  */
 void bs_lbp_join_ind_set_cb(pf_app_join_ind_cb_t pf_handler)
 {
+	bs_lock();
 	pf_app_join_ind_cb = pf_handler;
+	bs_unlock();
+}
+
+/**
+ * bs_lbp_state_ind_set_cb.
+ *
+ */
+void bs_lbp_state_ind_set_cb(pf_app_state_ind_cb_t pf_handler)
+{
+	bs_lock();
+	pf_app_state_ind_cb = pf_handler;
+	bs_unlock();
+}
+
+/**
+ * \brief Reports a change in bootstrap state to the application
+ *
+ */
+void bs_state_changed(enum bs_state_item e_item, uint16_t us_index)
+{
+	if (pf_app_state_ind_cb != NULL) {
+		pf_app_state_ind_cb(e_item, us_index);
+	}
+}
+
+/**
+ * \brief Restores GMK and active key index recovered from persistent storage
+ *
+ */
+void bs_restore_keys(const uint8_t *puc_gmk, uint8_t uc_key_index)
+{
+	bs_lock();
+	set_gmk((uint8_t *)puc_gmk);
+	_set_keying_table(uc_key_index, (uint8_t *)GetGMK());
+	bs_unlock();
 }
 
 /* / @cond 0 */
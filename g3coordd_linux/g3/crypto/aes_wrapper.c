@@ -37,19 +37,19 @@
 #include "aes_wrapper.h"
 #include "mbedtls/aes.h"
 #include "mbedtls/memory_buffer_alloc.h"
+#if defined(MBEDTLS_AESNI_C)
+#include "mbedtls/aesni.h"
+#endif
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRYPTO)
+#include <arm_neon.h>
+#define AES_WRAPPER_ARMV8_CE
+#endif
 
 #if defined(__cplusplus)
 extern "C"
 {
 #endif
 
-/** Key in byte format */
-static uint8_t spuc_key[256];
-/** Key size in bits */
-static uint16_t sus_key_size;
-
-mbedtls_aes_context aes_ctx;
-
 unsigned char mbedtls_buf[512];
 
 void crypto_init(void)
@@ -57,46 +57,26 @@ void crypto_init(void)
 	mbedtls_memory_buffer_alloc_init(mbedtls_buf, sizeof(mbedtls_buf));
 }
 
-AES_RETURN aes_encrypt(const unsigned char *in, unsigned char *out)
-{
-	/* Initialize the AES */
-	mbedtls_aes_init(&aes_ctx);
-
-	/* Trigger the AES */
-	mbedtls_aes_setkey_enc(&aes_ctx, spuc_key, sus_key_size);
-	mbedtls_aes_encrypt(&aes_ctx, in, out);
-
-	/* Free the AES */
-	mbedtls_aes_free(&aes_ctx);
+#ifdef AES_WRAPPER_ARMV8_CE
 
-	return EXIT_SUCCESS;
-}
-
-AES_RETURN aes_decrypt(const unsigned char *in, unsigned char *out)
+/* mbedTLS encryption key schedule is the FIPS-197 one, in byte order on little endian */
+static void _aes_armv8_encrypt(const mbedtls_aes_context *ctx, const unsigned char input[16], unsigned char output[16])
 {
-	/* Initialize the AES */
-	mbedtls_aes_init(&aes_ctx);
-
-	/* Trigger the AES */
-	mbedtls_aes_setkey_dec(&aes_ctx, spuc_key, sus_key_size);
-	mbedtls_aes_decrypt(&aes_ctx, in, out);
-
-	/* Free the AES */
-	mbedtls_aes_free(&aes_ctx);
-
-	return EXIT_SUCCESS;
+	const uint8_t *puc_rk = (const uint8_t *)ctx->rk;
+	uint8x16_t x_block = vld1q_u8(input);
+	int i;
+
+	for (i = 0; i < ctx->nr - 1; i++) {
+		x_block = vaesmcq_u8(vaeseq_u8(x_block, vld1q_u8(puc_rk)));
+		puc_rk += 16;
+	}
+
+	x_block = vaeseq_u8(x_block, vld1q_u8(puc_rk));
+	x_block = veorq_u8(x_block, vld1q_u8(puc_rk + 16));
+	vst1q_u8(output, x_block);
 }
 
-AES_RETURN aes_key(const unsigned char *key, int key_len)
-{
-	/* Store the key */
-	memcpy(spuc_key, key, key_len);
-
-	/* Store the key size */
-	sus_key_size = key_len * 8;
-
-	return EXIT_SUCCESS;
-}
+#endif
 
 void aes_wrapper_aes_init(aes_wrapper_context *ctx)
 {
@@ -110,7 +90,12 @@ int aes_wrapper_aes_setkey_enc(aes_wrapper_context *ctx, const unsigned char *ke
 
 void aes_wrapper_aes_encrypt(aes_wrapper_context *ctx, const unsigned char input[16], unsigned char output[16])
 {
-	mbedtls_aes_encrypt((mbedtls_aes_context *)ctx, input, output);
+#ifdef AES_WRAPPER_ARMV8_CE
+	_aes_armv8_encrypt((const mbedtls_aes_context *)ctx, input, output);
+#else
+	/* ECB entry point selects AES-NI when the CPU supports it */
+	mbedtls_aes_crypt_ecb((mbedtls_aes_context *)ctx, MBEDTLS_AES_ENCRYPT, input, output);
+#endif
 }
 
 void aes_wrapper_aes_free(aes_wrapper_context *ctx)
@@ -118,6 +103,32 @@ void aes_wrapper_aes_free(aes_wrapper_context *ctx)
 	mbedtls_aes_free((mbedtls_aes_context *)ctx);
 }
 
+const char *aes_wrapper_aes_engine(void)
+{
+#if defined(AES_WRAPPER_ARMV8_CE)
+	return "ARMv8-CE";
+#else
+#if defined(MBEDTLS_AESNI_C) && defined(MBEDTLS_HAVE_X86_64)
+	if (mbedtls_aesni_has_support(MBEDTLS_AESNI_AES)) {
+		return "AES-NI";
+	}
+#endif
+	return "software";
+#endif
+}
+
+void aes_wrapper_init(void)
+{
+	static const unsigned char auc_key[16] = {0};
+	mbedtls_aes_context x_ctx;
+
+	/* First key expansion builds the tables */
+	mbedtls_aes_init(&x_ctx);
+	mbedtls_aes_setkey_enc(&x_ctx, auc_key, 128);
+	mbedtls_aes_free(&x_ctx);
+	(void)aes_wrapper_aes_engine();
+}
+
 #if defined(__cplusplus)
 }
 #endif
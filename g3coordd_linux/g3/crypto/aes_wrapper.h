@@ -78,16 +78,24 @@ aes_wrapper_context;
 /* tables are being used                                            */
 void crypto_init(void);
 
-AES_RETURN aes_encrypt(const unsigned char *in, unsigned char *out);
-AES_RETURN aes_decrypt(const unsigned char *in, unsigned char *out);
-AES_RETURN aes_key(const unsigned char *key, int key_len);
-
-/* API functions to map on source file to mbedTLS or library used */
+/* API functions to map on source file to mbedTLS or library used. */
+/* There is no global key: every user (EAX context, CMAC context, EAP-PSK */
+/* session) keeps its own context, the key is expanded once in setkey. */
+/* Blocks are encrypted with the AES instructions of the CPU when available: */
+/* AES-NI (detected at run time) or ARMv8 Cryptography Extensions (when */
+/* built for them, e.g. -march=armv8-a+crypto). */
 void aes_wrapper_aes_init(aes_wrapper_context *ctx);
 int aes_wrapper_aes_setkey_enc(aes_wrapper_context *ctx, const unsigned char *key, unsigned int keybits);
 void aes_wrapper_aes_encrypt(aes_wrapper_context * ctx, const unsigned char input[16], unsigned char output[16]);
 void aes_wrapper_aes_free(aes_wrapper_context *ctx);
 
+/* Name of the AES implementation in use: "AES-NI", "ARMv8-CE" or "software" */
+const char *aes_wrapper_aes_engine(void);
+
+/* Builds the tables and detects the CPU features shared by all contexts. */
+/* Call it once before using contexts from several threads. */
+void aes_wrapper_init(void);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -109,6 +109,89 @@ void cipher_wrapper_ccm_free(cipher_wrapper_ccm_context *ctx)
 	mbedtls_ccm_free((mbedtls_ccm_context *)ctx);
 }
 
+/* Multiplication by x in GF(2^128), CMAC subkey generation */
+static void _aes_cmac_double(const unsigned char *input, unsigned char *output)
+{
+	unsigned char uc_msb = input[0] & 0x80;
+	int i;
+
+	for (i = 0; i < CIPHER_WRAPPER_CIPHER_BLKSIZE_MAX - 1; i++) {
+		output[i] = (unsigned char)((input[i] << 1) | (input[i + 1] >> 7));
+	}
+
+	output[CIPHER_WRAPPER_CIPHER_BLKSIZE_MAX - 1] = (unsigned char)(input[CIPHER_WRAPPER_CIPHER_BLKSIZE_MAX - 1] << 1);
+	if (uc_msb) {
+		output[CIPHER_WRAPPER_CIPHER_BLKSIZE_MAX - 1] ^= 0x87;
+	}
+}
+
+int cipher_wrapper_aes_cmac_setkey(cipher_wrapper_aes_cmac_context *ctx, const unsigned char *key, unsigned int keybits)
+{
+	unsigned char auc_l[CIPHER_WRAPPER_CIPHER_BLKSIZE_MAX] = {0};
+	int ret;
+
+	aes_wrapper_aes_init(&ctx->aes);
+	ret = aes_wrapper_aes_setkey_enc(&ctx->aes, key, keybits);
+	if (ret != 0) {
+		return ret;
+	}
+
+	aes_wrapper_aes_encrypt(&ctx->aes, auc_l, auc_l);
+	_aes_cmac_double(auc_l, ctx->k1);
+	_aes_cmac_double(ctx->k1, ctx->k2);
+	memset(auc_l, 0, sizeof(auc_l));
+
+	return 0;
+}
+
+void cipher_wrapper_aes_cmac(cipher_wrapper_aes_cmac_context *ctx, const unsigned char *input, size_t ilen,
+		unsigned char output[CIPHER_WRAPPER_CIPHER_BLKSIZE_MAX])
+{
+	unsigned char auc_x[CIPHER_WRAPPER_CIPHER_BLKSIZE_MAX] = {0};
+	const unsigned char *puc_subkey;
+	size_t n_blocks;
+	size_t n_last;
+	size_t i, j;
+
+	n_blocks = (ilen + CIPHER_WRAPPER_CIPHER_BLKSIZE_MAX - 1) / CIPHER_WRAPPER_CIPHER_BLKSIZE_MAX;
+	if (n_blocks == 0) {
+		n_blocks = 1;
+	}
+
+	for (i = 0; i < n_blocks - 1; i++) {
+		for (j = 0; j < CIPHER_WRAPPER_CIPHER_BLKSIZE_MAX; j++) {
+			auc_x[j] ^= *input++;
+		}
+
+		aes_wrapper_aes_encrypt(&ctx->aes, auc_x, auc_x);
+	}
+
+	/* Last block: complete one with K1, padded one with K2 */
+	n_last = ilen - (n_blocks - 1) * CIPHER_WRAPPER_CIPHER_BLKSIZE_MAX;
+	if (n_last == CIPHER_WRAPPER_CIPHER_BLKSIZE_MAX) {
+		puc_subkey = ctx->k1;
+	} else {
+		puc_subkey = ctx->k2;
+		auc_x[n_last] ^= 0x80;
+	}
+
+	for (j = 0; j < n_last; j++) {
+		auc_x[j] ^= input[j];
+	}
+
+	for (j = 0; j < CIPHER_WRAPPER_CIPHER_BLKSIZE_MAX; j++) {
+		auc_x[j] ^= puc_subkey[j];
+	}
+
+	aes_wrapper_aes_encrypt(&ctx->aes, auc_x, output);
+}
+
+void cipher_wrapper_aes_cmac_free(cipher_wrapper_aes_cmac_context *ctx)
+{
+	aes_wrapper_aes_free(&ctx->aes);
+	memset(ctx, 0, sizeof(cipher_wrapper_aes_cmac_context));
+}
+
 #if defined(__cplusplus)
 }
 #endif
@@ -34,6 +34,8 @@
 #ifndef _CIPHER_WRAPPER_H
 #define _CIPHER_WRAPPER_H
 
+#include "aes_wrapper.h"
+
 #if defined(__cplusplus)
 extern "C"
 {
@@ -311,6 +313,18 @@ typedef struct {
 }
 cipher_wrapper_ccm_context;
 
+/**
+ * \brief    AES-CMAC (RFC 4493) context. The key and subkeys are computed
+ *           once and used for every message of a session, no memory is
+ *           allocated.
+ */
+typedef struct {
+	aes_wrapper_context aes;                                /*!< AES context with the key expanded. */
+	unsigned char k1[CIPHER_WRAPPER_CIPHER_BLKSIZE_MAX];    /*!< Subkey for complete last block. */
+	unsigned char k2[CIPHER_WRAPPER_CIPHER_BLKSIZE_MAX];    /*!< Subkey for padded last block. */
+}
+cipher_wrapper_aes_cmac_context;
+
 /* API functions to map on source file to mbedTLS or library used */
 const cipher_wrapper_cipher_info_t *cipher_wrapper_cipher_info_from_type(const cipher_wrapper_cipher_type_t cipher_type);
 int cipher_wrapper_cipher_setup(cipher_wrapper_cipher_context_t *ctx, const cipher_wrapper_cipher_info_t *cipher_info);
@@ -329,6 +343,10 @@ int cipher_wrapper_ccm_encrypt_and_tag(cipher_wrapper_ccm_context *ctx, size_t l
 		size_t iv_len, const unsigned char *add, size_t add_len, const unsigned char *input,
 		unsigned char *output, unsigned char *tag, size_t tag_len);
 void cipher_wrapper_ccm_free(cipher_wrapper_ccm_context *ctx);
+int cipher_wrapper_aes_cmac_setkey(cipher_wrapper_aes_cmac_context *ctx, const unsigned char *key, unsigned int keybits);
+void cipher_wrapper_aes_cmac(cipher_wrapper_aes_cmac_context *ctx, const unsigned char *input, size_t ilen,
+		unsigned char output[CIPHER_WRAPPER_CIPHER_BLKSIZE_MAX]);
+void cipher_wrapper_aes_cmac_free(cipher_wrapper_aes_cmac_context *ctx);
 
 #if defined(__cplusplus)
 }
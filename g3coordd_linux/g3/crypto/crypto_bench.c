@@ -0,0 +1,250 @@
+/**
+ * \file
+ *
+ * \brief crypto_bench : EAX and CMAC throughput on EAP-PSK message sizes
+ *
+ * Copyright (c) 2021 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \asf_license_start
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip
+ * software and any derivatives exclusively with Microchip products.
+ * It is your responsibility to comply with third party license terms applicable
+ * to your use of third party software (including open source software) that
+ * may accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES,
+ * WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE,
+ * INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY,
+ * AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE
+ * LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL
+ * LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND WHATSOEVER RELATED TO THE
+ * SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS BEEN ADVISED OF THE
+ * POSSIBILITY OR THE DAMAGES ARE FORESEEABLE.  TO THE FULLEST EXTENT
+ * ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN ANY WAY
+ * RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+ * THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+ *
+ * \asf_license_stop
+ *
+ */
+
+/* Build: make crypto_bench. Usage: crypto_bench [iterations] */
+/* Known answer tests are run first, then every operation is timed with the */
+/* context keyed once per session and with the key set up for every message. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "eax.h"
+#include "cipher_wrapper.h"
+
+#define BENCH_DEFAULT_ITERATIONS   200000
+
+/* EAP-PSK P-Channel: 22 bytes header, 16 bytes nonce, protected data of messages 3 and 4 */
+#define BENCH_EAX_HDR_LEN          22
+#define BENCH_EAX_NONCE_LEN        16
+/* CMAC seeds: ID_S||RAND_P (message 3) and ID_P||ID_S||RAND_S||RAND_P (message 2) */
+static const size_t s_ax_cmac_sizes[] = {24, 52, 72, 88};
+static const size_t s_ax_eax_sizes[] = {1, 20, 40, 64};
+
+static const uint8_t s_auc_key[16] = {
+	0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+};
+
+static uint64_t _now_ns(void)
+{
+	struct timespec x_ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &x_ts);
+	return (uint64_t)x_ts.tv_sec * 1000000000ull + x_ts.tv_nsec;
+}
+
+static int _check(const char *sz_name, const uint8_t *puc_out, const uint8_t *puc_expected, size_t n_len)
+{
+	int ok = (memcmp(puc_out, puc_expected, n_len) == 0);
+
+	printf("  %-28s %s\n", sz_name, ok ? "ok" : "FAILED");
+	return ok ? 0 : 1;
+}
+
+/* RFC 4493 AES-CMAC examples and EAX paper (Bellare, Rogaway, Wagner) vectors */
+static int _known_answer_tests(void)
+{
+	static const uint8_t auc_msg[64] = {
+		0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+		0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+		0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+		0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10
+	};
+	static const uint8_t auc_cmac[4][16] = {
+		{0xbb, 0x1d, 0x69, 0x29, 0xe9, 0x59, 0x37, 0x28, 0x7f, 0xa3, 0x7d, 0x12, 0x9b, 0x75, 0x67, 0x46},
+		{0x07, 0x0a, 0x16, 0xb4, 0x6b, 0x4d, 0x41, 0x44, 0xf7, 0x9b, 0xdd, 0x9d, 0xd0, 0x4a, 0x28, 0x7c},
+		{0xdf, 0xa6, 0x67, 0x47, 0xde, 0x9a, 0xe6, 0x30, 0x30, 0xca, 0x32, 0x61, 0x14, 0x97, 0xc8, 0x27},
+		{0x51, 0xf0, 0xbe, 0xbf, 0x7e, 0x3b, 0x9d, 0x92, 0xfc, 0x49, 0x74, 0x17, 0x79, 0x36, 0x3c, 0xfe}
+	};
+	static const size_t ax_cmac_len[4] = {0, 16, 40, 64};
+	static const uint8_t auc_eax_key[16] = {
+		0x91, 0x94, 0x5d, 0x3f, 0x4d, 0xcb, 0xee, 0x0b, 0xf4, 0x5e, 0xf5, 0x22, 0x55, 0xf0, 0x95, 0xa4
+	};
+	static const uint8_t auc_eax_nonce[16] = {
+		0xbe, 0xca, 0xf0, 0x43, 0xb0, 0xa2, 0x3d, 0x84, 0x31, 0x94, 0xba, 0x97, 0x2c, 0x66, 0xde, 0xbd
+	};
+	static const uint8_t auc_eax_hdr[8] = {0xfa, 0x3b, 0xfd, 0x48, 0x06, 0xeb, 0x53, 0xfa};
+	static const uint8_t auc_eax_plain[2] = {0xf7, 0xfb};
+	static const uint8_t auc_eax_cipher[2] = {0x19, 0xdd};
+	static const uint8_t auc_eax_tag[16] = {
+		0x5c, 0x4c, 0x93, 0x31, 0x04, 0x9d, 0x0b, 0xda, 0xb0, 0x27, 0x74, 0x08, 0xf6, 0x79, 0x67, 0xe5
+	};
+	cipher_wrapper_aes_cmac_context x_cmac;
+	eax_ctx x_eax[1];
+	uint8_t auc_out[16];
+	uint8_t auc_data[2];
+	char sz_name[32];
+	int i_errors = 0;
+	int i;
+
+	printf("Known answer tests\n");
+	cipher_wrapper_aes_cmac_setkey(&x_cmac, s_auc_key, 128);
+	for (i = 0; i < 4; i++) {
+		cipher_wrapper_aes_cmac(&x_cmac, auc_msg, ax_cmac_len[i], auc_out);
+		snprintf(sz_name, sizeof(sz_name), "AES-CMAC %u bytes", (unsigned int)ax_cmac_len[i]);
+		i_errors += _check(sz_name, auc_out, auc_cmac[i], 16);
+	}
+
+	cipher_wrapper_aes_cmac_free(&x_cmac);
+
+	/* Same context for both messages, as in an EAP-PSK session */
+	eax_init_and_key(auc_eax_key, sizeof(auc_eax_key), x_eax);
+	memcpy(auc_data, auc_eax_plain, sizeof(auc_data));
+	eax_encrypt_message(auc_eax_nonce, sizeof(auc_eax_nonce), auc_eax_hdr, sizeof(auc_eax_hdr),
+			auc_data, sizeof(auc_data), auc_out, sizeof(auc_out), x_eax);
+	i_errors += _check("EAX encrypt, ciphertext", auc_data, auc_eax_cipher, sizeof(auc_data));
+	i_errors += _check("EAX encrypt, tag", auc_out, auc_eax_tag, sizeof(auc_out));
+	i = eax_decrypt_message(auc_eax_nonce, sizeof(auc_eax_nonce), auc_eax_hdr, sizeof(auc_eax_hdr),
+			auc_data, sizeof(auc_data), auc_eax_tag, sizeof(auc_eax_tag), x_eax);
+	i_errors += _check("EAX decrypt, plaintext", auc_data, auc_eax_plain, sizeof(auc_data));
+	printf("  %-28s %s\n", "EAX decrypt, tag", (i == RETURN_GOOD) ? "ok" : "FAILED");
+	i_errors += (i == RETURN_GOOD) ? 0 : 1;
+	eax_end(x_eax);
+
+	return i_errors;
+}
+
+static void _report(const char *sz_name, size_t n_len, uint32_t ul_iterations, uint64_t ull_ns)
+{
+	double d_s = (double)ull_ns / 1e9;
+
+	printf("  %-24s %4u bytes %10.0f msg/s %8.2f MB/s %8.0f ns/msg\n", sz_name, (unsigned int)n_len,
+			ul_iterations / d_s, (double)n_len * ul_iterations / d_s / 1e6, (double)ull_ns / ul_iterations);
+}
+
+static void _bench_cmac(uint32_t ul_iterations)
+{
+	cipher_wrapper_aes_cmac_context x_cmac;
+	uint8_t auc_data[128] = {0};
+	uint8_t auc_mac[16];
+	uint64_t ull_start;
+	uint32_t i;
+	size_t j;
+
+	printf("AES-CMAC\n");
+	for (j = 0; j < sizeof(s_ax_cmac_sizes) / sizeof(s_ax_cmac_sizes[0]); j++) {
+		cipher_wrapper_aes_cmac_setkey(&x_cmac, s_auc_key, 128);
+		ull_start = _now_ns();
+		for (i = 0; i < ul_iterations; i++) {
+			cipher_wrapper_aes_cmac(&x_cmac, auc_data, s_ax_cmac_sizes[j], auc_mac);
+			auc_data[0] ^= auc_mac[0];
+		}
+
+		_report("session key", s_ax_cmac_sizes[j], ul_iterations, _now_ns() - ull_start);
+		cipher_wrapper_aes_cmac_free(&x_cmac);
+
+		ull_start = _now_ns();
+		for (i = 0; i < ul_iterations; i++) {
+			cipher_wrapper_aes_cmac_setkey(&x_cmac, s_auc_key, 128);
+			cipher_wrapper_aes_cmac(&x_cmac, auc_data, s_ax_cmac_sizes[j], auc_mac);
+			cipher_wrapper_aes_cmac_free(&x_cmac);
+			auc_data[0] ^= auc_mac[0];
+		}
+
+		_report("key per message", s_ax_cmac_sizes[j], ul_iterations, _now_ns() - ull_start);
+	}
+}
+
+static void _bench_eax(uint32_t ul_iterations, int b_decrypt)
+{
+	eax_ctx x_eax[1];
+	uint8_t auc_hdr[BENCH_EAX_HDR_LEN] = {0};
+	uint8_t auc_nonce[BENCH_EAX_NONCE_LEN] = {0};
+	uint8_t auc_data[64] = {0};
+	uint8_t auc_tag[16] = {0};
+	uint64_t ull_start;
+	uint32_t i;
+	size_t j;
+
+	printf("EAX %s (%d bytes header)\n", b_decrypt ? "decrypt" : "encrypt", BENCH_EAX_HDR_LEN);
+	for (j = 0; j < sizeof(s_ax_eax_sizes) / sizeof(s_ax_eax_sizes[0]); j++) {
+		eax_init_and_key(s_auc_key, sizeof(s_auc_key), x_eax);
+		ull_start = _now_ns();
+		for (i = 0; i < ul_iterations; i++) {
+			auc_nonce[15] = (uint8_t)i;
+			if (b_decrypt) {
+				/* Tag does not match: the full decryption and tag computation are done anyway */
+				eax_decrypt_message(auc_nonce, sizeof(auc_nonce), auc_hdr, sizeof(auc_hdr), auc_data, s_ax_eax_sizes[j],
+						auc_tag, sizeof(auc_tag), x_eax);
+			} else {
+				eax_encrypt_message(auc_nonce, sizeof(auc_nonce), auc_hdr, sizeof(auc_hdr), auc_data, s_ax_eax_sizes[j],
+						auc_tag, sizeof(auc_tag), x_eax);
+			}
+		}
+
+		_report("session key", s_ax_eax_sizes[j], ul_iterations, _now_ns() - ull_start);
+		eax_end(x_eax);
+
+		ull_start = _now_ns();
+		for (i = 0; i < ul_iterations; i++) {
+			auc_nonce[15] = (uint8_t)i;
+			eax_init_and_key(s_auc_key, sizeof(s_auc_key), x_eax);
+			if (b_decrypt) {
+				eax_decrypt_message(auc_nonce, sizeof(auc_nonce), auc_hdr, sizeof(auc_hdr), auc_data, s_ax_eax_sizes[j],
+						auc_tag, sizeof(auc_tag), x_eax);
+			} else {
+				eax_encrypt_message(auc_nonce, sizeof(auc_nonce), auc_hdr, sizeof(auc_hdr), auc_data, s_ax_eax_sizes[j],
+						auc_tag, sizeof(auc_tag), x_eax);
+			}
+
+			eax_end(x_eax);
+		}
+
+		_report("key per message", s_ax_eax_sizes[j], ul_iterations, _now_ns() - ull_start);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t ul_iterations = BENCH_DEFAULT_ITERATIONS;
+
+	if (argc > 1) {
+		ul_iterations = (uint32_t)strtoul(argv[1], NULL, 0);
+		if (ul_iterations == 0) {
+			ul_iterations = BENCH_DEFAULT_ITERATIONS;
+		}
+	}
+
+	printf("AES engine: %s\n", aes_wrapper_aes_engine());
+	if (_known_answer_tests() != 0) {
+		return 1;
+	}
+
+	printf("%u messages per measure\n", ul_iterations);
+	_bench_cmac(ul_iterations);
+	_bench_eax(ul_iterations, 0);
+	_bench_eax(ul_iterations, 1);
+
+	return 0;
+}
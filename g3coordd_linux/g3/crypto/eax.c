@@ -55,11 +55,14 @@ ret_type eax_init_and_key(                      /* initialise mode and set key
 	/* set the context to all zeroes            */
 	memset(ctx, 0, sizeof(eax_ctx));
 
-	/* set the AES key                          */
-	aes_key(key, key_len);
+	/* set the AES key, expanded once for all the messages of the context */
+	aes_wrapper_aes_init(ctx->aes);
+	if (aes_wrapper_aes_setkey_enc(ctx->aes, key, key_len * 8) != 0) {
+		return RETURN_ERROR;
+	}
 
 	/* compute E(0) (needed for the pad values) */
-	aes_encrypt(UI8_PTR(ctx->pad_xvv), UI8_PTR(ctx->pad_xvv));
+	aes_wrapper_aes_encrypt(ctx->aes, UI8_PTR(ctx->pad_xvv), UI8_PTR(ctx->pad_xvv));
 
 	/* compute {02} * {E(0)} and {04} * {E(0)}  */
 	/* GF(2^128) mod x^128 + x^7 + x^2 + x + 1  */
@@ -105,7 +108,7 @@ ret_type eax_init_message(                      /* initialise a new message
 		i = 0;
 		while (i < iv_len) {
 			if (n_pos == EAX_BLOCK_SIZE) {
-				aes_encrypt(UI8_PTR(ctx->nce_cbc), UI8_PTR(ctx->nce_cbc));
+				aes_wrapper_aes_encrypt(ctx->aes, UI8_PTR(ctx->nce_cbc), UI8_PTR(ctx->nce_cbc));
 				n_pos = 0;
 			}
 
@@ -127,7 +130,7 @@ ret_type eax_init_message(                      /* initialise a new message
 	}
 
 	/* compute the OMAC*(nonce) value           */
-	aes_encrypt(UI8_PTR(ctx->nce_cbc), UI8_PTR(ctx->nce_cbc));
+	aes_wrapper_aes_encrypt(ctx->aes, UI8_PTR(ctx->nce_cbc), UI8_PTR(ctx->nce_cbc));
 
 	/* copy value into counter for CTR          */
 	memcpy(ctx->ctr_val, ctx->nce_cbc, EAX_BLOCK_SIZE);
@@ -159,7 +162,7 @@ ret_type eax_auth_header(                       /* authenticate the header
 		}
 
 		while (cnt + BLOCK_SIZE <= hdr_len) {
-			aes_encrypt(UI8_PTR(ctx->hdr_cbc), UI8_PTR(ctx->hdr_cbc));
+			aes_wrapper_aes_encrypt(ctx->aes, UI8_PTR(ctx->hdr_cbc), UI8_PTR(ctx->hdr_cbc));
 			xor_block_aligned(ctx->hdr_cbc, ctx->hdr_cbc, hdr + cnt);
 			cnt += BLOCK_SIZE;
 		}
@@ -171,7 +174,7 @@ ret_type eax_auth_header(                       /* authenticate the header
 		}
 
 		while (cnt + BLOCK_SIZE <= hdr_len) {
-			aes_encrypt(UI8_PTR(ctx->hdr_cbc), UI8_PTR(ctx->hdr_cbc));
+			aes_wrapper_aes_encrypt(ctx->aes, UI8_PTR(ctx->hdr_cbc), UI8_PTR(ctx->hdr_cbc));
 			xor_block(ctx->hdr_cbc, ctx->hdr_cbc, hdr + cnt);
 			cnt += BLOCK_SIZE;
 		}
@@ -179,7 +182,7 @@ ret_type eax_auth_header(                       /* authenticate the header
 
 	while (cnt < hdr_len) {
 		if (b_pos == BLOCK_SIZE || !b_pos) {
-			aes_encrypt(UI8_PTR(ctx->hdr_cbc), UI8_PTR(ctx->hdr_cbc));
+			aes_wrapper_aes_encrypt(ctx->aes, UI8_PTR(ctx->hdr_cbc), UI8_PTR(ctx->hdr_cbc));
 			b_pos = 0;
 		}
 
@@ -215,7 +218,7 @@ ret_type eax_auth_data(                         /* authenticate ciphertext data
 		}
 
 		while (cnt + BLOCK_SIZE <= data_len) {
-			aes_encrypt(UI8_PTR(ctx->txt_cbc), UI8_PTR(ctx->txt_cbc));
+			aes_wrapper_aes_encrypt(ctx->aes, UI8_PTR(ctx->txt_cbc), UI8_PTR(ctx->txt_cbc));
 			xor_block_aligned(ctx->txt_cbc, ctx->txt_cbc, data + cnt);
 			cnt += BLOCK_SIZE;
 		}
@@ -227,7 +230,7 @@ ret_type eax_auth_data(                         /* authenticate ciphertext data
 		}
 
 		while (cnt + BLOCK_SIZE <= data_len) {
-			aes_encrypt(UI8_PTR(ctx->txt_cbc), UI8_PTR(ctx->txt_cbc));
+			aes_wrapper_aes_encrypt(ctx->aes, UI8_PTR(ctx->txt_cbc), UI8_PTR(ctx->txt_cbc));
 			xor_block(ctx->txt_cbc, ctx->txt_cbc, data + cnt);
 			cnt += BLOCK_SIZE;
 		}
@@ -235,7 +238,7 @@ ret_type eax_auth_data(                         /* authenticate ciphertext data
 
 	while (cnt < data_len) {
 		if (b_pos == BLOCK_SIZE || !b_pos) {
-			aes_encrypt(UI8_PTR(ctx->txt_cbc), UI8_PTR(ctx->txt_cbc));
+			aes_wrapper_aes_encrypt(ctx->aes, UI8_PTR(ctx->txt_cbc), UI8_PTR(ctx->txt_cbc));
 			b_pos = 0;
 		}
 
@@ -271,7 +274,7 @@ ret_type eax_crypt_data(                        /* encrypt or decrypt data
 		}
 
 		while (cnt + BLOCK_SIZE <= data_len) {
-			aes_encrypt(UI8_PTR(ctx->ctr_val), UI8_PTR(ctx->enc_ctr));
+			aes_wrapper_aes_encrypt(ctx->aes, UI8_PTR(ctx->ctr_val), UI8_PTR(ctx->enc_ctr));
 			inc_ctr(ctx->ctr_val);
 			xor_block_aligned(data + cnt, data + cnt, ctx->enc_ctr);
 			cnt += BLOCK_SIZE;
@@ -284,7 +287,7 @@ ret_type eax_crypt_data(                        /* encrypt or decrypt data
 		}
 
 		while (cnt + BLOCK_SIZE <= data_len) {
-			aes_encrypt(UI8_PTR(ctx->ctr_val), UI8_PTR(ctx->enc_ctr));
+			aes_wrapper_aes_encrypt(ctx->aes, UI8_PTR(ctx->ctr_val), UI8_PTR(ctx->enc_ctr));
 			inc_ctr(ctx->ctr_val);
 			xor_block(data + cnt, data + cnt, ctx->enc_ctr);
 			cnt += BLOCK_SIZE;
@@ -293,7 +296,7 @@ ret_type eax_crypt_data(                        /* encrypt or decrypt data
 
 	while (cnt < data_len) {
 		if (b_pos == BLOCK_SIZE || !b_pos) {
-			aes_encrypt(UI8_PTR(ctx->ctr_val), UI8_PTR(ctx->enc_ctr));
+			aes_wrapper_aes_encrypt(ctx->aes, UI8_PTR(ctx->ctr_val), UI8_PTR(ctx->enc_ctr));
 			b_pos = 0;
 			inc_ctr(ctx->ctr_val);
 		}
@@ -325,7 +328,7 @@ ret_type eax_compute_tag(                       /* compute authentication tag
 	}
 
 	xor_block_aligned(ctx->hdr_cbc, ctx->hdr_cbc, p);
-	aes_encrypt(UI8_PTR(ctx->hdr_cbc), UI8_PTR(ctx->hdr_cbc));
+	aes_wrapper_aes_encrypt(ctx->aes, UI8_PTR(ctx->hdr_cbc), UI8_PTR(ctx->hdr_cbc));
 
 	/* complete OMAC* for ciphertext value  */
 	p = UI8_PTR(ctx->pad_xvv);
@@ -335,7 +338,7 @@ ret_type eax_compute_tag(                       /* compute authentication tag
 	}
 
 	xor_block_aligned(ctx->txt_cbc, ctx->txt_cbc, p);
-	aes_encrypt(UI8_PTR(ctx->txt_cbc), UI8_PTR(ctx->txt_cbc));
+	aes_wrapper_aes_encrypt(ctx->aes, UI8_PTR(ctx->txt_cbc), UI8_PTR(ctx->txt_cbc));
 
 	/* compute final authentication tag     */
 	for (i = 0; i < (unsigned int)tag_len; ++i) {
@@ -348,6 +351,7 @@ ret_type eax_compute_tag(                       /* compute authentication tag
 ret_type eax_end(                               /* clean up and end operation   */
 		eax_ctx ctx[1])         /* the mode context             */
 {
+	aes_wrapper_aes_free(ctx->aes);
 	memset(ctx, 0, sizeof(eax_ctx));
 	return RETURN_GOOD;
 }
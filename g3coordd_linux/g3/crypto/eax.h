@@ -78,7 +78,7 @@ typedef struct {
 	eax_buf_t txt_cbc;                      /* encrypt(2), for ctext CBC    */
 	eax_buf_t nce_cbc;                      /* encrypt (0|nonce), for iv CBC*/
 	eax_dbuf_t pad_xvv;                     /* {02} encrypt(0), pad values  */
-	/* aes_encrypt_ctx aes[1];                 / * AES encryption context       * / */
+	aes_wrapper_context aes[1];             /* AES encryption context       */
 	uint_32t hdr_cnt;                       /* header bytes so far          */
 	uint_32t txt_ccnt;                      /* text bytes so far (encrypt)  */
 	uint_32t txt_acnt;                      /* text bytes so far (auth)     */
@@ -42,6 +42,8 @@ extern "C" {
 /**INDENT-ON**/
 /* / @endcond */
 
+#include "oss_if.h"
+
 #define G3_COORD_VERSION "0.0.3"
 
 struct st_configuration {
@@ -62,10 +64,12 @@ struct st_configuration {
     uint8_t  mikroBUS;
 };
 
-extern struct st_configuration g_st_config;
+/* Configuration of the PAN run by the calling thread */
+extern PAN_LOCAL struct st_configuration g_st_config;
 
-/* TUN file descriptor */
-extern int tunfd;
+/* TUN file descriptors of the PAN: queue of PAN loop, queue for uplink packets */
+extern PAN_LOCAL int tunfd;
+extern PAN_LOCAL int tunfd_usi;
 
 /* / @cond 0 */
 /**INDENT-OFF**/
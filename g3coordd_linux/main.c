@@ -65,6 +65,8 @@
 
 #include "globals.h"
 
+#include "addUsi.h"
+#include "../src/Usi.h"
 #include "mac_wrapper.h"
 #include "AdpApi.h"
 #include "AdpApiTypes.h"
@@ -74,6 +76,8 @@
 #include "app_adp_mng.h"
 #include "Logger.h"
 #include "tun.h"
+#include "storage.h"
+#include "crypto/aes_wrapper.h"
 #include "debug.h"
 
 const unsigned char band_str[4][12] = {"CENELEC_A", "CENELEC_B", "FCC", "ARIB"};
@@ -81,8 +85,8 @@ const unsigned char band_str[4][12] = {"CENELEC_A", "CENELEC_B", "FCC", "ARIB"};
 #define COMMS_FD 0
 #define POLLTIMEOUT 20 /* ms */
 
-/* Default Configuration */
-struct st_configuration g_st_config = {
+/* Default Configuration. Every PAN thread starts from it and sets the one of its PAN */
+PAN_LOCAL struct st_configuration g_st_config = {
 	.b_verbose     = 1,
 	.b_conformance = 0, 
 	.uc_band       = ADP_BAND_CENELEC_A,
@@ -95,12 +99,14 @@ struct st_configuration g_st_config = {
 	.sz_hostname   = "127.0.0.1",
 	.sz_tcp_port   = 3000,
 	.sz_port_type  = 0,
+	.mikroBUS      = 0,
 	.uc16_psk_key  = CONF_PSK_KEY,
 	.uc16_gmk_key  = CONF_GMK_KEY,
 };
 
-/* TUN file descriptor */
-int tunfd;
+/* TUN file descriptors of the PAN */
+PAN_LOCAL int tunfd;
+PAN_LOCAL int tunfd_usi;
 
 uint32_t g_ui_read_tun = 1;
 
@@ -111,6 +117,31 @@ int g_usi_fd = 0;
 #define MIKROBUS1_GPIO_RESET "gpio17"  /* Reset for mikroBUS 1 is mapped on PB2  */
 #define MIKROBUS2_GPIO_RESET "PA26" /* Reset for mikroBUS 2 is mapped on PA26 */
 
+/* Multi-PAN: one thread per PAN (--pan), each one with its own modem, TUN and bootstrap.
+ * Module state of a PAN is thread local (PAN_LOCAL); crypto tables and log output are shared */
+#define G3COORD_MAX_PANS          4
+/* On exit request, time given to the PANs to save their state. A PAN waiting for the modem is not waited for */
+#define G3COORD_EXIT_WAIT_S       3
+
+/* PAN instance */
+struct g3_pan {
+	struct st_configuration x_config;
+	pthread_t x_thread;
+	/* TUN queues file descriptors */
+	int ai_tun_fds[TUN_NUM_QUEUES];
+	int i_tun_num_queues;
+	/* USI statistics requests already served */
+	int i_usi_stats_dumps;
+};
+
+static char *s_asz_pan_args[G3COORD_MAX_PANS];
+static struct g3_pan s_ax_pans[G3COORD_MAX_PANS];
+static int s_i_num_pans;
+/* PAN threads still running, main thread is signalled when one ends */
+static int s_i_running_pans;
+static pthread_mutex_t s_pans_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_pans_cond = PTHREAD_COND_INITIALIZER;
+
 /*******************************************************/
 
 /**
@@ -137,20 +168,18 @@ void reset_g3_adp_modem(int mikroBUS)
 
 /*******************************************************/
 
+/* Set by SIGINT and SIGHUP, every PAN loop ends */
+static volatile sig_atomic_t sb_exit;
+/* Counted by SIGUSR1, USI statistics are dumped from every PAN loop */
+static volatile sig_atomic_t si_usi_stats_dumps;
+
 /**
- * \brief Pthread to handle usi_process
- * usi_process needs to be called periodically to transmit/receive
- * USI Frames to/from serial port -
- * \return 0
+ * \brief Print a USI statistics line
  *
  *******************************************************/
-void usi_process_thread()
+static void app_g3_coordinator_print_usi_stats(void *ctx, const char *line)
 {
-	while (1) {
-		addUsi_Process();
-		usleep(1000);
-	}
-	pthread_exit(NULL);
+	fprintf((FILE *)ctx, "%s\r\n", line);
 }
 
 /*******************************************************/
@@ -164,13 +193,11 @@ void usi_process_thread()
 void app_g3_coordinator_signals_handler(int signum)
 {
 	if ((SIGINT == signum) || (SIGHUP == signum) || (SIGKILL == signum)) {
-		/* Ctrl+C Signal */
-		LOG_ERR(Log("I die...\r\n"));
-		/* Clean exit should be written */
-		exit(0);
-	#ifdef DEBUG_IN_FILE
-		close_log_file();
-	#endif
+		/* Ctrl+C Signal: PAN loops end, saving their state */
+		sb_exit = 1;
+	} else if (SIGUSR1 == signum) {
+		/* Dump USI statistics out of signal context */
+		si_usi_stats_dumps++;
 	}
 
 	return;
@@ -213,18 +240,170 @@ void app_g3_coordinator_print_help()
 	printf("\t-s, --speed: Serial Port Speed for device connected to Adp Mac Serialized device\r\n");
 	printf("\t-n, --hostname: Hostname connected to Adp Mac Serialized device\r\n");
 	printf("\t-o, --port: TCP Port for connection to Adp Mac Serialized device\r\n");
+	printf("\t-m, --bus: mikroBUS of the Adp Mac Serialized device reset line [0|1]. Default value: 0\r\n");
+	printf("\t-P, --pan: Run one PAN per --pan option (up to %d), each one in its own thread. Options not given are taken from the global ones:\r\n", G3COORD_MAX_PANS);
+	printf("\t           dev=,speed=,hostname=,port=,tun=,panid=,ip=,length=,band=,bus=\r\n");
+	printf("\t           e.g. --pan tun=g3plc0,dev=/dev/ttyS1,panid=0x781D --pan tun=g3plc1,dev=/dev/ttyS2,panid=0x781E,bus=1\r\n");
 	printf("\t-h, --help: print this help.\r\n");
 }
 
-static int app_g3_coordinator_parse_arguments(int argc, char **argv)
+/**
+ * \brief Parse a configuration option, from command line or from a PAN definition
+ * \return 0 on success, -1 on error
+ *
+ *******************************************************/
+static int app_g3_coordinator_parse_option(struct st_configuration *px_cfg, int c, char *arg)
 {
-	int c;
 	int value;
 	struct in6_addr result;
 
+	switch (c) {
+	case 'b':
+		LOG_INFO(Log("Option -b  [BAND] with value `%s'", arg));
+		if ((strncmp("CENELEC_A", arg, 9 ) == 0) || (strncmp("CEN_A", arg, 5 ) == 0) || (strncmp("CENA", arg, 4 ) == 0)) {
+			px_cfg->uc_band = ADP_BAND_CENELEC_A;
+		} else if ((strncmp("CENELEC_B", arg, 9 ) == 0) || (strncmp("CEN_B", arg, 5 ) == 0) || (strncmp("CENB", arg, 4 ) == 0)) {
+			px_cfg->uc_band = ADP_BAND_CENELEC_B;
+		} else if (strncmp("FCC", arg, 3 ) == 0) {
+			px_cfg->uc_band = ADP_BAND_FCC;
+		} else if (strncmp("ARIB", arg, 4 ) == 0) {
+			px_cfg->uc_band = ADP_BAND_ARIB;
+		} else {
+			LOG_ERR(Log("PLC BAND not recognized"));
+			return -1;
+		}
+
+		break;
+
+	case 'i':
+		LOG_INFO(Log("Option -i [IP6] with value `%s'", arg));
+		if (inet_pton(AF_INET6, arg, &result) != 1) {
+			LOG_ERR(Log("INVALID IP6 Address %s", arg));
+			return -1;
+		}
+
+		strcpy(px_cfg->sz_ipaddress, arg);
+		break;
+
+	case 'l':
+		LOG_INFO(Log("Option -l [prefix] with value `%s'", arg));
+		if (parse_interger(arg, (int *)&value, 10) != 0) {
+			LOG_ERR(Log("Error parsing length value: %s", arg));
+			return -1;
+		}
+
+		if ((value < 8) || (value > 127)) {
+			LOG_ERR(Log("Net prefix length  not valid. It must be in range [8 128]."));
+			return -1;
+		}
+
+		px_cfg->uc_prefix_len = value;
+		break;
+
+	case 'p':
+		LOG_INFO(Log("Option -p [PANID] with value `%s'", arg));
+		if (parse_interger(arg, (int *)&value, 10) != 0) {
+			LOG_ERR(Log("Error parsing PANID value: %s", arg));
+			return -1;
+		}
+
+		if (value == 0) {
+			/* Try parse in hex format */
+			if (parse_interger(arg, (int *)&value, 0) != 0) {
+				LOG_ERR(Log("Error parsing HEX PANID value: %s", arg));
+				return -1;
+			}
+		}
+
+		if ((value > 0xFFFF) || ((value & 0xFCFF) != value) || (value == 0)) {
+			/* In order to avoid the possibility of duplicated IPv6 addresses, the values
+			 *       of the PAN ID MUST be chosen so that the 7th (Universal/Local bit) and 8th
+			 *             (Individual/Group bit) bits of the first byte of the PAN ID are both zero */
+			LOG_ERR(Log("Invalid PANID:  %d(%04X)", value, value));
+			return -1;
+		}
+
+		px_cfg->us_pan_id = value;
+		break;
+
+	case 't':
+		LOG_INFO(Log("Option -t [TUN_NAME] with value `%s'", arg));
+		if (strlen(arg) > 32) {
+			LOG_ERR(Log("tun name too large: %s", arg));
+			return -1;
+		}
+
+		strcpy(px_cfg->sz_tun_name, arg);
+		break;
+
+	case 'd':
+		LOG_INFO(Log("Option -d [DEVICE] with value `%s'", arg));
+		if (strlen(arg) > 32) {
+			LOG_ERR(Log("Serial Port name too large: %s", arg));
+			return -1;
+		}
+
+		strcpy(px_cfg->sz_tty_name, arg);
+		break;
+
+	case 's':
+		LOG_INFO(Log("Option -s [SPEED] with value `%s'", arg));
+		if (parse_interger(arg, (int *)&value, 10) != 0) {
+			LOG_ERR(Log("Error parsing Serial Port Speed value: %s", arg));
+			return -1;
+		}
+
+		px_cfg->sz_tty_speed = value;
+		break;
+
+	case 'n':
+		/*! Usefull when using socat to redirect serial port to tcp port. For example: */
+		/*! socat -d -x TCP-LISTEN:3000,reuseaddr /dev/ttyS1,B230400,raw,echo=0 */
+		LOG_INFO(Log("Option -n [HOSTNAME] with value `%s'", arg));
+		if (strlen(arg) > 32) {
+			LOG_ERR(Log("Hostname too large: %s", arg));
+			return -1;
+		}
+
+		strcpy(px_cfg->sz_hostname, arg);
+		break;
+
+	case 'o':
+		LOG_INFO(Log("Option -o [PORT] with value `%s'", arg));
+		if (parse_interger(arg, (int *)&value, 10) != 0) {
+			LOG_ERR(Log("Error parsing Serial Port Speed value: %s", arg));
+			return -1;
+		}
+
+		px_cfg->sz_tcp_port = value;
+		break;
+
+	case 'm':
+		LOG_INFO(Log("Option -m [MIKROBUS] with value `%s'", arg));
+		if ((parse_interger(arg, (int *)&value, 10) != 0) || (value < MIKROBUS1) || (value > MIKROBUS2)) {
+			LOG_ERR(Log("Invalid mikroBUS: %s", arg));
+			return -1;
+		}
+
+		px_cfg->mikroBUS = value;
+		break;
+
+	default:
+		LOG_ERR(Log("OPTION not recognised: %c", c));
+		return -1;
+	} /* switch */
+
+	return 0;
+}
+
+static int app_g3_coordinator_parse_arguments(int argc, char **argv)
+{
+	int c;
+
 	while (1) {
 		int option_index = 0;
-		static struct option long_options[] = {
+		/* Not static: flags point to the configuration of the calling thread */
+		struct option long_options[] = {
 			{"verbose", no_argument, &g_st_config.b_verbose, 1},
 			{"silent", no_argument, &g_st_config.b_verbose, 0},
 			/*				{"conformance", no_argument,&g_st_config.b_conformance, 1}, */
@@ -237,11 +416,13 @@ static int app_g3_coordinator_parse_arguments(int argc, char **argv)
 			{"speed", required_argument, 0, 's'},
 			{"hostname", required_argument, 0, 'n'},
 			{"port", required_argument, 0, 'o'},
+			{"bus", required_argument, 0, 'm'},
+			{"pan", required_argument, 0, 'P'},
 			{"help", required_argument, 0, 'h'},
 			{0, 0, 0, 0}
 		};
 
-		c = getopt_long(argc, argv, "n:o:b:i:l:p:t:d:s:h", long_options, &option_index);
+		c = getopt_long(argc, argv, "n:o:b:i:l:p:t:d:s:m:P:h", long_options, &option_index);
 
 		/* Detect the end of the options. */
 		if (c == -1) {
@@ -267,133 +448,65 @@ static int app_g3_coordinator_parse_arguments(int argc, char **argv)
 			exit(0);
 			break;
 
-		case 'b':
-			LOG_INFO(Log("Option -b  [BAND] with value `%s'", optarg));
-			if ((strncmp("CENELEC_A", optarg, 9 ) == 0) || (strncmp("CEN_A", optarg, 5 ) == 0) || (strncmp("CENA", optarg, 4 ) == 0)) {
-				g_st_config.uc_band = ADP_BAND_CENELEC_A;
-			} else if ((strncmp("CENELEC_B", optarg, 9 ) == 0) || (strncmp("CEN_B", optarg, 5 ) == 0) || (strncmp("CENB", optarg, 4 ) == 0)) {
-				g_st_config.uc_band = ADP_BAND_CENELEC_B;
-			} else if (strncmp("FCC", optarg, 3 ) == 0) {
-				g_st_config.uc_band = ADP_BAND_FCC;
-			} else if (strncmp("ARIB", optarg, 4 ) == 0) {
-				g_st_config.uc_band = ADP_BAND_ARIB;
-			} else {
-				LOG_ERR(Log("PLC BAND not recognized"));
-				return -1;
-			}
-
-			break;
-
-		case 'i':
-			LOG_INFO(Log("Option -i [IP6] with value `%s'", optarg));
-			if (inet_pton(AF_INET6, optarg, &result) != 1) {
-				LOG_ERR(Log("INVALID IP6 Address %s", optarg));
-				return -1;
-			}
-
-			strcpy(g_st_config.sz_ipaddress, optarg);
-			break;
-
-		case 'l':
-			LOG_INFO(Log("Option -l [prefix] with value `%s'", optarg));
-			if (parse_interger(optarg, (int *)&value, 10) != 0) {
-				LOG_ERR(Log("Error parsing length value: %s", optarg));
+		case 'P':
+			/* Applied when all options are parsed: PANs inherit the global ones */
+			if (s_i_num_pans >= G3COORD_MAX_PANS) {
+				LOG_ERR(Log("Too many PANs, maximum is %d", G3COORD_MAX_PANS));
 				return -1;
 			}
 
-			if ((value < 8) || (value > 127)) {
-				LOG_ERR(Log("Net prefix length  not valid. It must be in range [8 128]."));
-				return -1;
-			}
-
-			g_st_config.uc_prefix_len = value;
+			s_asz_pan_args[s_i_num_pans++] = optarg;
 			break;
 
-		case 'p':
-			LOG_INFO(Log("Option -p [PANID] with value `%s'", optarg));
-			if (parse_interger(optarg, (int *)&value, 10) != 0) {
-				LOG_ERR(Log("Error parsing PANID value: %s", optarg));
-				return -1;
-			}
-
-			if (value == 0) {
-				/* Try parse in hex format */
-				if (parse_interger(optarg, (int *)&value, 0) != 0) {
-					LOG_ERR(Log("Error parsing HEX PANID value: %s", optarg));
-					return -1;
-				}
-			}
-
-			if ((value > 0xFFFF) || ((value & 0xFCFF) != value) || (value == 0)) {
-				/* In order to avoid the possibility of duplicated IPv6 addresses, the values
-				 *       of the PAN ID MUST be chosen so that the 7th (Universal/Local bit) and 8th
-				 *             (Individual/Group bit) bits of the first byte of the PAN ID are both zero */
-				LOG_ERR(Log("Invalid PANID:  %d(%04X)", value, value));
-				return -1;
-			}
-
-			g_st_config.us_pan_id = value;
-			break;
-
-		case 't':
-			LOG_INFO(Log("Option -t [TUN_NAME] with value `%s'", optarg));
-			if (strlen(optarg) > 32) {
-				LOG_ERR(Log("tun name too large: %s", optarg));
-				return -1;
-			}
-
-			strcpy(g_st_config.sz_tun_name, optarg);
-			break;
+		case '?':
+			return -1;
 
-		case 'd':
-			LOG_INFO(Log("Option -d [DEVICE] with value `%s'", optarg));
-			if (strlen(optarg) > 32) {
-				LOG_ERR(Log("Serial Port name too large: %s", optarg));
+		default:
+			if (app_g3_coordinator_parse_option(&g_st_config, c, optarg) != 0) {
 				return -1;
 			}
+		} /* switch */
+	} /* while */
+	return 0;
+}
 
-			strcpy(g_st_config.sz_tty_name, optarg);
-			break;
-
-		case 's':
-			LOG_INFO(Log("Option -s [SPEED] with value `%s'", optarg));
-			if (parse_interger(optarg, (int *)&value, 10) != 0) {
-				LOG_ERR(Log("Error parsing Serial Port Speed value: %s", optarg));
+/**
+ * \brief Build the configuration of every PAN (--pan key=value,...) on top of the global one
+ * \return 0 on success, -1 on error
+ *
+ *******************************************************/
+static int app_g3_coordinator_configure_pans(void)
+{
+	static char *const apsz_keys[] = {"dev", "speed", "hostname", "port", "tun", "panid", "ip", "length", "band", "bus", NULL};
+	static const char ac_opts[] = {'d', 's', 'n', 'o', 't', 'p', 'i', 'l', 'b', 'm'};
+	char *sz_subopts;
+	char *sz_value;
+	int i, j, key;
+
+	for (i = 0; i < s_i_num_pans; i++) {
+		s_ax_pans[i].x_config = g_st_config;
+		sz_subopts = s_asz_pan_args[i];
+		while (*sz_subopts != '\0') {
+			key = getsubopt(&sz_subopts, apsz_keys, &sz_value);
+			if ((key < 0) || (sz_value == NULL)) {
+				LOG_ERR(Log("Invalid PAN %d option: %s", i, sz_value ? sz_value : "(no value)"));
 				return -1;
 			}
 
-			g_st_config.sz_tty_speed = value;
-			break;
-
-		case 'n':
-			/*! Usefull when using socat to redirect serial port to tcp port. For example: */
-			/*! socat -d -x TCP-LISTEN:3000,reuseaddr /dev/ttyS1,B230400,raw,echo=0 */
-			LOG_INFO(Log("Option -n [HOSTNAME] with value `%s'", optarg));
-			if (strlen(optarg) > 32) {
-				LOG_ERR(Log("Hostname too large: %s", optarg));
+			if (app_g3_coordinator_parse_option(&s_ax_pans[i].x_config, ac_opts[key], sz_value) != 0) {
 				return -1;
 			}
+		}
 
-			strcpy(g_st_config.sz_hostname, optarg);
-			break;
-
-		case 'o':
-			LOG_INFO(Log("Option -o [PORT] with value `%s'", optarg));
-			if (parse_interger(optarg, (int *)&value, 10) != 0) {
-				LOG_ERR(Log("Error parsing Serial Port Speed value: %s", optarg));
+		/* TUN name identifies the PAN: node list, storage and status socket are named after it */
+		for (j = 0; j < i; j++) {
+			if (strcmp(s_ax_pans[i].x_config.sz_tun_name, s_ax_pans[j].x_config.sz_tun_name) == 0) {
+				LOG_ERR(Log("PANs %d and %d use the same TUN device %s", j, i, s_ax_pans[i].x_config.sz_tun_name));
 				return -1;
 			}
+		}
+	}
 
-			g_st_config.sz_tcp_port = value;
-			break;
-
-		case '?':
-			return -1;
-
-		default:
-			LOG_ERR(Log("OPTION not recognised: %s", optarg));
-		} /* switch */
-	} /* while */
 	return 0;
 }
 
@@ -415,50 +528,43 @@ static void app_g3_coordinator_print_arguments()
 			g_st_config.sz_tun_name, g_st_config.sz_tty_name, g_st_config.sz_tty_speed, g_st_config.uc16_psk_key, g_st_config.uc16_gmk_key));
 }
 
-int main(int argc, char **argv)
+/**
+ * \brief Run a PAN: modem, TUN and ADP initialization, then the PAN loop
+ * The loop processes USI as well, there is no USI thread.
+ * \return 0 when exit is requested, -1 on error
+ *
+ *******************************************************/
+static int app_g3_coordinator_run_pan(struct g3_pan *px_pan)
 {
-	static int num_tx = 0;
-	struct pollfd poll_fds[2];
+	int num_tx = 0;
+	/* TUN queues, USI events, ADP TX event and ADP flow status socket */
+	struct pollfd poll_fds[TUN_NUM_QUEUES + 3];
+	int usi_event_fd;
+	int usi_fd_idx;
+	int tx_event_fd_idx;
+	int flow_fd_idx;
 	int ret;
-	#ifdef DEBUG_IN_FILE
-		open_and_create_log_file();
-	#endif
-
-	SET_RGB_OFF()
-	SET_LED_GREEN_TIMER(500, 500)
-
-	/* Signals to be handled */
-	signal(SIGINT, app_g3_coordinator_signals_handler);
-	signal(SIGHUP, app_g3_coordinator_signals_handler);
-	signal(SIGKILL, app_g3_coordinator_signals_handler);
-
-	/* Global Configuration can be overridden with console parameters */
-	if (app_g3_coordinator_parse_arguments(argc, argv) < 0) {
-		LOG_ERR(Log("Error parsing arguments"));
-		app_g3_coordinator_print_help();
-		return -1;
-	}
+	int i;
 
-	/* Print Global Configuration */
+	/* Print PAN Configuration */
 	app_g3_coordinator_print_arguments();
-	LogEnable(g_st_config.b_verbose);
 
 	/* Reset ADP Modem by default */
-	reset_g3_adp_modem(MIKROBUS1);
+	reset_g3_adp_modem(g_st_config.mikroBUS);
 
-	/* Init USI/Base serial connection */
+	/* Init USI/Base serial connection. USI is processed by this thread, synchronous requests from now on included */
 	addUsi_Init();
+	usi_event_fd = addUsi_GetEventFd();
 
-	/* Create usi_process thread to handle USI Frames on serial port */
-	pthread_t usi_thread;
-	/* Create a thread which executes addUsi_Process() periodically */
-	if (pthread_create(&usi_thread, NULL, usi_process_thread, NULL)) {
-		LOG_ERR(Log("Error creating USI Thread\n"));
+	/* Allocate file descriptors. Without packet information header, ADP payloads are exchanged as they are */
+	px_pan->i_tun_num_queues = tun_alloc_mq(g_st_config.sz_tun_name, IFF_TUN | IFF_NO_PI, px_pan->ai_tun_fds, TUN_NUM_QUEUES);
+	if (px_pan->i_tun_num_queues < 0) {
+		px_pan->i_tun_num_queues = 0;
 		return -1;
 	}
 
-	/* Allocate file descriptors */
-	tunfd = tun_alloc(g_st_config.sz_tun_name, IFF_TUN);
+	tunfd = px_pan->ai_tun_fds[TUN_QUEUE_MAIN];
+	tunfd_usi = (px_pan->i_tun_num_queues > TUN_QUEUE_USI) ? px_pan->ai_tun_fds[TUN_QUEUE_USI] : tunfd;
 
 	/* Configure TUN interface */
 	if (tun_configure(g_st_config.sz_tun_name, g_st_config.us_pan_id, g_st_config.sz_ipaddress, g_st_config.uc_prefix_len) != 0) {
@@ -468,12 +574,12 @@ int main(int argc, char **argv)
 #ifdef APP_CONFORMANCE_TEST
 	/* Create udp_responder_thread to handle Conformance UDP Responder */
 	pthread_t conformance_thread;
-	/* Create a thread which executes addUsi_Process() periodically */
-	if (pthread_create(&conformance_thread, NULL, udp_responder_thread, (void *)&g_st_config.sz_tun_name)) {
+	if (pthread_create(&conformance_thread, NULL, udp_responder_thread, (void *)px_pan->x_config.sz_tun_name)) {
 		LOG_ERR(Log("Error creating Conformance Thread\n"));
 		return -1;
 	}
 
+	pthread_detach(conformance_thread);
 #endif
 
 	/* Adp Initialization */
@@ -485,70 +591,232 @@ int main(int argc, char **argv)
 	app_show_version();
 
 	/* Configure POLL descriptor arguments */
-	poll_fds[COMMS_FD].fd = tunfd;
-	poll_fds[COMMS_FD].events = POLLIN;
+	for (i = 0; i < px_pan->i_tun_num_queues; i++) {
+		poll_fds[COMMS_FD + i].fd = px_pan->ai_tun_fds[i];
+		poll_fds[COMMS_FD + i].events = POLLIN;
+	}
+
+	/* Negative descriptors (not available) are ignored by poll() */
+	usi_fd_idx = COMMS_FD + px_pan->i_tun_num_queues;
+	poll_fds[usi_fd_idx].fd = usi_event_fd;
+	poll_fds[usi_fd_idx].events = POLLIN;
+	tx_event_fd_idx = usi_fd_idx + 1;
+	poll_fds[tx_event_fd_idx].fd = adp_tx_event_fd();
+	poll_fds[tx_event_fd_idx].events = POLLIN;
+	flow_fd_idx = tx_event_fd_idx + 1;
+	poll_fds[flow_fd_idx].fd = adp_flow_status_fd();
+	poll_fds[flow_fd_idx].events = POLLIN;
 
 	SET_LED_GREEN()
 
-	while (1) {
-		poll_fds[COMMS_FD].revents = 0;
-		poll_fds[COMMS_FD].revents = 0;
+	while (!sb_exit) {
+		if (px_pan->i_usi_stats_dumps != si_usi_stats_dumps) {
+			px_pan->i_usi_stats_dumps = si_usi_stats_dumps;
+			LogLock();
+			usi_DumpStats(app_g3_coordinator_print_usi_stats, stderr);
+			LogUnlock();
+		}
 
-		if (adp_write_buffers_available()) {
-			/* PRINTF("ADP Buffers availables\r\n"); */
-			poll_fds[COMMS_FD].events = POLLIN;
-		} else {
-			/*If there is no more buffers available in the ADP,
-			 * we stop reading new packets from the tun descriptor
-			 * until new buffers are available.*/
-			/* LOG_DBG(Log("ADP Buffers NOT available")); */
-			poll_fds[COMMS_FD].events = 0; /*  */
-			continue;
+		for (i = 0; i < px_pan->i_tun_num_queues; i++) {
+			poll_fds[COMMS_FD + i].revents = 0;
+			if (adp_tx_queue_available()) {
+				poll_fds[COMMS_FD + i].events = POLLIN;
+			} else {
+				/* No room to queue packets, stop reading from the tun
+				 * descriptors until ADP confirms free some of them. */
+				poll_fds[COMMS_FD + i].events = 0;
+			}
+
+			if ((poll_fds[COMMS_FD + i].fd == tunfd_usi) && adp_rx_pending()) {
+				/* Upstream packets waiting for room in the TUN queue */
+				poll_fds[COMMS_FD + i].events |= POLLOUT;
+			}
 		}
 
-		ret = poll(poll_fds, 2, POLLTIMEOUT);
+		poll_fds[usi_fd_idx].revents = 0;
+		poll_fds[tx_event_fd_idx].revents = 0;
+		poll_fds[flow_fd_idx].revents = 0;
+
+		/* Sleeps while there is nothing to read or send, modem buffers full included */
+		ret = poll(poll_fds, flow_fd_idx + 1, POLLTIMEOUT);
+
+		/* Process USI: frames received from modem, pending transmissions */
+		addUsi_Process();
+		/* Upstream packets kept while TUN queue was full: their USI frames are released */
+		if (adp_rx_pending()) {
+			adp_rx_process();
+		}
 
-		/* Process USI - Do via thread */
-		/* addUsi_Process(); */
 		/* Process timed events */
 		adp_process(g_st_config.uc_band, g_st_config.us_pan_id);
 
-		if (ret == 0) {
-			continue;
-		} else if (ret < 0) {
-			/* perror("POLL ERROR!"); */
-			/* return -1; */
+		if ((ret > 0) && (poll_fds[tx_event_fd_idx].revents & POLLIN)) {
+			/* Window slot released or modem buffers ready: adp_tx_process() below */
+			adp_tx_event_clear();
 		}
 
-		if (poll_fds[COMMS_FD].revents & POLLIN) { /* new command from tun iface */
-			int len = 0;
-			uint8_t buffer[2048];
-			num_tx++;
+		if ((ret > 0) && (poll_fds[flow_fd_idx].revents & POLLIN)) {
+			adp_flow_status_process();
+		}
 
-			len = read(poll_fds[COMMS_FD].fd, buffer, G3_ADP_MAX_DATA_LENTHG + 4);
-			/* LOG_DBG(Log("Read from TUN...%d, len %d", num_tx, len)); */
-			if (len <= 0) {
-				LOG_ERR(Log("Error in TUN iface"));
-				return -1;
+		/* Drain a burst of packets from every ready queue: one wakeup for many packets */
+		for (i = 0; (ret > 0) && (i < px_pan->i_tun_num_queues); i++) {
+			int n;
+
+			if (!(poll_fds[COMMS_FD + i].revents & POLLIN)) {
+				continue;
 			}
 
-			if (len <= G3_ADP_MAX_DATA_LENTHG + 4) {
-				if (adp_send_ipv6_message(buffer + 4, len - 4) < 0) {
-					LOG_ERR(Log("ADP Send Message error"));
-				} else {
-					/* LOG_DBG(Log("ADP Send Message OK, wait confirm.")); */
+			for (n = 0; (n < TUN_RX_BURST) && adp_tx_queue_available(); n++) {
+				int len = 0;
+				uint8_t buffer[2048];
+
+				len = read(poll_fds[COMMS_FD + i].fd, buffer, sizeof(buffer));
+				if (len < 0) {
+					if ((errno == EAGAIN) || (errno == EINTR)) {
+						break;
+					}
+
+					LOG_ERR(Log("Error in TUN iface"));
+					return -1;
+				}
 
-					/* Do not read till  TX CONFIRM */
-					poll_fds[COMMS_FD].events = 0;
+				num_tx++;
+				/* LOG_DBG(Log("Read from TUN...%d, len %d", num_tx, len)); */
+				if ((len > 0) && (len <= G3_ADP_MAX_DATA_LENTHG)) {
+					if (adp_send_ipv6_message(buffer, len) < 0) {
+						LOG_ERR(Log("ADP Send Message error"));
+					}
+				} else {
+					LOG_ERR(Log("Error, PDU too large %d", len));
 				}
-			} else {
-				LOG_ERR(Log("Error, PDU too large %d", len));
 			}
 		}
 
+		/* Send queued packets while ADP window allows it */
+		adp_tx_process();
+
 		/* Process timed events */
 		adp_process(g_st_config.uc_band, g_st_config.us_pan_id);
-		/* Process USI - Do via thread */
-		/* addUsi_Process(); */
+		/* Process USI: send what has just been queued */
+		addUsi_Process();
 	}
+
+	return 0;
+}
+
+/**
+ * \brief PAN thread: runs the PAN with its configuration, ends with it
+ *
+ *******************************************************/
+static void *app_g3_coordinator_pan_thread(void *arg)
+{
+	struct g3_pan *px_pan = (struct g3_pan *)arg;
+	int i;
+
+	g_st_config = px_pan->x_config;
+	if (s_i_num_pans > 0) {
+		LogSetTag(g_st_config.sz_tun_name);
+	}
+
+	if (app_g3_coordinator_run_pan(px_pan) != 0) {
+		/* The other PANs keep running */
+		LOG_ERR(Log("PAN %s stopped", g_st_config.sz_tun_name));
+	}
+
+	/* Pending state changes are written before the PAN ends */
+	storage_exit();
+	for (i = 0; i < px_pan->i_tun_num_queues; i++) {
+		close(px_pan->ai_tun_fds[i]);
+	}
+
+	pthread_mutex_lock(&s_pans_mutex);
+	s_i_running_pans--;
+	pthread_cond_signal(&s_pans_cond);
+	pthread_mutex_unlock(&s_pans_mutex);
+	return NULL;
+}
+
+int main(int argc, char **argv)
+{
+	struct timespec x_wait;
+	time_t x_exit_deadline = 0;
+	int i_num_pans;
+	int i;
+	#ifdef DEBUG_IN_FILE
+		open_and_create_log_file();
+	#endif
+
+	SET_RGB_OFF()
+	SET_LED_GREEN_TIMER(500, 500)
+
+	/* Signals to be handled */
+	signal(SIGINT, app_g3_coordinator_signals_handler);
+	signal(SIGHUP, app_g3_coordinator_signals_handler);
+	signal(SIGKILL, app_g3_coordinator_signals_handler);
+	signal(SIGUSR1, app_g3_coordinator_signals_handler);
+
+	/* Global Configuration can be overridden with console parameters */
+	if (app_g3_coordinator_parse_arguments(argc, argv) < 0) {
+		LOG_ERR(Log("Error parsing arguments"));
+		app_g3_coordinator_print_help();
+		return -1;
+	}
+
+	LogEnable(g_st_config.b_verbose);
+
+	if (s_i_num_pans > 0) {
+		if (app_g3_coordinator_configure_pans() != 0) {
+			app_g3_coordinator_print_help();
+			return -1;
+		}
+
+		i_num_pans = s_i_num_pans;
+	} else {
+		/* Single PAN with the global configuration */
+		s_ax_pans[0].x_config = g_st_config;
+		i_num_pans = 1;
+	}
+
+	/* AES tables are shared by the bootstrap of all PANs */
+	aes_wrapper_init();
+
+	pthread_mutex_lock(&s_pans_mutex);
+	for (i = 0; i < i_num_pans; i++) {
+		if (pthread_create(&s_ax_pans[i].x_thread, NULL, app_g3_coordinator_pan_thread, &s_ax_pans[i])) {
+			LOG_ERR(Log("Error creating PAN %s thread", s_ax_pans[i].x_config.sz_tun_name));
+			continue;
+		}
+
+		pthread_detach(s_ax_pans[i].x_thread);
+		s_i_running_pans++;
+	}
+
+	/* Runs while some PAN is running, checking exit requests every second */
+	while (s_i_running_pans > 0) {
+		if (sb_exit) {
+			if (x_exit_deadline == 0) {
+				x_exit_deadline = time(NULL) + G3COORD_EXIT_WAIT_S;
+			} else if (time(NULL) >= x_exit_deadline) {
+				break;
+			}
+		}
+
+		clock_gettime(CLOCK_REALTIME, &x_wait);
+		x_wait.tv_sec++;
+		pthread_cond_timedwait(&s_pans_cond, &s_pans_mutex, &x_wait);
+	}
+
+	pthread_mutex_unlock(&s_pans_mutex);
+
+	if (!sb_exit) {
+		/* Every PAN stopped on error */
+		return -1;
+	}
+
+	LOG_ERR(Log("I die...\r\n"));
+	#ifdef DEBUG_IN_FILE
+		close_log_file();
+	#endif
+	return 0;
 }
@@ -39,6 +39,7 @@
 
 #include <stdarg.h>
 #include <stdio.h>
+#include <oss_if.h>
 
 #ifdef LINUX
 static int s_i_verbose = 0;
@@ -121,6 +122,33 @@ const char *LogGetFileName(const char *fullpath)
 	return(ret);
 }
 
+/* Every PAN thread sets its own tag */
+static PAN_LOCAL char s_sz_tag[32] = "";
+
+void LogSetTag(const char *tag)
+{
+	if (tag == NULL) {
+		s_sz_tag[0] = '\0';
+	} else {
+		snprintf(s_sz_tag, sizeof(s_sz_tag), "%s ", tag);
+	}
+}
+
+const char *LogGetTag(void)
+{
+	return s_sz_tag;
+}
+
+void LogLock(void)
+{
+	flockfile(stderr);
+}
+
+void LogUnlock(void)
+{
+	funlockfile(stderr);
+}
+
 /**********************************************************************************************************************/
 
 /** @}
@@ -112,6 +112,26 @@ void LogAssert(const char *file, uint32_t line, const char *condition);
  **********************************************************************************************************************/
 const char *LogGetFileName(const char *fullpath);
 
+/**********************************************************************************************************************/
+
+/** This function sets a tag printed in every log line of the calling thread, used to tell apart the logs of the PANs
+ * sharing the same output
+ ***********************************************************************************************************************
+ *
+ * @param tag Tag text (copied), NULL to remove it
+ *
+ **********************************************************************************************************************/
+void LogSetTag(const char *tag);
+
+/** This function returns the log tag, followed by a space when set
+ **********************************************************************************************************************/
+const char *LogGetTag(void);
+
+/** These functions keep the lines of a thread together while it outputs them, used by the logging macros
+ **********************************************************************************************************************/
+void LogLock(void);
+void LogUnlock(void);
+
 /*  #define NDEBUG */
 
 /* / Log level meaning that no log messages are output. */
@@ -162,10 +182,10 @@ extern uint32_t oss_get_up_time_ms(void);
 #if (LOG_LEVEL >= LOG_LVL_ERR) && !defined(NDEBUG)
 /* / Outputs an error message. */
   #define LOG_ERR(expression) \
-	{Log("\r\n%08X ERR   %s:%d ", oss_get_up_time_ms(), LogGetFileName(__FILE__), __LINE__); expression; }
+	{LogLock(); Log("\r\n%08X %sERR   %s:%d ", oss_get_up_time_ms(), LogGetTag(), LogGetFileName(__FILE__), __LINE__); expression; LogUnlock(); }
 /* / Outputs a high priority information message (log level LOG_LVL_ERR). */
   #define LOG_PRIO(expression) \
-	{Log("\r\n%08X PRIO  %s:%d ", oss_get_up_time_ms(), LogGetFileName(__FILE__), __LINE__); expression; }
+	{LogLock(); Log("\r\n%08X %sPRIO  %s:%d ", oss_get_up_time_ms(), LogGetTag(), LogGetFileName(__FILE__), __LINE__); expression; LogUnlock(); }
 #else
   #define LOG_ERR(expression)    /* Nothing */
   #define LOG_PRIO(expression)    /* Nothing */
@@ -175,7 +195,7 @@ extern uint32_t oss_get_up_time_ms(void);
 /* / Outputs an information message. */
 #pragma message "LOG_INFO enabled"
   #define LOG_INFO(expression) \
-	{Log("\r\n%08X INFO  %s:%d ", oss_get_up_time_ms(), LogGetFileName(__FILE__), __LINE__); expression; }
+	{LogLock(); Log("\r\n%08X %sINFO  %s:%d ", oss_get_up_time_ms(), LogGetTag(), LogGetFileName(__FILE__), __LINE__); expression; LogUnlock(); }
 #else
   #define LOG_INFO(expression)     /* Nothing */
 #endif
@@ -184,7 +204,7 @@ extern uint32_t oss_get_up_time_ms(void);
 /* / Outputs a debug message. */
 #pragma message "LOG_DBG enabled"
   #define LOG_DBG(expression) \
-	{Log("\r\n%08X DBG   %s:%d ", oss_get_up_time_ms(), LogGetFileName(__FILE__), __LINE__); expression; }
+	{LogLock(); Log("\r\n%08X %sDBG   %s:%d ", oss_get_up_time_ms(), LogGetTag(), LogGetFileName(__FILE__), __LINE__); expression; LogUnlock(); }
 #else
 	#pragma message "ARG, no debug"
   #define LOG_DBG(expression)             /* Nothing */
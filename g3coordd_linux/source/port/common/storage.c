@@ -33,145 +33,619 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <errno.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <AdpApi.h>
 #include "Logger.h"
+#include "conf_bs.h"
+#include "oss_if.h"
 #include "storage.h"
+#include "../src/UsiCrc.h"
 
-static struct TPersistentInfo persistentInfo;
+#define STORAGE_SNAPSHOT_MAGIC      0x47335354 /* "G3ST" */
+#define STORAGE_JOURNAL_BUF_SIZE    4096
 
-static uint16_t Crc16(const uint8_t *pu8Data, uint32_t u32Length, uint16_t u16Poly, uint16_t u16Crc);
-static void platform_init_storage(void);
-static bool platform_write_storage(uint32_t u32Length, const void *pData);
-static bool platform_read_storage(uint32_t u32Length, void *pData);
+/* Journal record types. Records hold final values, so replaying them twice is harmless */
+#define STORAGE_REC_LBD             1
+#define STORAGE_REC_STACK           2
 
-static void _get_persistent_data(struct TPersistentData *data);
+struct storage_lbd {
+	uint8_t auc_ext_addr[ADP_ADDRESS_64BITS];
+	uint8_t uc_lbp_hops;
+};
+
+/* Coordinator state kept in memory and saved in the snapshot */
+struct storage_state {
+	struct TPersistentInfo x_persistent;
+	uint8_t uc_stack_valid;
+	uint8_t uc_keys_valid;
+	uint8_t uc_key_index;
+	uint8_t auc_gmk[16];
+	uint16_t us_initial_short_address; /* 0: not stored */
+	uint16_t us_blacklist_size;
+	uint8_t auc_blacklist[MAX_LBDS][ADP_ADDRESS_64BITS];
+	struct storage_lbd ax_lbds[MAX_LBDS];
+};
+
+struct storage_snapshot {
+	uint32_t ul_magic;
+	uint32_t ul_seq;
+	uint16_t us_version;
+	uint16_t us_crc;
+	struct storage_state x_state;
+};
+
+struct storage_record_header {
+	uint8_t uc_type;
+	uint8_t uc_length;
+	uint16_t us_crc;
+};
+
+struct storage_record_lbd {
+	uint16_t us_index;
+	struct storage_lbd x_lbd;
+};
+
+/* Every PAN keeps its own store */
+static PAN_LOCAL pthread_mutex_t s_storage_mutex = PTHREAD_MUTEX_INITIALIZER;
+static PAN_LOCAL struct storage_state s_x_state;
+static PAN_LOCAL bool s_b_state_loaded;
+
+/* Snapshot file is mapped; both copies are kept, the older one is overwritten */
+static PAN_LOCAL struct storage_snapshot *s_px_snapshot = NULL;
+static PAN_LOCAL uint32_t s_ul_snapshot_seq;
+
+static PAN_LOCAL int s_i_journal_fd = -1;
+static PAN_LOCAL uint32_t s_ul_journal_size;
+static PAN_LOCAL uint8_t s_auc_journal_buf[STORAGE_JOURNAL_BUF_SIZE];
+static PAN_LOCAL uint32_t s_ul_journal_buf_len;
+
+/* Changes not yet on disk, time of the first one */
+static PAN_LOCAL bool s_b_pending;
+static PAN_LOCAL uint32_t s_ul_pending_time;
+/* Keys, blacklist or initial address changed: rewrite snapshot instead of journal */
+static PAN_LOCAL bool s_b_snapshot_dirty;
+/* Stack asked to store its data (AdpUpdNonVolatileDataIndication) */
+static PAN_LOCAL bool s_b_stack_update;
+
+static bool _get_persistent_data(struct TPersistentData *data);
 static void _set_persistent_data(struct TPersistentData *data);
 
+static uint16_t _record_crc(const struct storage_record_header *px_hdr, const uint8_t *puc_data)
+{
+	uint16_t us_crc = usi_Crc16Ccitt(USI_CRC16_CCITT_INIT, (const uint8_t *)px_hdr, 2);
+
+	return usi_Crc16Ccitt(us_crc, puc_data, px_hdr->uc_length);
+}
+
+static bool _snapshot_is_valid(const struct storage_snapshot *px_snap)
+{
+	if ((px_snap->ul_magic != STORAGE_SNAPSHOT_MAGIC) || (px_snap->us_version != STORAGE_SNAPSHOT_VERSION)) {
+		return false;
+	}
+
+	return (px_snap->us_crc == usi_Crc16Ccitt(USI_CRC16_CCITT_INIT, (const uint8_t *)&px_snap->x_state, sizeof(struct storage_state)));
+}
+
+static bool _is_null_ext_addr(const uint8_t *puc_ext_addr)
+{
+	static const uint8_t auc_null[ADP_ADDRESS_64BITS] = {0};
+
+	return (memcmp(puc_ext_addr, auc_null, ADP_ADDRESS_64BITS) == 0);
+}
+
+static void _mark_pending(void)
+{
+	if (!s_b_pending) {
+		s_b_pending = true;
+		s_ul_pending_time = oss_get_up_time_ms();
+	}
+}
+
 /**
- * \brief Initialize Storage Capabilities
- * It needs to be implemented if TPersistentInfo is not saved on G3 ADP/MAC Modem
- * Please see ENABLE_PIB_RESTORE on Embedded Project
- * \remarks
+ * \brief Writes buffered journal records and waits until they are on disk
+ * Called with storage mutex taken
  */
-void platform_init_storage(void)
+static void _journal_flush(void)
 {
-	return;
+	uint32_t ul_done = 0;
+	ssize_t i_len;
+
+	if ((s_i_journal_fd < 0) || (s_ul_journal_buf_len == 0)) {
+		return;
+	}
+
+	while (ul_done < s_ul_journal_buf_len) {
+		i_len = write(s_i_journal_fd, &s_auc_journal_buf[ul_done], s_ul_journal_buf_len - ul_done);
+		if (i_len < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			LOG_ERR(Log("Storage: journal write error %d", errno));
+			break;
+		}
+
+		ul_done += i_len;
+	}
+
+	if (fdatasync(s_i_journal_fd) < 0) {
+		LOG_ERR(Log("Storage: journal sync error %d", errno));
+	}
+
+	s_ul_journal_size += ul_done;
+	s_ul_journal_buf_len = 0;
+}
+
+/**
+ * \brief Appends a record to the journal buffer
+ * Called with storage mutex taken
+ */
+static void _journal_append(uint8_t uc_type, const void *p_data, uint8_t uc_length)
+{
+	struct storage_record_header x_hdr;
+
+	if (s_i_journal_fd < 0) {
+		return;
+	}
+
+	if ((s_ul_journal_buf_len + sizeof(x_hdr) + uc_length) > STORAGE_JOURNAL_BUF_SIZE) {
+		_journal_flush();
+	}
+
+	x_hdr.uc_type = uc_type;
+	x_hdr.uc_length = uc_length;
+	x_hdr.us_crc = _record_crc(&x_hdr, p_data);
+	memcpy(&s_auc_journal_buf[s_ul_journal_buf_len], &x_hdr, sizeof(x_hdr));
+	memcpy(&s_auc_journal_buf[s_ul_journal_buf_len + sizeof(x_hdr)], p_data, uc_length);
+	s_ul_journal_buf_len += sizeof(x_hdr) + uc_length;
+
+	_mark_pending();
 }
 
 /**
- * \brief Write Values to be storaged from G3 Stack
- * It needs to be implemented if TPersistentInfo is not saved on G3 ADP/MAC Modem
- * Please see ENABLE_PIB_RESTORE on Embedded Project
+ * \brief Saves whole state in the older snapshot copy and empties the journal
+ * Called with storage mutex taken
  */
-bool platform_write_storage(uint32_t u32Length, const void *pData)
+static void _snapshot_write(void)
 {
-	bool bRet = false;
-	return bRet;
+	struct storage_snapshot *px_snap;
+
+	if (s_px_snapshot == NULL) {
+		return;
+	}
+
+	s_ul_snapshot_seq++;
+	px_snap = &s_px_snapshot[s_ul_snapshot_seq & 1];
+
+	px_snap->ul_magic = 0;
+	memcpy(&px_snap->x_state, &s_x_state, sizeof(struct storage_state));
+	px_snap->ul_seq = s_ul_snapshot_seq;
+	px_snap->us_version = STORAGE_SNAPSHOT_VERSION;
+	px_snap->us_crc = usi_Crc16Ccitt(USI_CRC16_CCITT_INIT, (const uint8_t *)&px_snap->x_state, sizeof(struct storage_state));
+	px_snap->ul_magic = STORAGE_SNAPSHOT_MAGIC;
+
+	if (msync(s_px_snapshot, 2 * sizeof(struct storage_snapshot), MS_SYNC) < 0) {
+		LOG_ERR(Log("Storage: snapshot sync error %d", errno));
+		return;
+	}
+
+	/* Snapshot includes every journaled change, buffered ones too */
+	s_ul_journal_buf_len = 0;
+	if ((s_i_journal_fd >= 0) && (ftruncate(s_i_journal_fd, 0) == 0)) {
+		s_ul_journal_size = 0;
+	}
+
+	s_b_snapshot_dirty = false;
 }
 
 /**
- * \brief Read Values to be loaded on G3 Stack
- * It needs to be implemented if TPersistentInfo is not saved on G3 ADP/MAC Modem
- * Please see ENABLE_PIB_RESTORE on Embedded Project
+ * \brief Applies journal records on top of the loaded snapshot
+ *
+ * \return Length of the valid part of the journal
  */
-bool platform_read_storage(uint32_t u32Length, void *pData)
+static uint32_t _journal_replay(const uint8_t *puc_buf, uint32_t ul_size)
 {
-	bool bRet = false;
-	return bRet;
+	struct storage_record_header x_hdr;
+	struct storage_record_lbd x_lbd_rec;
+	const uint8_t *puc_data;
+	uint32_t ul_pos = 0;
+
+	while ((ul_pos + sizeof(x_hdr)) <= ul_size) {
+		memcpy(&x_hdr, &puc_buf[ul_pos], sizeof(x_hdr));
+		puc_data = &puc_buf[ul_pos + sizeof(x_hdr)];
+
+		/* A torn write at the end of the journal ends the replay */
+		if (((ul_pos + sizeof(x_hdr) + x_hdr.uc_length) > ul_size) || (x_hdr.us_crc != _record_crc(&x_hdr, puc_data))) {
+			break;
+		}
+
+		if ((x_hdr.uc_type == STORAGE_REC_LBD) && (x_hdr.uc_length == sizeof(x_lbd_rec))) {
+			memcpy(&x_lbd_rec, puc_data, sizeof(x_lbd_rec));
+			if (x_lbd_rec.us_index < MAX_LBDS) {
+				s_x_state.ax_lbds[x_lbd_rec.us_index] = x_lbd_rec.x_lbd;
+			}
+		} else if ((x_hdr.uc_type == STORAGE_REC_STACK) && (x_hdr.uc_length == sizeof(struct TPersistentInfo))) {
+			memcpy(&s_x_state.x_persistent, puc_data, sizeof(struct TPersistentInfo));
+			s_x_state.uc_stack_valid = 1;
+		}
+
+		s_b_state_loaded = true;
+		ul_pos += sizeof(x_hdr) + x_hdr.uc_length;
+	}
+
+	return ul_pos;
 }
 
 /**
- * \brief Stores persistent data.
+ * \brief Opens the state store and loads the last saved coordinator state
+ * If the store cannot be opened the coordinator works without it (cold start)
  *
- * \remarks It needs to be implemented if TPersistentInfo is not saved on G3 ADP/MAC Modem
+ * @param sz_instance  Coordinator instance name, each instance has its own files
  */
-void store_persistent_info(void)
+void storage_init(const char *sz_instance)
 {
-	LOG_INFO(Log("PDD_CB: Persistent data stored.\r\n"));
+	char sz_snapshot_file[PATH_MAX];
+	char sz_journal_file[PATH_MAX];
+	struct stat x_stat;
+	struct storage_snapshot *px_last = NULL;
+	uint8_t *puc_buf;
+	uint32_t ul_valid;
+	int i_fd;
+	uint8_t uc_i;
+
+	memset(&s_x_state, 0, sizeof(s_x_state));
+	snprintf(sz_snapshot_file, sizeof(sz_snapshot_file), STORAGE_SNAPSHOT_FILE_FMT, sz_instance);
+	snprintf(sz_journal_file, sizeof(sz_journal_file), STORAGE_JOURNAL_FILE_FMT, sz_instance);
+
+	if ((mkdir(STORAGE_DIR, 0700) < 0) && (errno != EEXIST)) {
+		LOG_ERR(Log("Storage: unable to create %s (%d), state will not be kept", STORAGE_DIR, errno));
+		return;
+	}
 
-	_get_persistent_data(&persistentInfo.m_data);
+	/* Snapshot */
+	i_fd = open(sz_snapshot_file, O_RDWR | O_CREAT, 0600);
+	if ((i_fd < 0) || (fstat(i_fd, &x_stat) < 0) ||
+			((x_stat.st_size != 2 * sizeof(struct storage_snapshot)) && (ftruncate(i_fd, 2 * sizeof(struct storage_snapshot)) < 0))) {
+		LOG_ERR(Log("Storage: unable to open %s (%d), state will not be kept", sz_snapshot_file, errno));
+		if (i_fd >= 0) {
+			close(i_fd);
+		}
 
-	/* Persistent info Header */
-	persistentInfo.m_u16Version = STORAGE_VERSION;
-	persistentInfo.m_u16Crc16 = Crc16((const uint8_t *)(&persistentInfo.m_data), sizeof(struct TPersistentData), 0x1021, 0xFFFF);
+		return;
+	}
+
+	s_px_snapshot = mmap(NULL, 2 * sizeof(struct storage_snapshot), PROT_READ | PROT_WRITE, MAP_SHARED, i_fd, 0);
+	close(i_fd);
+	if (s_px_snapshot == MAP_FAILED) {
+		LOG_ERR(Log("Storage: unable to map %s (%d), state will not be kept", sz_snapshot_file, errno));
+		s_px_snapshot = NULL;
+		return;
+	}
+
+	for (uc_i = 0; uc_i < 2; uc_i++) {
+		if (_snapshot_is_valid(&s_px_snapshot[uc_i]) &&
+				((px_last == NULL) || ((int32_t)(s_px_snapshot[uc_i].ul_seq - px_last->ul_seq) > 0))) {
+			px_last = &s_px_snapshot[uc_i];
+		}
+	}
 
-	/* Write internal data to the persistent storage */
-	platform_write_storage(sizeof(struct TPersistentInfo), &persistentInfo);
+	if (px_last != NULL) {
+		memcpy(&s_x_state, &px_last->x_state, sizeof(struct storage_state));
+		s_ul_snapshot_seq = px_last->ul_seq;
+		s_b_state_loaded = true;
+	}
+
+	/* Journal */
+	s_i_journal_fd = open(sz_journal_file, O_RDWR | O_CREAT | O_APPEND, 0600);
+	if (s_i_journal_fd < 0) {
+		LOG_ERR(Log("Storage: unable to open %s (%d), changes will not be kept", sz_journal_file, errno));
+	} else if ((fstat(s_i_journal_fd, &x_stat) == 0) && (x_stat.st_size > 0)) {
+		puc_buf = malloc(x_stat.st_size);
+		if ((puc_buf != NULL) && (pread(s_i_journal_fd, puc_buf, x_stat.st_size, 0) == x_stat.st_size)) {
+			ul_valid = _journal_replay(puc_buf, x_stat.st_size);
+			if ((ul_valid < x_stat.st_size) && (ftruncate(s_i_journal_fd, ul_valid) == 0)) {
+				LOG_INFO(Log("Storage: journal truncated to %u bytes", ul_valid));
+			}
+
+			s_ul_journal_size = ul_valid;
+		}
+
+		free(puc_buf);
+	}
+
+	LOG_INFO(Log("Storage: state %s (snapshot %u, journal %u bytes)", s_b_state_loaded ? "loaded" : "empty",
+			s_ul_snapshot_seq, s_ul_journal_size));
+}
+
+/**
+ * \brief Writes pending changes and closes the state store
+ * Called by the PAN loop when it ends
+ */
+void storage_exit(void)
+{
+	pthread_mutex_lock(&s_storage_mutex);
+	_journal_flush();
+	if (s_i_journal_fd >= 0) {
+		close(s_i_journal_fd);
+		s_i_journal_fd = -1;
+	}
+
+	if (s_px_snapshot != NULL) {
+		munmap(s_px_snapshot, 2 * sizeof(struct storage_snapshot));
+		s_px_snapshot = NULL;
+	}
+
+	pthread_mutex_unlock(&s_storage_mutex);
+}
+
+/**
+ * \brief Storage process, writes pending changes in batches
+ * Must be called periodically from the PAN loop (it may use synchronous stack requests)
+ */
+void storage_process(void)
+{
+	struct TPersistentData x_data;
+	bool b_stack_update;
+
+	pthread_mutex_lock(&s_storage_mutex);
+	b_stack_update = s_b_stack_update;
+	s_b_stack_update = false;
+	pthread_mutex_unlock(&s_storage_mutex);
+
+	if (b_stack_update) {
+		/* Fields which can not be read keep their stored value */
+		pthread_mutex_lock(&s_storage_mutex);
+		x_data = s_x_state.x_persistent.m_data;
+		pthread_mutex_unlock(&s_storage_mutex);
+		if (!_get_persistent_data(&x_data)) {
+			/* Frame counter unknown: stored record is kept, the margin added on load covers it */
+			LOG_ERR(Log("storage_process() unable to read the frame counter, persistent data not stored.\r\n"));
+			b_stack_update = false;
+		}
+	}
+
+	if (b_stack_update) {
+		pthread_mutex_lock(&s_storage_mutex);
+		s_x_state.x_persistent.m_data = x_data;
+		s_x_state.x_persistent.m_u16Version = STORAGE_VERSION;
+		s_x_state.x_persistent.m_u16Crc16 = usi_Crc16Ccitt(USI_CRC16_CCITT_INIT, (const uint8_t *)(&x_data), sizeof(struct TPersistentData));
+		s_x_state.uc_stack_valid = 1;
+		_journal_append(STORAGE_REC_STACK, &s_x_state.x_persistent, sizeof(struct TPersistentInfo));
+		pthread_mutex_unlock(&s_storage_mutex);
+		LOG_INFO(Log("PDD_CB: Persistent data stored.\r\n"));
+	}
+
+	pthread_mutex_lock(&s_storage_mutex);
+	if (s_b_pending && ((oss_get_up_time_ms() - s_ul_pending_time) >= STORAGE_FLUSH_MS)) {
+		if (s_b_snapshot_dirty || ((s_ul_journal_size + s_ul_journal_buf_len) >= STORAGE_JOURNAL_MAX_SIZE)) {
+			_snapshot_write();
+		} else {
+			_journal_flush();
+		}
+
+		s_b_pending = false;
+	}
+
+	pthread_mutex_unlock(&s_storage_mutex);
+}
+
+/**
+ * \brief Bootstrap state change callback: keeps stored state up to date
+ * It can be called from any thread, always with the bootstrap lock taken
+ */
+void storage_bs_state_ind(enum bs_state_item e_item, uint16_t us_index)
+{
+	struct storage_record_lbd x_lbd_rec;
+	struct t_bs_lbp_get_param_confirm x_get_confirm;
+
+	if (s_px_snapshot == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&s_storage_mutex);
+
+	switch (e_item) {
+	case BS_STATE_ITEM_LBD:
+		x_lbd_rec.us_index = us_index;
+		if (bs_get_lbd_entry(us_index, x_lbd_rec.x_lbd.auc_ext_addr, &x_lbd_rec.x_lbd.uc_lbp_hops)) {
+			s_x_state.ax_lbds[us_index] = x_lbd_rec.x_lbd;
+			_journal_append(STORAGE_REC_LBD, &x_lbd_rec, sizeof(x_lbd_rec));
+		}
+
+		break;
+
+	case BS_STATE_ITEM_BLACKLIST:
+		s_x_state.us_blacklist_size = bs_get_blacklist(s_x_state.auc_blacklist, MAX_LBDS);
+		s_b_snapshot_dirty = true;
+		_mark_pending();
+		break;
+
+	case BS_STATE_ITEM_KEYS:
+		bs_get_keys(s_x_state.auc_gmk, &s_x_state.uc_key_index);
+		s_x_state.uc_keys_valid = 1;
+		s_b_snapshot_dirty = true;
+		_mark_pending();
+		break;
+
+	case BS_STATE_ITEM_INITIAL_SHORT_ADDRESS:
+		bs_lbp_get_param(LBP_IB_INITIAL_SHORT_ADDRESS, 0, &x_get_confirm);
+		s_x_state.us_initial_short_address = (x_get_confirm.uc_attribute_value[0] << 8) | x_get_confirm.uc_attribute_value[1];
+		s_b_snapshot_dirty = true;
+		_mark_pending();
+		break;
+
+	default:
+		break;
+	}
+
+	pthread_mutex_unlock(&s_storage_mutex);
+}
+
+/**
+ * \brief Restores saved bootstrap state (joined devices, blacklist, keys) after bs_init
+ * Devices restored this way do not need to bootstrap again
+ */
+void storage_restore_bootstrap(void)
+{
+	struct t_bs_lbp_set_param_confirm x_set_confirm;
+	uint8_t auc_value[2];
+	uint16_t us_i;
+	uint16_t us_restored = 0;
+
+	/* Same lock order as storage_bs_state_ind(): bootstrap first */
+	bs_lock();
+	pthread_mutex_lock(&s_storage_mutex);
+
+	if (!s_b_state_loaded) {
+		pthread_mutex_unlock(&s_storage_mutex);
+		bs_unlock();
+		return;
+	}
+
+	if (s_x_state.us_initial_short_address != 0) {
+		auc_value[0] = (uint8_t)(s_x_state.us_initial_short_address & 0x00FF);
+		auc_value[1] = (uint8_t)(s_x_state.us_initial_short_address >> 8);
+		bs_lbp_set_param(LBP_IB_INITIAL_SHORT_ADDRESS, 0, 2, auc_value, &x_set_confirm);
+	}
+
+	if (s_x_state.uc_keys_valid) {
+		bs_restore_keys(s_x_state.auc_gmk, s_x_state.uc_key_index);
+	}
+
+	for (us_i = 0; us_i < s_x_state.us_blacklist_size; us_i++) {
+		bs_lbp_set_param(LBP_IB_ADD_DEVICE_TO_BLACKLIST, 0, ADP_ADDRESS_64BITS, s_x_state.auc_blacklist[us_i], &x_set_confirm);
+	}
+
+	for (us_i = 0; us_i < MAX_LBDS; us_i++) {
+		/* Empty slots are not devices */
+		if (_is_null_ext_addr(s_x_state.ax_lbds[us_i].auc_ext_addr)) {
+			continue;
+		}
+
+		if (bs_restore_lbd_entry(us_i, s_x_state.ax_lbds[us_i].auc_ext_addr, s_x_state.ax_lbds[us_i].uc_lbp_hops)) {
+			us_restored++;
+		}
+	}
+
+	pthread_mutex_unlock(&s_storage_mutex);
+	bs_unlock();
+
+	LOG_INFO(Log("Storage: %u devices restored", us_restored));
+}
+
+/**
+ * \brief Requests to store persistent data from G3 stack.
+ * Called from AdpUpdNonVolatileDataIndication; data is read and stored from storage_process.
+ */
+void store_persistent_info(void)
+{
+	pthread_mutex_lock(&s_storage_mutex);
+	s_b_stack_update = true;
+	pthread_mutex_unlock(&s_storage_mutex);
 }
 
 /**
  * \brief Loads persistent data
  *
- * \remarks It needs to be implemented if TPersistentInfo is not saved on G3 ADP/MAC Modem
+ * \remarks Restored frame counter is moved forward STORAGE_FRAME_COUNTER_MARGIN and never goes back
  */
 void load_persistent_info(void)
 {
+	struct TPersistentInfo x_info;
+	struct TPersistentData x_current = {0};
 	bool b_upd_info;
 	LOG_INFO(Log("Loading persistent data...\r\n"));
 
-	b_upd_info = true;
-	platform_init_storage();
+	pthread_mutex_lock(&s_storage_mutex);
+	x_info = s_x_state.x_persistent;
+	b_upd_info = s_x_state.uc_stack_valid;
+	pthread_mutex_unlock(&s_storage_mutex);
 
-	/* Read the persistent storage */
-	if (platform_read_storage(sizeof(struct TPersistentInfo), &persistentInfo)) {
+	if (b_upd_info) {
 		/* Check the CRC */
-		uint16_t u16Crc16 = Crc16((const uint8_t *)(&persistentInfo.m_data), sizeof(struct TPersistentData), 0x1021, 0xFFFF);
+		uint16_t u16Crc16 = usi_Crc16Ccitt(USI_CRC16_CCITT_INIT, (const uint8_t *)(&x_info.m_data), sizeof(struct TPersistentData));
 
-		if (persistentInfo.m_u16Crc16 != u16Crc16) {
-			LOG_ERR(Log("load_persistent_info() CRC error. Read: %u, Calc: %u\r\n", persistentInfo.m_u16Crc16, u16Crc16));
+		if (x_info.m_u16Crc16 != u16Crc16) {
+			LOG_ERR(Log("load_persistent_info() CRC error. Read: %u, Calc: %u\r\n", x_info.m_u16Crc16, u16Crc16));
 			b_upd_info = false;
-		} else if (persistentInfo.m_u16Version > STORAGE_VERSION) {
+		} else if (x_info.m_u16Version > STORAGE_VERSION) {
 			LOG_ERR(Log("load_persistent_info() storage version error.\r\n"));
 			b_upd_info = false;
 		}
 	} else {
 		LOG_ERR(Log("load_persistent_info() unable to read storage.\r\n"));
-		b_upd_info = false;
 	}
 
 	/* Increment startup counter */
-	persistentInfo.m_u32StartupCounter++;
+	x_info.m_u32StartupCounter++;
 
 	/* Set Values to G3 Stack */
-	_set_persistent_data(&persistentInfo.m_data);
-	LOG_INFO(Log("Persistent data loaded. Startup Counter: %d\r\n", persistentInfo.m_u32StartupCounter));
-}
-
-/**
- * \brief Calculates CRC-16
- *
- */
-static uint16_t Crc16(const uint8_t *pu8Data, uint32_t u32Length, uint16_t u16Poly, uint16_t u16Crc)
-{
-	uint8_t u8Index;
-	while (u32Length--) {
-		u16Crc ^= (*pu8Data++) << 8;
-		for (u8Index = 0; u8Index < 8; u8Index++) {
-			u16Crc = (u16Crc << 1) ^ ((u16Crc & 0x8000U) ? u16Poly : 0);
+	if (b_upd_info) {
+		x_info.m_data.m_u32FrameCounter += STORAGE_FRAME_COUNTER_MARGIN;
+		/* Counter of the stack only counts when it could be read */
+		if (_get_persistent_data(&x_current) && (x_current.m_u32FrameCounter > x_info.m_data.m_u32FrameCounter)) {
+			x_info.m_data.m_u32FrameCounter = x_current.m_u32FrameCounter;
 		}
+
+		_set_persistent_data(&x_info.m_data);
+		x_info.m_u16Crc16 = usi_Crc16Ccitt(USI_CRC16_CCITT_INIT, (const uint8_t *)(&x_info.m_data), sizeof(struct TPersistentData));
+	}
+
+	pthread_mutex_lock(&s_storage_mutex);
+	s_x_state.x_persistent = x_info;
+	if (b_upd_info) {
+		_journal_append(STORAGE_REC_STACK, &s_x_state.x_persistent, sizeof(struct TPersistentInfo));
 	}
-	return u16Crc;
+
+	pthread_mutex_unlock(&s_storage_mutex);
+
+	LOG_INFO(Log("Persistent data loaded. Startup Counter: %d\r\n", x_info.m_u32StartupCounter));
 }
 
 /**
  * \brief Gets G3 stack info to be stored
  *
  * \param info     Pointer to the persistent info
+ *
+ * \return true if the frame counter was read. Fields not read are left unchanged
  */
-static void _get_persistent_data(struct TPersistentData *data)
+static bool _get_persistent_data(struct TPersistentData *data)
 {
+	bool b_frame_counter = false;
+
 	struct TAdpMacGetConfirm macGetConfirm;
-	struct TAdpGetConfirm adpGetConfirm;
+	struct TAdpGetConfirm adpGetConfirms[2];
+	const struct TAdpPibRequest adpRequests[2] = {
+		{ ADP_IB_MANUF_DISCOVER_SEQUENCE_NUMBER, 0, 0, NULL },
+		{ ADP_IB_MANUF_BROADCAST_SEQUENCE_NUMBER, 0, 0, NULL },
+	};
 
 	/* Read internal data from the stack */
 	AdpMacGetRequestSync(MAC_WRP_PIB_FRAME_COUNTER, 0, &macGetConfirm);
-	memcpy(&data->m_u32FrameCounter, macGetConfirm.m_au8AttributeValue, macGetConfirm.m_u8AttributeLength);
-	AdpGetRequestSync(ADP_IB_MANUF_DISCOVER_SEQUENCE_NUMBER, 0, &adpGetConfirm);
-	memcpy(&data->m_u16DiscoverSeqNumber, adpGetConfirm.m_au8AttributeValue, adpGetConfirm.m_u8AttributeLength);
-	AdpGetRequestSync(ADP_IB_MANUF_BROADCAST_SEQUENCE_NUMBER, 0, &adpGetConfirm);
-	memcpy(&data->m_u8BroadcastSeqNumber, adpGetConfirm.m_au8AttributeValue, adpGetConfirm.m_u8AttributeLength);
+	if ((macGetConfirm.m_u8Status == G3_SUCCESS) && (macGetConfirm.m_u8AttributeLength == sizeof(data->m_u32FrameCounter))) {
+		memcpy(&data->m_u32FrameCounter, macGetConfirm.m_au8AttributeValue, sizeof(data->m_u32FrameCounter));
+		b_frame_counter = true;
+	}
+
+	AdpGetRequestMulti(adpRequests, 2, adpGetConfirms);
+	if (adpGetConfirms[0].m_u8Status == G3_SUCCESS) {
+		memcpy(&data->m_u16DiscoverSeqNumber, adpGetConfirms[0].m_au8AttributeValue, sizeof(data->m_u16DiscoverSeqNumber));
+	}
+
+	if (adpGetConfirms[1].m_u8Status == G3_SUCCESS) {
+		memcpy(&data->m_u8BroadcastSeqNumber, adpGetConfirms[1].m_au8AttributeValue, sizeof(data->m_u8BroadcastSeqNumber));
+	}
+
+	return b_frame_counter;
 }
 
 /**
@@ -181,13 +655,14 @@ static void _get_persistent_data(struct TPersistentData *data)
  */
 static void _set_persistent_data(struct TPersistentData *data)
 {
-	struct TAdpMacSetConfirm macSetConfirm;
-	struct TAdpSetConfirm adpSetConfirm;
+	struct TAdpSetConfirm setConfirms[3];
+	const bool abMac[3] = { true, false, false };
+	const struct TAdpPibRequest requests[3] = {
+		{ MAC_WRP_PIB_FRAME_COUNTER, 0, sizeof(data->m_u32FrameCounter), (const uint8_t *)(&data->m_u32FrameCounter) },
+		{ ADP_IB_MANUF_DISCOVER_SEQUENCE_NUMBER, 0, sizeof(data->m_u16DiscoverSeqNumber), (const uint8_t *)(&data->m_u16DiscoverSeqNumber) },
+		{ ADP_IB_MANUF_BROADCAST_SEQUENCE_NUMBER, 0, sizeof(data->m_u8BroadcastSeqNumber), (const uint8_t *)(&data->m_u8BroadcastSeqNumber) },
+	};
 
-	/* Write internal data to the stack */
-	AdpMacSetRequestSync(MAC_WRP_PIB_FRAME_COUNTER, 0, sizeof(data->m_u32FrameCounter), (const uint8_t *)(&data->m_u32FrameCounter), &macSetConfirm);
-	AdpSetRequestSync(ADP_IB_MANUF_DISCOVER_SEQUENCE_NUMBER, 0, sizeof(data->m_u16DiscoverSeqNumber),
-			(const uint8_t *)(&data->m_u16DiscoverSeqNumber), &adpSetConfirm);
-	AdpSetRequestSync(ADP_IB_MANUF_BROADCAST_SEQUENCE_NUMBER, 0, sizeof(data->m_u8BroadcastSeqNumber),
-			(const uint8_t *)(&data->m_u8BroadcastSeqNumber), &adpSetConfirm);
+	/* Write internal data to the stack, in a single pipelined batch */
+	AdpMibSetRequestMulti(requests, abMac, 3, setConfirms);
 }
@@ -36,9 +36,24 @@
 
 /* System includes */
 #include <mac_wrapper.h>
+#include "bs_api.h"
 
 #define STORAGE_VERSION 1
 
+/* Coordinator state store: snapshot file with two CRC protected copies plus an append-only journal */
+#define STORAGE_DIR                     "/var/lib/g3coordd"
+/* One snapshot and journal per coordinator instance: <dir>/<instance>.snap, <dir>/<instance>.jnl */
+#define STORAGE_SNAPSHOT_FILE_FMT       STORAGE_DIR "/%s.snap"
+#define STORAGE_JOURNAL_FILE_FMT        STORAGE_DIR "/%s.jnl"
+#define STORAGE_SNAPSHOT_VERSION        1
+
+/* Journal records are written and synced in batches, at most this time after the first one */
+#define STORAGE_FLUSH_MS                1000
+/* Snapshot is rewritten and journal emptied when the journal reaches this size */
+#define STORAGE_JOURNAL_MAX_SIZE        (64 * 1024)
+/* Added to restored frame counter: frames sent after the last stored value must not be reused */
+#define STORAGE_FRAME_COUNTER_MARGIN    0x10000
+
 /* struct to store persistent data from stack (MAC & ADP) */
 struct TPersistentData {
 	uint32_t m_u32FrameCounter;
@@ -57,4 +72,10 @@ struct TPersistentInfo {
 void store_persistent_info(void);
 void load_persistent_info(void);
 
+void storage_init(const char *sz_instance);
+void storage_exit(void);
+void storage_process(void);
+void storage_restore_bootstrap(void);
+void storage_bs_state_ind(enum bs_state_item e_item, uint16_t us_index);
+
 #endif
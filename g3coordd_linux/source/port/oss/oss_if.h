@@ -42,6 +42,11 @@ extern "C" {
 /**INDENT-ON**/
 /* / @endcond */
 
+/* Storage of the state of a PAN: every PAN runs in its own thread (Makefile sets __thread) */
+#ifndef PAN_LOCAL
+#define PAN_LOCAL
+#endif
+
 extern uint8_t CONF_EXTENDED_ADDRESS[8];
 
 /* ! \name G3 OSS interface API */
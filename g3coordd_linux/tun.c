@@ -53,71 +53,112 @@
 #include "tun.h"
 
 /*
- * @brief	Set TUN Queue
- * @param	fd_tun	TUN file descriptor
- * @param	enable	Enable/Disable Queue
- * @return	0 on success
- *                         -1 otherwise
- */
-static int tun_set_queue(int fd_tun, int enable)
-{
-	struct ifreq ifr;
-
-	memset(&ifr, 0, sizeof(ifr));
-	if (enable) {
-		ifr.ifr_flags = IFF_ATTACH_QUEUE;
-	} else {
-		ifr.ifr_flags = IFF_DETACH_QUEUE;
-	}
-
-	return ioctl(fd_tun, TUNSETQUEUE, (void *)&ifr);
-}
-
-/*
- * @brief	Alloc TUN Device
- * @param	dev	TUN device name
+ * @brief	Open a TUN Device queue
+ * @param	dev	TUN device name, empty to let the kernel choose it
  * @param	flags	Tun device flags
- * @return	Tun device file descriptor
- *                         -1 otherwise
+ * @return	Queue file descriptor (non blocking)
+ *                         -1 otherwise, errno is kept
  */
-int tun_alloc(const char *dev, int flags)
+static int tun_open_queue(char *dev, int flags)
 {
 	struct ifreq ifr;
 	int fd, err;
 	char *clonedev = "/dev/net/tun";
 
 	/* open the clone device */
-	if ((fd = open(clonedev, O_RDWR | O_SYNC)) < 0) {
-		LOG_ERR(Log("Error open TUN clone device"));
-		return fd;
+	if ((fd = open(clonedev, O_RDWR | O_NONBLOCK)) < 0) {
+		return -1;
 	}
 
 	/* preparation of the struct ifr, of type "struct ifreq" */
 	memset(&ifr, 0, sizeof(ifr));
 
-	ifr.ifr_flags = flags;   /* IFF_TUN or IFF_TAP, plus maybe IFF_NO_PI */
+	ifr.ifr_flags = flags;   /* IFF_TUN or IFF_TAP, plus maybe IFF_NO_PI, IFF_MULTI_QUEUE */
 
 	if (*dev) {
 		strncpy(ifr.ifr_name, dev, IFNAMSIZ);
 	}
 
-	/* try to create the device */
-	if ((err = ioctl(fd, TUNSETIFF, (void *)&ifr)) < 0) {
-		LOG_ERR(Log("Error creating TUN device"));
+	/* try to create the device, or attach a new queue to it */
+	if (ioctl(fd, TUNSETIFF, (void *)&ifr) < 0) {
+		err = errno;
 		close(fd);
-		return err;
+		errno = err;
+		return -1;
 	}
 
 	strcpy(dev, ifr.ifr_name);
 
-	if (ioctl(fd, TUNSETPERSIST, 0) < 0) {
+	return fd;
+}
+
+/*
+ * @brief	Alloc TUN Device with several queues
+ * @param	dev	TUN device name
+ * @param	flags	Tun device flags (IFF_MULTI_QUEUE is added if more than one queue)
+ * @param	pi_fds	Queue file descriptors, non blocking
+ * @param	i_queues	Number of queues
+ * @return	Number of queues opened: 1 if the kernel has no multiqueue TUN
+ *                         -1 otherwise
+ */
+int tun_alloc_mq(char *dev, int flags, int *pi_fds, int i_queues)
+{
+	int i;
+
+	if (i_queues > 1) {
+		flags |= IFF_MULTI_QUEUE;
+	}
+
+	pi_fds[0] = tun_open_queue(dev, flags);
+	if ((pi_fds[0] < 0) && (flags & IFF_MULTI_QUEUE) && (errno == EINVAL)) {
+		LOG_INFO(Log("Multiqueue TUN not supported, using one queue"));
+		flags &= ~IFF_MULTI_QUEUE;
+		i_queues = 1;
+		pi_fds[0] = tun_open_queue(dev, flags);
+	}
+
+	if (pi_fds[0] < 0) {
+		LOG_ERR(Log("Error creating TUN device: %s", strerror(errno)));
+		return -1;
+	}
+
+	/* Next queues are attached to the device created by the first one */
+	for (i = 1; i < i_queues; i++) {
+		pi_fds[i] = tun_open_queue(dev, flags);
+		if (pi_fds[i] < 0) {
+			LOG_ERR(Log("Error attaching TUN queue %d: %s", i, strerror(errno)));
+			while (i-- > 0) {
+				close(pi_fds[i]);
+			}
+
+			return -1;
+		}
+	}
+
+	if (ioctl(pi_fds[0], TUNSETPERSIST, 0) < 0) {
 		perror("disabling TUNSETPERSIST");
 		exit(1);
 	}
 
-	tun_set_queue(fd, 0);
+	LOG_INFO(Log("Successfully created TUN device, %d queues", i_queues));
 
-	LOG_INFO(Log("Successfully created TUN device"));
+	return i_queues;
+}
+
+/*
+ * @brief	Alloc TUN Device
+ * @param	dev	TUN device name
+ * @param	flags	Tun device flags
+ * @return	Tun device file descriptor (non blocking)
+ *                         -1 otherwise
+ */
+int tun_alloc(char *dev, int flags)
+{
+	int fd;
+
+	if (tun_alloc_mq(dev, flags, &fd, 1) < 0) {
+		return -1;
+	}
 
 	return fd;
 }
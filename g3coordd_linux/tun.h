@@ -31,5 +31,15 @@
  *
  */
 
-int tun_alloc(const char *dev, int flags);
+/* TUN queues of a PAN. The PAN loop reads downlink packets from all of */
+/* them, uplink packets written from USI callbacks go to their own queue. */
+#define TUN_QUEUE_MAIN  0
+#define TUN_QUEUE_USI   1
+#define TUN_NUM_QUEUES  2
+
+/* Packets read from each queue per wakeup */
+#define TUN_RX_BURST    16
+
+int tun_alloc(char *dev, int flags);
+int tun_alloc_mq(char *dev, int flags, int *pi_fds, int i_queues);
 int tun_configure(const char *tun_name, uint16_t panId, const char *ipaddr, uint8_t prefix_len);
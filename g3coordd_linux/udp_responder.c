@@ -156,6 +156,8 @@ int udp_responder_thread(const char *iface)
 	struct sockaddr_in6 source;
 	socklen_t source_len;
 
+	/* Logs tagged as the ones of the PAN */
+	LogSetTag(iface);
 	LOG_INFO(Log("Starting CONFORMANCE G3 app"));
 	udp_server_fd = open_udp_server(iface);
 	if (udp_server_fd <= 0) {
@@ -43,6 +43,7 @@
 #include <netdb.h>
 #include <arpa/inet.h>
 
+#include <sys/uio.h>
 #include <termios.h> /* POSIX terminal control definitions */
 #include "../src/Usi.h"
 #include "../src/UsiCfg.h"
@@ -51,7 +52,8 @@
 
 #define CONFIG_GLOBAL_FD_SERIAL_PORT
 #ifdef CONFIG_GLOBAL_FD_SERIAL_PORT
-int32_t fd_serial_port = -1;
+/* Port of the modem of the PAN */
+PAN_LOCAL int32_t fd_serial_port = -1;
 #else
 /* Definitions needed for USI Ports Management */
 #define MAX_USI_PORTS 4
@@ -60,14 +62,14 @@ struct usi_port_t {
 	uint8_t port_number;
 	int32_t fd;
 };
-struct usi_port_t usi_ports[MAX_USI_PORTS];
-static uint32_t num_usi_ports = 0;
+PAN_LOCAL struct usi_port_t usi_ports[MAX_USI_PORTS];
+static PAN_LOCAL uint32_t num_usi_ports = 0;
 #endif
 
 int _open_tty_serial(char *_sz_port, unsigned int _ui_speed);
 
-/* Global Configuration save information about the connection */
-extern struct st_configuration g_st_config;
+/* Configuration of the PAN, with information about the connection */
+extern PAN_LOCAL struct st_configuration g_st_config;
 
 /**@brief Open communication port (parameters are defined in PrjCfg.h)
   @param port_type: Port Type (UART_TYPE, USART_TYPE, COM_TYPE)
@@ -182,6 +184,42 @@ uint16_t addUsi_TxMsg(uint8_t port_type, uint8_t port_number, uint8_t *sz_msg, u
 	return (ret > 0) ? ret : 0;
 }
 
+/*
+ * @brief	This function transmits several buffers through the interface
+ *        with a single system call.
+ * @param	port_type	  Serial Port Type
+ * @param port_number Serial Port Number
+ * @param	iov			    Buffers to be sent, in order
+ * @param	iovcnt		  Number of buffers
+ * @return	number of bytes written in the output buffer
+ *
+ */
+uint16_t addUsi_TxMsgV(uint8_t port_type, uint8_t port_number, const struct iovec *iov, uint8_t iovcnt)
+{
+	int32_t fd;
+	ssize_t ret;
+
+#ifdef CONFIG_GLOBAL_FD_SERIAL_PORT
+	fd = fd_serial_port;
+#else
+	uint32_t i;
+	/* Look for File descriptor associated to serial port */
+	fd = 0;
+	for (i = 0; i < MAX_USI_PORTS; i++) {
+		if ((usi_ports[i].port_type == port_type) && (usi_ports[i].port_number == port_number)) {
+			fd = usi_ports[i].fd;
+		}
+	}
+	if (!fd) {
+		LOG_USI_ERR("Tx Serial port not found!!!");
+		return 0;
+	}
+#endif
+	/* write all buffers to tty */
+	ret = writev(fd, iov, iovcnt);
+	return (ret > 0) ? ret : 0;
+}
+
 /*
  * @brief	This function reads a character from the UART.
  * @param	port_type	  Port Type to write in
@@ -216,6 +254,63 @@ int8_t addUsi_RxChar(uint8_t port_type, uint8_t port_number, uint8_t *c)
 	return (ret > 0) ? 0 : -1;
 }
 
+/*
+ * @brief	This function reads a block of characters from the UART.
+ * @param	port_type	  Port Type to read from
+ * @param	port_number	Port Number to read from
+ * @param	buf			    Buffer to store characters read.
+ * @param	maxlen		  Size of buffer.
+ * @return  	        number of characters read, 0 if none
+ *
+ */
+uint16_t addUsi_RxBlock(uint8_t port_type, uint8_t port_number, uint8_t *buf, uint16_t maxlen)
+{
+	int32_t fd, ret;
+
+#ifdef CONFIG_GLOBAL_FD_SERIAL_PORT
+	fd = fd_serial_port;
+#else
+	uint32_t i;
+	/* Look for File descriptor associated to serial port */
+	fd = 0;
+	for (i = 0; i < MAX_USI_PORTS; i++) {
+		if ((usi_ports[i].port_type == port_type) && (usi_ports[i].port_number == port_number)) {
+			fd = usi_ports[i].fd;
+		}
+	}
+	if (!fd) {
+		LOG_USI_ERR("Rx Serial port not found!!!");
+		return 0;
+	}
+#endif
+	/* Read all available bytes from tty, up to maxlen */
+	ret = read(fd, buf, maxlen);
+	return (ret > 0) ? ret : 0;
+}
+
+/*
+ * @brief	This function gets the file descriptor of the port.
+ * @param	port_type	  Port Type
+ * @param	port_number	Port Number
+ * @return  	        file descriptor, -1 if port is not open
+ *
+ */
+int32_t addUsi_GetFd(uint8_t port_type, uint8_t port_number)
+{
+#ifdef CONFIG_GLOBAL_FD_SERIAL_PORT
+	return fd_serial_port;
+#else
+	uint32_t i;
+	/* Look for File descriptor associated to serial port */
+	for (i = 0; i < num_usi_ports; i++) {
+		if ((usi_ports[i].port_type == port_type) && (usi_ports[i].port_number == port_number)) {
+			return usi_ports[i].fd;
+		}
+	}
+	return -1;
+#endif
+}
+
 /*
  * @brief	Open TTY serial.
  * @param	_sz_port	tty to connect to.
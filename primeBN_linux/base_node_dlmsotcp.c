@@ -643,6 +643,7 @@ void _dlmsotcp_cl_432_join_ind_cb(uint8_t *puc_device_id, uint8_t uc_device_id_l
   *********************************************************/
   prime_sn * p_prime_sn;
 	uint8_t uc_length;
+	uint8_t uc_autoclose = FALSE;
 	uint8_t puc_dlms_msg[512];
   /*********************************************************
   *       Code                                             *
@@ -654,23 +655,24 @@ void _dlmsotcp_cl_432_join_ind_cb(uint8_t *puc_device_id, uint8_t uc_device_id_l
 		 us_max_index_connected_node = us_dst_address + 1;
 	}
   p_prime_sn = prime_network_find_sn(&prime_network,puc_mac);
-  if (p_prime_sn){
+  if (p_prime_sn == (prime_sn *)NULL){
     // Service Node still not seen before
   }else{
     prime_network_mutex_lock();
     p_prime_sn->cl432Conn.connState = CL432_CONN_STATE_OPEN;
-    p_prime_sn->cl432Conn.connAddress = us_dst_address;
+    prime_network_set_sn_cl432_address(p_prime_sn,us_dst_address);
     memset(p_prime_sn->cl432Conn.connSerialNumber,'\0',16);
     memcpy(p_prime_sn->cl432Conn.connSerialNumber,puc_device_id,uc_device_id_len);
     p_prime_sn->cl432Conn.connLenSerial = uc_device_id_len;
     memcpy(p_prime_sn->cl432Conn.connMAC,puc_mac,6);
+    uc_autoclose = p_prime_sn->autoclose_enabled;
     prime_network_mutex_unlock();
   }
 
   uc_length = (uc_device_id_len > 16) ? 16 : uc_device_id_len;
 
 	/* Forward notification to concentrator */
-	if (p_prime_sn->autoclose_enabled == FALSE) {
+	if (uc_autoclose == FALSE) {
 		if ((g_concentrator_fd != 0) && (i_enable_notifications)) {
 			/* DLMSoTCP Version 0x0001 */
 			puc_dlms_msg[0] = 0;
@@ -728,6 +730,7 @@ void _dlmsotcp_cl_432_leave_ind_cb(uint16_t us_dst_address)
   *       Local Vars                                       *
   *********************************************************/
   prime_sn * p_prime_sn;
+  uint8_t uc_autoclose = FALSE;
   uint8_t uc_length;
 	uint8_t puc_dlms_msg[512];
 
@@ -741,13 +744,16 @@ void _dlmsotcp_cl_432_leave_ind_cb(uint16_t us_dst_address)
   if (p_prime_sn == (prime_sn *)NULL){
     // Service Node still not seen before
   }else{
-    p_prime_sn->cl432Conn.connAddress = CL_432_INVALID_ADDRESS;
+    prime_network_mutex_lock();
+    prime_network_set_sn_cl432_address(p_prime_sn,CL_432_INVALID_ADDRESS);
     p_prime_sn->autoclose_enabled = FALSE;
+    uc_autoclose = p_prime_sn->autoclose_enabled;
+    prime_network_mutex_unlock();
   }
 
 	/* fordward notification */
 	if ((g_concentrator_fd > 0) && (i_enable_notifications)) {
-		if (!p_prime_sn->autoclose_enabled) {
+		if (!uc_autoclose) {
 			/* Version 0x0001 */
 			puc_dlms_msg[0] = 0;
 			puc_dlms_msg[1] = 1;
@@ -806,6 +812,7 @@ uint8_t puc_dlms_msg[512];
       if (prime_network_sn == 0){
          PRIME_DLMSOTCP_LOG(LOG_ERR,"No PRIME SN Present\n");
       }else{
+         prime_network_read_lock();
          list_for_each_safe(entry, tmp, &prime_network) {
             p_prime_sn = list_entry(entry, prime_sn, list);
             if ((p_prime_sn->cl432Conn.connState == CL432_CONN_STATE_OPEN) && (p_prime_sn->cl432Conn.connAddress != CL_432_INVALID_ADDRESS));
@@ -855,6 +862,7 @@ uint8_t puc_dlms_msg[512];
                 PRIME_DLMSOTCP_LOG_NOSTAMP(LOG_DBG,"\r\n");
         				write(g_concentrator_fd, puc_dlms_msg, uc_length);
     			}
+         prime_network_read_unlock();
         }
     }
 }
@@ -922,22 +930,28 @@ void _dlmsotcp_close_432()
 *********************************************************/
 mchp_list *entry, *tmp;
 prime_sn * p_prime_sn;
+uint16_t pus_release[NUM_MAX_PRIME_SN];
+uint16_t us_release = 0, us_i;
 /*********************************************************
 *       Code                                             *
 *********************************************************/
     if (prime_network_sn == 0){
   	   PRIME_DLMSOTCP_LOG(LOG_ERR,"No PRIME SN Present\n");
     }else{
+       prime_network_mutex_lock();
        list_for_each_safe(entry, tmp, &prime_network) {
-          prime_network_mutex_lock();
           p_prime_sn = list_entry(entry, prime_sn, list);
           if ((p_prime_sn->cl432Conn.connState == CL432_CONN_STATE_OPEN) && (p_prime_sn->autoclose_enabled)) {
-             prime_cl_432_release_request(p_prime_sn->cl432Conn.connAddress);
+             pus_release[us_release++] = p_prime_sn->cl432Conn.connAddress;
              p_prime_sn->cl432Conn.connState = CL432_CONN_STATE_CLOSED;
-             p_prime_sn->cl432Conn.connAddress = CL_432_INVALID_ADDRESS;
+             prime_network_set_sn_cl432_address(p_prime_sn,CL_432_INVALID_ADDRESS);
              p_prime_sn->autoclose_enabled = FALSE;
           }
-          prime_network_mutex_unlock();
+       }
+       prime_network_mutex_unlock();
+       /* USI requests out of the network lock */
+       for (us_i = 0; us_i < us_release; us_i++){
+          prime_cl_432_release_request(pus_release[us_i]);
        }
     }
 }
@@ -959,13 +973,13 @@ void base_node_dlmsotcp_auto_close_session()
     if (prime_network_sn == 0){
        PRIME_DLMSOTCP_LOG(LOG_ERR,"No PRIME SN Present\n");
     }else{
+       prime_network_mutex_lock();
        list_for_each_safe(entry, tmp, &prime_network) {
-          prime_network_mutex_lock();
           p_prime_sn = list_entry(entry, prime_sn, list);
-          p_prime_sn->cl432Conn.connAddress = CL_432_INVALID_ADDRESS;
+          prime_network_set_sn_cl432_address(p_prime_sn,CL_432_INVALID_ADDRESS);
           p_prime_sn->autoclose_enabled = FALSE;
-          prime_network_mutex_unlock();
        }
+       prime_network_mutex_unlock();
     }
 }
 
@@ -1155,6 +1169,8 @@ int base_node_dlmsotcp_init()
   *********************************************************/
   mchp_list *entry, *tmp;
   prime_sn * p_prime_sn;
+  uint16_t pus_release[NUM_MAX_PRIME_SN];
+  uint16_t us_release = 0, us_i;
   /*********************************************************
   *       Code                                             *
   *********************************************************/
@@ -1163,14 +1179,18 @@ int base_node_dlmsotcp_init()
   if (prime_network_sn == 0){
 	   PRIME_DLMSOTCP_LOG(LOG_ERR,"No PRIME SN Present\n");
   }else{
+     prime_network_mutex_lock();
      list_for_each_safe(entry, tmp, &prime_network) {
-        prime_network_mutex_lock();
         p_prime_sn = list_entry(entry, prime_sn, list);
-        prime_cl_432_release_request(p_prime_sn->cl432Conn.connAddress);
+        pus_release[us_release++] = p_prime_sn->cl432Conn.connAddress;
         p_prime_sn->cl432Conn.connState = CL432_CONN_STATE_CLOSED;
-        p_prime_sn->cl432Conn.connAddress = CL_432_INVALID_ADDRESS;
+        prime_network_set_sn_cl432_address(p_prime_sn,CL_432_INVALID_ADDRESS);
         p_prime_sn->autoclose_enabled = FALSE;
-        prime_network_mutex_unlock();
+     }
+     prime_network_mutex_unlock();
+     /* USI requests out of the network lock */
+     for (us_i = 0; us_i < us_release; us_i++){
+        prime_cl_432_release_request(pus_release[us_i]);
      }
   }
 
@@ -170,15 +170,12 @@ void reset_modem(int mikroBUS)
 
 /*
  * \brief Pthread to handle usi_process
- *        usi_process needs to be called periodically to transmit/receive
- *        USI Frames to/from serial port*
+ *        USI Frames are transmitted/received to/from serial port
+ *        as soon as the port or a new message wakes up the USI loop
  */
 void * usi_process_thread(void * thread_parameters)
 {
-  while (1){
-		 addUsi_Process();
-		 usleep(1000);
-	}
+  addUsi_RunLoop();
 	pthread_exit(NULL);
 }
 
@@ -232,12 +229,23 @@ int initUSImanagement(void)
   return 0;
 }
 
+/* MLME PIBs read by prime_get_fw_information() */
+#define FW_INFO_PIBS 5
+static const uint16_t aus_fw_info_pibs[FW_INFO_PIBS] = {
+	PIB_MAC_INTERNAL_SW_VERSION,
+	PIB_432_INTERNAL_SW_VERSION,
+	PIB_MAC_APP_FW_VERSION,
+	PIB_MAC_APP_VENDOR_ID,
+	PIB_MAC_APP_PRODUCT_ID
+};
+
 /*
  * \brief Get Information related with PRIME Layers Version
  */
 void prime_get_fw_information(void)
 {
 	struct TmacGetConfirm macGetConfirm;
+	struct TmacGetConfirm ax_fw_info[FW_INFO_PIBS];
 
   /* PIB_PHY_SW_VERSION */
 	prime_cl_null_plme_get_request_sync(PIB_PHY_SW_VERSION,PRIME_SYNC_TIMEOUT_GET_REQUEST,&macGetConfirm);
@@ -255,39 +263,34 @@ void prime_get_fw_information(void)
       PRIME_LOG(LOG_INFO,"PRIME PHY HOST Version 0x%08X\r\n", g_st_info.phy_host_version);
   }
 
+  /* MAC and 4-32 versions, requested back-to-back */
+	prime_cl_null_mlme_get_request_multi(aus_fw_info_pibs,FW_INFO_PIBS,PRIME_SYNC_TIMEOUT_GET_REQUEST,ax_fw_info);
+
   /* PIB_MAC_INTERNAL_SW_VERSION */
-	prime_cl_null_mlme_get_request_sync(PIB_MAC_INTERNAL_SW_VERSION,PRIME_SYNC_TIMEOUT_GET_REQUEST,&macGetConfirm);
-	if ((macGetConfirm.m_u8Status == MLME_RESULT_DONE) && (macGetConfirm.m_u8AttributeLength == 4)){
-			memcpy(&g_st_info.mac_sw_version,macGetConfirm.m_au8AttributeValue,4);
+	if ((ax_fw_info[0].m_u8Status == MLME_RESULT_DONE) && (ax_fw_info[0].m_u8AttributeLength == 4)){
+			memcpy(&g_st_info.mac_sw_version,ax_fw_info[0].m_au8AttributeValue,4);
 			// 4 Bytes should be the result
 			PRIME_LOG(LOG_INFO,"PRIME MAC SW Version 0x%08X\r\n", g_st_info.mac_sw_version);
 	}
 	/* PIB_432_INTERNAL_SW_VERSION - 4 Bytes */
-	prime_cl_null_mlme_get_request_sync(PIB_432_INTERNAL_SW_VERSION,PRIME_SYNC_TIMEOUT_GET_REQUEST,&macGetConfirm);
-	if ((macGetConfirm.m_u8Status == MLME_RESULT_DONE) && (macGetConfirm.m_u8AttributeLength == 4)){
-			memcpy(&g_st_info.cl432_sw_version,macGetConfirm.m_au8AttributeValue,4);
+	if ((ax_fw_info[1].m_u8Status == MLME_RESULT_DONE) && (ax_fw_info[1].m_u8AttributeLength == 4)){
+			memcpy(&g_st_info.cl432_sw_version,ax_fw_info[1].m_au8AttributeValue,4);
 			// 4 Bytes should be the result
 			PRIME_LOG(LOG_INFO,"PRIME 4-32 SW Version 0x%08X\r\n",g_st_info.cl432_sw_version);
 	}
   /* PRIME_FW_VERSION - 16 Bytes */
-	prime_cl_null_mlme_get_request_sync(PIB_MAC_APP_FW_VERSION,PRIME_SYNC_TIMEOUT_GET_REQUEST,&macGetConfirm);
-	if ((macGetConfirm.m_u8Status == MLME_RESULT_DONE) && (macGetConfirm.m_u8AttributeLength == 16)){
-			memcpy(&g_st_info.app_version,macGetConfirm.m_au8AttributeValue,16);
-			// 4 Bytes should be the result
+	if ((ax_fw_info[2].m_u8Status == MLME_RESULT_DONE) && (ax_fw_info[2].m_u8AttributeLength == 16)){
+			memcpy(&g_st_info.app_version,ax_fw_info[2].m_au8AttributeValue,16);
 			PRIME_LOG(LOG_INFO,"PRIME FW Version %s\r\n",g_st_info.app_version);
 	}
 	/* PRIME_FW_VENDOR - 2 Bytes */
-	prime_cl_null_mlme_get_request_sync(PIB_MAC_APP_VENDOR_ID,PRIME_SYNC_TIMEOUT_GET_REQUEST,&macGetConfirm);
-	if ((macGetConfirm.m_u8Status == MLME_RESULT_DONE) && (macGetConfirm.m_u8AttributeLength == 2)){
-			memcpy(&g_st_info.app_vendor_id,macGetConfirm.m_au8AttributeValue,2);
-			// 4 Bytes should be the result
+	if ((ax_fw_info[3].m_u8Status == MLME_RESULT_DONE) && (ax_fw_info[3].m_u8AttributeLength == 2)){
+			memcpy(&g_st_info.app_vendor_id,ax_fw_info[3].m_au8AttributeValue,2);
 			PRIME_LOG(LOG_INFO,"PRIME FW Vendor 0x%04X\r\n", g_st_info.app_vendor_id);
 	}
 	/* PRIME_FW_MODEL - 2 Bytes */
-	prime_cl_null_mlme_get_request_sync(PIB_MAC_APP_PRODUCT_ID,PRIME_SYNC_TIMEOUT_GET_REQUEST,&macGetConfirm);
-	if ((macGetConfirm.m_u8Status == MLME_RESULT_DONE) && (macGetConfirm.m_u8AttributeLength == 2)){
-			memcpy(&g_st_info.app_product_id,macGetConfirm.m_au8AttributeValue,2);
-			// 4 Bytes should be the result
+	if ((ax_fw_info[4].m_u8Status == MLME_RESULT_DONE) && (ax_fw_info[4].m_u8AttributeLength == 2)){
+			memcpy(&g_st_info.app_product_id,ax_fw_info[4].m_au8AttributeValue,2);
 			PRIME_LOG(LOG_INFO,"PRIME Product ID 0x%04X\r\n",	g_st_info.app_product_id);
 	}
 
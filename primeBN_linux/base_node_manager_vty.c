@@ -57,6 +57,8 @@ extern "C" {
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <ctype.h>
+#include <time.h>
 #include "command.h"
 #include "vty.h"
 #include "globals.h"
@@ -66,6 +68,7 @@ extern "C" {
 #include "prime_api_defs_host.h"
 #include "ifacePrime_api.h"
 #include "UsiCfg.h"
+#include "Usi.h"
 #include "base_node_manager.h"
 #include "base_node_mng.h"
 #include "base_node_dlmsotcp.h"
@@ -272,6 +275,7 @@ DEFUN (prime_show_info_mac,
 **********************************************/
 uint8_t  mac[6];
 prime_sn * sn = NULL;
+prime_sn x_sn;
 /*********************************************
 *       Code                                 *
 **********************************************/
@@ -281,23 +285,24 @@ prime_sn * sn = NULL;
     return CMD_ERR_NOTHING_TODO;
   }
   sn = prime_network_find_sn(&prime_network,mac);
-  if (sn == NULL){
+  // Lock-free copy: not blocked by network events being processed
+  if ((sn == NULL) || prime_network_get_sn(sn, &x_sn)){
     vty_out(vty, "Service Node with EUI48 '%s' doesn't exist\r\n", argv[0]);
     return CMD_ERR_NOTHING_TODO;
   }
-  if (!sn->registered){
+  if (!x_sn.registered){
     vty_out(vty, "Service Node with EUI48 '%s' not registered\r\n", argv[0]);
     return CMD_ERR_NOTHING_TODO;
   }
   vty_out(vty,"EUI48          TCap SwCap      Vendor            Model           Version    \r\n");
   vty_out(vty,"-------------- ---- ----- ---------------  ---------------- ----------------\r\n");
   vty_out(vty,"0x%s 0x%02X 0x%02X %16s %16s %16s\r\n",    \
-                                              eui48_to_str(sn->regEntryID,NULL), \
-                                              sn->regEntryTCap,                  \
-                                              sn->regEntrySwCap,                 \
-                                              sn->fu_vendor,                     \
-                                              sn->fu_model,                      \
-                                              sn->fu_version);
+                                              eui48_to_str(x_sn.regEntryID,NULL), \
+                                              x_sn.regEntryTCap,                  \
+                                              x_sn.regEntrySwCap,                 \
+                                              x_sn.fu_vendor,                     \
+                                              x_sn.fu_model,                      \
+                                              x_sn.fu_version);
 	return CMD_SUCCESS;
 }
 
@@ -9284,7 +9289,7 @@ struct  TmacGetConfirm x_pib_confirm;
      list_for_each_safe(entry, tmp, &prime_network) {
         p_prime_sn = list_entry(entry, prime_sn, list);
         p_prime_sn->cl432Conn.connState = CL432_CONN_STATE_CLOSED;
-        p_prime_sn->cl432Conn.connAddress = CL_432_INVALID_ADDRESS;
+        prime_network_set_sn_cl432_address(p_prime_sn,CL_432_INVALID_ADDRESS);
      }
      prime_network_mutex_unlock();
 
@@ -10087,6 +10092,53 @@ DEFUN (prime_reset_mac_statistics,
   return CMD_SUCCESS;
 }
 
+/**
+* \brief Print a USI statistics line on the VTY
+*
+*/
+static void _vty_usi_stats_print(void *ctx, const char *line)
+{
+  vty_out((struct vty *)ctx, "%s\r\n", line);
+}
+
+/**
+* \brief Show USI Link Statistics
+*
+*/
+
+DEFUN (prime_show_usi_statistics,
+       prime_show_usi_statistics_cmd,
+       "show usi statistics",
+       PRIME_SHOW_STR
+       "USI serial link\n"
+       "USI Link Statistics\n")
+{
+/*********************************************
+*       Code                                 *
+**********************************************/
+  usi_DumpStats(_vty_usi_stats_print, vty);
+  return CMD_SUCCESS;
+}
+
+/**
+* \brief Reset USI Link Statistics
+*
+*/
+
+DEFUN (prime_reset_usi_statistics,
+       prime_reset_usi_statistics_cmd,
+       "usi reset statistics",
+       "USI serial link\r\n"
+       "Reset\r\n"
+       "USI Link Statistics\r\n")
+{
+/*********************************************
+*       Code                                 *
+**********************************************/
+  usi_ResetStats();
+  return CMD_SUCCESS;
+}
+
 /**
  * \brief Zero Crossing Commands
  *
@@ -10492,6 +10544,8 @@ DEFUN (prime_bmng_fw_upgrade_abort_all,
   mchp_list *entry, *tmp;
   struct TmacGetConfirm x_pib_confirm;
   struct TmacSetConfirm s_pib_confirm;
+  uint8_t (*puc_targets)[EUI48_LEN];
+  uint16_t us_targets = 0, us_i;
   /*********************************************
   *       Code                                 *
   **********************************************/
@@ -10504,20 +10558,36 @@ DEFUN (prime_bmng_fw_upgrade_abort_all,
          return CMD_ERR_NOTHING_TODO;
      }
 
-     // FW Upgrade abortion for each node
-     prime_network_mutex_lock();
+     // Targets are collected first: USI requests are not done under the network lock
+     prime_network_read_lock();
+     list_for_each_safe(entry, tmp, &prime_network) {
+        us_targets++;
+     }
+     puc_targets = malloc((us_targets + 1) * EUI48_LEN);
+     us_targets = 0;
+     if (puc_targets == NULL){
+        prime_network_read_unlock();
+        vty_out(vty,"Not enough memory\r\n");
+        return CMD_WARNING;
+     }
      list_for_each_safe(entry, tmp, &prime_network) {
         sn = list_entry(entry, prime_sn, list);
         if (sn->fwup_en){
-           bmng_fup_abort_fu_request_sync(sn->regEntryID, &s_pib_confirm);
-           if (s_pib_confirm.m_u8Status == FUP_ACK_OK){
-              vty_out(vty,"%s Firmware Upgrade aborted\r\n", eui48_to_str(sn->regEntryID,NULL));
-           }else{
-              vty_out(vty,"Error aborting %s Firmware Upgrade (0x%X)\r\n", eui48_to_str(sn->regEntryID,NULL), s_pib_confirm.m_u8Status);
-           }
+           memcpy(puc_targets[us_targets++], sn->regEntryID, EUI48_LEN);
         }
      }
-     prime_network_mutex_unlock();
+     prime_network_read_unlock();
+
+     // FW Upgrade abortion for each node
+     for (us_i = 0; us_i < us_targets; us_i++){
+        bmng_fup_abort_fu_request_sync(puc_targets[us_i], &s_pib_confirm);
+        if (s_pib_confirm.m_u8Status == FUP_ACK_OK){
+           vty_out(vty,"%s Firmware Upgrade aborted\r\n", eui48_to_str(puc_targets[us_i],NULL));
+        }else{
+           vty_out(vty,"Error aborting %s Firmware Upgrade (0x%X)\r\n", eui48_to_str(puc_targets[us_i],NULL), s_pib_confirm.m_u8Status);
+        }
+     }
+     free(puc_targets);
      return CMD_SUCCESS;
 }
 
@@ -10550,7 +10620,7 @@ mchp_list *entry, *tmp;
      // FW Upgrade Admin Status
      vty_out(vty,"EUI48               Vendor            Model           Version    \r\n");
      vty_out(vty,"-------------- ---------------- ---------------- ----------------\r\n");
-     prime_network_mutex_lock();
+     prime_network_read_lock();
      list_for_each_safe(entry, tmp, &prime_network) {
         sn = list_entry(entry, prime_sn, list);
         if (sn->fwup_en){
@@ -10560,7 +10630,7 @@ mchp_list *entry, *tmp;
                                                  sn->fu_version);
         }
      }
-     prime_network_mutex_unlock();
+     prime_network_read_unlock();
      return CMD_SUCCESS;
 }
 
@@ -10879,7 +10949,7 @@ uint16_t us_value;
       // FW Upgrade abortion for each node
       vty_out(vty,"EUI48               STATE       PAGES\r\n");
       vty_out(vty,"-------------- ---------------- -----\r\n");
-      prime_network_mutex_lock();
+      prime_network_read_lock();
       list_for_each_safe(entry, tmp, &prime_network) {
          sn = list_entry(entry, prime_sn, list);
          if (sn->fwup_en){
@@ -10890,7 +10960,7 @@ uint16_t us_value;
            }
          }
       }
-      prime_network_mutex_unlock();
+      prime_network_read_unlock();
     }else{
       vty_out(vty,"FW Upgrade Status: %s\r\n", (fw_upgrade_status() == FW_UPGRADE_IDLE) ? "Idle" : "Finished");
     }
@@ -11073,7 +11143,7 @@ int level;
   }else{
      vty_out(vty,"EUI48           LNID    State   LSID  SID Level TCap SwCap\n");
      vty_out(vty,"-------------- ------- -------  ----  --- ----- ---- -----\n");
-     prime_network_mutex_lock();
+     prime_network_read_lock();
      for (level=0; level<=prime_network_get_max_level();level++){
        list_for_each_safe(entry, tmp, &prime_network) {
           p_prime_sn = list_entry(entry, prime_sn, list);
@@ -11090,7 +11160,7 @@ int level;
           }
        }
      }
-     prime_network_mutex_unlock();
+     prime_network_read_unlock();
   }
   return CMD_SUCCESS;
 }
@@ -11134,7 +11204,7 @@ char sn_mac[18], sw_mac[18];
         fprintf(fp_graphviz,"digraph Topology {\r\nranksep=3;\r\nratio=auto;\r\n");
         fprintf(fp_graphviz,"%s [shape=diamond]\r\n",eui48_to_str((const unsigned char *)&g_st_config.eui48,NULL));
      }
-     prime_network_mutex_lock();
+     prime_network_read_lock();
      for (level=0; level<=prime_network_get_max_level();level++){
        /* First - Detect the switch nodes */
        list_for_each_safe(entry, tmp, &prime_network) {
@@ -11194,7 +11264,7 @@ char sn_mac[18], sw_mac[18];
           }
        }
      }
-     prime_network_mutex_unlock();
+     prime_network_read_unlock();
      if (en_graphviz){
         fprintf(fp_graphviz,"}\r\n");
         fclose(fp_graphviz);
@@ -11229,7 +11299,7 @@ prime_sn * p_prime_sn;
   }else{
      vty_out(vty,"EUI48          Level  LSID  RxLvl RxSNR\n");
      vty_out(vty,"-------------- ----- ------ ----- -----\n");
-     prime_network_mutex_lock();
+     prime_network_read_lock();
      list_for_each_safe(entry, tmp, &prime_network) {
         p_prime_sn = list_entry(entry, prime_sn, list);
         if (p_prime_sn->regEntryState == REGISTER_STATE_SWITCH){
@@ -11240,7 +11310,7 @@ prime_sn * p_prime_sn;
                                                             p_prime_sn->regEntryRxSNR);
         }
      }
-     prime_network_mutex_unlock();
+     prime_network_read_unlock();
   }
   return CMD_SUCCESS;
 }
@@ -11275,7 +11345,7 @@ uint8_t level;
   }else{
      vty_out(vty,"EUI48           LNID    State   LSID  SID Level TCap SwCap\n");
      vty_out(vty,"-------------- ------- -------  ----  --- ----- ---- -----\n");
-     prime_network_mutex_lock();
+     prime_network_read_lock();
      list_for_each_safe(entry, tmp, &prime_network) {
         p_prime_sn = list_entry(entry, prime_sn, list);
         if ((p_prime_sn->registered) && (p_prime_sn->regEntryLevel == level)){
@@ -11290,11 +11360,219 @@ uint8_t level;
                                                                                 p_prime_sn->regEntrySwCap);
         }
      }
-     prime_network_mutex_unlock();
+     prime_network_read_unlock();
   }
   return CMD_SUCCESS;
 }
 
+/* Maximum events listed by "show network events" */
+#define PRIME_VTY_NETWORK_EVENTS_MAX_ROWS  1000
+
+/*
+ * \brief  Print one stored Network Event
+ */
+static void _prime_vty_network_event_row(void *ctx, uint64_t ull_ts, const char *sz_event, const char *sz_eui48,
+                                         uint16_t us_lnid, uint8_t uc_lsid, uint8_t uc_sid)
+{
+  struct vty *vty = (struct vty *)ctx;
+  time_t x_time = (time_t)(ull_ts / 1000);
+  struct tm x_tm;
+  char sz_time[32];
+
+  localtime_r(&x_time, &x_tm);
+  strftime(sz_time, sizeof(sz_time), "%Y-%m-%d %H:%M:%S", &x_tm);
+  vty_out(vty,"%s.%03u  0x%s  %-10s  %05d  %03d  %03d\r\n", sz_time, (unsigned)(ull_ts % 1000),
+                                                            sz_eui48, sz_event, us_lnid, uc_lsid, uc_sid);
+}
+
+/*
+ * \brief  Parse the optional EUI48 and event filters of the network events commands
+ * \return 0 if success, -1 if the EUI48 is wrong
+ */
+static int _prime_vty_network_events_filter(char *sz_mac, const char *sz_event_arg,
+                                            char *sz_eui48, char *sz_event)
+{
+  uint8_t mac[EUI48_LEN];
+  int i;
+
+  if (sz_mac != NULL){
+     if (str_to_eui48(sz_mac,mac))
+        return -1;
+     /* Stored as eui48_to_str() writes it */
+     eui48_to_str(mac,sz_eui48);
+  }
+  if (sz_event_arg != NULL){
+     /* Stored as network_event_to_str() writes it */
+     for (i = 0; (sz_event_arg[i] != '\0') && (i < 15); i++){
+        sz_event[i] = toupper((unsigned char)sz_event_arg[i]);
+     }
+     sz_event[i] = '\0';
+  }
+  return 0;
+}
+
+/**
+* \brief Show PRIME Network Events stored on the Database
+*
+*/
+DEFUN (prime_network_show_events,
+       prime_network_show_events_cmd,
+       "show network events (all|register|unregister|promote|demote|alive|reboot|no_duk|unknown|error) <1-8760>",
+       PRIME_SHOW_STR
+       "PRIME Network\n"
+       "PRIME Network Events\n"
+       "All Events\n"
+       "Register Events\n"
+       "Unregister Events\n"
+       "Promote Events\n"
+       "Demote Events\n"
+       "Alive Events\n"
+       "Reboot Events\n"
+       "No DUK Events\n"
+       "Unknown Node Events\n"
+       "Error Events\n"
+       "Last hours\n")
+{
+/*********************************************************
+*       Local Vars                                       *
+*********************************************************/
+char sz_eui48[(EUI48_LEN << 1) + 1];
+char sz_event[16];
+uint32_t ul_hours;
+int res;
+/*********************************************************
+*       Code                                             *
+*********************************************************/
+  VTY_CHECK_PRIME_MODE(PRIME_MODE_BASE);
+  ul_hours = (uint32_t)atoi(argv[1]);
+  if (_prime_vty_network_events_filter((argc > 2) ? argv[2] : NULL, argv[0], sz_eui48, sz_event)){
+     vty_out(vty,"Service Node EUI48 length is wrong\r\n");
+     return CMD_ERR_NOTHING_TODO;
+  }
+  vty_out(vty,"Time                     EUI48           Event       LNID   LSID SID\n");
+  vty_out(vty,"----------------------- --------------  ----------  -----  ---- ---\n");
+  res = prime_network_events_db_query((argc > 2) ? sz_eui48 : NULL,
+                                      (strcmp(argv[0],"all") == 0) ? NULL : sz_event,
+                                      ul_hours, PRIME_VTY_NETWORK_EVENTS_MAX_ROWS,
+                                      _prime_vty_network_event_row, vty);
+  if (res < 0){
+     vty_out(vty,"Network Events Database not available\r\n");
+     return CMD_WARNING;
+  }
+  vty_out(vty,"%d events%s\r\n", res, (res == PRIME_VTY_NETWORK_EVENTS_MAX_ROWS) ? " (truncated)" : "");
+  return CMD_SUCCESS;
+}
+
+ALIAS (prime_network_show_events,
+       prime_network_show_events_mac_cmd,
+       "show network events (all|register|unregister|promote|demote|alive|reboot|no_duk|unknown|error) <1-8760> MAC",
+       PRIME_SHOW_STR
+       "PRIME Network\n"
+       "PRIME Network Events\n"
+       "All Events\n"
+       "Register Events\n"
+       "Unregister Events\n"
+       "Promote Events\n"
+       "Demote Events\n"
+       "Alive Events\n"
+       "Reboot Events\n"
+       "No DUK Events\n"
+       "Unknown Node Events\n"
+       "Error Events\n"
+       "Last hours\n"
+       "Service Node EUI48\n")
+
+/*
+ * \brief  Print one (node, event) count
+ */
+static void _prime_vty_network_event_rate(void *ctx, const char *sz_eui48, const char *sz_event, uint32_t ul_count)
+{
+  struct vty *vty = ((void **)ctx)[0];
+  uint32_t ul_hours = *(uint32_t *)((void **)ctx)[1];
+
+  vty_out(vty,"0x%s  %-10s  %8u  %10.2f\r\n", sz_eui48, sz_event, ul_count, (double)ul_count / ul_hours);
+}
+
+/**
+* \brief Show PRIME Network Events rate per Service Node
+*
+*/
+DEFUN (prime_network_show_events_rate,
+       prime_network_show_events_rate_cmd,
+       "show network events rate <1-8760>",
+       PRIME_SHOW_STR
+       "PRIME Network\n"
+       "PRIME Network Events\n"
+       "Events per Service Node and hour\n"
+       "Last hours\n")
+{
+/*********************************************************
+*       Local Vars                                       *
+*********************************************************/
+char sz_eui48[(EUI48_LEN << 1) + 1];
+uint32_t ul_hours;
+void *ctx[2];
+int res;
+/*********************************************************
+*       Code                                             *
+*********************************************************/
+  VTY_CHECK_PRIME_MODE(PRIME_MODE_BASE);
+  ul_hours = (uint32_t)atoi(argv[0]);
+  if (_prime_vty_network_events_filter((argc > 1) ? argv[1] : NULL, NULL, sz_eui48, NULL)){
+     vty_out(vty,"Service Node EUI48 length is wrong\r\n");
+     return CMD_ERR_NOTHING_TODO;
+  }
+  ctx[0] = vty;
+  ctx[1] = &ul_hours;
+  vty_out(vty,"EUI48           Event          Count      Per hour\n");
+  vty_out(vty,"--------------  ----------  --------  ----------\n");
+  res = prime_network_events_db_rate((argc > 1) ? sz_eui48 : NULL, ul_hours, _prime_vty_network_event_rate, ctx);
+  if (res < 0){
+     vty_out(vty,"Network Events Database not available\r\n");
+     return CMD_WARNING;
+  }
+  return CMD_SUCCESS;
+}
+
+ALIAS (prime_network_show_events_rate,
+       prime_network_show_events_rate_mac_cmd,
+       "show network events rate <1-8760> MAC",
+       PRIME_SHOW_STR
+       "PRIME Network\n"
+       "PRIME Network Events\n"
+       "Events per Service Node and hour\n"
+       "Last hours\n"
+       "Service Node EUI48\n")
+
+/**
+* \brief Configure days of PRIME Network Events kept on the Database
+*
+*/
+DEFUN (prime_config_network_events_retention,
+       prime_config_network_events_retention_cmd,
+       "config network_events retention <1-365>",
+       PRIME_CONFIG_STR
+       "PRIME Network Events Database\n"
+       "Days of events kept\n"
+       "Days\n")
+{
+    char info[256];
+    uint16_t us_days;
+
+    us_days = (uint16_t)atoi(argv[0]);
+    prime_network_events_db_set_retention(us_days);
+
+    // Write File Config
+    sprintf(info, "config network_events retention");
+    config_del_line_byleft(prime_config, info);
+    sprintf(info, "config network_events retention %d", us_days);
+    config_add_line(prime_config, info);
+    ENSURE_CONFIG(vty);
+
+    vty_out(vty,"PRIME Network Events retention set to %d days\r\n",us_days);
+    return CMD_SUCCESS;
+}
+
 DEFUN (prime_network_show_cl432_connections,
        prime_network_show_cl432_connections_cmd,
       "show network cl432_connections",
@@ -11319,7 +11597,7 @@ prime_sn * p_prime_sn;
      vty_out(vty,"--------------------------------------\r\n");
      vty_out(vty,"EUI48           ADDRESS  SERIAL/NUMBER\n");
      vty_out(vty,"-------------- --------- -------------\n");
-     prime_network_mutex_lock();
+     prime_network_read_lock();
      list_for_each_safe(entry, tmp, &prime_network) {
         p_prime_sn = list_entry(entry, prime_sn, list);
         if (p_prime_sn->cl432Conn.connState == CL432_CONN_STATE_OPEN){
@@ -11329,7 +11607,7 @@ prime_sn * p_prime_sn;
                                 p_prime_sn->cl432Conn.connSerialNumber);
         }
      }
-     prime_network_mutex_unlock();
+     prime_network_read_unlock();
   }
   return CMD_SUCCESS;
 }
@@ -11369,12 +11647,12 @@ mac_conn * conn = NULL;
       }else{
          vty_out(vty,"LCID ConnType\n");
          vty_out(vty,"---- --------\n");
-         prime_network_mutex_lock();
+         prime_network_read_lock();
          list_for_each_safe(entry, tmp, &sn->macConnList) {
             conn = list_entry(entry, mac_conn, list);
             vty_out(vty,"%04d  %d(%s)\r\n", conn->connEntryLCID, conn->connType,mac_connection_type_str[conn->connType]);
          }
-         prime_network_mutex_unlock();
+         prime_network_read_unlock();
       }
    }
    return CMD_SUCCESS;
@@ -11439,6 +11717,7 @@ int prime_vty_init(void)
   cmd_install_element (PRIME_NODE, &config_prime_end_cmd);
   // Specific Commands
   cmd_install_element (PRIME_NODE, &prime_config_loglevel_cmd);
+  cmd_install_element (PRIME_NODE, &prime_config_network_events_retention_cmd);
   cmd_install_element (PRIME_NODE, &prime_config_log_enable_cmd);
   cmd_install_element (PRIME_NODE, &prime_show_info_cmd);
   cmd_install_element (PRIME_NODE, &prime_show_info_mac_cmd);
@@ -11707,6 +11986,8 @@ int prime_vty_init(void)
   cmd_install_element (PRIME_NODE, &prime_reset_all_statistics_cmd);
   cmd_install_element (PRIME_NODE, &prime_reset_phy_statistics_cmd);
   cmd_install_element (PRIME_NODE, &prime_reset_mac_statistics_cmd);
+  cmd_install_element (PRIME_NODE, &prime_show_usi_statistics_cmd);
+  cmd_install_element (PRIME_NODE, &prime_reset_usi_statistics_cmd);
 
   cmd_install_element (PRIME_NODE, &prime_modem_reboot_request_cmd);
   cmd_install_element (PRIME_NODE, &prime_modem_bmng_reboot_request_cmd);
@@ -11742,6 +12023,10 @@ int prime_vty_init(void)
   cmd_install_element (PRIME_NODE, &prime_network_show_available_switches_cmd);
   cmd_install_element (PRIME_NODE, &prime_network_show_topology_cmd);
   cmd_install_element (PRIME_NODE, &prime_network_show_level_registered_devices_cmd);
+  cmd_install_element (PRIME_NODE, &prime_network_show_events_cmd);
+  cmd_install_element (PRIME_NODE, &prime_network_show_events_mac_cmd);
+  cmd_install_element (PRIME_NODE, &prime_network_show_events_rate_cmd);
+  cmd_install_element (PRIME_NODE, &prime_network_show_events_rate_mac_cmd);
 
   // PRIME Zero Crossing Commands
   cmd_install_element (PRIME_NODE, &prime_modem_bmng_zc_request_cmd);
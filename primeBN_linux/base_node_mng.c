@@ -82,7 +82,22 @@ extern "C" {
 #define MNG_PLANE_LOCAL 0
 #define MNG_PLANE_BASE 1
 
+/* Maximum number of MLME get requests waiting for their confirm at the same time */
+#define PRIME_SYNC_MAX_GET_REQUESTS 8
+
 T_prime_sync_mgmt g_prime_sync_mgmt;
+
+/* Outstanding MLME get requests of prime_cl_null_mlme_get_request_multi() */
+struct TprimeSyncGetReq{
+    bool f_sync_res;                          // Flag to indicate syncronous response
+    bool f_sync_req;                          // Flag to indicate syncronous request (entry in use)
+    uint16_t m_u16AttributeId;                // PIB attribute requested
+    struct TmacGetConfirm *pmacGetConfirm;    // Get Confirm struct of the requester
+};
+static struct TprimeSyncGetReq sx_prime_sync_get[PRIME_SYNC_MAX_GET_REQUESTS];
+static uint8_t suc_prime_sync_get_pending = 0;
+/* Mutex for the outstanding MLME get requests */
+static pthread_mutex_t prime_sync_get_mutex = PTHREAD_MUTEX_INITIALIZER;
 uint8_t flag_GetListConfirm = false;          // Global Flag to Detect End of GetListRequest answer from Base Node Modem
 
 /*
@@ -576,7 +591,7 @@ void _prime_cl_null_plme_reset_cfm_cb(plme_result_t x_result)
   memset(&g_prime_sync_mgmt.s_macGetConfirm,0,sizeof(struct TmacGetConfirm));
   if (g_prime_sync_mgmt.f_sync_req){
       g_prime_sync_mgmt.s_macGetConfirm.m_u8Status = x_result;
-		  g_prime_sync_mgmt.f_sync_res = true;
+		  addUsi_SignalProcessing((Bool *)&g_prime_sync_mgmt.f_sync_res);
   }
   return ;
 }
@@ -633,7 +648,7 @@ void _prime_cl_null_plme_sleep_cfm_cb(plme_result_t x_result)
   memset(&g_prime_sync_mgmt.s_macGetConfirm,0,sizeof(struct TmacGetConfirm));
   if (g_prime_sync_mgmt.f_sync_req){
       g_prime_sync_mgmt.s_macGetConfirm.m_u8Status = x_result;
-		  g_prime_sync_mgmt.f_sync_res = true;
+		  addUsi_SignalProcessing((Bool *)&g_prime_sync_mgmt.f_sync_res);
   }
   return ;
 }
@@ -688,7 +703,7 @@ void _prime_cl_null_plme_resume_cfm_cb(plme_result_t x_result)
   memset(&g_prime_sync_mgmt.s_macGetConfirm,0,sizeof(struct TmacGetConfirm));
   if (g_prime_sync_mgmt.f_sync_req){
       g_prime_sync_mgmt.s_macGetConfirm.m_u8Status = x_result;
-		  g_prime_sync_mgmt.f_sync_res = true;
+		  addUsi_SignalProcessing((Bool *)&g_prime_sync_mgmt.f_sync_res);
   }
   return ;
 }
@@ -720,7 +735,7 @@ void _prime_cl_null_plme_get_cfm_cb(plme_result_t x_status, uint16_t us_pib_attr
       g_prime_sync_mgmt.s_macGetConfirm.m_u16AttributeId = us_pib_attrib;
       g_prime_sync_mgmt.s_macGetConfirm.m_u8AttributeLength = uc_pib_size;
       memcpy(&g_prime_sync_mgmt.s_macGetConfirm.m_au8AttributeValue,pv_pib_value,uc_pib_size);
-		  g_prime_sync_mgmt.f_sync_res = true;
+		  addUsi_SignalProcessing((Bool *)&g_prime_sync_mgmt.f_sync_res);
   }
   return ;
 }
@@ -835,7 +850,7 @@ void _prime_cl_null_plme_set_cfm_cb(plme_result_t x_result)
 //  if (g_prime_sync_mgmt.f_sync_req && (g_prime_sync_mgmt.m_u16AttributeId == us_pib_attrib)){
       g_prime_sync_mgmt.s_macSetConfirm.m_u8Status = x_result;
 //      g_prime_sync_mgmt.s_macSetConfirm.m_u16AttributeId = us_pib_attrib;
-		  g_prime_sync_mgmt.f_sync_res = true;
+		  addUsi_SignalProcessing((Bool *)&g_prime_sync_mgmt.f_sync_res);
 //  }
   return ;
 }
@@ -891,7 +906,7 @@ void _prime_cl_null_mlme_promote_cfm_cb(mlme_result_t x_result)
   memset(&g_prime_sync_mgmt.s_macGetConfirm,0,sizeof(struct TmacGetConfirm));
   if (g_prime_sync_mgmt.f_sync_req){
       g_prime_sync_mgmt.s_macGetConfirm.m_u8Status = x_result;
-      g_prime_sync_mgmt.f_sync_res = true;
+      addUsi_SignalProcessing((Bool *)&g_prime_sync_mgmt.f_sync_res);
   }
   return ;
 }
@@ -945,7 +960,7 @@ void _prime_cl_null_mlme_demote_cfm_cb(mlme_result_t x_result)
   memset(&g_prime_sync_mgmt.s_macGetConfirm,0,sizeof(struct TmacGetConfirm));
   if (g_prime_sync_mgmt.f_sync_req){
       g_prime_sync_mgmt.s_macGetConfirm.m_u8Status = x_result;
-      g_prime_sync_mgmt.f_sync_res = true;
+      addUsi_SignalProcessing((Bool *)&g_prime_sync_mgmt.f_sync_res);
   }
   return ;
 }
@@ -999,7 +1014,7 @@ void _prime_cl_null_mlme_unregister_cfm_cb(mlme_result_t x_result)
   memset(&g_prime_sync_mgmt.s_macGetConfirm,0,sizeof(struct TmacGetConfirm));
   if (g_prime_sync_mgmt.f_sync_req){
       g_prime_sync_mgmt.s_macGetConfirm.m_u8Status = x_result;
-      g_prime_sync_mgmt.f_sync_res = true;
+      addUsi_SignalProcessing((Bool *)&g_prime_sync_mgmt.f_sync_res);
   }
   return ;
 }
@@ -1052,7 +1067,7 @@ void _prime_cl_null_mlme_reset_cfm_cb(mlme_result_t x_result)
   memset(&g_prime_sync_mgmt.s_macGetConfirm,0,sizeof(struct TmacGetConfirm));
   if (g_prime_sync_mgmt.f_sync_req){
       g_prime_sync_mgmt.s_macGetConfirm.m_u8Status = x_result;
-		  g_prime_sync_mgmt.f_sync_res = true;
+		  addUsi_SignalProcessing((Bool *)&g_prime_sync_mgmt.f_sync_res);
   }
   return ;
 }
@@ -1067,14 +1082,38 @@ void _prime_cl_null_mlme_reset_cfm_cb(mlme_result_t x_result)
  */
 void _prime_cl_null_mlme_get_cfm_cb(mlme_result_t x_status, uint16_t us_pib_attrib, void *pv_pib_value, uint8_t uc_pib_size)
 {
+  struct TprimeSyncGetReq *px_req;
+  uint8_t uc_i;
+
   //PRIME_LOG(LOG_DEBUG,"_prime_cl_null_mlme_get_cfm_cb status = 0x%02X attr = 0x%04X\r\n", x_status, us_pib_attrib);
+  if (suc_prime_sync_get_pending){
+    /* Pipelined requests: confirm to the oldest request of the attribute */
+    pthread_mutex_lock(&prime_sync_get_mutex);
+    for (uc_i = 0; uc_i < PRIME_SYNC_MAX_GET_REQUESTS; uc_i++){
+      px_req = &sx_prime_sync_get[uc_i];
+      if (px_req->f_sync_req && !px_req->f_sync_res && (px_req->m_u16AttributeId == us_pib_attrib)){
+        if (uc_pib_size > sizeof(px_req->pmacGetConfirm->m_au8AttributeValue)){
+          uc_pib_size = sizeof(px_req->pmacGetConfirm->m_au8AttributeValue);
+        }
+        px_req->pmacGetConfirm->m_u8Status = x_status;
+        px_req->pmacGetConfirm->m_u16AttributeId = us_pib_attrib;
+        px_req->pmacGetConfirm->m_u8AttributeLength = uc_pib_size;
+        memcpy(&px_req->pmacGetConfirm->m_au8AttributeValue,pv_pib_value,uc_pib_size);
+        addUsi_SignalProcessing((Bool *)&px_req->f_sync_res);
+        pthread_mutex_unlock(&prime_sync_get_mutex);
+        return ;
+      }
+    }
+    pthread_mutex_unlock(&prime_sync_get_mutex);
+  }
+
   memset(&g_prime_sync_mgmt.s_macGetConfirm,0,sizeof(struct TmacGetConfirm));
   if (g_prime_sync_mgmt.f_sync_req && (g_prime_sync_mgmt.m_u16AttributeId == us_pib_attrib)){
       g_prime_sync_mgmt.s_macGetConfirm.m_u8Status = x_status;
       g_prime_sync_mgmt.s_macGetConfirm.m_u16AttributeId = us_pib_attrib;
       g_prime_sync_mgmt.s_macGetConfirm.m_u8AttributeLength = uc_pib_size;
       memcpy(&g_prime_sync_mgmt.s_macGetConfirm.m_au8AttributeValue,pv_pib_value,uc_pib_size);
-		  g_prime_sync_mgmt.f_sync_res = true;
+		  addUsi_SignalProcessing((Bool *)&g_prime_sync_mgmt.f_sync_res);
   }
   return ;
 }
@@ -1135,6 +1174,89 @@ void prime_cl_null_mlme_get_request_sync(uint16_t us_pib_attrib, uint8_t uc_time
 	//PRIME_LOG(LOG_DEBUG,"prime_cl_null_mlme_get_request_sync result = %d\r\n",result);
 }
 
+/**
+ * \brief MLME get request of several attributes. Requests are sent back-to-back,
+ *        keeping up to PRIME_SYNC_MAX_GET_REQUESTS waiting for their confirm.
+ * \param pus_pib_attribs   PIB attributes
+ * \param uc_count          Number of PIB attributes
+ * \param uc_timeout        Timeout for each request
+ * \param pmacGetConfirms   array of TmacGetConfirm structures, one per attribute
+ */
+void prime_cl_null_mlme_get_request_multi(const uint16_t *pus_pib_attribs, uint8_t uc_count, uint8_t uc_timeout, struct TmacGetConfirm *pmacGetConfirms)
+{
+  struct TprimeSyncGetReq *apx_req[PRIME_SYNC_MAX_GET_REQUESTS];
+  struct TprimeSyncGetReq *px_req;
+  struct TmacGetConfirm *px_confirm;
+  uint8_t uc_sent = 0;
+  uint8_t uc_done = 0;
+  uint8_t uc_i;
+  uint16_t us_value;
+  uint32_t ui_value;
+
+  while (uc_done < uc_count){
+    // Fill the window of outstanding requests
+    while ((uc_sent < uc_count) && ((uc_sent - uc_done) < PRIME_SYNC_MAX_GET_REQUESTS)){
+      px_req = NULL;
+      pthread_mutex_lock(&prime_sync_get_mutex);
+      for (uc_i = 0; uc_i < PRIME_SYNC_MAX_GET_REQUESTS; uc_i++){
+        if (!sx_prime_sync_get[uc_i].f_sync_req){
+          px_req = &sx_prime_sync_get[uc_i];
+          px_req->f_sync_req = true;
+          px_req->f_sync_res = false;
+          px_req->m_u16AttributeId = pus_pib_attribs[uc_sent];
+          px_req->pmacGetConfirm = &pmacGetConfirms[uc_sent];
+          suc_prime_sync_get_pending++;
+          break;
+        }
+      }
+      pthread_mutex_unlock(&prime_sync_get_mutex);
+      if (px_req == NULL){
+        break;
+      }
+      apx_req[uc_sent % PRIME_SYNC_MAX_GET_REQUESTS] = px_req;
+      // Send the asynchronous call
+      prime_cl_null_mlme_get_request(pus_pib_attribs[uc_sent]);
+      uc_sent++;
+    }
+
+    px_confirm = &pmacGetConfirms[uc_done];
+    if (uc_sent == uc_done){
+      // No room for the request
+      px_confirm->m_u8Status = -1;
+      PRIME_LOG(LOG_ERR,"ERROR: No room for request 0x%04X\r\n",pus_pib_attribs[uc_done]);
+      uc_sent++;
+      uc_done++;
+      continue;
+    }
+
+    // Confirms arrive in order: wait processing for the oldest request, or timeout
+    px_req = apx_req[uc_done % PRIME_SYNC_MAX_GET_REQUESTS];
+    addUsi_WaitProcessing(uc_timeout, (Bool *)&px_req->f_sync_res);
+
+    pthread_mutex_lock(&prime_sync_get_mutex);
+    if (!px_req->f_sync_res){
+      // Confirm not received
+      px_confirm->m_u8Status = -1;
+      PRIME_LOG(LOG_ERR,"ERROR: Confirm for 0x%04X not received\r\n",pus_pib_attribs[uc_done]);
+    }else if (px_confirm->m_u8AttributeLength == 4){
+      // Take care with endianess - USI_HOST transfers on Big Endian
+      memcpy(&ui_value,&px_confirm->m_au8AttributeValue,4);
+      ui_value = ntohl(ui_value);
+      memcpy(&px_confirm->m_au8AttributeValue,&ui_value,4);
+    }else if (px_confirm->m_u8AttributeLength == 2){
+      memcpy(&us_value,&px_confirm->m_au8AttributeValue,2);
+      us_value = ntohs(us_value);
+      memcpy(&px_confirm->m_au8AttributeValue,&us_value,2);
+    }
+    px_req->f_sync_req = false;
+    px_req->f_sync_res = false;
+    suc_prime_sync_get_pending--;
+    pthread_mutex_unlock(&prime_sync_get_mutex);
+
+    uc_done++;
+  }
+}
+
 /**
  * \brief MLME get list request syncronous
  * \param us_pib_attrib        PIB attribute
@@ -1413,19 +1535,20 @@ void print_cl432ListNode(cl432ListNode * entry)
   prime_sn *sn;
 
   PRIME_LOG(LOG_DEBUG,"_prime_cl_null_mlme_list_get_cfm_cb result = %d\r\n",x_status);
+  if ((x_status == MLME_RESULT_DONE) && (!flag_GetListConfirm) && (us_pib_len == 0)){
+     // Received Last Message after a mlme_list_get_request
+     // Must be set before waking up the synchronous request
+     PRIME_LOG(LOG_DEBUG,"_prime_cl_null_mlme_list_get_cfm_cb last message received\r\n");
+     flag_GetListConfirm = true;
+  }
   if (g_prime_sync_mgmt.f_sync_req && (g_prime_sync_mgmt.m_u16AttributeId == us_pib_attrib)){
       g_prime_sync_mgmt.s_macGetConfirm.m_u8Status = x_status;
       //g_prime_sync_mgmt.s_macGetConfirm.m_u16AttributeId = us_pib_attrib;
       //g_prime_sync_mgmt.s_macGetConfirm.m_u8AttributeLength = uc_pib_size;
       //memcpy(&g_prime_sync_mgmt.s_macGetConfirm.m_au8AttributeValue,pv_pib_value,uc_pib_size);
-      g_prime_sync_mgmt.f_sync_res = true;
+      addUsi_SignalProcessing((Bool *)&g_prime_sync_mgmt.f_sync_res);
   }
   if (x_status == MLME_RESULT_DONE){
-    if ((!flag_GetListConfirm) && (us_pib_len == 0)){
-       // Received Last Message after a mlme_list_get_request
-       PRIME_LOG(LOG_DEBUG,"_prime_cl_null_mlme_list_get_cfm_cb last message received\r\n");
-       flag_GetListConfirm = true;
-    }
     switch (us_pib_attrib)
     {
       case PIB_MAC_LIST_REGISTER_DEVICES:
@@ -1455,9 +1578,9 @@ void print_cl432ListNode(cl432ListNode * entry)
               }
            }
            prime_network_mutex_lock();
-           sn->regEntryLNID = reg_device_entry.regEntryLNID;
+           prime_network_set_sn_lnid(sn,reg_device_entry.regEntryLNID);
            sn->regEntryState = reg_device_entry.regEntryState;
-           sn->regEntryLSID = reg_device_entry.regEntryLSID;
+           prime_network_set_sn_lsid(sn,reg_device_entry.regEntryLSID);
            sn->regEntrySID = reg_device_entry.regEntrySID;
            sn->regEntryLevel = reg_device_entry.regEntryLevel;
            sn->regEntryTCap = reg_device_entry.regEntryTCap;
@@ -1495,7 +1618,7 @@ void print_cl432ListNode(cl432ListNode * entry)
              }
           }
           prime_network_mutex_lock();
-          sn->regEntryLNID = active_conn_entry.connEntryLNID;
+          prime_network_set_sn_lnid(sn,active_conn_entry.connEntryLNID);
           sn->regEntrySID = active_conn_entry.connEntrySID;
           prime_network_mutex_unlock();
           active_conn_entry_tmp = prime_sn_find_mac_connection(sn, active_conn_entry.connEntryLCID);
@@ -1536,7 +1659,7 @@ void print_cl432ListNode(cl432ListNode * entry)
              }
           }
           prime_network_mutex_lock();
-          sn->regEntryLNID = active_conn_entry.connEntryLNID;
+          prime_network_set_sn_lnid(sn,active_conn_entry.connEntryLNID);
           sn->regEntrySID = active_conn_entry.connEntrySID;
           prime_network_mutex_unlock();
           active_conn_entry_tmp = prime_sn_find_mac_connection(sn, active_conn_entry.connEntryLCID);
@@ -1649,7 +1772,7 @@ void print_cl432ListNode(cl432ListNode * entry)
              PRIME_LOG(LOG_ERR,"Available Switch not found before\r\n");
              break;
           }
-          sn->regEntryLSID    = available_switches_entry.slistEntryLSID;
+          prime_network_set_sn_lsid(sn,available_switches_entry.slistEntryLSID);
           sn->regEntryLevel = available_switches_entry.slistEntryLevel;
           sn->regEntryRxLvl = available_switches_entry.slistEntryRxLvl;
           sn->regEntryRxSNR = available_switches_entry.slistEntryRxSNR;
@@ -1699,7 +1822,7 @@ void print_cl432ListNode(cl432ListNode * entry)
           if (sn != (prime_sn *) NULL){
              prime_network_mutex_lock();
              sn->cl432Conn.connState = CL432_CONN_STATE_OPEN;
-             sn->cl432Conn.connAddress = cl432_node_entry.cl432address;
+             prime_network_set_sn_cl432_address(sn,cl432_node_entry.cl432address);
              memcpy(sn->cl432Conn.connSerialNumber,cl432_node_entry.cl432serial,16);
              sn->cl432Conn.connLenSerial = cl432_node_entry.cl432serial_len;
              memcpy(sn->cl432Conn.connMAC, cl432_node_entry.cl432mac, 6);
@@ -1766,7 +1889,7 @@ void _prime_cl_null_mlme_set_cfm_cb(mlme_result_t x_result)
 //  if (g_prime_sync_mgmt.f_sync_req && (g_prime_sync_mgmt.m_u16AttributeId == us_pib_attrib)){
       g_prime_sync_mgmt.s_macSetConfirm.m_u8Status = x_result;
 //      g_prime_sync_mgmt.s_macSetConfirm.m_u16AttributeId = us_pib_attrib;
-		  g_prime_sync_mgmt.f_sync_res = true;
+		  addUsi_SignalProcessing((Bool *)&g_prime_sync_mgmt.f_sync_res);
 //  }
   return ;
 }
@@ -2054,7 +2177,7 @@ void prime_common_mng_rsp_cb(uint8_t mng_plane, uint8_t *eui48, uint8_t* ptrMsg,
             }else{
                memcpy(&g_prime_sync_mgmt.s_macGetConfirm.m_au8AttributeValue[0],ptr,us_pib_size);
             }
-            g_prime_sync_mgmt.f_sync_res = true;
+            addUsi_SignalProcessing((Bool *)&g_prime_sync_mgmt.f_sync_res);
         }
     } else {
         /* Enhanced response for a PIB */
@@ -2103,9 +2226,9 @@ void prime_common_mng_rsp_cb(uint8_t mng_plane, uint8_t *eui48, uint8_t* ptrMsg,
                  }
               }
               prime_network_mutex_lock();
-              sn->regEntryLNID  = reg_device_entry.regEntryLNID;
+              prime_network_set_sn_lnid(sn,reg_device_entry.regEntryLNID);
               sn->regEntryState = reg_device_entry.regEntryState;
-              sn->regEntryLSID  = reg_device_entry.regEntryLSID;
+              prime_network_set_sn_lsid(sn,reg_device_entry.regEntryLSID);
               sn->regEntrySID   = reg_device_entry.regEntrySID;
               sn->regEntryLevel = reg_device_entry.regEntryLevel;
               sn->regEntryTCap  = reg_device_entry.regEntryTCap;
@@ -2132,7 +2255,7 @@ void prime_common_mng_rsp_cb(uint8_t mng_plane, uint8_t *eui48, uint8_t* ptrMsg,
                  }
               }
               prime_network_mutex_lock();
-              sn->regEntryLNID = active_conn_entry.connEntryLNID;
+              prime_network_set_sn_lnid(sn,active_conn_entry.connEntryLNID);
               sn->regEntrySID = active_conn_entry.connEntrySID;
               prime_network_mutex_unlock();
               active_conn_entry_tmp = prime_sn_find_mac_connection(sn, active_conn_entry.connEntryLCID);
@@ -2163,7 +2286,7 @@ void prime_common_mng_rsp_cb(uint8_t mng_plane, uint8_t *eui48, uint8_t* ptrMsg,
                  }
               }
               prime_network_mutex_lock();
-              sn->regEntryLNID = active_conn_entry.connEntryLNID;
+              prime_network_set_sn_lnid(sn,active_conn_entry.connEntryLNID);
               sn->regEntrySID = active_conn_entry.connEntrySID;
               prime_network_mutex_unlock();
               active_conn_entry_tmp = prime_sn_find_mac_connection(sn, active_conn_entry.connEntryLCID);
@@ -2290,7 +2413,7 @@ void prime_common_mng_rsp_cb(uint8_t mng_plane, uint8_t *eui48, uint8_t* ptrMsg,
               if (sn != (prime_sn *) NULL){
                  prime_network_mutex_lock();
                  sn->cl432Conn.connState = CL432_CONN_STATE_OPEN;
-                 sn->cl432Conn.connAddress = cl432_node_entry.cl432address;
+                 prime_network_set_sn_cl432_address(sn,cl432_node_entry.cl432address);
                  memcpy(sn->cl432Conn.connSerialNumber,cl432_node_entry.cl432serial,16);
                  sn->cl432Conn.connLenSerial = cl432_node_entry.cl432serial_len;
                  memcpy(sn->cl432Conn.connMAC, cl432_node_entry.cl432mac, 6);
@@ -2310,7 +2433,7 @@ void prime_common_mng_rsp_cb(uint8_t mng_plane, uint8_t *eui48, uint8_t* ptrMsg,
            if (g_prime_sync_mgmt.f_sync_req && (g_prime_sync_mgmt.m_u16AttributeId == us_pib_attrib)){
               g_prime_sync_mgmt.s_macGetConfirm.m_u8Status = 0;
               g_prime_sync_mgmt.s_macGetConfirm.m_u16AttributeId = us_pib_attrib;
-              g_prime_sync_mgmt.f_sync_res = true;
+              addUsi_SignalProcessing((Bool *)&g_prime_sync_mgmt.f_sync_res);
            }
         }else {
 
@@ -2558,7 +2681,7 @@ void prime_bmng_ack_ind_cb(uint8_t uc_cmd, pprof_ack_code_t x_ack_code)
         /* Only for Asyncronous Set && Reboot - For Get // Zero Cross Request syncronism with response_cb */
         g_prime_sync_mgmt.s_macSetConfirm.m_u8Status = x_ack_code;
         g_prime_sync_mgmt.s_macSetConfirm.m_u16AttributeId = uc_cmd;
-        g_prime_sync_mgmt.f_sync_res = true;
+        addUsi_SignalProcessing((Bool *)&g_prime_sync_mgmt.f_sync_res);
      }
   }
 }
@@ -2664,7 +2787,7 @@ void prime_bmng_pprof_zerocross_response_cb(uint8_t *puc_eui48, uint8_t uc_zc_st
   if (g_prime_sync_mgmt.f_sync_req && (g_prime_sync_mgmt.m_u16AttributeId == prime_bmng_pprof_zc_diff_request_cmd)){
       g_prime_sync_mgmt.s_macSetConfirm.m_u8Status = PPROF_ACK_OK;
       g_prime_sync_mgmt.s_macSetConfirm.m_u16AttributeId = prime_bmng_pprof_zc_diff_request_cmd;
-      g_prime_sync_mgmt.f_sync_res = true;
+      addUsi_SignalProcessing((Bool *)&g_prime_sync_mgmt.f_sync_res);
 
       sn = prime_network_find_sn(&prime_network,puc_eui48);
       if (sn != NULL){
@@ -2948,6 +3071,8 @@ int base_node_manager_mng_init()
     st_bmng_cbs.fup_status_ind_cb               = (void *) prime_bmng_fup_status_ind_msg_cb;
     st_bmng_cbs.fup_version_ind_cb              = (void *) prime_bmng_fup_version_ind_msg_cb;
     st_bmng_cbs.network_event_ind_cb            = (void *) prime_bmng_network_event_msg_cb;
+    /* Network Events are stored by a writer thread, open the DB before events arrive */
+    prime_network_events_db_init();
     st_bmng_cbs.pprof_ack_ind_cb                = (void *) prime_bmng_ack_ind_cb ;
     st_bmng_cbs.pprof_get_response_cb           = (void *) prime_bmng_pprof_get_response_cb;
     st_bmng_cbs.pprof_zerocross_response_cb     = (void *) prime_bmng_pprof_zerocross_response_cb;
@@ -330,6 +330,14 @@ void prime_cl_null_mlme_reset_request_sync(uint8_t timeout, struct TmacGetConfir
  * \param pmacGetConfirm pointer to TmacGetConfirm structure
  */
 void prime_cl_null_mlme_get_request_sync(uint16_t us_pib_attrib, uint8_t timeout, struct TmacGetConfirm *pmacGetConfirm);
+/**
+ * \brief MLME get request of several attributes, pipelined
+ * \param pus_pib_attribs  PIB attributes
+ * \param uc_count         Number of PIB attributes
+ * \param timeout          Timeout waiting answer from PRIME stack
+ * \param pmacGetConfirms  array of TmacGetConfirm structures, one per attribute
+ */
+void prime_cl_null_mlme_get_request_multi(const uint16_t *pus_pib_attribs, uint8_t uc_count, uint8_t timeout, struct TmacGetConfirm *pmacGetConfirms);
 /**
  * \brief MLME get list request syncronous
  * \param us_pib_attrib        PIB attribute
@@ -48,7 +48,12 @@ extern "C" {
 *************************************************************/
 #include <time.h>
 #include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <pthread.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 
 #include "mngLayerHost.h"
 #include "prime_api_host.h"
@@ -56,6 +61,7 @@ extern "C" {
 #include "cl_432_defs.h"
 #include "mac_pib.h"
 #include "mac_defs.h"
+#include "UsiCrc.h"
 
 #include "prime_utils.h"
 #include "prime_log.h"
@@ -73,6 +79,15 @@ extern "C" {
 #define PRIME_SYNC_TIMEOUT 3
 #define CHUNKSIZE 0x0200
 #define MAX_NUM_TRIES_TRANSFER 3
+/* Data frames waiting for ACK on the image transfer */
+#define FUP_TX_WINDOW 8
+#define FUP_TX_WINDOW_MAX 16
+#define FUP_TX_FRAME_TIMEOUT_MS (PRIME_SYNC_TIMEOUT * 1000)
+/* Data frame states */
+#define FUP_FRAME_PENDING 0
+#define FUP_FRAME_SENT    1
+#define FUP_FRAME_ACKED   2
+#define FUP_FRAME_NACKED  3
 #define BROADCAST_ADDRESS 0xFFFFFFFFFFFF
 
 /* Extern Vars */
@@ -91,123 +106,123 @@ uint8_t fup_ack_code_str[10][16] = {"OK","ERROR","ERROR MAC","ERROR MODEL","ERRO
 void prime_bmng_fup_get_state_request(uint8_t * puc_eui48)
 #endif
 
-/** CRC-32 evaluation table */
-static const uint32_t pul_crc32_table[256] = {
-	0x00000000, 0x04C11DB7, 0x09823B6E, 0x0D4326D9,
-	0x130476DC, 0x17C56B6B, 0x1A864DB2, 0x1E475005,
-	0x2608EDB8, 0x22C9F00F, 0x2F8AD6D6, 0x2B4BCB61,
-	0x350C9B64, 0x31CD86D3, 0x3C8EA00A, 0x384FBDBD,
-	0x4C11DB70, 0x48D0C6C7, 0x4593E01E, 0x4152FDA9,
-	0x5F15ADAC, 0x5BD4B01B, 0x569796C2, 0x52568B75,
-	0x6A1936C8, 0x6ED82B7F, 0x639B0DA6, 0x675A1011,
-	0x791D4014, 0x7DDC5DA3, 0x709F7B7A, 0x745E66CD,
-	0x9823B6E0, 0x9CE2AB57, 0x91A18D8E, 0x95609039,
-	0x8B27C03C, 0x8FE6DD8B, 0x82A5FB52, 0x8664E6E5,
-	0xBE2B5B58, 0xBAEA46EF, 0xB7A96036, 0xB3687D81,
-	0xAD2F2D84, 0xA9EE3033, 0xA4AD16EA, 0xA06C0B5D,
-	0xD4326D90, 0xD0F37027, 0xDDB056FE, 0xD9714B49,
-	0xC7361B4C, 0xC3F706FB, 0xCEB42022, 0xCA753D95,
-	0xF23A8028, 0xF6FB9D9F, 0xFBB8BB46, 0xFF79A6F1,
-	0xE13EF6F4, 0xE5FFEB43, 0xE8BCCD9A, 0xEC7DD02D,
-	0x34867077, 0x30476DC0, 0x3D044B19, 0x39C556AE,
-	0x278206AB, 0x23431B1C, 0x2E003DC5, 0x2AC12072,
-	0x128E9DCF, 0x164F8078, 0x1B0CA6A1, 0x1FCDBB16,
-	0x018AEB13, 0x054BF6A4, 0x0808D07D, 0x0CC9CDCA,
-	0x7897AB07, 0x7C56B6B0, 0x71159069, 0x75D48DDE,
-	0x6B93DDDB, 0x6F52C06C, 0x6211E6B5, 0x66D0FB02,
-	0x5E9F46BF, 0x5A5E5B08, 0x571D7DD1, 0x53DC6066,
-	0x4D9B3063, 0x495A2DD4, 0x44190B0D, 0x40D816BA,
-	0xACA5C697, 0xA864DB20, 0xA527FDF9, 0xA1E6E04E,
-	0xBFA1B04B, 0xBB60ADFC, 0xB6238B25, 0xB2E29692,
-	0x8AAD2B2F, 0x8E6C3698, 0x832F1041, 0x87EE0DF6,
-	0x99A95DF3, 0x9D684044, 0x902B669D, 0x94EA7B2A,
-	0xE0B41DE7, 0xE4750050, 0xE9362689, 0xEDF73B3E,
-	0xF3B06B3B, 0xF771768C, 0xFA325055, 0xFEF34DE2,
-	0xC6BCF05F, 0xC27DEDE8, 0xCF3ECB31, 0xCBFFD686,
-	0xD5B88683, 0xD1799B34, 0xDC3ABDED, 0xD8FBA05A,
-	0x690CE0EE, 0x6DCDFD59, 0x608EDB80, 0x644FC637,
-	0x7A089632, 0x7EC98B85, 0x738AAD5C, 0x774BB0EB,
-	0x4F040D56, 0x4BC510E1, 0x46863638, 0x42472B8F,
-	0x5C007B8A, 0x58C1663D, 0x558240E4, 0x51435D53,
-	0x251D3B9E, 0x21DC2629, 0x2C9F00F0, 0x285E1D47,
-	0x36194D42, 0x32D850F5, 0x3F9B762C, 0x3B5A6B9B,
-	0x0315D626, 0x07D4CB91, 0x0A97ED48, 0x0E56F0FF,
-	0x1011A0FA, 0x14D0BD4D, 0x19939B94, 0x1D528623,
-	0xF12F560E, 0xF5EE4BB9, 0xF8AD6D60, 0xFC6C70D7,
-	0xE22B20D2, 0xE6EA3D65, 0xEBA91BBC, 0xEF68060B,
-	0xD727BBB6, 0xD3E6A601, 0xDEA580D8, 0xDA649D6F,
-	0xC423CD6A, 0xC0E2D0DD, 0xCDA1F604, 0xC960EBB3,
-	0xBD3E8D7E, 0xB9FF90C9, 0xB4BCB610, 0xB07DABA7,
-	0xAE3AFBA2, 0xAAFBE615, 0xA7B8C0CC, 0xA379DD7B,
-	0x9B3660C6, 0x9FF77D71, 0x92B45BA8, 0x9675461F,
-	0x8832161A, 0x8CF30BAD, 0x81B02D74, 0x857130C3,
-	0x5D8A9099, 0x594B8D2E, 0x5408ABF7, 0x50C9B640,
-	0x4E8EE645, 0x4A4FFBF2, 0x470CDD2B, 0x43CDC09C,
-	0x7B827D21, 0x7F436096, 0x7200464F, 0x76C15BF8,
-	0x68860BFD, 0x6C47164A, 0x61043093, 0x65C52D24,
-	0x119B4BE9, 0x155A565E, 0x18197087, 0x1CD86D30,
-	0x029F3D35, 0x065E2082, 0x0B1D065B, 0x0FDC1BEC,
-	0x3793A651, 0x3352BBE6, 0x3E119D3F, 0x3AD08088,
-	0x2497D08D, 0x2056CD3A, 0x2D15EBE3, 0x29D4F654,
-	0xC5A92679, 0xC1683BCE, 0xCC2B1D17, 0xC8EA00A0,
-	0xD6AD50A5, 0xD26C4D12, 0xDF2F6BCB, 0xDBEE767C,
-	0xE3A1CBC1, 0xE760D676, 0xEA23F0AF, 0xEEE2ED18,
-	0xF0A5BD1D, 0xF464A0AA, 0xF9278673, 0xFDE69BC4,
-	0x89B8FD09, 0x8D79E0BE, 0x803AC667, 0x84FBDBD0,
-	0x9ABC8BD5, 0x9E7D9662, 0x933EB0BB, 0x97FFAD0C,
-	0xAFB010B1, 0xAB710D06, 0xA6322BDF, 0xA2F33668,
-	0xBCB4666D, 0xB8757BDA, 0xB5365D03, 0xB1F740B4,
-};
+/* Windowed image transfer: data frame states, indexed by frame number */
+static pthread_mutex_t s_x_fup_tx_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_x_fup_tx_cond = PTHREAD_COND_INITIALIZER;
+static uint8_t *s_puc_fup_frame_state = NULL;
+static uint16_t s_us_fup_frames = 0;
 
 /**
- * \brief  This function calculates the CRC32 of the input data.
- *
- * \param    puc_buf_ptr  Pointer to the input data
- * \param    ul_len       Length of data to evaluate
- * \param    ul_crc_init  Initial value for the CRC calculation algorithm
- *
- * \retval   calculated CRC
- *
+ * \brief  Monotonic time in ms, for the data frame timers
  */
-static uint32_t fu_eval_crc_32(const uint8_t *puc_buf_ptr, uint32_t ul_len, uint32_t ul_crc_init)
+static uint64_t fu_now_ms(void)
 {
-	uint8_t uc_idx;
-	uint32_t ul_crc;
-
-	ul_crc = ul_crc_init;
-	if (ul_len != 0) {
-		while (ul_len--) {
-			uc_idx = (uint8_t)(ul_crc >> 24) ^ *puc_buf_ptr++;
-			ul_crc = (ul_crc << 8) ^ pul_crc32_table[uc_idx];
-		}
-	}
+  struct timespec x_now;
 
-	return ul_crc;
+  clock_gettime(CLOCK_MONOTONIC, &x_now);
+  return ((uint64_t)x_now.tv_sec * 1000) + (x_now.tv_nsec / 1000000);
 }
 
 /**
- * \brief  This function calculates the CRC32 of a file stream
- *
- * \param    file  file stream
+ * \brief  Send the image data frames keeping up to uc_window frames
+ *         outstanding. Only NACKed or timed out frames are sent again,
+ *         ACKed frames are kept between calls so a new call resumes
+ *         from the first frame not acknowledged.
  *
- * \retval   calculated CRC
+ * \param  puc_image   Image (mapped)
+ * \param  ui_size     Image size
+ * \param  us_chunk    Frame size
+ * \param  uc_window   Maximum frames waiting for ACK
  *
+ * \retval SUCCESS when all frames are ACKed, -1 if a frame runs out of tries
  */
-static uint32_t fu_eval_crc_32_file(FILE *file)
+static int fu_send_frames(const uint8_t *puc_image, uint32_t ui_size, uint16_t us_chunk, uint8_t uc_window)
 {
-	uint32_t crc_init, nbytes;
-  uint8_t  buffer[CHUNKSIZE];
-
-	crc_init = 0;
-  fseek(file,0,SEEK_SET);  /* Set Pointer to the beginning of the file */
-  nbytes = fread (buffer, sizeof(uint8_t), CHUNKSIZE, file);
-  while (nbytes != 0)
-  {
-     crc_init = fu_eval_crc_32(buffer, nbytes, crc_init);
-     nbytes = fread(buffer, sizeof(uint8_t), CHUNKSIZE, file);
-	}
-
-	return crc_init;
+  uint64_t ull_sent[FUP_TX_WINDOW_MAX];
+  uint8_t  uc_tries[FUP_TX_WINDOW_MAX];
+  uint16_t us_send[FUP_TX_WINDOW_MAX];
+  uint16_t us_base, us_frame, us_num_send, us_i;
+  uint32_t ui_offset;
+  uint64_t ull_now, ull_wait;
+  struct timespec x_deadline;
+  uint8_t *puc_state;
+  int res = SUCCESS;
+
+  /* Timers and tries of the frames in the window, slot = frame % FUP_TX_WINDOW_MAX */
+  memset(ull_sent, 0, sizeof(ull_sent));
+  memset(uc_tries, 0, sizeof(uc_tries));
+  if ((uc_window == 0) || (uc_window > FUP_TX_WINDOW_MAX))
+    uc_window = FUP_TX_WINDOW_MAX;
+  us_base = 1;
+  pthread_mutex_lock(&s_x_fup_tx_mutex);
+  puc_state = s_puc_fup_frame_state;
+  while (1){
+    /* Slide the window over the ACKed frames */
+    while ((us_base <= s_us_fup_frames) && (puc_state[us_base] == FUP_FRAME_ACKED)){
+      /* Free the slot for the frame FUP_TX_WINDOW_MAX ahead */
+      uc_tries[us_base % FUP_TX_WINDOW_MAX] = 0;
+      us_base++;
+    }
+    if (us_base > s_us_fup_frames)
+      break;
+    ull_now = fu_now_ms();
+    ull_wait = FUP_TX_FRAME_TIMEOUT_MS;
+    us_num_send = 0;
+    for (us_frame = us_base; (us_frame <= s_us_fup_frames) && (us_frame < us_base + uc_window); us_frame++){
+      us_i = us_frame % FUP_TX_WINDOW_MAX;
+      if (puc_state[us_frame] == FUP_FRAME_ACKED)
+        continue;
+      if (puc_state[us_frame] == FUP_FRAME_SENT){
+        if (ull_now - ull_sent[us_i] < FUP_TX_FRAME_TIMEOUT_MS){
+          /* Still waiting for its ACK */
+          if (ull_sent[us_i] + FUP_TX_FRAME_TIMEOUT_MS - ull_now < ull_wait)
+            ull_wait = ull_sent[us_i] + FUP_TX_FRAME_TIMEOUT_MS - ull_now;
+          continue;
+        }
+        PRIME_LOG(LOG_DBG,"Firmware Upgrade frame %d timeout\r\n", us_frame);
+      }
+      /* New, NACKed or timed out frame */
+      if (uc_tries[us_i] == MAX_NUM_TRIES_TRANSFER){
+        PRIME_LOG(LOG_ERR,"Firmware Upgrade frame %d not acknowledged after %d tries\r\n", us_frame, MAX_NUM_TRIES_TRANSFER);
+        res = -1;
+        break;
+      }
+      uc_tries[us_i]++;
+      ull_sent[us_i] = ull_now;
+      puc_state[us_frame] = FUP_FRAME_SENT;
+      us_send[us_num_send++] = us_frame;
+    }
+    if (res != SUCCESS)
+      break;
+    if (us_num_send > 0){
+      /* Marked as SENT before sending: the ACK can arrive before the request returns */
+      pthread_mutex_unlock(&s_x_fup_tx_mutex);
+      for (us_i = 0; us_i < us_num_send; us_i++){
+        ui_offset = (uint32_t)(us_send[us_i] - 1) * us_chunk;
+        bmng_fup_data_frame_request(us_send[us_i],
+                                    (ui_size - ui_offset < us_chunk) ? (uint16_t)(ui_size - ui_offset) : us_chunk,
+                                    (uint8_t *)puc_image + ui_offset);
+      }
+      pthread_mutex_lock(&s_x_fup_tx_mutex);
+      continue;
+    }
+    /* Window full: wait for an ACK/NACK or the first frame timeout */
+    clock_gettime(CLOCK_REALTIME, &x_deadline);
+    x_deadline.tv_sec += ull_wait / 1000;
+    x_deadline.tv_nsec += (long)(ull_wait % 1000) * 1000000L;
+    if (x_deadline.tv_nsec >= 1000000000L){
+      x_deadline.tv_sec++;
+      x_deadline.tv_nsec -= 1000000000L;
+    }
+    pthread_cond_timedwait(&s_x_fup_tx_cond, &s_x_fup_tx_mutex, &x_deadline);
+  }
+  /* Frames not ACKed are sent again on the next call */
+  for (us_frame = us_base; us_frame <= s_us_fup_frames; us_frame++){
+    if (puc_state[us_frame] != FUP_FRAME_ACKED)
+      puc_state[us_frame] = FUP_FRAME_PENDING;
+  }
+  pthread_mutex_unlock(&s_x_fup_tx_mutex);
+  return res;
 }
 
 /**
@@ -987,12 +1002,12 @@ int fw_upgrade_download(void)
 **********************************************/
   struct TmacSetConfirm x_pib_confirm;
   uint32_t chunksize = CHUNKSIZE;
-  uint32_t nbytes, filesize, filecrc;
-  uint16_t frame_num,num_tries,num_tries_frame;
-  FILE *firmware;
-  uint8_t buffer[CHUNKSIZE];
+  uint32_t filesize, filecrc;
+  uint16_t frame_num,num_tries;
+  int fd_firmware;
+  uint8_t *image;
   uint8_t rule = 0;
-	uint8_t additional_frame = 0;
+  int res;
   struct stat st;
   prime_sn * sn;
   mchp_list *entry, *tmp;
@@ -1003,8 +1018,8 @@ int fw_upgrade_download(void)
     PRIME_LOG(LOG_DEBUG,"prime_bmng_fup_start_process\r\n");
 
     /* Check Firmware File Exists and can be opened */
-    firmware = fopen ((const char *) fu_options.binarypath, "rb");
-    if (firmware == NULL){
+    fd_firmware = open((const char *) fu_options.binarypath, O_RDONLY);
+    if (fd_firmware < 0){
       PRIME_LOG(LOG_ERR,"Error opening %s firmware upgrade file\r\n", (const char *) fu_options.binarypath);
       return ERROR_FW_UPGRADE_FILEPATH;
     }
@@ -1013,7 +1028,7 @@ int fw_upgrade_download(void)
     bmng_fup_set_upg_options_request_sync(fu_options.arq_en, fu_options.pagesize, fu_options.mult_en, fu_options.delay, fu_options.timer, &x_pib_confirm);
     if (x_pib_confirm.m_u8Status != FUP_ACK_OK){
         PRIME_LOG(LOG_ERR,"Error setting Firmware Upgrade Options\r\n");
-				fclose(firmware);
+				close(fd_firmware);
 				return ERROR_FW_UPGRADE_SET_OPTIONS;
     }
 
@@ -1021,7 +1036,7 @@ int fw_upgrade_download(void)
     bmng_fup_clear_target_list_request_sync(&x_pib_confirm);
     if (x_pib_confirm.m_u8Status != FUP_ACK_OK){
         PRIME_LOG(LOG_ERR,"Error clearing Firmware Upgrade Target List\r\n");
-				fclose(firmware);
+				close(fd_firmware);
 				return ERROR_FW_UPGRADE_CLEAR_TARGET_LIST;
     }
 
@@ -1032,7 +1047,7 @@ int fw_upgrade_download(void)
           bmng_fup_add_target_request_sync(sn->regEntryID, &x_pib_confirm);
           if (x_pib_confirm.m_u8Status != FUP_ACK_OK){
             PRIME_LOG(LOG_ERR,"Error adding %s to Firmware Upgrade list (0x%X)\r\n",eui48_to_str(sn->regEntryID,NULL),x_pib_confirm.m_u8Status);
-						fclose(firmware);
+						close(fd_firmware);
 						return ERROR_FW_UPGRADE_ADD_TARGET;
           }
        }
@@ -1042,7 +1057,7 @@ int fw_upgrade_download(void)
     bmng_fup_set_fw_data_request_sync(fu_options.vendor_len, fu_options.vendor,fu_options.model_len, fu_options.model,fu_options.version_len, fu_options.version, &x_pib_confirm);
     if (x_pib_confirm.m_u8Status != FUP_ACK_OK){
         PRIME_LOG(LOG_ERR,"Error setting Firmware Upgrade Data Information\r\n");
-				fclose(firmware);
+				close(fd_firmware);
 				return ERROR_FW_UPGRADE_SET_DATA;
     }
 
@@ -1055,7 +1070,7 @@ int fw_upgrade_download(void)
 		bmng_fup_set_match_rule_request_sync(rule, &x_pib_confirm);
 		if (x_pib_confirm.m_u8Status != FUP_ACK_OK){
 				PRIME_LOG(LOG_ERR,"Error setting Firmware Upgrade Match Rule\r\n");
-				fclose(firmware);
+				close(fd_firmware);
 				return ERROR_FW_UPGRADE_SET_RULE;
 		}
 
@@ -1064,71 +1079,73 @@ int fw_upgrade_download(void)
 			prime_bmng_fup_set_signature_data_request_sync(fu_options.sign_algo, fu_options.sign_size, &x_pib_confirm);
     	if (x_pib_confirm.m_u8Status != FUP_ACK_OK){
         	PRIME_LOG(LOG_ERR,"Error setting Firmware Upgrade Data Information\r\n");
-					fclose(firmware);
+					close(fd_firmware);
 					return ERROR_FW_UPGRADE_SET_DATA;
     	}
 		}
 
     // Init File Transfer
-    /* Calculate Filesize */
-    stat(fu_options.binarypath, &st);
+    /* Map the image once: frames are sent (and resent) straight from it */
+    if (fstat(fd_firmware, &st) < 0){
+      PRIME_LOG(LOG_ERR,"Error reading %s firmware upgrade file\r\n", (const char *) fu_options.binarypath);
+      close(fd_firmware);
+      return ERROR_FW_UPGRADE_FILEPATH;
+    }
     filesize = st.st_size;
-		PRIME_LOG(LOG_DBG,"Firmware Upgrade Filesize: 0x%08X\r\n",filesize);
-    /* Calculate CRC */
-    filecrc = fu_eval_crc_32_file(firmware);
-		PRIME_LOG(LOG_DBG,"Firmware Upgrade CRC: 0x%08X\r\n",filecrc);
-    num_tries = MAX_NUM_TRIES_TRANSFER;
-		/* Number of frames to be sent */
-		chunksize = CHUNKSIZE;
-    frame_num = (filesize / chunksize) ;
-		/* Check if a last frame with size 0 bytes need to be sent */
-		if ((filesize % chunksize) == 0)
-		   additional_frame = 1;
-
-    while (num_tries){
-      bmng_fup_init_file_tx_request_sync(frame_num + 1, filesize, chunksize /*fu_options.pagesize */, filecrc, &x_pib_confirm);
-      if (x_pib_confirm.m_u8Status != FUP_ACK_OK){
-          PRIME_LOG(LOG_ERR,"Error setting Firmware Upgrade Init File Tx Request\r\n");
-					fclose(firmware);
-          return ERROR_FW_UPGRADE_INIT_FILE_TX;
+    PRIME_LOG(LOG_DBG,"Firmware Upgrade Filesize: 0x%08X\r\n",filesize);
+    image = NULL;
+    if (filesize > 0){
+      image = mmap(NULL, filesize, PROT_READ, MAP_PRIVATE, fd_firmware, 0);
+      if (image == MAP_FAILED){
+        PRIME_LOG(LOG_ERR,"Error mapping %s firmware upgrade file\r\n", (const char *) fu_options.binarypath);
+        close(fd_firmware);
+        return ERROR_FW_UPGRADE_FILEPATH;
       }
-      // Data File Transfer to USI
-      frame_num = 1;                              /* Number of frames (chunks) sent */
-      num_tries_frame = MAX_NUM_TRIES_TRANSFER;   /* Maximum Tries to send a frame (chunk) */
-      fseek(firmware,0,SEEK_SET);                 /* Set Pointer to the beginning of the file */
-      nbytes = fread (buffer, sizeof(uint8_t), chunksize, firmware);
-      while (((nbytes != 0) || additional_frame) && num_tries_frame)
-      {
-         /* Send to Base Node Modem  */
-         num_tries_frame--; /* Discount one try */
-         bmng_fup_data_frame_request_sync(frame_num, nbytes, buffer, &x_pib_confirm);
-         if (x_pib_confirm.m_u8Status == FUP_ACK_OK){
-            /* Read next chunk */
-            nbytes = fread (buffer, sizeof(uint8_t), chunksize, firmware);
-            frame_num++;
-            num_tries_frame = MAX_NUM_TRIES_TRANSFER;
-         }
-				 if (additional_frame && (nbytes == 0))
-				    additional_frame = 0;
-				 usleep(250);
+      madvise(image, filesize, MADV_SEQUENTIAL);
+    }
+    close(fd_firmware);
+    /* Calculate CRC, single pass over the mapped image */
+    filecrc = USI_CRC32_INIT;
+    if (filesize > 0)
+      filecrc = usi_Crc32(filecrc, image, filesize);
+    PRIME_LOG(LOG_DBG,"Firmware Upgrade CRC: 0x%08X\r\n",filecrc);
+    /* Number of frames to be sent: last one is shorter, or 0 bytes if filesize is a multiple of the chunk */
+    chunksize = CHUNKSIZE;
+    frame_num = (filesize / chunksize) + 1;
+
+    bmng_fup_init_file_tx_request_sync(frame_num, filesize, chunksize /*fu_options.pagesize */, filecrc, &x_pib_confirm);
+    if (x_pib_confirm.m_u8Status != FUP_ACK_OK){
+        PRIME_LOG(LOG_ERR,"Error setting Firmware Upgrade Init File Tx Request\r\n");
+        if (image != NULL)
+          munmap(image, filesize);
+        return ERROR_FW_UPGRADE_INIT_FILE_TX;
+    }
+
+    // Data File Transfer to USI
+    pthread_mutex_lock(&s_x_fup_tx_mutex);
+    s_puc_fup_frame_state = calloc(frame_num + 1, sizeof(uint8_t));
+    s_us_fup_frames = frame_num;
+    pthread_mutex_unlock(&s_x_fup_tx_mutex);
+    res = -1;
+    if (s_puc_fup_frame_state != NULL){
+      /* First round windowed, then resume frame by frame from the first frame not ACKed */
+      for (num_tries = 0; (num_tries < MAX_NUM_TRIES_TRANSFER) && (res != SUCCESS); num_tries++){
+        res = fu_send_frames(image, filesize, chunksize, (num_tries == 0) ? FUP_TX_WINDOW : 1);
       }
-      if (!num_tries_frame){
-         /* Impossible to transfer the full file to base node modem */
-         /* Decrease Transefer Frame Size */
-         chunksize >>= 2;
-         num_tries--;
-      }else{
-				 PRIME_LOG(LOG_INFO,"Firmware Upgrade sent to Base Node Modem\r\n");
-				 break;
-			}
     }
-    if (!num_tries){
+    pthread_mutex_lock(&s_x_fup_tx_mutex);
+    free(s_puc_fup_frame_state);
+    s_puc_fup_frame_state = NULL;
+    s_us_fup_frames = 0;
+    pthread_mutex_unlock(&s_x_fup_tx_mutex);
+    if (image != NULL)
+      munmap(image, filesize);
+    if (res != SUCCESS){
       /* File Transfer failed! */
       PRIME_LOG(LOG_ERR,"Error sending firmware upgrade file to base node modem\r\n");
-			fclose(firmware);
-			return -1;
+      return -1;
     }
-    fclose(firmware);
+    PRIME_LOG(LOG_INFO,"Firmware Upgrade sent to Base Node Modem\r\n");
 
     // Check CRC of File Transfered via USI
     bmng_fup_check_crc_request_sync(&x_pib_confirm);
@@ -1186,6 +1203,22 @@ int fw_upgrade_status()
 void prime_bmng_fup_ack_ind_msg_cb(uint8_t uc_cmd, uint8_t uc_ack, uint16_t us_data)
 {
     PRIME_LOG(LOG_DEBUG,"bmng_fup_ack_ind_msg_cb uc_cmd=0x%02X  uc_ack=0x%02X us_data=0x%04X\r\n", uc_cmd,uc_ack,us_data);
+    if (uc_cmd == prime_bmng_fup_data_frame_request_cmd){
+       /* Image transfer: us_data is the frame number */
+       pthread_mutex_lock(&s_x_fup_tx_mutex);
+       if ((s_puc_fup_frame_state != NULL) && (us_data > 0) && (us_data <= s_us_fup_frames)){
+          if (uc_ack == FUP_ACK_OK){
+             s_puc_fup_frame_state[us_data] = FUP_FRAME_ACKED;
+          }else if (s_puc_fup_frame_state[us_data] == FUP_FRAME_SENT){
+             PRIME_LOG(LOG_DBG,"Firmware Upgrade frame %d NACK (%s)\r\n", us_data, (uc_ack < 10) ? (char *)fup_ack_code_str[uc_ack] : "?");
+             s_puc_fup_frame_state[us_data] = FUP_FRAME_NACKED;
+          }
+          pthread_cond_signal(&s_x_fup_tx_cond);
+          pthread_mutex_unlock(&s_x_fup_tx_mutex);
+          return;
+       }
+       pthread_mutex_unlock(&s_x_fup_tx_mutex);
+    }
     memset(&g_prime_sync_mgmt.s_macSetConfirm,0,sizeof(struct TmacSetConfirm));
     if (g_prime_sync_mgmt.f_sync_req && (g_prime_sync_mgmt.m_u16AttributeId == uc_cmd)){
        if ((uc_cmd != prime_bmng_fup_get_version_request_cmd) && (uc_cmd != prime_bmng_fup_get_state_request_cmd)){
@@ -1194,7 +1227,7 @@ void prime_bmng_fup_ack_ind_msg_cb(uint8_t uc_cmd, uint8_t uc_ack, uint16_t us_d
           g_prime_sync_mgmt.s_macSetConfirm.m_u16AttributeId = uc_cmd;
           memcpy(g_prime_sync_mgmt.s_macSetConfirm.m_au8AttributeValue,&us_data,2);
           g_prime_sync_mgmt.s_macGetConfirm.m_u8AttributeLength = 2;
-          g_prime_sync_mgmt.f_sync_res = true;
+          addUsi_SignalProcessing((Bool *)&g_prime_sync_mgmt.f_sync_res);
        }
     }
 }
@@ -1260,7 +1293,7 @@ char broadcast_address[6] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
 	if (g_prime_sync_mgmt.f_sync_req) {
 			g_prime_sync_mgmt.s_macGetConfirm.m_u8Status = FUP_ACK_OK;
 			/* Information saved on Service Node Entry */
-			g_prime_sync_mgmt.f_sync_res = true;
+			addUsi_SignalProcessing((Bool *)&g_prime_sync_mgmt.f_sync_res);
 	}
 }
 
@@ -1301,7 +1334,7 @@ prime_sn *sn;
 	if (g_prime_sync_mgmt.f_sync_req) {
 			g_prime_sync_mgmt.s_macGetConfirm.m_u8Status = FUP_ACK_OK;
 			/* Information saved on Service Node Entry */
-			g_prime_sync_mgmt.f_sync_res = true;
+			addUsi_SignalProcessing((Bool *)&g_prime_sync_mgmt.f_sync_res);
 	}
 }
 
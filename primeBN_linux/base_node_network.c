@@ -57,6 +57,7 @@ extern "C" {
 #include <unistd.h>
 #include <signal.h>
 #include <pthread.h>
+#include <sched.h>
 #include <time.h>
 #include "conf_global.h"
 
@@ -80,7 +81,6 @@ extern "C" {
 *       Defines                                             *
 *************************************************************/
 #define DUK_LEN 16
-#define NUM_MAX_PRIME_SN 2000
 #define NUM_MAX_PRIME_MAC_CONNECTIONS 10
 #define NUM_MAX_PRIME_LEVELS 63
 
@@ -90,25 +90,257 @@ mchp_list prime_network;
 uint16_t prime_network_sn = 0;
 /* Number of Levels on PRIME Network */
 uint8_t  prime_network_max_level = 0;
-/* Mutex for accessing PRIME Network Information */
-pthread_mutex_t prime_network_mutex = PTHREAD_MUTEX_INITIALIZER;
+/* Lock for accessing PRIME Network Information: shared for readers walking
+   the list, exclusive for writers. Writers are preferred so a burst of show
+   commands can not starve the network event callbacks */
+static pthread_rwlock_t prime_network_rwlock = PTHREAD_RWLOCK_WRITER_NONRECURSIVE_INITIALIZER_NP;
+/* Sequence for lock-free readers: odd while a writer holds the lock */
+static uint32_t prime_network_seq = 0;
+
+/* Lookup indexes for the PRIME Network: hash buckets with the chains
+   embedded on each prime_sn, so a lookup by EUI48, LSID, LNID or CL4-32
+   address does not need to walk the whole prime_network list.
+   LSID is 8 bits wide and is indexed directly */
+#define PRIME_SN_HASH_SIZE     2048     /* Power of two, >= NUM_MAX_PRIME_SN */
+#define PRIME_SN_HASH_MASK     (PRIME_SN_HASH_SIZE - 1)
+#define PRIME_SN_LSID_SIZE     256
+/* PRIME SN entries are taken from slabs of this size, allocated on demand
+   and kept on a free list once the SN is deleted. Slabs are never freed, so
+   a reader holding a stale prime_sn pointer always reads a prime_sn */
+#define PRIME_SN_SLAB_ENTRIES  64
+
+/* Slab slot: keeps every packed prime_sn on an aligned address */
+typedef union {
+    prime_sn  sn;
+    uint64_t  align;
+} prime_sn_slot;
+
+static prime_sn *prime_sn_hash_eui48[PRIME_SN_HASH_SIZE];
+static prime_sn *prime_sn_hash_lnid[PRIME_SN_HASH_SIZE];
+static prime_sn *prime_sn_hash_cl432[PRIME_SN_HASH_SIZE];
+static prime_sn *prime_sn_hash_lsid[PRIME_SN_LSID_SIZE];
+/* Free PRIME SN entries, chained through p_next_eui48 while unused */
+static prime_sn *prime_sn_free_list = NULL;
+/* Number of PRIME SN entries allocated on slabs */
+static uint16_t prime_sn_slab_entries = 0;
+/* Mutex for the lookup indexes. Setters are called with or without
+   the network write lock held, so the indexes have their own lock */
+static pthread_mutex_t prime_network_index_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 /*
- * \brief PRIME Network Mutex Lock
+ * \brief EUI48 hash bucket
+ * \param eui48  EUI48 Address
+ *
+ * \return Bucket index
+ */
+static uint16_t _prime_sn_hash_eui48(const uint8_t *eui48)
+{
+    uint32_t ul_hash = 2166136261u;
+    uint8_t  uc_i;
+
+    /* FNV-1a: vendor prefix bytes are mostly equal, the mix spreads the rest */
+    for (uc_i = 0; uc_i < EUI48_LEN; uc_i++){
+        ul_hash ^= eui48[uc_i];
+        ul_hash *= 16777619u;
+    }
+    return (uint16_t)((ul_hash ^ (ul_hash >> 16)) & PRIME_SN_HASH_MASK);
+}
+
+/*
+ * \brief Insert a PRIME SN at the tail of a hash chain
+ *        (keeps the first-registered-first-found order of the list walk)
+ */
+#define PRIME_SN_CHAIN_INSERT(head, sn, next)        \
+  do {                                               \
+     prime_sn *p_tail = (head);                      \
+     (sn)->next = NULL;                              \
+     if (p_tail == NULL){                            \
+        (head) = (sn);                               \
+     }else{                                          \
+        while (p_tail->next != NULL)                 \
+           p_tail = p_tail->next;                    \
+        p_tail->next = (sn);                         \
+     }                                               \
+  } while (0)
+
+/*
+ * \brief Remove a PRIME SN from a hash chain
+ */
+#define PRIME_SN_CHAIN_REMOVE(head, sn, next)        \
+  do {                                               \
+     prime_sn *p_prev = (head);                      \
+     if (p_prev == (sn)){                            \
+        (head) = (sn)->next;                         \
+     }else{                                          \
+        while ((p_prev != NULL) && (p_prev->next != (sn))) \
+           p_prev = p_prev->next;                    \
+        if (p_prev != NULL)                          \
+           p_prev->next = (sn)->next;                \
+     }                                               \
+     (sn)->next = NULL;                              \
+  } while (0)
+
+/*
+ * \brief Link a PRIME SN on all lookup indexes
+ * \param p_prime_sn PRIME SN Device Pointer
+ *
+ * \return -
+ */
+static void _prime_sn_index_add(prime_sn *p_prime_sn)
+{
+    PRIME_SN_CHAIN_INSERT(prime_sn_hash_eui48[_prime_sn_hash_eui48(p_prime_sn->regEntryID)], p_prime_sn, p_next_eui48);
+    PRIME_SN_CHAIN_INSERT(prime_sn_hash_lsid[p_prime_sn->regEntryLSID], p_prime_sn, p_next_lsid);
+    PRIME_SN_CHAIN_INSERT(prime_sn_hash_lnid[p_prime_sn->regEntryLNID & PRIME_SN_HASH_MASK], p_prime_sn, p_next_lnid);
+    PRIME_SN_CHAIN_INSERT(prime_sn_hash_cl432[p_prime_sn->cl432Conn.connAddress & PRIME_SN_HASH_MASK], p_prime_sn, p_next_cl432);
+}
+
+/*
+ * \brief Unlink a PRIME SN from all lookup indexes
+ * \param p_prime_sn PRIME SN Device Pointer
+ *
+ * \return -
+ */
+static void _prime_sn_index_del(prime_sn *p_prime_sn)
+{
+    PRIME_SN_CHAIN_REMOVE(prime_sn_hash_eui48[_prime_sn_hash_eui48(p_prime_sn->regEntryID)], p_prime_sn, p_next_eui48);
+    PRIME_SN_CHAIN_REMOVE(prime_sn_hash_lsid[p_prime_sn->regEntryLSID], p_prime_sn, p_next_lsid);
+    PRIME_SN_CHAIN_REMOVE(prime_sn_hash_lnid[p_prime_sn->regEntryLNID & PRIME_SN_HASH_MASK], p_prime_sn, p_next_lnid);
+    PRIME_SN_CHAIN_REMOVE(prime_sn_hash_cl432[p_prime_sn->cl432Conn.connAddress & PRIME_SN_HASH_MASK], p_prime_sn, p_next_cl432);
+}
+
+/*
+ * \brief Return a PRIME SN entry to the slab free list
+ * \param p_prime_sn PRIME SN Device Pointer
+ *
+ * \return -
+ */
+static void _prime_sn_free(prime_sn *p_prime_sn)
+{
+    p_prime_sn->p_next_eui48 = prime_sn_free_list;
+    prime_sn_free_list = p_prime_sn;
+}
+
+/*
+ * \brief Get a PRIME SN entry from the slab free list
+ *
+ * \return Pointer to the entry or NULL if no memory available
+ */
+static prime_sn * _prime_sn_alloc(void)
+{
+/*********************************************************
+*       Vars                                             *
+*********************************************************/
+    prime_sn_slot * p_slots;
+    prime_sn * p_slab;
+    uint16_t   us_i;
+/*********************************************************
+*       Code                                             *
+*********************************************************/
+    if (prime_sn_free_list == (prime_sn *) NULL){
+       /// Grow the pool by one slab; slabs are never returned
+       p_slots = (prime_sn_slot *) calloc(PRIME_SN_SLAB_ENTRIES, sizeof(prime_sn_slot));
+       if (p_slots == (prime_sn_slot *) NULL){
+          return (prime_sn *) NULL;
+       }
+       for (us_i = 0; us_i < PRIME_SN_SLAB_ENTRIES; us_i++){
+          _prime_sn_free(&p_slots[us_i].sn);
+       }
+       prime_sn_slab_entries += PRIME_SN_SLAB_ENTRIES;
+       PRIME_LOG(LOG_DBG, "PRIME SN slab allocated, %d entries\r\n", prime_sn_slab_entries);
+    }
+    p_slab = prime_sn_free_list;
+    prime_sn_free_list = p_slab->p_next_eui48;
+    return p_slab;
+}
+
+
+/*
+ * \brief PRIME Network Write Lock (exclusive)
  * \return 0
  */
 int prime_network_mutex_lock()
 {
-    return pthread_mutex_lock(&prime_network_mutex);
+    int i_ret;
+
+    i_ret = pthread_rwlock_wrlock(&prime_network_rwlock);
+    /* Odd sequence: lock-free readers retry until the write is done */
+    __atomic_store_n(&prime_network_seq, prime_network_seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    return i_ret;
 }
 
 /*
- * \brief PRIME Network Mutex Unlock
+ * \brief PRIME Network Write Unlock
  * \return 0
  */
 int prime_network_mutex_unlock()
 {
-    return pthread_mutex_unlock(&prime_network_mutex);
+    __atomic_store_n(&prime_network_seq, prime_network_seq + 1, __ATOMIC_RELEASE);
+    return pthread_rwlock_unlock(&prime_network_rwlock);
+}
+
+/*
+ * \brief PRIME Network Read Lock (shared)
+ * \return 0
+ */
+int prime_network_read_lock()
+{
+    return pthread_rwlock_rdlock(&prime_network_rwlock);
+}
+
+/*
+ * \brief PRIME Network Read Unlock
+ * \return 0
+ */
+int prime_network_read_unlock()
+{
+    return pthread_rwlock_unlock(&prime_network_rwlock);
+}
+
+/*
+ * \brief Begin a lock-free read of the PRIME Network
+ *
+ * \return Sequence to be checked with prime_network_read_retry()
+ */
+uint32_t prime_network_read_begin()
+{
+    uint32_t ul_seq;
+
+    /* Write sections are short and never wait on the USI: spin */
+    while ((ul_seq = __atomic_load_n(&prime_network_seq, __ATOMIC_ACQUIRE)) & 1){
+       sched_yield();
+    }
+    return ul_seq;
+}
+
+/*
+ * \brief Check if a lock-free read has to be repeated
+ * \param seq  Sequence returned by prime_network_read_begin()
+ *
+ * \return 1 if a writer modified the PRIME Network during the read
+ */
+int prime_network_read_retry(uint32_t seq)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return (__atomic_load_n(&prime_network_seq, __ATOMIC_RELAXED) != seq);
+}
+
+/*
+ * \brief Get a consistent copy of a PRIME SN without locking
+ * \param p_prime_sn  PRIME SN Device Pointer
+ * \param p_copy      Copy of the PRIME SN
+ *
+ * \return 0 if copied, -1 if the PRIME SN has been deleted
+ */
+int prime_network_get_sn(const prime_sn *p_prime_sn, prime_sn *p_copy)
+{
+    uint32_t ul_seq;
+
+    do {
+       ul_seq = prime_network_read_begin();
+       memcpy(p_copy, p_prime_sn, sizeof(prime_sn));
+    } while (prime_network_read_retry(ul_seq));
+    return (p_copy->in_use) ? 0 : -1;
 }
 
 /*
@@ -134,35 +366,42 @@ int prime_network_mutex_unlock()
  /*********************************************************
  *       Code                                             *
  *********************************************************/
-     pthread_mutex_lock(&prime_network_mutex);
+     if (prime_network_sn == NUM_MAX_PRIME_SN){
+         PRIME_LOG(LOG_ERR,"Maximum Number of PRIME SN registered\r\n");
+         return (prime_sn *) NULL;
+     }
+     // Whitelist the DUK before locking: USI requests never run under the lock
+     if (duk != NULL){
+        memcpy(&buffer[0],eui48,EUI48_LEN);
+        memcpy(&buffer[6],duk,DUK_LEN);
+        prime_cl_null_mlme_set_request_sync(PIB_MAC_SEC_DUK_BN,buffer,22,PRIME_SYNC_TIMEOUT_SET_REQUEST,&x_pib_confirm);
+        if (x_pib_confirm.m_u8Status != MLME_RESULT_DONE){
+            PRIME_LOG(LOG_ERR, "Error adding Service Node to whitelist\r\n");
+            return (prime_sn *) NULL;
+        }
+     }
+     prime_network_mutex_lock();
  	   if (prime_network_sn == NUM_MAX_PRIME_SN){
  		     PRIME_LOG(LOG_ERR,"Maximum Number of PRIME SN registered\r\n");
- 		     pthread_mutex_unlock(&prime_network_mutex);
+ 		     prime_network_mutex_unlock();
  		     return (prime_sn *) NULL;
  	   }
-     /// Initial Malloc
-     p_prime_sn = (prime_sn *) malloc(sizeof(prime_sn));
+     /// Take entry from slab
+     pthread_mutex_lock(&prime_network_index_mutex);
+     p_prime_sn = _prime_sn_alloc();
+     pthread_mutex_unlock(&prime_network_index_mutex);
      if (p_prime_sn == (prime_sn *) NULL){
          PRIME_LOG(LOG_ERR,"Impossible to allocate space for a new PRIME SN\r\n");
-         pthread_mutex_unlock(&prime_network_mutex);
+         prime_network_mutex_unlock();
          return (prime_sn *) NULL;
      }
      // Initialize Entry
      memset(p_prime_sn, 0, sizeof(prime_sn));
      // Set Entry - MAC is necessar
      memcpy(p_prime_sn->regEntryID, eui48, EUI48_LEN);
-     memcpy(&buffer[0],eui48,EUI48_LEN);
      p_prime_sn->security_profile = sec_profile;
      if (duk != NULL){
         memcpy(p_prime_sn->duk, duk, DUK_LEN);
-        memcpy(&buffer[6],duk,DUK_LEN);
-        prime_cl_null_mlme_set_request_sync(PIB_MAC_SEC_DUK_BN,buffer,22,PRIME_SYNC_TIMEOUT_SET_REQUEST,&x_pib_confirm);
-        if (x_pib_confirm.m_u8Status != MLME_RESULT_DONE){
-            PRIME_LOG(LOG_ERR, "Error adding Service Node to whitelist\r\n");
-            free(p_prime_sn);
-            pthread_mutex_unlock(&prime_network_mutex);
-            return (prime_sn *) NULL;
-        }
      }
      // If Register from CMDLINE, enable administrative state
      p_prime_sn->admin_en = admin_en;
@@ -172,10 +411,14 @@ int prime_network_mutex_unlock()
      p_prime_sn->macConns = 0;
      /// Include SN on Prime Network
      mchp_list_add_tail(p_prime_sn, p_prime_network);
+     pthread_mutex_lock(&prime_network_index_mutex);
+     _prime_sn_index_add(p_prime_sn);
+     pthread_mutex_unlock(&prime_network_index_mutex);
+     p_prime_sn->in_use = 1;
      prime_network_sn++;
      PRIME_LOG(LOG_DBG, "New PRIME SN Device created\r\n");
      prime_network_print_sn(p_prime_sn);
-     pthread_mutex_unlock(&prime_network_mutex);
+     prime_network_mutex_unlock();
      return p_prime_sn;
  }
 
@@ -196,7 +439,7 @@ int prime_network_mutex_unlock()
  *       Code                                             *
  *********************************************************/
      PRIME_LOG(LOG_INFO, "Deleting PRIME SN 0x%s\r\n",eui48_to_str(p_prime_sn->regEntryID,NULL));
-     pthread_mutex_lock(&prime_network_mutex);
+     prime_network_mutex_lock();
      /// Delete frame queues on RX
      //prime_device_frame_queue_destroy(p_g3plc_device->frame_queue);
      /// Delete Service Node State Machine
@@ -210,10 +453,14 @@ int prime_network_mutex_unlock()
      }
      /// Unlink Service Node on PRIME Network
      mchp_list_del(p_prime_sn);
-     /// Free Memory on PRIME Network List
-     free(p_prime_sn);
+     /// Return entry to the slab
+     pthread_mutex_lock(&prime_network_index_mutex);
+     _prime_sn_index_del(p_prime_sn);
+     _prime_sn_free(p_prime_sn);
+     pthread_mutex_unlock(&prime_network_index_mutex);
+     p_prime_sn->in_use = 0;
      prime_network_sn-- ;
-     pthread_mutex_unlock(&prime_network_mutex);
+     prime_network_mutex_unlock();
  }
 
  /*
@@ -228,24 +475,18 @@ int prime_network_mutex_unlock()
  /*********************************************************
  *       Variables Locales Definidas                      *
  *********************************************************/
-     mchp_list *entry, *tmp;
      prime_sn * p_prime_sn;
  /*********************************************************
  *       Code                                           *
  *********************************************************/
-     if (prime_network_sn == 0){
- 		    //PRIME_LOG(LOG_DEBUG, "No PRIME SN present\r\n");
- 		    return (prime_sn *) NULL;
- 	   }
-     list_for_each_safe(entry, tmp, p_prime_network) {
-         p_prime_sn = list_entry(entry, prime_sn, list);
-         //prime_network_print_sn(p_prime_sn);
-         if (memcmp(p_prime_sn->regEntryID, regEntryID, EUI48_LEN) == 0){
- 			      //PRIME_LOG(LOG_DEBUG, "PRIME SN 0x%s found!\r\n",eui48_to_str(regEntryID,NULL));
-            return p_prime_sn;
-         }
+     (void)p_prime_network;
+     pthread_mutex_lock(&prime_network_index_mutex);
+     p_prime_sn = prime_sn_hash_eui48[_prime_sn_hash_eui48(regEntryID)];
+     while ((p_prime_sn != NULL) && (memcmp(p_prime_sn->regEntryID, regEntryID, EUI48_LEN) != 0)){
+        p_prime_sn = p_prime_sn->p_next_eui48;
      }
-     return (prime_sn *) NULL;
+     pthread_mutex_unlock(&prime_network_index_mutex);
+     return p_prime_sn;
  }
 
 /*
@@ -260,24 +501,42 @@ prime_sn * prime_network_find_sn_lsid(mchp_list * p_prime_network, uint8_t lsid)
  /*********************************************************
  *       Variables Locales Definidas                      *
  *********************************************************/
-     mchp_list *entry, *tmp;
      prime_sn * p_prime_sn;
  /*********************************************************
  *       Code                                           *
  *********************************************************/
-     if (prime_network_sn == 0){
- 		    //PRIME_LOG(LOG_DEBUG, "No PRIME SN present\r\n");
- 		    return (prime_sn *) NULL;
- 	   }
-     list_for_each_safe(entry, tmp, p_prime_network) {
-         p_prime_sn = list_entry(entry, prime_sn, list);
-         //prime_network_print_sn(p_prime_sn);
-         if (p_prime_sn->regEntryLSID == lsid){
- 			      //PRIME_LOG(LOG_DEBUG, "LSID found on PRIME SN 0x%s!\r\n",eui48_to_str(p_prime_sn->regEntryID,NULL));
-            return p_prime_sn;
-         }
+     (void)p_prime_network;
+     pthread_mutex_lock(&prime_network_index_mutex);
+     /* LSID bucket holds only SNs with this LSID */
+     p_prime_sn = prime_sn_hash_lsid[lsid];
+     pthread_mutex_unlock(&prime_network_index_mutex);
+     return p_prime_sn;
+ }
+
+/*
+* \brief Look for a PRIME SN on the list for LNID
+* \param p_prime_network PRIME SN List
+* \param lnid            PRIME LNID
+*
+* \return Pointer to the PRIME SN Structure or NULL if doesn't exist
+*/
+prime_sn * prime_network_find_sn_lnid(mchp_list * p_prime_network, uint16_t lnid)
+ {
+ /*********************************************************
+ *       Variables Locales Definidas                      *
+ *********************************************************/
+     prime_sn * p_prime_sn;
+ /*********************************************************
+ *       Code                                           *
+ *********************************************************/
+     (void)p_prime_network;
+     pthread_mutex_lock(&prime_network_index_mutex);
+     p_prime_sn = prime_sn_hash_lnid[lnid & PRIME_SN_HASH_MASK];
+     while ((p_prime_sn != NULL) && (p_prime_sn->regEntryLNID != lnid)){
+        p_prime_sn = p_prime_sn->p_next_lnid;
      }
-     return (prime_sn *) NULL;
+     pthread_mutex_unlock(&prime_network_index_mutex);
+     return p_prime_sn;
  }
 
  /*
@@ -292,26 +551,74 @@ prime_sn * prime_network_find_sn_lsid(mchp_list * p_prime_network, uint8_t lsid)
   /*********************************************************
   *       Variables Locales Definidas                      *
   *********************************************************/
-      mchp_list *entry, *tmp;
       prime_sn * p_prime_sn;
   /*********************************************************
   *       Code                                           *
   *********************************************************/
-      if (prime_network_sn == 0){
-  		    //PRIME_LOG(LOG_DEBUG, "No PRIME SN present\r\n");
-  		    return (prime_sn *) NULL;
-  	   }
-      list_for_each_safe(entry, tmp, p_prime_network) {
-          p_prime_sn = list_entry(entry, prime_sn, list);
-          //prime_network_print_sn(p_prime_sn);
-          if (p_prime_sn->cl432Conn.connAddress == cl432_address){
-  			      //PRIME_LOG(LOG_DEBUG, "CL4-32 Address found on PRIME SN 0x%s!\r\n",eui48_to_str(p_prime_sn->regEntryID,NULL));
-             return p_prime_sn;
-          }
+      (void)p_prime_network;
+      pthread_mutex_lock(&prime_network_index_mutex);
+      p_prime_sn = prime_sn_hash_cl432[cl432_address & PRIME_SN_HASH_MASK];
+      while ((p_prime_sn != NULL) && (p_prime_sn->cl432Conn.connAddress != cl432_address)){
+         p_prime_sn = p_prime_sn->p_next_cl432;
       }
-      return (prime_sn *) NULL;
+      pthread_mutex_unlock(&prime_network_index_mutex);
+      return p_prime_sn;
   }
 
+/*
+ * \brief Set the LSID of a PRIME SN keeping the lookup index updated
+ * \param p_prime_sn  PRIME SN Device Pointer
+ * \param lsid        LSID allocated to the SN
+ *
+ * \return -
+ */
+void prime_network_set_sn_lsid(prime_sn *p_prime_sn, uint8_t lsid)
+{
+    if (p_prime_sn->regEntryLSID == lsid)
+       return;
+    pthread_mutex_lock(&prime_network_index_mutex);
+    PRIME_SN_CHAIN_REMOVE(prime_sn_hash_lsid[p_prime_sn->regEntryLSID], p_prime_sn, p_next_lsid);
+    p_prime_sn->regEntryLSID = lsid;
+    PRIME_SN_CHAIN_INSERT(prime_sn_hash_lsid[lsid], p_prime_sn, p_next_lsid);
+    pthread_mutex_unlock(&prime_network_index_mutex);
+}
+
+/*
+ * \brief Set the LNID of a PRIME SN keeping the lookup index updated
+ * \param p_prime_sn  PRIME SN Device Pointer
+ * \param lnid        LNID allocated to the SN
+ *
+ * \return -
+ */
+void prime_network_set_sn_lnid(prime_sn *p_prime_sn, uint16_t lnid)
+{
+    if (p_prime_sn->regEntryLNID == lnid)
+       return;
+    pthread_mutex_lock(&prime_network_index_mutex);
+    PRIME_SN_CHAIN_REMOVE(prime_sn_hash_lnid[p_prime_sn->regEntryLNID & PRIME_SN_HASH_MASK], p_prime_sn, p_next_lnid);
+    p_prime_sn->regEntryLNID = lnid;
+    PRIME_SN_CHAIN_INSERT(prime_sn_hash_lnid[lnid & PRIME_SN_HASH_MASK], p_prime_sn, p_next_lnid);
+    pthread_mutex_unlock(&prime_network_index_mutex);
+}
+
+/*
+ * \brief Set the CL4-32 address of a PRIME SN keeping the lookup index updated
+ * \param p_prime_sn     PRIME SN Device Pointer
+ * \param cl432_address  CL4-32 Address
+ *
+ * \return -
+ */
+void prime_network_set_sn_cl432_address(prime_sn *p_prime_sn, uint16_t cl432_address)
+{
+    if (p_prime_sn->cl432Conn.connAddress == cl432_address)
+       return;
+    pthread_mutex_lock(&prime_network_index_mutex);
+    PRIME_SN_CHAIN_REMOVE(prime_sn_hash_cl432[p_prime_sn->cl432Conn.connAddress & PRIME_SN_HASH_MASK], p_prime_sn, p_next_cl432);
+    p_prime_sn->cl432Conn.connAddress = cl432_address;
+    PRIME_SN_CHAIN_INSERT(prime_sn_hash_cl432[cl432_address & PRIME_SN_HASH_MASK], p_prime_sn, p_next_cl432);
+    pthread_mutex_unlock(&prime_network_index_mutex);
+}
+
 /*
  * \brief Print List of PRIME SN
  * \param p_prime_network PRIME SN linked list Pointer
@@ -331,12 +638,12 @@ void prime_network_print_sn_list(mchp_list * p_prime_network)
     if (prime_network_sn == 0){
 		   PRIME_LOG(LOG_DEBUG, "No PRIME SN present\r\n");
 	  }else{
-	     pthread_mutex_lock(&prime_network_mutex);
+	     prime_network_read_lock();
        list_for_each_safe(entry, tmp, p_prime_network) {
           p_prime_sn = list_entry(entry, prime_sn, list);
           prime_network_print_sn(p_prime_sn);
        }
-       pthread_mutex_unlock(&prime_network_mutex);
+       prime_network_read_unlock();
     }
 }
 
@@ -494,7 +801,7 @@ int prime_sn_del_mac_connections(prime_sn *sn)
  *       Code                                             *
  *********************************************************/
      PRIME_LOG(LOG_INFO, "Deleting MAC Connections for PRIME SN 0x%s\r\n",eui48_to_str(sn->regEntryID,NULL));
-     //pthread_mutex_lock(&prime_network_mutex);   // Not needed because must be locked before for getting the Service Node
+     //prime_network_mutex_lock();   // Not needed because must be locked before for getting the Service Node
      /// Free Memory on MAC Connection List
      list_for_each_safe(entry, tmp, &sn->macConnList) {
          p_mac_conn = list_entry(entry, mac_conn, list);
@@ -502,7 +809,7 @@ int prime_sn_del_mac_connections(prime_sn *sn)
             free(p_mac_conn);
      }
      sn->macConns = 0;
-     //pthread_mutex_unlock(&prime_network_mutex); // Not needed because must be locked before for getting the Service Node
+     //prime_network_mutex_unlock(); // Not needed because must be locked before for getting the Service Node
      return 0;
 }
 
@@ -551,6 +858,13 @@ struct TmacGetConfirm x_pib_confirm;
     // Initialize PRIME Network List
     INIT_LIST_HEAD(&prime_network);
     prime_network_sn = 0;
+    // Initialize Lookup Indexes
+    pthread_mutex_lock(&prime_network_index_mutex);
+    memset(prime_sn_hash_eui48, 0, sizeof(prime_sn_hash_eui48));
+    memset(prime_sn_hash_lsid, 0, sizeof(prime_sn_hash_lsid));
+    memset(prime_sn_hash_lnid, 0, sizeof(prime_sn_hash_lnid));
+    memset(prime_sn_hash_cl432, 0, sizeof(prime_sn_hash_cl432));
+    pthread_mutex_unlock(&prime_network_index_mutex);
 
     // Add Base Node Device itself
 
@@ -67,6 +67,9 @@ typedef enum {
 
 #define CL_432_INVALID_ADDRESS       (0xFFFF)
 
+/* Maximum Number of PRIME Service Nodes on the PRIME Network */
+#define NUM_MAX_PRIME_SN             2000
+
  /* MAC Connection Information */
 struct __attribute__((__packed__)) mac_conn_list_t{     // List of MAC Connections
     mchp_list list;               // LIST
@@ -131,22 +134,76 @@ struct __attribute__((__packed__)) prime_sn_t{     // List of registered devices
    // From 4-32 Connection List
    cl432_conn  cl432Conn;         // 4-32 Connection Information
    uint8_t     autoclose_enabled; // 4-32 Autoclose Enabled
+   // Lookup Index Chains (owned by base_node_network.c)
+   struct prime_sn_t *p_next_eui48; // Next SN on EUI48 hash bucket
+   struct prime_sn_t *p_next_lsid;  // Next SN on LSID hash bucket
+   struct prime_sn_t *p_next_lnid;  // Next SN on LNID hash bucket
+   struct prime_sn_t *p_next_cl432; // Next SN on CL4-32 address hash bucket
+   uint8_t     in_use;            // Entry linked on prime_network (cleared on delete)
  };
 typedef struct prime_sn_t prime_sn;
 
 /*
- * \brief PRIME Network Mutex Lock
+ * PRIME Network concurrency
+ *
+ * Writers serialize on a reader-writer lock and bump a sequence counter
+ * (odd while the model is being changed). Readers either:
+ *  - take the shared read lock to walk prime_network (show commands), or
+ *  - copy a single SN with prime_network_get_sn(), which never blocks:
+ *    it retries the copy if a writer ran meanwhile. SN entries live in
+ *    type-stable slabs, so a stale pointer never reaches freed memory.
+ * Writers must not do USI requests while holding the lock.
+ */
+
+/*
+ * \brief PRIME Network Write Lock (exclusive)
  * \return 0
  *
  */
  int prime_network_mutex_lock();
 
 /*
- * \brief PRIME Network Mutex Lock
+ * \brief PRIME Network Write Unlock
  * \return 0
  */
   int prime_network_mutex_unlock();
 
+/*
+ * \brief PRIME Network Read Lock (shared, for walking prime_network)
+ * \return 0
+ */
+ int prime_network_read_lock();
+
+/*
+ * \brief PRIME Network Read Unlock
+ * \return 0
+ */
+ int prime_network_read_unlock();
+
+/*
+ * \brief Begin a lock-free read of the PRIME Network
+ *
+ * \return Sequence to be checked with prime_network_read_retry()
+ */
+ uint32_t prime_network_read_begin();
+
+/*
+ * \brief Check if a lock-free read has to be repeated
+ * \param seq  Sequence returned by prime_network_read_begin()
+ *
+ * \return 1 if a writer modified the PRIME Network during the read
+ */
+ int prime_network_read_retry(uint32_t seq);
+
+/*
+ * \brief Get a consistent copy of a PRIME SN without locking
+ * \param p_prime_sn  -> PRIME SN Device Pointer (from a find function)
+ * \param p_copy      -> Copy of the PRIME SN (list pointers not usable)
+ *
+ * \return 0 if copied, -1 if the PRIME SN has been deleted
+ */
+ int prime_network_get_sn(const prime_sn *p_prime_sn, prime_sn *p_copy);
+
 /*
  * \brief Create a new PRIME SN
  * \param p_prime_network        -> PRIME SN List
@@ -194,6 +251,42 @@ prime_sn * prime_network_find_sn_lsid(mchp_list * p_prime_network, uint8_t lsid)
 */
 prime_sn * prime_network_find_sn_cl432_address(mchp_list * p_prime_network, uint16_t cl432_address);
 
+/*
+* \brief Look for a PRIME SN on the list for LNID
+* \param prime_sn_list       PRIME SN List
+* \param lnid                PRIME LNID
+*
+* \return Pointer to the PRIME SN Structure or NULL if doesn't exist
+*/
+prime_sn * prime_network_find_sn_lnid(mchp_list * p_prime_network, uint16_t lnid);
+
+/*
+ * \brief Set the LSID of a PRIME SN keeping the lookup index updated
+ * \param p_prime_sn  -> PRIME SN Device Pointer
+ * \param lsid        -> LSID allocated to the SN
+ *
+ * \return -
+ */
+void prime_network_set_sn_lsid(prime_sn *p_prime_sn, uint8_t lsid);
+
+/*
+ * \brief Set the LNID of a PRIME SN keeping the lookup index updated
+ * \param p_prime_sn  -> PRIME SN Device Pointer
+ * \param lnid        -> LNID allocated to the SN
+ *
+ * \return -
+ */
+void prime_network_set_sn_lnid(prime_sn *p_prime_sn, uint16_t lnid);
+
+/*
+ * \brief Set the CL4-32 address of a PRIME SN keeping the lookup index updated
+ * \param p_prime_sn    -> PRIME SN Device Pointer
+ * \param cl432_address -> CL4-32 Address (CL_432_INVALID_ADDRESS when closed)
+ *
+ * \return -
+ */
+void prime_network_set_sn_cl432_address(prime_sn *p_prime_sn, uint16_t cl432_address);
+
 /*
  * \brief Print List of PRIME SN
  * \param p_prime_network => PRIME SN linked list Pointer
@@ -69,12 +69,46 @@ extern "C" {
 *       Defines                                             *
 *************************************************************/
 #define DATABASE "/etc/config/prime_network_events.sql"
+/* Events waiting for the DB writer thread */
+#define NETWORK_EVENTS_QUEUE_LEN  1024
+/* Writer thread commits a transaction every BATCH_MS or BATCH_ROWS events */
+#define NETWORK_EVENTS_BATCH_MS   200
+#define NETWORK_EVENTS_BATCH_ROWS 64
+/* One EVENTS_YYYYMMDD table per UTC day, dropped whole when expired */
+#define NETWORK_EVENTS_PARTITION_FMT  "EVENTS_%04d%02d%02d"
+#define NETWORK_EVENTS_PARTITION_LEN  32
+#define NETWORK_EVENTS_FIRST          "EVENTS_0"
+#define NETWORK_EVENTS_LAST           "EVENTS_A"   /* Sorts after every partition */
+#define NETWORK_EVENTS_RETENTION_DAYS 30
+
+/* Queued Network Event */
+typedef struct {
+	uint64_t ull_ts;             /* ms since epoch, strictly increasing */
+	bmng_net_event_t x_event;
+} network_event_entry_t;
 /************************************************************
 *       Global Vars                                         *
 *************************************************************/
 static int prime_bmng_network_events_loglevel = PRIME_LOG_ERR;
 /* Mutex for accessing PRIME BMNG Network Events Database */
 pthread_mutex_t prime_bmng_network_events_mutex = PTHREAD_MUTEX_INITIALIZER;
+/* Long-lived Database connection, only used by the writer thread */
+static sqlite3 *s_px_db = NULL;
+static sqlite3_stmt *s_px_insert_stmt = NULL;
+/* Partition s_px_insert_stmt inserts into */
+static char s_sz_partition[NETWORK_EVENTS_PARTITION_LEN];
+/* Last timestamp given to an event */
+static uint64_t s_ull_last_ts = 0;
+/* Days of events kept on the Database */
+static uint16_t s_us_retention_days = NETWORK_EVENTS_RETENTION_DAYS;
+static bool s_b_retention_pending = false;
+/* Bounded event queue between the USI callback and the writer thread */
+static network_event_entry_t s_x_queue[NETWORK_EVENTS_QUEUE_LEN];
+static uint16_t s_us_queue_head = 0;
+static uint16_t s_us_queue_count = 0;
+static uint32_t s_ul_queue_dropped = 0;
+static bool s_b_remove_pending = false;
+static pthread_cond_t s_x_queue_cond = PTHREAD_COND_INITIALIZER;
 
 /************************************************************
 *       External Global Vars                                *
@@ -124,93 +158,600 @@ int prime_bmng_network_events_mutex_unlock()
 }
 
 /*
- * \brief  PRIME Network Events Data Access Object
- * \param  cmd      DB Command
- * \param  event    Pointer to Network Event Structure
- * \return      integer
+ * \brief  Partition table name for a timestamp (one partition per UTC day)
+ * \param  ull_ts   Timestamp in ms since epoch
+ * \param  sz_name  Destination, NETWORK_EVENTS_PARTITION_LEN bytes
+ * \return sz_name
  */
-int prime_network_events_db_dao (int cmd, bmng_net_event_t *event) //, sort sortby)
+static char * _network_events_partition_name(uint64_t ull_ts, char *sz_name)
 {
-	FILE *filedb;
-	sqlite3 *db;
-	char sql_query[256];
+	time_t x_time = (time_t)(ull_ts / 1000);
+	struct tm x_tm;
+
+	gmtime_r(&x_time, &x_tm);
+	snprintf(sz_name, NETWORK_EVENTS_PARTITION_LEN, NETWORK_EVENTS_PARTITION_FMT,
+	         (x_tm.tm_year + 1900) % 10000, x_tm.tm_mon + 1, x_tm.tm_mday);
+	return sz_name;
+}
+
+/*
+ * \brief  Current time in ms since epoch
+ */
+static uint64_t _network_events_now_ms(void)
+{
+	struct timespec x_now;
+
+	clock_gettime(CLOCK_REALTIME, &x_now);
+	return ((uint64_t)x_now.tv_sec * 1000) + (x_now.tv_nsec / 1000000);
+}
+
+/*
+ * \brief  Build a UNION ALL over the partitions between two partition names
+ * \param  db        SQLite connection
+ * \param  sz_select Per-partition SELECT, '%s' is replaced by the partition name
+ * \param  sz_first  First partition (NETWORK_EVENTS_FIRST for all)
+ * \param  sz_last   Last partition (NETWORK_EVENTS_LAST for all)
+ * \return SQL allocated with sqlite3_mprintf (NULL if no partition matches)
+ */
+static char * _network_events_partitions_sql(sqlite3 *db, const char *sz_select, const char *sz_first, const char *sz_last)
+{
+	sqlite3_stmt *px_stmt;
+	char *sql = NULL;
+	const char *sz_name;
+
+	if (sqlite3_prepare_v2(db, "SELECT name FROM sqlite_master WHERE type='table' AND name GLOB 'EVENTS_[0-9]*' "
+	                           "AND name BETWEEN ?1 AND ?2 ORDER BY name;", -1, &px_stmt, NULL) != SQLITE_OK){
+		 PRIME_NETWORK_EVENTS_LOG(LOG_ERR,"SQL error: %s\n", sqlite3_errmsg(db));
+		 return NULL;
+	}
+	sqlite3_bind_text(px_stmt, 1, sz_first, -1, SQLITE_STATIC);
+	sqlite3_bind_text(px_stmt, 2, sz_last, -1, SQLITE_STATIC);
+	while (sqlite3_step(px_stmt) == SQLITE_ROW){
+		 sz_name = (const char *)sqlite3_column_text(px_stmt, 0);
+		 if (sql == NULL){
+				sql = sqlite3_mprintf(sz_select, sz_name);
+		 }else{
+				sql = sqlite3_mprintf("%z UNION ALL %z", sql, sqlite3_mprintf(sz_select, sz_name));
+		 }
+	}
+	sqlite3_finalize(px_stmt);
+	return sql;
+}
+
+/*
+ * \brief  Recreate the EVENTS view over all the partitions
+ *         (keeps "SELECT * FROM EVENTS" working for external tools)
+ * \param  db       SQLite connection
+ */
+static void _network_events_db_view(sqlite3 *db)
+{
+	char *sql;
+
+	sqlite3_exec(db, "DROP VIEW IF EXISTS EVENTS;", NULL, 0, NULL);
+	sql = _network_events_partitions_sql(db, "SELECT * FROM %s", NETWORK_EVENTS_FIRST, NETWORK_EVENTS_LAST);
+	if (sql != NULL){
+		 sql = sqlite3_mprintf("CREATE VIEW EVENTS AS %z;", sql);
+		 sqlite3_exec(db, sql, NULL, 0, NULL);
+		 sqlite3_free(sql);
+	}
+}
+
+/*
+ * \brief  Drop whole partitions: no row by row DELETE nor VACUUM
+ * \param  db         SQLite connection
+ * \param  sz_before  Drop partitions older than this one (NULL: drop all)
+ */
+static void _network_events_db_drop(sqlite3 *db, const char *sz_before)
+{
+	sqlite3_stmt *px_stmt;
 	char *sql;
+	bool b_dropped = false;
+
+	if (sqlite3_prepare_v2(db, "SELECT name FROM sqlite_master WHERE type='table' AND name GLOB 'EVENTS_[0-9]*' "
+	                           "AND name < ?1 ORDER BY name LIMIT 1;", -1, &px_stmt, NULL) != SQLITE_OK){
+		 PRIME_NETWORK_EVENTS_LOG(LOG_ERR,"SQL error: %s\n", sqlite3_errmsg(db));
+		 return;
+	}
+	sqlite3_bind_text(px_stmt, 1, (sz_before != NULL) ? sz_before : NETWORK_EVENTS_LAST, -1, SQLITE_STATIC);
+	while (sqlite3_step(px_stmt) == SQLITE_ROW){
+		 sql = sqlite3_mprintf("DROP TABLE %s;", (const char *)sqlite3_column_text(px_stmt, 0));
+		 sqlite3_reset(px_stmt);
+		 if (sqlite3_exec(db, sql, NULL, 0, NULL) != SQLITE_OK){
+				PRIME_NETWORK_EVENTS_LOG(LOG_ERR,"SQL error: %s\n", sqlite3_errmsg(db));
+				sqlite3_free(sql);
+				break;
+		 }
+		 PRIME_NETWORK_EVENTS_LOG(LOG_INFO,"Network Events partition dropped: %s\r\n", sql);
+		 sqlite3_free(sql);
+		 b_dropped = true;
+	}
+	sqlite3_finalize(px_stmt);
+	if (b_dropped){
+		 _network_events_db_view(db);
+		 /* Give freed pages back to the filesystem in small steps */
+		 sqlite3_exec(db, "PRAGMA incremental_vacuum(1024);", NULL, 0, NULL);
+	}
+}
+
+/*
+ * \brief  Drop the partitions older than the retention period
+ * \param  db       SQLite connection
+ * \param  ull_now  Current timestamp (ms)
+ */
+static void _network_events_db_retention(sqlite3 *db, uint64_t ull_now)
+{
+	char sz_oldest[NETWORK_EVENTS_PARTITION_LEN];
+
+	_network_events_partition_name(ull_now - ((uint64_t)s_us_retention_days * 86400000ULL), sz_oldest);
+	_network_events_db_drop(db, sz_oldest);
+}
+
+/*
+ * \brief  Create (if needed) the partition for a timestamp and prepare the insert on it
+ * \param  db       SQLite connection
+ * \param  ull_ts   Timestamp (ms) of the events to insert
+ * \return SQLITE_OK or SQLite error
+ */
+static int _network_events_db_partition(sqlite3 *db, uint64_t ull_ts)
+{
+	char sz_name[NETWORK_EVENTS_PARTITION_LEN];
+	char *error = 0;
+	char *sql;
+	int res;
+
+	_network_events_partition_name(ull_ts, sz_name);
+	if ((s_px_insert_stmt != NULL) && (strcmp(sz_name, s_sz_partition) == 0))
+		 return SQLITE_OK;
+	/* ts is the rowid: partitions are stored in time order */
+	sql = sqlite3_mprintf("CREATE TABLE IF NOT EXISTS %s ("
+				 "`ts` INTEGER PRIMARY KEY, "
+				 "`event` TEXT, "
+				 "`eui48` TEXT, "
+				 "`lnid` NUMBER, "
+				 "`lsid` NUMBER, "
+				 "`sid` NUMBER, "
+				 "`alvRxcnt` NUMBER, "
+				 "`alvTxcnt` NUMBER, "
+				 "`alvTime` NUMBER);"
+				 "CREATE INDEX IF NOT EXISTS %s_eui48 ON %s (eui48, ts);"
+				 "CREATE INDEX IF NOT EXISTS %s_event ON %s (event, ts);",
+				 sz_name, sz_name, sz_name, sz_name, sz_name);
+	res = sqlite3_exec(db, sql, NULL, 0, &error);
+	sqlite3_free(sql);
+	if (res != SQLITE_OK){
+		 PRIME_NETWORK_EVENTS_LOG(LOG_ERR,"Error creating SQL Network Events partition %s: %s\r\n", sz_name, error);
+		 sqlite3_free(error);
+		 return res;
+	}
+	sqlite3_finalize(s_px_insert_stmt);
+	sql = sqlite3_mprintf("INSERT INTO %s VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?);", sz_name);
+	res = sqlite3_prepare_v2(db, sql, -1, &s_px_insert_stmt, NULL);
+	sqlite3_free(sql);
+	if (res != SQLITE_OK){
+		 PRIME_NETWORK_EVENTS_LOG(LOG_ERR,"Error preparing SQL Network Events insert: %s\r\n", sqlite3_errmsg(db));
+		 s_px_insert_stmt = NULL;
+		 return res;
+	}
+	strcpy(s_sz_partition, sz_name);
+	PRIME_NETWORK_EVENTS_LOG(LOG_INFO,"Network Events partition %s\r\n", sz_name);
+	/* New day: expire old partitions and expose the new one on the view */
+	_network_events_db_retention(db, ull_ts);
+	_network_events_db_view(db);
+	return SQLITE_OK;
+}
+
+/*
+ * \brief  Prepare the Network Events Database
+ *         Renames the old unpartitioned EVENTS table, creates the
+ *         current partition and seeds the monotonic timestamp
+ * \param  db       SQLite connection
+ * \return SQLITE_OK or SQLite error
+ */
+static int _network_events_db_prepare(sqlite3 *db)
+{
+	sqlite3_stmt *px_stmt;
+	char *error = 0;
+	char *sql;
+	bool b_legacy = false;
+	int res;
+
+	/* Must be set before the first table is created to take effect */
+	sqlite3_exec(db, "PRAGMA auto_vacuum=INCREMENTAL;", NULL, 0, NULL);
+	/* WAL: readers (VTY, external tools) do not block the writer thread */
+	res = sqlite3_exec(db, "PRAGMA journal_mode=WAL; PRAGMA synchronous=NORMAL;", NULL, 0, &error);
+	if (res != SQLITE_OK){
+		 PRIME_NETWORK_EVENTS_LOG(LOG_ERR,"SQL error setting WAL mode: %s\n", error);
+		 sqlite3_free(error);
+	}
+	/* Databases from previous versions: keep their rows apart, without timestamp */
+	if (sqlite3_prepare_v2(db, "SELECT 1 FROM sqlite_master WHERE type='table' AND name='EVENTS';", -1, &px_stmt, NULL) == SQLITE_OK){
+		 b_legacy = (sqlite3_step(px_stmt) == SQLITE_ROW);
+		 sqlite3_finalize(px_stmt);
+	}
+	if (b_legacy){
+		 sqlite3_exec(db, "ALTER TABLE EVENTS RENAME TO EVENTS_LEGACY;", NULL, 0, NULL);
+		 PRIME_NETWORK_EVENTS_LOG(LOG_INFO,"SQL Network Events table renamed to EVENTS_LEGACY\r\n");
+	}
+	res = _network_events_db_partition(db, _network_events_now_ms());
+	if (res != SQLITE_OK)
+		 return res;
+	/* Timestamps must keep growing even if the clock went back across a restart */
+	sql = _network_events_partitions_sql(db, "SELECT MAX(ts) AS m FROM %s", NETWORK_EVENTS_FIRST, NETWORK_EVENTS_LAST);
+	if (sql != NULL){
+		 sql = sqlite3_mprintf("SELECT MAX(m) FROM (SELECT 0 AS m UNION ALL %z);", sql);
+		 if (sqlite3_prepare_v2(db, sql, -1, &px_stmt, NULL) == SQLITE_OK){
+				if (sqlite3_step(px_stmt) == SQLITE_ROW)
+					 s_ull_last_ts = (uint64_t)sqlite3_column_int64(px_stmt, 0);
+				sqlite3_finalize(px_stmt);
+		 }
+		 sqlite3_free(sql);
+	}
+	return SQLITE_OK;
+}
+
+/*
+ * \brief  Insert one Network Event with the prepared statement
+ * \param  entry    Pointer to queued Network Event
+ * \return SQLITE_DONE or SQLite error
+ */
+static int _network_events_db_insert(network_event_entry_t *entry)
+{
+	bmng_net_event_t *event = &entry->x_event;
+	char sz_event[16];
+	char sz_eui48[(EUI48_LEN << 1) + 1];
+	int res;
+
+	res = _network_events_db_partition(s_px_db, entry->ull_ts);
+	if (res != SQLITE_OK)
+		 return res;
+	network_event_to_str(event->net_event, sz_event);
+	eui48_to_str(event->mac, sz_eui48);
+	sqlite3_bind_int64(s_px_insert_stmt, 1, (sqlite3_int64)entry->ull_ts);
+	sqlite3_bind_text(s_px_insert_stmt, 2, sz_event, -1, SQLITE_TRANSIENT);
+	sqlite3_bind_text(s_px_insert_stmt, 3, sz_eui48, -1, SQLITE_TRANSIENT);
+	sqlite3_bind_int(s_px_insert_stmt, 4, event->lnid);
+	sqlite3_bind_int(s_px_insert_stmt, 5, event->lsid);
+	sqlite3_bind_int(s_px_insert_stmt, 6, event->sid);
+	sqlite3_bind_int(s_px_insert_stmt, 7, event->alvRxcnt);
+	sqlite3_bind_int(s_px_insert_stmt, 8, event->alvTxcnt);
+	sqlite3_bind_int(s_px_insert_stmt, 9, event->alvTime);
+	res = sqlite3_step(s_px_insert_stmt);
+	if (res != SQLITE_DONE){
+		 PRIME_NETWORK_EVENTS_LOG(LOG_ERR,"SQL error: %s\n", sqlite3_errmsg(s_px_db));
+	}
+	sqlite3_reset(s_px_insert_stmt);
+	return res;
+}
+
+/*
+ * \brief  Network Events DB writer thread
+ *         Drains the event queue in transactions of up to
+ *         NETWORK_EVENTS_BATCH_ROWS rows, at least every
+ *         NETWORK_EVENTS_BATCH_MS milliseconds
+ */
+static void * _network_events_db_thread(void *arg)
+{
+	network_event_entry_t x_batch[NETWORK_EVENTS_BATCH_ROWS];
+	struct timespec x_deadline;
+	uint16_t us_rows, us_i;
+	bool b_remove, b_retention;
 	char *error = 0;
-	bool exists = false;
+
+	(void)arg;
+	while (1){
+		 prime_bmng_network_events_mutex_lock();
+		 clock_gettime(CLOCK_REALTIME, &x_deadline);
+		 x_deadline.tv_nsec += NETWORK_EVENTS_BATCH_MS * 1000000L;
+		 if (x_deadline.tv_nsec >= 1000000000L){
+				x_deadline.tv_sec++;
+				x_deadline.tv_nsec -= 1000000000L;
+		 }
+		 /* Wait for a full batch or the batch period, whatever comes first */
+		 while ((s_us_queue_count < NETWORK_EVENTS_BATCH_ROWS) && !s_b_remove_pending && !s_b_retention_pending){
+				if (pthread_cond_timedwait(&s_x_queue_cond, &prime_bmng_network_events_mutex, &x_deadline) != 0)
+					 break;
+		 }
+		 us_rows = 0;
+		 while ((s_us_queue_count > 0) && (us_rows < NETWORK_EVENTS_BATCH_ROWS)){
+				x_batch[us_rows++] = s_x_queue[s_us_queue_head];
+				s_us_queue_head = (s_us_queue_head + 1) % NETWORK_EVENTS_QUEUE_LEN;
+				s_us_queue_count--;
+		 }
+		 b_remove = s_b_remove_pending;
+		 s_b_remove_pending = false;
+		 b_retention = s_b_retention_pending;
+		 s_b_retention_pending = false;
+		 prime_bmng_network_events_mutex_unlock();
+
+		 if (us_rows > 0){
+				sqlite3_exec(s_px_db, "BEGIN;", NULL, 0, NULL);
+				for (us_i = 0; us_i < us_rows; us_i++){
+					 _network_events_db_insert(&x_batch[us_i]);
+				}
+				if (sqlite3_exec(s_px_db, "COMMIT;", NULL, 0, &error) != SQLITE_OK){
+					 PRIME_NETWORK_EVENTS_LOG(LOG_ERR,"SQL error: %s\n", error);
+					 sqlite3_free(error);
+					 sqlite3_exec(s_px_db, "ROLLBACK;", NULL, 0, NULL);
+				}else{
+					 PRIME_NETWORK_EVENTS_LOG(LOG_INFO,"Inserted %d Network Events on SQL Database\r\n", us_rows);
+				}
+		 }
+		 if (b_remove){
+				/* Drop every partition, the insert statement is prepared again on the next event */
+				sqlite3_finalize(s_px_insert_stmt);
+				s_px_insert_stmt = NULL;
+				sqlite3_exec(s_px_db, "DROP TABLE IF EXISTS EVENTS_LEGACY;", NULL, 0, NULL);
+				_network_events_db_drop(s_px_db, NULL);
+				_network_events_db_partition(s_px_db, _network_events_now_ms());
+				PRIME_NETWORK_EVENTS_LOG(LOG_INFO,"Network Event SQL Database cleaned\r\n");
+		 }
+		 if (b_retention){
+				_network_events_db_retention(s_px_db, _network_events_now_ms());
+		 }
+	}
+	return NULL;
+}
+
+/*
+ * \brief  Open the PRIME Network Events Database and start the writer thread
+ * \return SUCCESS or -1
+ */
+int prime_network_events_db_init()
+{
+	pthread_t x_thread;
+	pthread_attr_t x_thread_attr;
 	int res;
 
-  sql = &sql_query[0];
-  /* Check if Database exists */
-  if ((filedb = fopen(DATABASE, "r"))){
-        fclose(filedb);
-        exists = true;
-  }
-	/* Open Database */
+	if (s_px_db != NULL)
+		 return SUCCESS;
 	sqlite3_initialize();
-	res = sqlite3_open(DATABASE,&db);
+	res = sqlite3_open(DATABASE, &s_px_db);
 	if (res != SQLITE_OK){
 		 /* Error creating/openning SQL Database */
-		 PRIME_NETWORK_EVENTS_LOG(LOG_ERR,"ERROR creating/opening SQLite DB in memory: %s\n",sqlite3_errmsg(db));
+		 PRIME_NETWORK_EVENTS_LOG(LOG_ERR,"ERROR creating/opening SQLite DB: %s\n",sqlite3_errmsg(s_px_db));
+		 sqlite3_close(s_px_db);
+		 s_px_db = NULL;
 		 return -1;
 	}
-	/* Create Table if necessary */
-	if (!exists){
-//              "`timestamp` DATETIME, "
-		 sql = "CREATE TABLE EVENTS ("
-					 "`event` TEXT, "
-					 "`eui48` TEXT, "
-					 "`lnid` NUMBER, "
-					 "`lsid` NUMBER, "
-					 "`sid` NUMBER, "
-					 "`alvRxcnt` NUMBER, "
-					 "`alvTxcnt` NUMBER, "
-					 "`alvTime` NUMBER)";
-		/* Execute SQL statement */
-		res = sqlite3_exec(db, sql, NULL, 0, &error);
-		if (res != SQLITE_OK){
-			 PRIME_NETWORK_EVENTS_LOG(LOG_ERR,"Error creating SQL Network Events Table\r\n");
-			 sqlite3_free(error);
-		}
-		PRIME_NETWORK_EVENTS_LOG(LOG_INFO,"SQL Network Events Table created\r\n");
+	if (_network_events_db_prepare(s_px_db) != SQLITE_OK){
+		 sqlite3_close(s_px_db);
+		 s_px_db = NULL;
+		 return -1;
 	}
+	pthread_attr_init(&x_thread_attr);
+	pthread_attr_setdetachstate(&x_thread_attr, PTHREAD_CREATE_DETACHED);
+	if (pthread_create(&x_thread, &x_thread_attr, _network_events_db_thread, NULL)) {
+		 PRIME_NETWORK_EVENTS_LOG(LOG_ERR,"Error creating Network Events DB Thread\r\n");
+		 pthread_attr_destroy(&x_thread_attr);
+		 sqlite3_finalize(s_px_insert_stmt);
+		 sqlite3_close(s_px_db);
+		 s_px_db = NULL;
+		 return -1;
+	}
+	pthread_attr_destroy(&x_thread_attr);
+	return SUCCESS;
+}
 
+/*
+ * \brief  PRIME Network Events Data Access Object
+ *         Never touches the disk: events are queued for the writer thread
+ * \param  cmd      DB Command
+ * \param  event    Pointer to Network Event Structure
+ * \return 0 if queued, -1 if the database is not open or the queue is full
+ */
+int prime_network_events_db_dao (int cmd, bmng_net_event_t *event) //, sort sortby)
+{
+	network_event_entry_t *x_entry;
+	uint64_t ull_now;
+	int res = 0;
+
+	if (s_px_db == NULL)
+		 return -1;
+	prime_bmng_network_events_mutex_lock();
 	switch (cmd) {
 			case NEW_ENTRY:
-				// sprintf(sql_query,"INSERT INTO events VALUES (DATETIME(STRFTIME('%s','now'), 'unixepoch'), %s, %s, 0x%X, 0x%X, 0x%X, 0x%X, 0x%X, 0x%X)",
-			 sprintf(sql_query,"INSERT INTO EVENTS VALUES ('%s', '%s', %d, %d, %d, %d, %d, %d);",      \
-																																											 network_event_to_str(event->net_event, NULL),     \
-																																																		 eui48_to_str(event->mac, NULL),     \
-																																																												event->lnid,     \
-																																																												event->lsid,     \
-																																																												event->sid,      \
-																																																												event->alvRxcnt, \
-																																																												event->alvTxcnt, \
-																																																												event->alvTime);
-				res = sqlite3_exec(db, sql_query, NULL, 0, &error);
-				if (res != SQLITE_OK){
-						PRIME_NETWORK_EVENTS_LOG(LOG_ERR,"SQL error: %s\n", error);
-						sqlite3_free(error);
-				}else{
-						PRIME_NETWORK_EVENTS_LOG(LOG_INFO,"Inserted new Network Event on SQL Database\r\n");
+				if (s_us_queue_count == NETWORK_EVENTS_QUEUE_LEN){
+					 /* Disk is not keeping up: drop rather than stall the USI callback */
+					 if ((s_ul_queue_dropped++ % NETWORK_EVENTS_QUEUE_LEN) == 0){
+							PRIME_NETWORK_EVENTS_LOG(LOG_ERR,"Network Events queue full, %u events dropped\r\n", s_ul_queue_dropped);
+					 }
+					 res = -1;
+					 break;
 				}
+				x_entry = &s_x_queue[(s_us_queue_head + s_us_queue_count) % NETWORK_EVENTS_QUEUE_LEN];
+				/* Monotonic: never repeats nor goes back, even on clock steps */
+				ull_now = _network_events_now_ms();
+				s_ull_last_ts = (ull_now > s_ull_last_ts) ? ull_now : s_ull_last_ts + 1;
+				x_entry->ull_ts = s_ull_last_ts;
+				x_entry->x_event = *event;
+				s_us_queue_count++;
+				if (s_us_queue_count >= NETWORK_EVENTS_BATCH_ROWS)
+					 pthread_cond_signal(&s_x_queue_cond);
 				break;
 			case DB_REMOVE:
-				strcpy(sql_query,"DELETE from EVENTS; VACUUM;");
-				res = sqlite3_exec(db, sql_query, NULL, 0, &error);
-				if (res != SQLITE_OK){
-						PRIME_NETWORK_EVENTS_LOG(LOG_ERR,"SQL error: %s\n", error);
-						sqlite3_free(error);
-				}
-				PRIME_NETWORK_EVENTS_LOG(LOG_INFO,"Network Event SQL Database cleaned\r\n");
+				s_b_remove_pending = true;
+				pthread_cond_signal(&s_x_queue_cond);
 				break;
 			default:
 				break;
 	}
-	sqlite3_shutdown();
+	prime_bmng_network_events_mutex_unlock();
+	return res;
+}
+
+/*
+ * \brief  Open a read-only connection for a query (WAL: never blocks the writer)
+ * \return SQLite connection or NULL
+ */
+static sqlite3 * _network_events_db_open_ro(void)
+{
+	sqlite3 *db = NULL;
+
+	if (sqlite3_open_v2(DATABASE, &db, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK){
+		 PRIME_NETWORK_EVENTS_LOG(LOG_ERR,"ERROR opening SQLite DB: %s\n", sqlite3_errmsg(db));
+		 sqlite3_close(db);
+		 return NULL;
+	}
+	sqlite3_busy_timeout(db, NETWORK_EVENTS_BATCH_MS);
+	return db;
+}
+
+/*
+ * \brief  Query the Network Events of the last hours
+ *         Only the partitions of the time range are read, filters use
+ *         the (eui48, ts) and (event, ts) indexes
+ * \param  sz_eui48  EUI48 as stored (12 hex chars) or NULL for all nodes
+ * \param  sz_event  Event as stored (REGISTER, ALIVE...) or NULL for all events
+ * \param  ul_hours  Time range in hours back from now
+ * \param  ul_limit  Maximum rows, the most recent ones (0 no limit)
+ * \param  cb        Called for each event, oldest first
+ * \param  ctx       Callback context
+ * \return Number of events or -1
+ */
+int prime_network_events_db_query(const char *sz_eui48, const char *sz_event, uint32_t ul_hours, uint32_t ul_limit,
+                                  network_events_row_cb cb, void *ctx)
+{
+	sqlite3 *db;
+	sqlite3_stmt *px_stmt;
+	char sz_first[NETWORK_EVENTS_PARTITION_LEN];
+	char sz_last[NETWORK_EVENTS_PARTITION_LEN];
+	char *sz_select;
+	char *sql;
+	uint64_t ull_now, ull_from;
+	int res = 0;
+
+	db = _network_events_db_open_ro();
+	if (db == NULL)
+		 return -1;
+	ull_now = _network_events_now_ms();
+	ull_from = ull_now - ((uint64_t)ul_hours * 3600000ULL);
+	_network_events_partition_name(ull_from, sz_first);
+	_network_events_partition_name(ull_now, sz_last);
+	/* '%%s' survives this mprintf as the partition name placeholder */
+	sz_select = sqlite3_mprintf("SELECT ts, event, eui48, lnid, lsid, sid FROM %%s WHERE ts BETWEEN ?1 AND ?2%s%s",
+	                            (sz_eui48 != NULL) ? " AND eui48 = ?3" : "",
+	                            (sz_event != NULL) ? " AND event = ?4" : "");
+	sql = _network_events_partitions_sql(db, sz_select, sz_first, sz_last);
+	sqlite3_free(sz_select);
+	if (sql == NULL){
+		 sqlite3_close(db);
+		 return 0;
+	}
+	if (ul_limit > 0){
+		 /* Newest rows, given back in time order */
+		 sql = sqlite3_mprintf("SELECT * FROM (%z ORDER BY ts DESC LIMIT %u) ORDER BY ts;", sql, ul_limit);
+	}else{
+		 sql = sqlite3_mprintf("%z ORDER BY ts;", sql);
+	}
+	if (sqlite3_prepare_v2(db, sql, -1, &px_stmt, NULL) != SQLITE_OK){
+		 PRIME_NETWORK_EVENTS_LOG(LOG_ERR,"SQL error: %s\n", sqlite3_errmsg(db));
+		 sqlite3_free(sql);
+		 sqlite3_close(db);
+		 return -1;
+	}
+	sqlite3_free(sql);
+	sqlite3_bind_int64(px_stmt, 1, (sqlite3_int64)ull_from);
+	sqlite3_bind_int64(px_stmt, 2, (sqlite3_int64)ull_now);
+	if (sz_eui48 != NULL)
+		 sqlite3_bind_text(px_stmt, 3, sz_eui48, -1, SQLITE_STATIC);
+	if (sz_event != NULL)
+		 sqlite3_bind_text(px_stmt, 4, sz_event, -1, SQLITE_STATIC);
+	while (sqlite3_step(px_stmt) == SQLITE_ROW){
+		 cb(ctx, (uint64_t)sqlite3_column_int64(px_stmt, 0),
+		    (const char *)sqlite3_column_text(px_stmt, 1),
+		    (const char *)sqlite3_column_text(px_stmt, 2),
+		    (uint16_t)sqlite3_column_int(px_stmt, 3),
+		    (uint8_t)sqlite3_column_int(px_stmt, 4),
+		    (uint8_t)sqlite3_column_int(px_stmt, 5));
+		 res++;
+	}
+	sqlite3_finalize(px_stmt);
+	sqlite3_close(db);
+	return res;
+}
+
+/*
+ * \brief  Count the Network Events of the last hours per node and event
+ * \param  sz_eui48  EUI48 as stored (12 hex chars) or NULL for all nodes
+ * \param  ul_hours  Time range in hours back from now
+ * \param  cb        Called for each (node, event) pair
+ * \param  ctx       Callback context
+ * \return Number of (node, event) pairs or -1
+ */
+int prime_network_events_db_rate(const char *sz_eui48, uint32_t ul_hours, network_events_rate_cb cb, void *ctx)
+{
+	sqlite3 *db;
+	sqlite3_stmt *px_stmt;
+	char sz_first[NETWORK_EVENTS_PARTITION_LEN];
+	char sz_last[NETWORK_EVENTS_PARTITION_LEN];
+	char *sz_select;
+	char *sql;
+	uint64_t ull_now, ull_from;
+	int res = 0;
+
+	db = _network_events_db_open_ro();
+	if (db == NULL)
+		 return -1;
+	ull_now = _network_events_now_ms();
+	ull_from = ull_now - ((uint64_t)ul_hours * 3600000ULL);
+	_network_events_partition_name(ull_from, sz_first);
+	_network_events_partition_name(ull_now, sz_last);
+	sz_select = sqlite3_mprintf("SELECT eui48, event FROM %%s WHERE ts BETWEEN ?1 AND ?2%s",
+	                            (sz_eui48 != NULL) ? " AND eui48 = ?3" : "");
+	sql = _network_events_partitions_sql(db, sz_select, sz_first, sz_last);
+	sqlite3_free(sz_select);
+	if (sql == NULL){
+		 sqlite3_close(db);
+		 return 0;
+	}
+	sql = sqlite3_mprintf("SELECT eui48, event, COUNT(*) FROM (%z) GROUP BY eui48, event ORDER BY eui48, event;", sql);
+	if (sqlite3_prepare_v2(db, sql, -1, &px_stmt, NULL) != SQLITE_OK){
+		 PRIME_NETWORK_EVENTS_LOG(LOG_ERR,"SQL error: %s\n", sqlite3_errmsg(db));
+		 sqlite3_free(sql);
+		 sqlite3_close(db);
+		 return -1;
+	}
+	sqlite3_free(sql);
+	sqlite3_bind_int64(px_stmt, 1, (sqlite3_int64)ull_from);
+	sqlite3_bind_int64(px_stmt, 2, (sqlite3_int64)ull_now);
+	if (sz_eui48 != NULL)
+		 sqlite3_bind_text(px_stmt, 3, sz_eui48, -1, SQLITE_STATIC);
+	while (sqlite3_step(px_stmt) == SQLITE_ROW){
+		 cb(ctx, (const char *)sqlite3_column_text(px_stmt, 0),
+		    (const char *)sqlite3_column_text(px_stmt, 1),
+		    (uint32_t)sqlite3_column_int(px_stmt, 2));
+		 res++;
+	}
+	sqlite3_finalize(px_stmt);
 	sqlite3_close(db);
 	return res;
 }
 
+/*
+ * \brief  Set the days of Network Events kept on the Database
+ *         Older partitions are dropped by the writer thread
+ * \param  us_days  Retention in days
+ * \return 0
+ */
+int prime_network_events_db_set_retention(uint16_t us_days)
+{
+	prime_bmng_network_events_mutex_lock();
+	s_us_retention_days = us_days;
+	s_b_retention_pending = true;
+	pthread_cond_signal(&s_x_queue_cond);
+	prime_bmng_network_events_mutex_unlock();
+	return 0;
+}
+
+/*
+ * \brief  Get the days of Network Events kept on the Database
+ * \return Retention in days
+ */
+uint16_t prime_network_events_db_get_retention()
+{
+	return s_us_retention_days;
+}
+
 /**
 * \brief   Base Management Callback Network Event Indication
 *          Asyncronous events from PRIME Network - Cqan interfere normal use of USI Interface
@@ -263,8 +804,8 @@ void prime_bmng_network_event_msg_cb(bmng_net_event_t *px_net_event)
         }
         prime_network_mutex_lock();
         sn->state = SN_STATE_TERMINAL;
-        sn->regEntryLNID  = px_net_event->lnid;       // LNID allocated to this Node
-        sn->regEntryLSID  = px_net_event->lsid;       // SID Allocated to this Nodes
+        prime_network_set_sn_lnid(sn,px_net_event->lnid);       // LNID allocated to this Node
+        prime_network_set_sn_lsid(sn,px_net_event->lsid);       // SID Allocated to this Nodes
         sn->regEntrySID   = px_net_event->sid;        // SID of Switch through which this Node is connected
         sn->regEntryState = REGISTER_STATE_TERMINAL;  // Service Node Register State
         sn->alvRxcnt      = px_net_event->alvRxcnt;   // Alive Received Counter
@@ -285,8 +826,8 @@ void prime_bmng_network_event_msg_cb(bmng_net_event_t *px_net_event)
         }
         prime_network_mutex_lock();
         sn->state = SN_STATE_DISCONNECTED;
-        sn->regEntryLNID = px_net_event->lnid;       // LNID allocated to this Node
-        sn->regEntryLSID = px_net_event->lsid;       // SID Allocated to this Nodes
+        prime_network_set_sn_lnid(sn,px_net_event->lnid);       // LNID allocated to this Node
+        prime_network_set_sn_lsid(sn,px_net_event->lsid);       // SID Allocated to this Nodes
         sn->regEntrySID  = px_net_event->sid;        // SID of Switch through which this Node is connected
         sn->alvRxcnt     = px_net_event->alvRxcnt;   // Alive Received Counter
         sn->alvTxcnt     = px_net_event->alvTxcnt;   // Alive Transmitted Counter
@@ -307,8 +848,8 @@ void prime_bmng_network_event_msg_cb(bmng_net_event_t *px_net_event)
         }
         prime_network_mutex_lock();
         sn->state = SN_STATE_SWITCH;
-        sn->regEntryLNID  = px_net_event->lnid;       // LNID allocated to this Node
-        sn->regEntryLSID  = px_net_event->lsid;       // LSID Allocated to this Nodes
+        prime_network_set_sn_lnid(sn,px_net_event->lnid);       // LNID allocated to this Node
+        prime_network_set_sn_lsid(sn,px_net_event->lsid);       // LSID Allocated to this Nodes
         sn->regEntrySID   = px_net_event->sid;        // SID of Switch through which this Node is connected
         sn->regEntryState = REGISTER_STATE_SWITCH;    // SID of Switch through which this Node is connected
         sn->alvRxcnt      = px_net_event->alvRxcnt;   // Alive Received Counter
@@ -327,8 +868,8 @@ void prime_bmng_network_event_msg_cb(bmng_net_event_t *px_net_event)
         }
         prime_network_mutex_lock();
         sn->state = SN_STATE_TERMINAL;
-        sn->regEntryLNID  = px_net_event->lnid;       // LNID allocated to this Node
-        sn->regEntryLSID  = px_net_event->lsid;       // LSID Allocated to this Nodes
+        prime_network_set_sn_lnid(sn,px_net_event->lnid);       // LNID allocated to this Node
+        prime_network_set_sn_lsid(sn,px_net_event->lsid);       // LSID Allocated to this Nodes
         sn->regEntrySID   = px_net_event->sid;        // SID of Switch through which this Node is connected
         sn->regEntryState = REGISTER_STATE_TERMINAL;  // Register State Terminal
         sn->alvRxcnt      = px_net_event->alvRxcnt;   // Alive Received Counter
@@ -347,8 +888,8 @@ void prime_bmng_network_event_msg_cb(bmng_net_event_t *px_net_event)
            // sn->state = SN_STATE_TERMINAL;
         }
         prime_network_mutex_lock();
-        sn->regEntryLNID = px_net_event->lnid;       // LNID allocated to this Node
-        sn->regEntryLSID = px_net_event->lsid;       // LSID Allocated to this Nodes
+        prime_network_set_sn_lnid(sn,px_net_event->lnid);       // LNID allocated to this Node
+        prime_network_set_sn_lsid(sn,px_net_event->lsid);       // LSID Allocated to this Nodes
         sn->regEntrySID  = px_net_event->sid;        // SID of Switch through which this Node is connected
         sn->alvRxcnt     = px_net_event->alvRxcnt;   // Alive Received Counter
         sn->alvTxcnt     = px_net_event->alvTxcnt;   // Alive Transmitted Counter
@@ -89,6 +89,61 @@ int prime_bmng_network_events_mutex_lock();
  */
 int prime_bmng_network_events_mutex_unlock();
 
+/*
+ * \brief  Open the PRIME Network Events Database and start the writer thread
+ * \return 0 if success, -1 otherwise
+ */
+int prime_network_events_db_init();
+
+/*
+ * \brief  PRIME Network Events Data Access Object (queued, never blocks on disk)
+ * \param  cmd      DB Command (NEW_ENTRY/DB_REMOVE)
+ * \param  event    Pointer to Network Event Structure
+ * \return 0 if queued, -1 otherwise
+ */
+int prime_network_events_db_dao(int cmd, bmng_net_event_t *event);
+
+/* Network Events query callbacks */
+typedef void (*network_events_row_cb)(void *ctx, uint64_t ull_ts, const char *sz_event, const char *sz_eui48,
+                                      uint16_t us_lnid, uint8_t uc_lsid, uint8_t uc_sid);
+typedef void (*network_events_rate_cb)(void *ctx, const char *sz_eui48, const char *sz_event, uint32_t ul_count);
+
+/*
+ * \brief  Query the Network Events of the last hours, oldest first
+ * \param  sz_eui48  EUI48 (12 hex chars) or NULL for all nodes
+ * \param  sz_event  Event (REGISTER, ALIVE...) or NULL for all events
+ * \param  ul_hours  Time range in hours back from now
+ * \param  ul_limit  Maximum rows, the most recent ones (0 no limit)
+ * \param  cb        Called for each event
+ * \param  ctx       Callback context
+ * \return Number of events or -1
+ */
+int prime_network_events_db_query(const char *sz_eui48, const char *sz_event, uint32_t ul_hours, uint32_t ul_limit,
+                                  network_events_row_cb cb, void *ctx);
+
+/*
+ * \brief  Count the Network Events of the last hours per node and event
+ * \param  sz_eui48  EUI48 (12 hex chars) or NULL for all nodes
+ * \param  ul_hours  Time range in hours back from now
+ * \param  cb        Called for each (node, event) pair
+ * \param  ctx       Callback context
+ * \return Number of (node, event) pairs or -1
+ */
+int prime_network_events_db_rate(const char *sz_eui48, uint32_t ul_hours, network_events_rate_cb cb, void *ctx);
+
+/*
+ * \brief  Set the days of Network Events kept on the Database
+ * \param  us_days  Retention in days
+ * \return 0
+ */
+int prime_network_events_db_set_retention(uint16_t us_days);
+
+/*
+ * \brief  Get the days of Network Events kept on the Database
+ * \return Retention in days
+ */
+uint16_t prime_network_events_db_get_retention();
+
 /**
 * \brief   Base Management Callback Network Event Indication
 *          Asyncronous events from PRIME Network - Cqan interfere normal use of USI Interface
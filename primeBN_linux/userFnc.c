@@ -55,6 +55,7 @@ extern "C" {
 #include <netdb.h>
 #include <arpa/inet.h>
 
+#include <sys/uio.h>
 #include <termios.h> // POSIX terminal control definitions
 #include "../src/Usi.h"
 #include "../src/UsiCfg.h"
@@ -213,6 +214,51 @@ uint16_t addUsi_TxMsg(uint8_t port_type, uint8_t port_number, uint8_t *sz_msg, u
 	return (ret > 0)? ret: SUCCESS;
 }
 
+/*
+ * \brief	This function transmits several buffers through the interface
+ *        with a single system call.
+ *
+ * \param	port_type	  Serial Port Type
+ * \param port_number Serial Port Number
+ * \param	iov			    Buffers to be sent, in order
+ * \param	iovcnt		  Number of buffers
+ *
+ * \return	number of bytes written in the output buffer
+ */
+uint16_t addUsi_TxMsgV(uint8_t port_type, uint8_t port_number, const struct iovec *iov, uint8_t iovcnt)
+{
+	int32_t fd;
+	ssize_t ret;
+	size_t j;
+	uint8_t k;
+
+#ifdef CONFIG_GLOBAL_FD_SERIAL_PORT
+	fd = fd_serial_port;
+#else
+  uint32_t i;
+  /* Look for File descriptor associated to serial port */
+	fd = 0;
+	for (i=0;i<MAX_USI_PORTS;i++){
+	    if ((usi_ports[i].port_type == port_type) && (usi_ports[i].port_number == port_number)){
+         fd=usi_ports[i].fd;
+		  }
+	}
+	if (fd <= 0){
+			return SUCCESS;
+	}
+#endif
+	/* write all buffers to tty */
+	fprintf(stderr,"[USI] >> 0x");
+	for (k=0;k<iovcnt;k++){
+		for (j=0;j<iov[k].iov_len;j++){
+			fprintf(stderr,"%02X",((const uint8_t *)iov[k].iov_base)[j]);
+		}
+	}
+	fprintf(stderr,"\r\n"); fflush(stderr);
+	ret = writev(fd, iov, iovcnt);
+	return (ret > 0)? ret: SUCCESS;
+}
+
 /*
  * \brief	This function reads a character from the UART.
  *
@@ -247,6 +293,64 @@ int8_t addUsi_RxChar(uint8_t port_type, uint8_t port_number, uint8_t *c)
 	return (ret > 0) ? SUCCESS : -1;
 }
 
+/*
+ * \brief	This function reads a block of characters from the UART.
+ *
+ * \param	port_type	  Port Type to read from
+ * \param	port_number	Port Number to read from
+ * \param	buf			    Buffer to store characters read.
+ * \param	maxlen		  Size of buffer.
+ *
+ * \return  	        number of characters read, 0 if none
+ */
+uint16_t addUsi_RxBlock(uint8_t port_type, uint8_t port_number, uint8_t *buf, uint16_t maxlen)
+{
+	int32_t fd, ret;
+
+#ifdef CONFIG_GLOBAL_FD_SERIAL_PORT
+	fd = fd_serial_port;
+#else
+  uint32_t i;
+  /* Look for File descriptor associated to serial port */
+	fd = 0;
+	for (i=0;i<MAX_USI_PORTS;i++){
+	    if ((usi_ports[i].port_type == port_type) && (usi_ports[i].port_number == port_number)){
+         fd=usi_ports[i].fd;
+		  }
+	}
+	if (fd <= 0){
+			return 0;
+	}
+#endif
+	/* Read all available bytes from tty, up to maxlen */
+	ret = read(fd, buf, maxlen);
+	return (ret > 0) ? ret : 0;
+}
+
+/*
+ * \brief	This function gets the file descriptor of the port.
+ *
+ * \param	port_type	  Port Type
+ * \param	port_number	Port Number
+ *
+ * \return  	        file descriptor, -1 if port is not open
+ */
+int32_t addUsi_GetFd(uint8_t port_type, uint8_t port_number)
+{
+#ifdef CONFIG_GLOBAL_FD_SERIAL_PORT
+	return (fd_serial_port > 0) ? fd_serial_port : -1;
+#else
+  uint32_t i;
+  /* Look for File descriptor associated to serial port */
+	for (i=0;i<num_usi_ports;i++){
+	    if ((usi_ports[i].port_type == port_type) && (usi_ports[i].port_number == port_number)){
+         return usi_ports[i].fd;
+		  }
+	}
+	return -1;
+#endif
+}
+
 /*
  * \brief	Open TTY serial.
  *
@@ -11,6 +11,7 @@
 #include <netdb.h>
 #include <arpa/inet.h>
 
+#include <sys/uio.h>
 #include <termios.h> /* POSIX terminal control definitions */
 
 #include "debug.h"
@@ -70,6 +71,19 @@ uint16_t addUsi_TxMsg(uint8_t port_type, uint8_t port, uint8_t *sz_msg, uint16_t
 	return write(g_usi_fd, sz_msg, i_msglen);
 }
 
+/**@brief Transmit several buffers through the interface in one call
+  @param port: port number configured in PrjCfg.h
+  @param iov: buffers to send, in order
+  @param iovcnt: number of buffers
+  @return the number of bytes written.
+*/
+uint16_t addUsi_TxMsgV(uint8_t port_type, uint8_t port, const struct iovec *iov, uint8_t iovcnt)
+{
+	/* write all buffers to tty */
+	ssize_t ret = writev(g_usi_fd, iov, iovcnt);
+	return (ret > 0) ? ret : 0;
+}
+
 /**@brief Read char from port
   @param port: port number configured in PrjCfg.h
   @param c: pointer to a character
@@ -86,6 +100,23 @@ int8_t addUsi_RxChar(uint8_t port_type, uint8_t port, uint8_t *c)
 	return -1;
 }
 
+/**@brief Read a block of chars from port
+  @param port: port number configured in PrjCfg.h
+  @param buf: buffer to store the chars
+  @param maxlen: buffer length
+  @return the number of chars read, 0 if there is nothing to read.
+*/
+uint16_t addUsi_RxBlock(uint8_t port_type, uint8_t port, uint8_t *buf, uint16_t maxlen)
+{
+	/* read all available bytes from socket*/
+	int i_recv = read(g_usi_fd, buf, maxlen);
+	if (i_recv > 0) {
+		return i_recv;
+	}
+
+	return 0;
+}
+
 /*
  * @brief	Open TTY serial.
  * @param	_sz_port	tty to connect to.
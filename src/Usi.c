@@ -34,6 +34,10 @@
 /* System includes */
 #include <stdio.h>
 #include <string.h>
+#include <stdbool.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
 
 /* Port includes */
 #include "../addUsi.h"
@@ -43,6 +47,7 @@
 /* Config Include */
 #include "Usi.h"
 #include "UsiCfg.h"
+#include "UsiCrc.h"
 #include "Logger.h"
 #include "debug.h"
 #undef PRINTF
@@ -52,6 +57,9 @@
 
 #define MIN_OVERHEAD            5       /* 1 Start Byte, 2 Bytes (Len+Protocol), 1 End Byte, 1 CRC Byte */
 
+/* Statistics are updated from the USI thread and from sender threads */
+#define USI_STAT_ADD(counter, n)    __atomic_fetch_add(&(counter), (n), __ATOMIC_RELAXED)
+
 /* *** Public Variables ****************************************************** */
 
 extern usi_decode_cmd_cb cbFnMngLay;
@@ -66,13 +74,12 @@ extern usi_decode_cmd_cb cbFnG3Coord;
 
 extern const uint8_t usiCfgNumProtocols;                /* Number of used protocols */
 extern const uint8_t usiCfgNumPorts;                    /* Number of used ports */
-extern MapPorts *const usiCfgMapPorts;                          /* Port Mapping */
+extern PAN_LOCAL MapPorts *usiCfgMapPorts;                      /* Port Mapping */
 extern MapProtocols *const usiCfgMapProtocols;          /* Protocol Mapping */
-extern MapBuffers *const usiCfgRxBuf;                   /* Reception Buffers Mapping */
-extern MapBuffers *const usiCfgTxBuf;                   /* Transmission Buffers Mapping */
-extern MapBuffers *const usiCfgAuxTxBuf;                /* Aux buffer for transmission */
-extern RxParam *const usiCfgRxParam;                            /* Control parameters in reception */
-extern TxParam *const usiCfgTxParam;                            /* Control parameters in transmission */
+extern PAN_LOCAL MapBuffers *usiCfgRxBuf;               /* Reception Buffers Mapping */
+extern PAN_LOCAL MapBuffers *usiCfgTxBuf;               /* Transmission Buffers Mapping */
+extern PAN_LOCAL RxParam *usiCfgRxParam;                        /* Control parameters in reception */
+extern PAN_LOCAL TxParam *usiCfgTxParam;                        /* Control parameters in transmission */
 
 /* *** Declarations ********************************************************** */
 /* Reception states */
@@ -90,217 +97,120 @@ enum {
 
 /* *** Local variables ******************************************************* */
 
-static uint32_t rxCrc;
-static uint32_t evCrc;
-
-/* -------------------------------- */
-/* CRC evaluation table */
-static const uint32_t crc32table[256] = {
-	0x00000000, 0x04C11DB7, 0x09823B6E, 0x0D4326D9,
-	0x130476DC, 0x17C56B6B, 0x1A864DB2, 0x1E475005,
-	0x2608EDB8, 0x22C9F00F, 0x2F8AD6D6, 0x2B4BCB61,
-	0x350C9B64, 0x31CD86D3, 0x3C8EA00A, 0x384FBDBD,
-	0x4C11DB70, 0x48D0C6C7, 0x4593E01E, 0x4152FDA9,
-	0x5F15ADAC, 0x5BD4B01B, 0x569796C2, 0x52568B75,
-	0x6A1936C8, 0x6ED82B7F, 0x639B0DA6, 0x675A1011,
-	0x791D4014, 0x7DDC5DA3, 0x709F7B7A, 0x745E66CD,
-	0x9823B6E0, 0x9CE2AB57, 0x91A18D8E, 0x95609039,
-	0x8B27C03C, 0x8FE6DD8B, 0x82A5FB52, 0x8664E6E5,
-	0xBE2B5B58, 0xBAEA46EF, 0xB7A96036, 0xB3687D81,
-	0xAD2F2D84, 0xA9EE3033, 0xA4AD16EA, 0xA06C0B5D,
-	0xD4326D90, 0xD0F37027, 0xDDB056FE, 0xD9714B49,
-	0xC7361B4C, 0xC3F706FB, 0xCEB42022, 0xCA753D95,
-	0xF23A8028, 0xF6FB9D9F, 0xFBB8BB46, 0xFF79A6F1,
-	0xE13EF6F4, 0xE5FFEB43, 0xE8BCCD9A, 0xEC7DD02D,
-	0x34867077, 0x30476DC0, 0x3D044B19, 0x39C556AE,
-	0x278206AB, 0x23431B1C, 0x2E003DC5, 0x2AC12072,
-	0x128E9DCF, 0x164F8078, 0x1B0CA6A1, 0x1FCDBB16,
-	0x018AEB13, 0x054BF6A4, 0x0808D07D, 0x0CC9CDCA,
-	0x7897AB07, 0x7C56B6B0, 0x71159069, 0x75D48DDE,
-	0x6B93DDDB, 0x6F52C06C, 0x6211E6B5, 0x66D0FB02,
-	0x5E9F46BF, 0x5A5E5B08, 0x571D7DD1, 0x53DC6066,
-	0x4D9B3063, 0x495A2DD4, 0x44190B0D, 0x40D816BA,
-	0xACA5C697, 0xA864DB20, 0xA527FDF9, 0xA1E6E04E,
-	0xBFA1B04B, 0xBB60ADFC, 0xB6238B25, 0xB2E29692,
-	0x8AAD2B2F, 0x8E6C3698, 0x832F1041, 0x87EE0DF6,
-	0x99A95DF3, 0x9D684044, 0x902B669D, 0x94EA7B2A,
-	0xE0B41DE7, 0xE4750050, 0xE9362689, 0xEDF73B3E,
-	0xF3B06B3B, 0xF771768C, 0xFA325055, 0xFEF34DE2,
-	0xC6BCF05F, 0xC27DEDE8, 0xCF3ECB31, 0xCBFFD686,
-	0xD5B88683, 0xD1799B34, 0xDC3ABDED, 0xD8FBA05A,
-	0x690CE0EE, 0x6DCDFD59, 0x608EDB80, 0x644FC637,
-	0x7A089632, 0x7EC98B85, 0x738AAD5C, 0x774BB0EB,
-	0x4F040D56, 0x4BC510E1, 0x46863638, 0x42472B8F,
-	0x5C007B8A, 0x58C1663D, 0x558240E4, 0x51435D53,
-	0x251D3B9E, 0x21DC2629, 0x2C9F00F0, 0x285E1D47,
-	0x36194D42, 0x32D850F5, 0x3F9B762C, 0x3B5A6B9B,
-	0x0315D626, 0x07D4CB91, 0x0A97ED48, 0x0E56F0FF,
-	0x1011A0FA, 0x14D0BD4D, 0x19939B94, 0x1D528623,
-	0xF12F560E, 0xF5EE4BB9, 0xF8AD6D60, 0xFC6C70D7,
-	0xE22B20D2, 0xE6EA3D65, 0xEBA91BBC, 0xEF68060B,
-	0xD727BBB6, 0xD3E6A601, 0xDEA580D8, 0xDA649D6F,
-	0xC423CD6A, 0xC0E2D0DD, 0xCDA1F604, 0xC960EBB3,
-	0xBD3E8D7E, 0xB9FF90C9, 0xB4BCB610, 0xB07DABA7,
-	0xAE3AFBA2, 0xAAFBE615, 0xA7B8C0CC, 0xA379DD7B,
-	0x9B3660C6, 0x9FF77D71, 0x92B45BA8, 0x9675461F,
-	0x8832161A, 0x8CF30BAD, 0x81B02D74, 0x857130C3,
-	0x5D8A9099, 0x594B8D2E, 0x5408ABF7, 0x50C9B640,
-	0x4E8EE645, 0x4A4FFBF2, 0x470CDD2B, 0x43CDC09C,
-	0x7B827D21, 0x7F436096, 0x7200464F, 0x76C15BF8,
-	0x68860BFD, 0x6C47164A, 0x61043093, 0x65C52D24,
-	0x119B4BE9, 0x155A565E, 0x18197087, 0x1CD86D30,
-	0x029F3D35, 0x065E2082, 0x0B1D065B, 0x0FDC1BEC,
-	0x3793A651, 0x3352BBE6, 0x3E119D3F, 0x3AD08088,
-	0x2497D08D, 0x2056CD3A, 0x2D15EBE3, 0x29D4F654,
-	0xC5A92679, 0xC1683BCE, 0xCC2B1D17, 0xC8EA00A0,
-	0xD6AD50A5, 0xD26C4D12, 0xDF2F6BCB, 0xDBEE767C,
-	0xE3A1CBC1, 0xE760D676, 0xEA23F0AF, 0xEEE2ED18,
-	0xF0A5BD1D, 0xF464A0AA, 0xF9278673, 0xFDE69BC4,
-	0x89B8FD09, 0x8D79E0BE, 0x803AC667, 0x84FBDBD0,
-	0x9ABC8BD5, 0x9E7D9662, 0x933EB0BB, 0x97FFAD0C,
-	0xAFB010B1, 0xAB710D06, 0xA6322BDF, 0xA2F33668,
-	0xBCB4666D, 0xB8757BDA, 0xB5365D03, 0xB1F740B4,
-};
+static PAN_LOCAL uint32_t rxCrc;
+static PAN_LOCAL uint32_t evCrc;
 
-/* -------------------------------- */
-/* / Table to calculate CRC */
-static const uint16_t crc16Table[256] = {
-	0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
-	0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef,
-	0x1231, 0x0210, 0x3273, 0x2252, 0x52b5, 0x4294, 0x72f7, 0x62d6,
-	0x9339, 0x8318, 0xb37b, 0xa35a, 0xd3bd, 0xc39c, 0xf3ff, 0xe3de,
-	0x2462, 0x3443, 0x0420, 0x1401, 0x64e6, 0x74c7, 0x44a4, 0x5485,
-	0xa56a, 0xb54b, 0x8528, 0x9509, 0xe5ee, 0xf5cf, 0xc5ac, 0xd58d,
-	0x3653, 0x2672, 0x1611, 0x0630, 0x76d7, 0x66f6, 0x5695, 0x46b4,
-	0xb75b, 0xa77a, 0x9719, 0x8738, 0xf7df, 0xe7fe, 0xd79d, 0xc7bc,
-	0x48c4, 0x58e5, 0x6886, 0x78a7, 0x0840, 0x1861, 0x2802, 0x3823,
-	0xc9cc, 0xd9ed, 0xe98e, 0xf9af, 0x8948, 0x9969, 0xa90a, 0xb92b,
-	0x5af5, 0x4ad4, 0x7ab7, 0x6a96, 0x1a71, 0x0a50, 0x3a33, 0x2a12,
-	0xdbfd, 0xcbdc, 0xfbbf, 0xeb9e, 0x9b79, 0x8b58, 0xbb3b, 0xab1a,
-	0x6ca6, 0x7c87, 0x4ce4, 0x5cc5, 0x2c22, 0x3c03, 0x0c60, 0x1c41,
-	0xedae, 0xfd8f, 0xcdec, 0xddcd, 0xad2a, 0xbd0b, 0x8d68, 0x9d49,
-	0x7e97, 0x6eb6, 0x5ed5, 0x4ef4, 0x3e13, 0x2e32, 0x1e51, 0x0e70,
-	0xff9f, 0xefbe, 0xdfdd, 0xcffc, 0xbf1b, 0xaf3a, 0x9f59, 0x8f78,
-	0x9188, 0x81a9, 0xb1ca, 0xa1eb, 0xd10c, 0xc12d, 0xf14e, 0xe16f,
-	0x1080, 0x00a1, 0x30c2, 0x20e3, 0x5004, 0x4025, 0x7046, 0x6067,
-	0x83b9, 0x9398, 0xa3fb, 0xb3da, 0xc33d, 0xd31c, 0xe37f, 0xf35e,
-	0x02b1, 0x1290, 0x22f3, 0x32d2, 0x4235, 0x5214, 0x6277, 0x7256,
-	0xb5ea, 0xa5cb, 0x95a8, 0x8589, 0xf56e, 0xe54f, 0xd52c, 0xc50d,
-	0x34e2, 0x24c3, 0x14a0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
-	0xa7db, 0xb7fa, 0x8799, 0x97b8, 0xe75f, 0xf77e, 0xc71d, 0xd73c,
-	0x26d3, 0x36f2, 0x0691, 0x16b0, 0x6657, 0x7676, 0x4615, 0x5634,
-	0xd94c, 0xc96d, 0xf90e, 0xe92f, 0x99c8, 0x89e9, 0xb98a, 0xa9ab,
-	0x5844, 0x4865, 0x7806, 0x6827, 0x18c0, 0x08e1, 0x3882, 0x28a3,
-	0xcb7d, 0xdb5c, 0xeb3f, 0xfb1e, 0x8bf9, 0x9bd8, 0xabbb, 0xbb9a,
-	0x4a75, 0x5a54, 0x6a37, 0x7a16, 0x0af1, 0x1ad0, 0x2ab3, 0x3a92,
-	0xfd2e, 0xed0f, 0xdd6c, 0xcd4d, 0xbdaa, 0xad8b, 0x9de8, 0x8dc9,
-	0x7c26, 0x6c07, 0x5c64, 0x4c45, 0x3ca2, 0x2c83, 0x1ce0, 0x0cc1,
-	0xef1f, 0xff3e, 0xcf5d, 0xdf7c, 0xaf9b, 0xbfba, 0x8fd9, 0x9ff8,
-	0x6e17, 0x7e36, 0x4e55, 0x5e74, 0x2e93, 0x3eb2, 0x0ed1, 0x1ef0
-};
+/* Protocol to port lookup, indexed by protocol type. Built in usi_Init() */
+static PAN_LOCAL int8_t usiProtocolPort[256];
+
+/* Link statistics */
+static PAN_LOCAL UsiPortStats usiPortStats[USI_MAX_PORTS];
+static PAN_LOCAL UsiLatencyStats usiLatencyStats;
 
 /* ************************************************************************** */
 
-/** @brief	Calculate CRC32 using a table for the polinomial
- *
- *       @param		bufPtr	Ptr to msg with data to use
- *       @param		len		Length of data to evaluate
- *
- *      @return		calculated CRC
+/** @brief	Reset reception
  *
- * This function calculates the corresponding CRC for the given data.
- * CRC32 is used on USI Protocol IDs:
- * MNGP_PRIME_GETQRY
- * MNGP_PRIME_GETRSP
- * MNGP_PRIME_SET
- * MNGP_PRIME_RESET
- * MNGP_PRIME_REBOOT
- * MNGP_PRIME_FU
- * MNGP_PRIME_EN_PIBQRY
- * MNGP_PRIME_EN_PIBRSP
+ * Initalize reception machine
  **************************************************************************/
 
-static uint32_t _evalCrc32(const uint8_t *bufPtr, uint16_t len)
+static void _resetRx(uint8_t port)
 {
-	uint8_t idx;
-	uint32_t crc;
+	usiCfgRxParam[port].rxStat = RX_IDLE;
+	usiCfgRxParam[port].idx = 0;
+}
 
-	crc = 0;
-	if (len != 0) {
-		while (len--) {
-			idx = (uint8_t)(crc >> 24) ^ *bufPtr++;
-			crc = (crc << 8) ^ crc32table[idx];
-		}
-	}
+/* ************************************************************************** */
+
+/** @brief	Get buffer of a reception frame slot
+ *
+ *      @param		port	Port index
+ *      @param		slot	Frame slot index
+ *
+ *      @return		Pointer to the slot buffer
+ **************************************************************************/
 
-	return crc;
+static inline uint8_t *_rxSlotBuf(uint8_t port, uint8_t slot)
+{
+	return &usiCfgRxBuf[port].buf[(uint32_t)slot * usiCfgRxBuf[port].size];
 }
 
 /* ************************************************************************** */
 
-/** @brief	Calculate CRC16 using a table for the polinomial
+/** @brief	Get a free reception frame slot to deframe into
  *
- *      @param		bufPtr	Pointer to data buffer
- *      @param		len		Buffer size
+ *      @param		port	Port index
  *
- *      @return		calculated CRC
+ *      @return		Slot index, USI_RX_NO_SLOT if every slot is in use
  *
- * This function calculates the corresponding CRC for the given data.
- * CRC16 is used on USI Protocol IDs:
- * PROTOCOL_SNIF_PRIME
- * PROTOCOL_SNIF_G3
- * PROTOCOL_MAC_G3
- * PROTOCOL_ADP_G3
- * PROTOCOL_COORD_G3
- * PROTOCOL_PRIMEoUDP
+ * The slot is returned with one reference, owned by the deframer until the
+ * frame is complete and then by the dispatch queue.
  **************************************************************************/
 
-static uint16_t _evalCrc16(const uint8_t *bufPtr, uint16_t len)                 /* len = 64 -> 2.93 ms. */
+static uint8_t _rxGetSlot(uint8_t port)
 {
-	uint16_t crc;
+	uint8_t slot;
+	uint8_t ref;
 
-	crc = 0;
-	while (len--) {
-		crc = (uint16_t)(crc16Table [(crc >> 8) & 0xff] ^ (crc << 8) ^ (*bufPtr++ & 0x00ff));
+	for (slot = 0; slot < USI_RX_FRAME_SLOTS; slot++) {
+		ref = 0;
+		if (__atomic_compare_exchange_n(&usiCfgRxParam[port].slotRef[slot], &ref, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+			return slot;
+		}
 	}
-	return crc;
+
+	return USI_RX_NO_SLOT;
 }
 
 /* ************************************************************************** */
 
-/** @brief	Calculate CRC16 using a table for the polinomial
- *
- *      @param		bufPtr	Pointer to data buffer
- *      @param		len		Buffer size
+/** @brief	Drop a reference to a reception frame slot
  *
- *      @return		calculated CRC
+ *      @param		port	Port index
+ *      @param		slot	Frame slot index
+ *      @param		wakeup	Wake the USI thread up if the port is waiting for
+ *                          a free slot. Not needed from the USI thread itself
  *
- * This function calculates the corresponding CRC for the given data.
+ * When the last reference is dropped the slot is free again.
  **************************************************************************/
 
-static uint8_t _evalCrc8(const uint8_t *bufPtr, uint16_t len)
+static void _rxPutSlot(uint8_t port, uint8_t slot, bool wakeup)
 {
-	uint8_t crc;
-
-	crc = 0;
-	while (len--) {
-		crc = crc ^ *bufPtr++;
+	if ((__atomic_sub_fetch(&usiCfgRxParam[port].slotRef[slot], 1, __ATOMIC_RELEASE) == 0) && wakeup) {
+		if (__atomic_load_n(&usiCfgRxParam[port].fillSlot, __ATOMIC_RELAXED) == USI_RX_NO_SLOT) {
+			addUsi_Wakeup();
+		}
 	}
-	return crc;
 }
 
 /* ************************************************************************** */
 
-/** @brief	Reset reception
+/** @brief	Find the reception frame slot holding a pointer
  *
- * Initalize reception machine
+ *      @param		frame	Pointer inside a received frame
+ *      @param		port	Port index, output
+ *      @param		slot	Frame slot index, output
+ *
+ *      @return		TRUE if the pointer belongs to a frame slot, FALSE otherwise
  **************************************************************************/
 
-static void _resetRx(uint8_t port)
+static uint8_t _rxFindSlot(const uint8_t *frame, uint8_t *port, uint8_t *slot)
 {
-	usiCfgRxParam[port].rxStat = RX_IDLE;
-	usiCfgRxParam[port].rcvPktReady = FALSE;
-	usiCfgRxParam[port].idx = 0;
+	uint8_t i;
+	const uint8_t *buf;
+	uint16_t size;
+
+	for (i = 0; i < usiCfgNumPorts; i++) {
+		buf = usiCfgRxBuf[i].buf;
+		size = usiCfgRxBuf[i].size;
+		if ((frame >= buf) && (frame < (buf + ((uint32_t)size * USI_RX_FRAME_SLOTS)))) {
+			*port = i;
+			*slot = (uint8_t)((uint32_t)(frame - buf) / size);
+			return(TRUE);
+		}
+	}
+
+	return(FALSE);
 }
 
 /* ************************************************************************** */
@@ -316,41 +226,24 @@ static void _resetRx(uint8_t port)
 
 static int8_t _getPortFromProtocol(uint8_t pType)
 {
-	uint8_t i;
-
-	for (i = 0; i < usiCfgNumProtocols; i++) {
-		/*		if (usiCfgMapProtocols[i].pType == pType) */
-		/*			return usiCfgMapProtocols[i].port; */
-		if ((pType < 0x10) && (usiCfgMapProtocols[i].pType == MNGP_PRIME)) {
-			return usiCfgMapProtocols[i].port;
-		}
-
-		if (usiCfgMapProtocols[i].pType == pType) {
-			return usiCfgMapProtocols[i].port;
-		}
-	}
-
-	return (-1);
+	return usiProtocolPort[pType];
 }
 
 /* ************************************************************************** */
 
 /** @brief	This function process the complete received data.
  *
- *      @param		port	Port where message is received
+ *      @param		rxBuf	Frame slot where message is received
  *
  * Switching data depending on protocol type [TYPE field]
  **************************************************************************/
 
-static uint8_t _processMsg(uint8_t port)
+static uint8_t _processMsg(uint8_t *rxBuf)
 {
 	uint16_t len;
 	uint8_t type;
-	uint8_t *rxBuf;
 	uint8_t result = TRUE;
 
-	/* Get Reception buffer */
-	rxBuf = &usiCfgRxBuf[port].buf[0];
 	/* Extract protocol */
 	type = TYPE_PROTOCOL(rxBuf[TYPE_PROTOCOL_OFFSET]);
 
@@ -445,6 +338,7 @@ static uint8_t _processMsg(uint8_t port)
 /** @brief	Process received message
  *
  *  @param  port   Communication Port
+ *  @param  rxBuf  Frame slot where message is received
  *  @return TRUE if message is OK
  *          FALSE if message is not OK
  *
@@ -453,17 +347,15 @@ static uint8_t _processMsg(uint8_t port)
  *      - Validate CRC32 over the message
  **************************************************************************/
 
-static uint8_t _doEoMsg(uint8_t port)                   /* 3 ms. */
+static uint8_t _doEoMsg(uint8_t port, uint8_t *rxBuf)                   /* 3 ms. */
 {
 	uint8_t *tb;
 	uint8_t type;
 	uint16_t count;
 	uint16_t len;
-	uint8_t *rxBuf;
 
-	/* Get buffer and number of bytes */
+	/* Get number of bytes */
 	count = usiCfgRxParam[port].idx;
-	rxBuf = &usiCfgRxBuf[port].buf[0];
 	if (count < 4) {                                        /* insuffucient data */
 		return(FALSE);
 	}
@@ -471,7 +363,7 @@ static uint8_t _doEoMsg(uint8_t port)                   /* 3 ms. */
 	#ifdef DEBUG_IN_FILE
 		{
 			fprintf((FILE *)get_file_debug_ptr(),"[%s] %s", timestamp_log(),"Rx = ");
-			for(uint8_t k = 0; k < count; k++)
+			for(uint16_t k = 0; k < count; k++)
 			{
 				 fprintf((FILE *)get_file_debug_ptr(),"%02x", rxBuf[k]);
 			}
@@ -504,7 +396,7 @@ static uint8_t _doEoMsg(uint8_t port)                   /* 3 ms. */
 		/* Correct length (exclude CRC) */
 		usiCfgRxParam[port].idx -= 4;
 		/* Calculate CRC */
-		evCrc = _evalCrc32(rxBuf, len + 2);         /* +2 header bytes: included in CRC */
+		evCrc = usi_Crc32(USI_CRC32_INIT, rxBuf, len + 2);         /* +2 header bytes: included in CRC */
 		break;
 
 	case PROTOCOL_SNIF_PRIME:
@@ -519,7 +411,7 @@ static uint8_t _doEoMsg(uint8_t port)                   /* 3 ms. */
 		/* Correct length (exclude CRC) */
 		usiCfgRxParam[port].idx -= 2;
 		/* Calculate CRC */
-		evCrc = (uint32_t)_evalCrc16(rxBuf, len + 2); /* +2 header bytes: included in CRC */
+		evCrc = (uint32_t)usi_Crc16(USI_CRC16_INIT, rxBuf, len + 2); /* +2 header bytes: included in CRC */
 		break;
 
 	case PROTOCOL_PRIME_API:
@@ -529,7 +421,7 @@ static uint8_t _doEoMsg(uint8_t port)                   /* 3 ms. */
 		/* Correct length (exclude CRC) */
 		usiCfgRxParam[port].idx -= 1;
 		/* Calculate CRC */
-		evCrc = (uint32_t)_evalCrc8(rxBuf, len + 2); /* +2 header bytes: included in CRC */
+		evCrc = (uint32_t)usi_Crc8(USI_CRC8_INIT, rxBuf, len + 2); /* +2 header bytes: included in CRC */
 		break;
 
 	default:
@@ -556,22 +448,52 @@ static uint8_t _doEoMsg(uint8_t port)                   /* 3 ms. */
 
 /** @brief	Initialize Serial Profile
  *
- * Init all to inactive
+ * Check the CRC engine, set the port tables of the calling thread, init
+ * all to inactive and build the protocol to port lookup table.
+ * MNGP_PRIME owns every protocol type below 0x10.
  **************************************************************************/
 
 void usi_Init(void)
 {
+	uint16_t j;
 	uint8_t i;
 
+	if (!usi_CrcSelfTest()) {
+		LOG_USI_ERR("CRC engine self test failed\n");
+	}
+
+	usiCfg_Init();
+
+	memset(usiProtocolPort, -1, sizeof(usiProtocolPort));
+	for (i = 0; i < usiCfgNumProtocols; i++) {
+		if (usiCfgMapProtocols[i].port >= usiCfgNumPorts) {
+			LOG_USI_ERR("Protocol 0x%02x mapped to unknown port %u\n", usiCfgMapProtocols[i].pType, usiCfgMapProtocols[i].port);
+			continue;
+		}
+
+		if (usiCfgMapProtocols[i].pType == MNGP_PRIME) {
+			for (j = 0; j < 0x10; j++) {
+				usiProtocolPort[j] = usiCfgMapProtocols[i].port;
+			}
+		} else {
+			usiProtocolPort[usiCfgMapProtocols[i].pType] = usiCfgMapProtocols[i].port;
+		}
+	}
+
 	for (i = 0; i < usiCfgNumPorts; i++) {
 		/* Init Rx Parameters */
 		usiCfgRxParam[i].rxStat = RX_IDLE;
-		usiCfgRxParam[i].rcvPktReady = FALSE;
+		usiCfgRxParam[i].fillSlot = USI_RX_NO_SLOT;
 		usiCfgRxParam[i].idx = 0;
+		usiCfgRxParam[i].readyHead = 0;
+		usiCfgRxParam[i].readyCount = 0;
+		memset(usiCfgRxParam[i].slotRef, 0, sizeof(usiCfgRxParam[i].slotRef));
+		usiCfgRxParam[i].blkIdx = 0;
+		usiCfgRxParam[i].blkLen = 0;
 		/* Init Tx Parameters */
-		usiCfgTxParam[i].count = 0;
-		usiCfgTxParam[i].idxIn = 0;
-		usiCfgTxParam[i].idxOut = 0;
+		usiCfgTxParam[i].head = 0;
+		usiCfgTxParam[i].tail = 0;
+		usiCfgTxParam[i].out = 0;
 	}
 }
 
@@ -618,6 +540,196 @@ void usi_Start(void)
 
 /* ************************************************************************** */
 
+/** @brief	Wrap a transmission ring counter
+ *
+ *       @param		idx		Counter value
+ *       @param		size	Size of ring buffer
+ *
+ *      @return		Counter value in range
+ *
+ * Ring counters run modulo twice the buffer size, so a full ring can be
+ * told apart from an empty one without losing one char of room.
+ **************************************************************************/
+
+static inline uint32_t _txWrap(uint32_t idx, uint16_t size)
+{
+	return (idx >= 2u * size) ? (idx - 2u * size) : idx;
+}
+
+/* ************************************************************************** */
+
+/** @brief	Number of chars between two transmission ring counters
+ *
+ *       @param		from	First counter
+ *       @param		to		Last counter
+ *       @param		size	Size of ring buffer
+ *
+ *      @return		Number of chars
+ **************************************************************************/
+
+static inline uint32_t _txDistance(uint32_t from, uint32_t to, uint16_t size)
+{
+	return (to >= from) ? (to - from) : (to + 2u * size - from);
+}
+
+/* ************************************************************************** */
+
+/** @brief	Count chars which must be escaped
+ *
+ *       @param		buf		Ptr to data
+ *       @param		len		Length of data
+ *
+ *      @return		Number of MSGMARK and ESCMARK chars in data
+ **************************************************************************/
+
+static uint16_t _txCountEscapes(const uint8_t *buf, uint16_t len)
+{
+	uint16_t i;
+	uint16_t count = 0;
+
+	/* Branchless, so compiler can vectorize it */
+	for (i = 0; i < len; i++) {
+		count += (uint16_t)((buf[i] == MSGMARK) | (buf[i] == ESCMARK));
+	}
+
+	return count;
+}
+
+/* ************************************************************************** */
+
+/** @brief	Copy chars to transmission ring
+ *
+ *       @param		txBuf	Transmission buffer
+ *       @param		pos		Ring counter where chars are copied
+ *       @param		src		Ptr to chars
+ *       @param		len		Number of chars
+ *
+ *      @return		Ring counter after the copied chars
+ **************************************************************************/
+
+static uint32_t _txCopy(const MapBuffers *txBuf, uint32_t pos, const uint8_t *src, uint16_t len)
+{
+	uint16_t size = txBuf->size;
+	uint32_t offset = (pos >= size) ? (pos - size) : pos;
+	uint32_t first = size - offset;
+
+	if (len <= first) {
+		memcpy(&txBuf->buf[offset], src, len);
+	} else {
+		/* Wrap at the end of buffer */
+		memcpy(&txBuf->buf[offset], src, first);
+		memcpy(&txBuf->buf[0], &src[first], len - first);
+	}
+
+	return _txWrap(pos + len, size);
+}
+
+/* ************************************************************************** */
+
+/** @brief	Copy chars to transmission ring adding required escapes
+ *
+ *       @param		txBuf	Transmission buffer
+ *       @param		pos		Ring counter where chars are copied
+ *       @param		src		Ptr to chars
+ *       @param		len		Number of chars
+ *
+ *      @return		Ring counter after the copied chars
+ *
+ * Runs of chars without escape are copied as a block.
+ **************************************************************************/
+
+static uint32_t _txEscape(const MapBuffers *txBuf, uint32_t pos, const uint8_t *src, uint16_t len)
+{
+	uint16_t run;
+	uint8_t esc[2];
+
+	while (len) {
+		/* Look for next char to escape */
+		for (run = 0; run < len; run++) {
+			if ((src[run] == MSGMARK) || (src[run] == ESCMARK)) {
+				break;
+			}
+		}
+
+		pos = _txCopy(txBuf, pos, src, run);
+		src += run;
+		len -= run;
+
+		if (len) {
+			/* Escape needed: mark and modified char */
+			esc[0] = ESCMARK;
+			esc[1] = *src++ ^ 0x20;
+			pos = _txCopy(txBuf, pos, esc, 2);
+			len--;
+		}
+	}
+
+	return pos;
+}
+
+/* ************************************************************************** */
+
+/** @brief	Reserve room in transmission ring
+ *
+ *       @param		port	Port index
+ *       @param		len		Number of chars to reserve
+ *       @param		pos		Ring counter of reserved room
+ *
+ *      @return		TRUE if reserved, FALSE if no room
+ *
+ * Several threads may reserve at the same time, each one gets its own
+ * room to fill. It must be published with _txCommit().
+ **************************************************************************/
+
+static uint8_t _txReserve(uint8_t port, uint32_t len, uint32_t *pos)
+{
+	TxParam *txCfg = &usiCfgTxParam[port];
+	uint16_t size = usiCfgTxBuf[port].size;
+	uint32_t head;
+	uint32_t out;
+
+	head = __atomic_load_n(&txCfg->head, __ATOMIC_RELAXED);
+	do {
+		/* Room released by transmission can be overwritten after this load */
+		out = __atomic_load_n(&txCfg->out, __ATOMIC_ACQUIRE);
+		if (len > (size - _txDistance(out, head, size))) {
+			return(FALSE);
+		}
+	} while (!__atomic_compare_exchange_n(&txCfg->head, &head, _txWrap(head + len, size), false,
+			__ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+	*pos = head;
+	return(TRUE);
+}
+
+/* ************************************************************************** */
+
+/** @brief	Publish reserved room of transmission ring
+ *
+ *       @param		port	Port index
+ *       @param		start	Ring counter of reserved room
+ *       @param		end		Ring counter after reserved room
+ *
+ * Rooms are published in the order they were reserved, so a thread waits
+ * for the threads which reserved before it.
+ **************************************************************************/
+
+static void _txCommit(uint8_t port, uint32_t start, uint32_t end)
+{
+	TxParam *txCfg = &usiCfgTxParam[port];
+
+	while (__atomic_load_n(&txCfg->tail, __ATOMIC_RELAXED) != start) {
+#ifdef __linux__
+		sched_yield();
+#endif
+	}
+
+	/* Chars written to reserved room are visible before the new tail */
+	__atomic_store_n(&txCfg->tail, end, __ATOMIC_RELEASE);
+}
+
+/* ************************************************************************** */
+
 /** @brief	Transmit message
  *
  *       @param		pType	Protocol Type
@@ -628,21 +740,24 @@ void usi_Start(void)
  *                                              - TRUE: Sent
  *                                              - FALSE: No room to send
  *
+ * Thread safe: frames sent from several threads are never interleaved.
  **************************************************************************/
 /* uint8_t usi_SendCmd (uint8_t pType, uint8_t *msg, uint16_tlen) */
 uint8_t usi_SendCmd(CmdParams *msg)
 {
-	//LOG_ERR(Log("usi_SendCmd= "));
 	uint32_t crc;
 	int8_t portIdx;
-	uint8_t *ptr2TxBuf;
-	uint8_t *ptr2AuxTxBuf;
-	uint8_t cmd;
-	uint16_t availableLen;
-	uint16_t prevIdxIn;
-	uint16_t i;
-	uint8_t ch;
-	uint16_t putChars = 0;
+	uint8_t header[3];
+	uint8_t headerLen = 2;
+	uint8_t trailer[4];
+	uint8_t trailerLen;
+	const uint8_t *body;
+	uint16_t bodyLen;
+	uint32_t frameLen;
+	uint32_t escapes;
+	uint32_t pos;
+	uint32_t start;
+	const uint8_t mark = MSGMARK;
 	uint8_t pType = msg->pType;
 	uint16_t len = msg->len;
 
@@ -651,40 +766,28 @@ uint8_t usi_SendCmd(CmdParams *msg)
 	if (portIdx == -1) {
 		return(FALSE);
 	}
-	portIdx = 0;
 
-	/* Get available length in buffer */
-	availableLen = usiCfgTxBuf[portIdx].size - usiCfgTxParam[portIdx].count;
-
-	/* First checking, available length at least equal to minimum required space */
-	if (availableLen < (len + MIN_OVERHEAD)) {
+	/* First checking, buffer size at least equal to minimum required space */
+	if (usiCfgTxBuf[portIdx].size < (len + MIN_OVERHEAD)) {
+		USI_STAT_ADD(usiPortStats[portIdx].txFull, 1);
 		return(FALSE);
 	}
 
-	/* Get ptr to TxBuffer */
-	ptr2TxBuf = usiCfgTxBuf[portIdx].buf;
-	ptr2AuxTxBuf = usiCfgAuxTxBuf->buf;
-
-	//LOG_ERR(Log("ptr2TxBuf= %x ptr2AuxTxBuf= %x, portIdx = %d",ptr2TxBuf,ptr2AuxTxBuf,portIdx));
-	/* Store index, just in case after checkings we have to restore previous state */
-	prevIdxIn = usiCfgTxParam[portIdx].idxIn;
-
-	/* Copy message to aux buffer including header */
-	ptr2AuxTxBuf[0] = LEN_HI_PROTOCOL(len);
-	ptr2AuxTxBuf[1] = LEN_LO_PROTOCOL(len) + TYPE_PROTOCOL(pType);
-	/* memcpy (&ptr2AuxTxBuf[2], msg, len); */
-	memcpy(&ptr2AuxTxBuf[2], msg->buf, len);
-
-	/* Adjust XLEN if pType is prime_api protocol */
-	cmd = ptr2AuxTxBuf[CMD_PROTOCOL_OFFSET];
-	if (pType == PROTOCOL_PRIME_API) {
-		ptr2AuxTxBuf[CMD_PROTOCOL_OFFSET] = LEN_EX_PROTOCOL(len) + CMD_PROTOCOL(cmd);
+	/* Header */
+	header[0] = LEN_HI_PROTOCOL(len);
+	header[1] = LEN_LO_PROTOCOL(len) + TYPE_PROTOCOL(pType);
+	body = msg->buf;
+	bodyLen = len;
+
+	/* Adjust XLEN if pType is prime_api protocol: command byte goes with header */
+	if ((pType == PROTOCOL_PRIME_API) && (len > 0)) {
+		header[CMD_PROTOCOL_OFFSET] = LEN_EX_PROTOCOL(len) + CMD_PROTOCOL(body[0]);
+		headerLen++;
+		body++;
+		bodyLen--;
 	}
 
-	/* Add 2 header bytes to LEN */
-	len += 2;
-
-	/* Calculate CRC */
+	/* Calculate CRC of header and body */
 	switch (pType) {
 	case MNGP_PRIME_GETQRY:
 	case MNGP_PRIME_GETRSP:
@@ -693,12 +796,12 @@ uint8_t usi_SendCmd(CmdParams *msg)
 	case MNGP_PRIME_REBOOT:
 	case MNGP_PRIME_FU:
 	case PROTOCOL_MNGP_PRIME_GETQRY_EN:
-		crc = _evalCrc32(ptr2AuxTxBuf, len);
-		ptr2AuxTxBuf[len] = (uint8_t)(crc >> 24);
-		ptr2AuxTxBuf[len + 1] = (uint8_t)(crc >> 16);
-		ptr2AuxTxBuf[len + 2] = (uint8_t)(crc >> 8);
-		ptr2AuxTxBuf[len + 3] = (uint8_t)crc;
-		len += 4;
+		crc = usi_Crc32(usi_Crc32(USI_CRC32_INIT, header, headerLen), body, bodyLen);
+		trailer[0] = (uint8_t)(crc >> 24);
+		trailer[1] = (uint8_t)(crc >> 16);
+		trailer[2] = (uint8_t)(crc >> 8);
+		trailer[3] = (uint8_t)crc;
+		trailerLen = 4;
 		break;
 
 	case PROTOCOL_SNIF_PRIME:
@@ -706,148 +809,88 @@ uint8_t usi_SendCmd(CmdParams *msg)
 	case PROTOCOL_MAC_G3:
 	case PROTOCOL_ADP_G3:
 	case PROTOCOL_COORD_G3:
-		crc = (uint32_t)_evalCrc16(ptr2AuxTxBuf, len);
-		ptr2AuxTxBuf[len] = (uint8_t)(crc >> 8);
-		ptr2AuxTxBuf[len + 1] = (uint8_t)(crc);
-		len += 2;
-		break;
-
-	case PROTOCOL_PRIME_API:
-		crc = (uint32_t)_evalCrc8(ptr2AuxTxBuf, len);
-		ptr2AuxTxBuf[len] = (uint8_t)(crc);
-		len += 1;
-		break;
-
 	case PROTOCOL_PHY_SERIAL_PRIME:
-		crc = (uint32_t)_evalCrc16(ptr2AuxTxBuf, len);
-		ptr2AuxTxBuf[len] = (uint8_t)(crc >> 8);
-		ptr2AuxTxBuf[len + 1] = (uint8_t)(crc);
-		len += 2;
+		crc = (uint32_t)usi_Crc16(usi_Crc16(USI_CRC16_INIT, header, headerLen), body, bodyLen);
+		trailer[0] = (uint8_t)(crc >> 8);
+		trailer[1] = (uint8_t)(crc);
+		trailerLen = 2;
 		break;
 
+	case PROTOCOL_PRIME_API:
 	default:
-		crc = (uint32_t)_evalCrc8(ptr2AuxTxBuf, len);
-		ptr2AuxTxBuf[len] = (uint8_t)(crc);
-		len += 1;
+		crc = (uint32_t)usi_Crc8(usi_Crc8(USI_CRC8_INIT, header, headerLen), body, bodyLen);
+		trailer[0] = (uint8_t)(crc);
+		trailerLen = 1;
 		break;
 	}
 
-	/* Fill tx buffer adding required escapes -------------------------------------------- */
-	/* ----------------------------------------------------------------------------------- */
-
-	/* Start Escape */
-	ptr2TxBuf[usiCfgTxParam[portIdx].idxIn] = MSGMARK;
-	usiCfgTxParam[portIdx].idxIn++;
-	putChars++;
-
-	/* Check index overflow */
-	if (usiCfgTxParam[portIdx].idxIn == usiCfgTxBuf[portIdx].size) {
-		usiCfgTxParam[portIdx].idxIn = 0;
-	}
-
-	/* Check there is still room */
-	if (usiCfgTxParam[portIdx].idxIn == usiCfgTxParam[portIdx].idxOut) {
-		/* No Room. Restore index and return error */
-		usiCfgTxParam[portIdx].idxIn = prevIdxIn;
+	/* Reserve room for the whole frame, start and end marks included */
+	escapes = _txCountEscapes(header, headerLen) + _txCountEscapes(body, bodyLen) + _txCountEscapes(trailer, trailerLen);
+	frameLen = 2 + headerLen + bodyLen + trailerLen + escapes;
+	if (!_txReserve(portIdx, frameLen, &start)) {
+		USI_STAT_ADD(usiPortStats[portIdx].txFull, 1);
 		return(FALSE);
 	}
 
-	/* Message */
-	for (i = 0; i < len; i++) {
-		/* Get next char */
-		ch = ptr2AuxTxBuf[i];
-
-		if (ch == MSGMARK || ch == ESCMARK) {
-			/* Escape needed (mark) */
-			ptr2TxBuf[usiCfgTxParam[portIdx].idxIn] = 0x7D;
-			usiCfgTxParam[portIdx].idxIn++;
-			putChars++;
-
-			/* Check index overflow */
-			if (usiCfgTxParam[portIdx].idxIn == usiCfgTxBuf[portIdx].size) {
-				usiCfgTxParam[portIdx].idxIn = 0;
-			}
-
-			/* Check there is still room */
-			if (usiCfgTxParam[portIdx].idxIn == usiCfgTxParam[portIdx].idxOut) {
-				/* No Room. Restore index and return error */
-				usiCfgTxParam[portIdx].idxIn = prevIdxIn;
-				return(FALSE);
-			}
-
-			/* Escape needed (modified char) */
-			ptr2TxBuf[usiCfgTxParam[portIdx].idxIn] = (ch ^ 0x20);
-			usiCfgTxParam[portIdx].idxIn++;
-			putChars++;
+	/* Fill reserved room adding required escapes */
+	pos = _txCopy(&usiCfgTxBuf[portIdx], start, &mark, 1);
+	pos = _txEscape(&usiCfgTxBuf[portIdx], pos, header, headerLen);
+	pos = _txEscape(&usiCfgTxBuf[portIdx], pos, body, bodyLen);
+	pos = _txEscape(&usiCfgTxBuf[portIdx], pos, trailer, trailerLen);
+	pos = _txCopy(&usiCfgTxBuf[portIdx], pos, &mark, 1);
 
-			/* Check index overflow */
-			if (usiCfgTxParam[portIdx].idxIn == usiCfgTxBuf[portIdx].size) {
-				usiCfgTxParam[portIdx].idxIn = 0;
-			}
-
-			/* Check there is still room */
-			if (usiCfgTxParam[portIdx].idxIn == usiCfgTxParam[portIdx].idxOut) {
-				/* No Room. Restore index and return error */
-				usiCfgTxParam[portIdx].idxIn = prevIdxIn;
-				return(FALSE);
-			}
-		} else {
-			/* No escape */
-			ptr2TxBuf[usiCfgTxParam[portIdx].idxIn] = ch;
-			usiCfgTxParam[portIdx].idxIn++;
-			putChars++;
-
-			/* Check index overflow */
-			if (usiCfgTxParam[portIdx].idxIn == usiCfgTxBuf[portIdx].size) {
-				usiCfgTxParam[portIdx].idxIn = 0;
-			}
+	/* Message ready to be sent */
+	_txCommit(portIdx, start, pos);
+	USI_STAT_ADD(usiPortStats[portIdx].txFrames, 1);
+	USI_STAT_ADD(usiPortStats[portIdx].txEscapes, escapes);
+	USI_STAT_ADD(usiPortStats[portIdx].protoTxFrames[TYPE_PROTOCOL(pType)], 1);
+	USI_STAT_ADD(usiPortStats[portIdx].protoTxBytes[TYPE_PROTOCOL(pType)], headerLen + bodyLen + trailerLen);
+	/* Wake up USI processing to send it */
+	addUsi_Wakeup();
+	return(TRUE);
+}
 
-			/* Check there is still room */
-			if (usiCfgTxParam[portIdx].idxIn == usiCfgTxParam[portIdx].idxOut) {
-				/* No Room. Restore index and return error */
-				usiCfgTxParam[portIdx].idxIn = prevIdxIn;
-				return(FALSE);
-			}
-		}
-	}
+/* ************************************************************************** */
 
-	/* End Escape */
-	ptr2TxBuf[usiCfgTxParam[portIdx].idxIn] = MSGMARK;
-	usiCfgTxParam[portIdx].idxIn++;
-	putChars++;
+/** @brief	Default block reception
+ *
+ *      @param		port_type	Port Type
+ *      @param		port		Port Channel
+ *      @param		buf		Buffer to store received chars
+ *      @param		maxlen		Size of buffer
+ *
+ *      @return		Number of chars stored in buf
+ *
+ * Fallback for custom ports which only implement addUsi_RxChar(). Port
+ * backends override it with a single bulk read.
+ **************************************************************************/
 
-	/* Check index overflow */
-	if (usiCfgTxParam[portIdx].idxIn == usiCfgTxBuf[portIdx].size) {
-		usiCfgTxParam[portIdx].idxIn = 0;
-	}
+__attribute__((weak)) uint16_t addUsi_RxBlock(uint8_t port_type, uint8_t port, uint8_t *buf, uint16_t maxlen)
+{
+	uint16_t len = 0;
 
-	/* Check there is still room */
-	if (usiCfgTxParam[portIdx].idxIn == usiCfgTxParam[portIdx].idxOut) {
-		/* No Room. Restore index and return error */
-		usiCfgTxParam[portIdx].idxIn = prevIdxIn;
-		return(FALSE);
+	while ((len < maxlen) && (addUsi_RxChar(port_type, port, &buf[len]) == 0)) {
+		len++;
 	}
 
-	/* ----------------------------------------------------------------------------------- */
-	/* ----------------------------------------------------------------------------------- */
-
-	/* If this point is reached, message is correct in buffer */
-	usiCfgTxParam[portIdx].count += putChars;
-	/* Message ready to be sent */
-	return(TRUE);
+	return len;
 }
 
 /* ************************************************************************** */
 
 /** @brief	Process reception machine
  *
+ * Chars are fetched from the port in blocks of USI_RX_BLOCK_SIZE and
+ * deframed into a free frame slot. Complete messages are queued to be
+ * dispatched by usi_TxProcess() and deframing goes on in the next free slot.
+ * Only when every slot is queued or retained, the remaining chars are kept
+ * in the port staging buffer until a slot is released.
  **************************************************************************/
 
 void usi_RxProcess(void)
 {
 	uint8_t i;
 	uint8_t ch;
-	uint8_t nextfor;
 	uint8_t chn;
 	RxParam *rxCfg;
 	uint8_t *rxBuf;
@@ -855,38 +898,49 @@ void usi_RxProcess(void)
 
 	uint16_t rxBufSize;
 	uint16_t rxCfgIdx;
+	uint16_t blkIdx;
+	uint16_t blkLen;
 
 	/* Check reception on every port */
 	for (i = 0; i < usiCfgNumPorts; i++) {
-		if (usiCfgRxParam[i].rcvPktReady) {
-			continue; /* Last message no processed yet */
-		}
-
-		nextfor = FALSE;
 		sType = usiCfgMapPorts[i].sType;
 		chn = usiCfgMapPorts[i].chn;
 		rxCfg = &usiCfgRxParam[i];
 		rxCfgIdx = rxCfg->idx;
-		rxBuf = &usiCfgRxBuf[i].buf[rxCfgIdx];
+		rxBuf = (rxCfg->fillSlot == USI_RX_NO_SLOT) ? NULL : _rxSlotBuf(i, rxCfg->fillSlot);
 		rxBufSize = usiCfgRxBuf[i].size;
-		while (TRUE) {
-			/*if (usiCfgMapPorts[i].sType == UART_TYPE)
-			 *      ch = uartRxChar (chn);
-			 * else
-			 *      ch = spiRxChar (chn);*/
+		blkIdx = rxCfg->blkIdx;
+		blkLen = rxCfg->blkLen;
+		while (1) {
+			if (rxCfg->fillSlot == USI_RX_NO_SLOT) {
+				/* Last message queued: go on in a free slot */
+				rxCfg->fillSlot = _rxGetSlot(i);
+				if (rxCfg->fillSlot == USI_RX_NO_SLOT) {
+					break; /* Every slot in use */
+				}
+
+				rxBuf = _rxSlotBuf(i, rxCfg->fillSlot);
+			}
 
 			/* Get char */
+			if (blkIdx == blkLen) {
+				/* Staging buffer is empty. Read next block from port */
+				blkIdx = 0;
+				blkLen = addUsi_RxBlock(sType, chn, rxCfg->blk, USI_RX_BLOCK_SIZE);
+				if (blkLen == 0) {
+					/* No char */
+					break;
+				}
 
-			/* Check if there is something to receive */
-			if (addUsi_RxChar(sType, chn, &ch) == -1) {
-				/* No char */
-				break;
+				USI_STAT_ADD(usiPortStats[i].rxBytes, blkLen);
 			}
 
+			ch = rxCfg->blk[blkIdx++];
+
 			/* Process received char */
 			switch (rxCfg->rxStat) {
 			case RX_IDLE:
-				if (ch == 0x7e) {
+				if (ch == MSGMARK) {
 					/* Start reception process */
 					rxCfg->idx = rxCfgIdx =  0;
 					rxCfg->rxStat = RX_MSG;
@@ -895,40 +949,44 @@ void usi_RxProcess(void)
 				continue;    /* Do not introduce any character in buffer */
 
 			case RX_MSG:
-				if (ch == 0x7d) {
+				if (ch == ESCMARK) {
 					/* Ecape information in message */
 					rxCfg->rxStat = RX_ESC;
 					continue;
 				}
 
-				if (ch == 0x7e) {
+				if (ch == MSGMARK) {
 					if (rxCfgIdx == 0) {
 						/* Two consecutive 0x7E */
 						/* The first was ending of a non processed message */
 						/* The second is the begining of next message to process */
 						continue;
+					}
+
+					rxCfg->idx = rxCfgIdx;         /* Must be updated before call _doEoMsg */
+					/* End reception process */
+					if (_doEoMsg(i, rxBuf)) {
+						/* CRC is OK: queue message to be dispatched */
+						rxCfg->readySlot[(rxCfg->readyHead + rxCfg->readyCount) % USI_RX_FRAME_SLOTS] = rxCfg->fillSlot;
+						rxCfg->readyCount++;
+						rxCfg->fillSlot = USI_RX_NO_SLOT;
+						USI_STAT_ADD(usiPortStats[i].rxFrames, 1);
+						USI_STAT_ADD(usiPortStats[i].protoRxFrames[TYPE_PROTOCOL(rxBuf[TYPE_PROTOCOL_OFFSET])], 1);
+						USI_STAT_ADD(usiPortStats[i].protoRxBytes[TYPE_PROTOCOL(rxBuf[TYPE_PROTOCOL_OFFSET])], rxCfgIdx);
 					} else {
-						rxCfg->idx = rxCfgIdx;         /* Must be updated before call _doEoMsg */
-						/* End reception process */
-						if (_doEoMsg(i)) {
-							/* CRC is OK */
-							rxCfg->rxStat = RX_EORX;
-							rxCfg->rcvPktReady = TRUE;
-						} else {
-							rxCfgIdx = 0;
-							/* CRC is NOK */
-							_resetRx(i);
-						}
-
-						nextfor = TRUE;           /* end while */
+						USI_STAT_ADD(usiPortStats[i].crcErrors, 1);
 					}
+
+					rxCfgIdx = 0;
+					_resetRx(i);
+					continue;
 				}
 
 				break;
 
 			case RX_ESC:
 				/* Ecape secuence */
-				if (ch == 0x7d) {
+				if (ch == ESCMARK) {
 					rxCfgIdx = 0;
 					/* It is not possible to receive 0x7D again */
 					_resetRx(i);
@@ -946,81 +1004,131 @@ void usi_RxProcess(void)
 				break;
 			} /* switch */
 
-			if (nextfor) {
-				break;    /* end while */
-			}
-
 			/* Insert in buffer if possible */
 			if (rxCfgIdx >= rxBufSize) {                                                    /* Too large */
 				rxCfgIdx = 0;
 				_resetRx(i);
-				break;
+				USI_STAT_ADD(usiPortStats[i].overruns, 1);
+				continue;
 			}
 
-			*rxBuf++ = ch;
-			rxCfgIdx++;
+			rxBuf[rxCfgIdx++] = ch;
 		} /* End while */
+
 		rxCfg->idx = rxCfgIdx;
+		rxCfg->blkIdx = blkIdx;
+		rxCfg->blkLen = blkLen;
 	} /* End for */
 }
 
 /* ************************************************************************** */
 
+/** @brief	Default gathered transmission
+ *
+ *      @param		port_type	Port Type
+ *      @param		port		Port Channel
+ *      @param		iov		Buffers to send, in order
+ *      @param		iovcnt		Number of buffers
+ *
+ *      @return		Number of chars sent
+ *
+ * Fallback for custom ports which only implement addUsi_TxMsg(). Port
+ * backends override it with a single writev().
+ **************************************************************************/
+
+__attribute__((weak)) uint16_t addUsi_TxMsgV(uint8_t port_type, uint8_t port, const struct iovec *iov, uint8_t iovcnt)
+{
+	uint16_t len = 0;
+	uint16_t sent;
+	uint8_t i;
+
+	for (i = 0; i < iovcnt; i++) {
+		sent = addUsi_TxMsg(port_type, port, (uint8_t *)iov[i].iov_base, iov[i].iov_len);
+		len += sent;
+		if (sent < iov[i].iov_len) {
+			break;
+		}
+	}
+
+	return len;
+}
+
+/* ************************************************************************** */
+
 /** @brief	Process transmission machine
  *
+ * Only the USI processing thread transmits, senders just fill the rings.
+ * Every committed char is handed to the port in one gathered write, also
+ * when it wraps around the end of the ring.
  **************************************************************************/
 
 void usi_TxProcess(void)
 {
 	uint8_t i;
-	uint16_t len;
-	uint16_t txLen;
+	uint16_t size;
+	uint32_t len;
+	uint32_t out;
+	uint32_t offset;
+	struct iovec txIov[2];
+	uint8_t txIovCnt;
 	uint16_t sentChars;
+	uint8_t slot;
 	TxParam *txCfg;
+	RxParam *rxCfg;
 
 	for (i = 0; i < usiCfgNumPorts; i++) {                                              /* Check every buffer */
-		/* If there is a complete message in RXBuffer, it should be processed */
-		if (usiCfgRxParam[i].rcvPktReady) {
-			_processMsg(i);
-			/* Message processed. Make room for next */
-			usiCfgRxParam[i].rcvPktReady = FALSE;
-			usiCfgRxParam[i].rxStat = RX_IDLE;
-			usiCfgRxParam[i].idx = 0;
+		/* Dispatch every complete message received, in order */
+		rxCfg = &usiCfgRxParam[i];
+		while (rxCfg->readyCount) {
+			slot = rxCfg->readySlot[rxCfg->readyHead];
+			rxCfg->readyHead = (rxCfg->readyHead + 1) % USI_RX_FRAME_SLOTS;
+			rxCfg->readyCount--;
+			_processMsg(_rxSlotBuf(i, slot));
+			/* Message processed. Slot is free unless retained by callback */
+			_rxPutSlot(i, slot, false);
 		}
 
-		/* Get Tx Len message */
+		/* Get Tx Len message: chars committed and not sent yet */
 		txCfg = &usiCfgTxParam[i];
-		len = txCfg->count;
+		size = usiCfgTxBuf[i].size;
+		out = txCfg->out;
+		len = _txDistance(out, __atomic_load_n(&txCfg->tail, __ATOMIC_ACQUIRE), size);
 
 		/* Check if there is something to transmit */
 		if (len) {
-			txLen = len;
-
-			/* In case end of buffer is near, transmit only last part, next process will transmit part pf message placed at the beginning of buffer */
-			if ((txCfg->idxOut + txLen) > usiCfgTxBuf[i].size) {
-				txLen = usiCfgTxBuf[i].size - txCfg->idxOut;
+			offset = (out >= size) ? (out - size) : out;
+			txIov[0].iov_base = &usiCfgTxBuf[i].buf[offset];
+			txIov[0].iov_len = len;
+			txIovCnt = 1;
+
+			/* In case end of buffer is near, the rest of chars are at the beginning of buffer */
+			if ((offset + len) > size) {
+				txIov[0].iov_len = size - offset;
+				txIov[1].iov_base = &usiCfgTxBuf[i].buf[0];
+				txIov[1].iov_len = len - txIov[0].iov_len;
+				txIovCnt = 2;
 			}
 
 			/* Send chars to device, checking how many have been really processed by device */
-			sentChars = addUsi_TxMsg(usiCfgMapPorts[i].sType, usiCfgMapPorts[i].chn, &usiCfgTxBuf[i].buf[txCfg->idxOut], txLen);
+			sentChars = addUsi_TxMsgV(usiCfgMapPorts[i].sType, usiCfgMapPorts[i].chn, txIov, txIovCnt);
 			#ifdef DEBUG_IN_FILE
 				fprintf((FILE *)get_file_debug_ptr(),"[%s] %s", timestamp_log(),"Tx = ");
-				uint8_t *bufptr = &(usiCfgTxBuf[i].buf[txCfg->idxOut]);
-				for(uint8_t k = 0; k<txLen; k++)
+				for(uint8_t v = 0; v < txIovCnt; v++)
 				{
-					 fprintf((FILE *)get_file_debug_ptr(),"%02x", bufptr[k]);
+					uint8_t *bufptr = (uint8_t *)txIov[v].iov_base;
+					for(uint16_t k = 0; k < txIov[v].iov_len; k++)
+					{
+						 fprintf((FILE *)get_file_debug_ptr(),"%02x", bufptr[k]);
+					}
 				}
 				fprintf((FILE *)get_file_debug_ptr(),"\r\n");
 			
 			#endif
 
-			/* Adjust buffer values depending on sent chars */
-			txCfg->count -= sentChars;
-			txCfg->idxOut += sentChars;
-			/* Check end of buffer */
-			if (txCfg->idxOut == usiCfgTxBuf[i].size) {
-				txCfg->idxOut = 0;
-			}
+			USI_STAT_ADD(usiPortStats[i].txBytes, sentChars);
+
+			/* Release sent chars: senders can reuse their room */
+			__atomic_store_n(&txCfg->out, _txWrap(out + sentChars, size), __ATOMIC_RELEASE);
 		}
 	}
 }
@@ -1045,10 +1153,295 @@ void usi_Flush(void)
 		/* Check every buffer */
 		pendingTx = FALSE;
 		for (i = 0; i < usiCfgNumPorts; i++) {
-			if (usiCfgTxParam[i].count) {
+			if (usi_TxPending(i)) {
 				pendingTx = TRUE;
 				break;
 			}
 		}
 	}
 }
+
+/* ************************************************************************** */
+
+/** @brief	Check pending reception work
+ *
+ *      @return		TRUE if a received message or read chars are pending to
+ *                              be processed on any port, FALSE otherwise
+ *
+ * Pending work does not make the port readable again, so caller must keep
+ * processing until this function returns FALSE. Chars waiting for a frame
+ * slot retained by a callback are not pending: releasing the slot wakes the
+ * USI thread up.
+ **************************************************************************/
+
+uint8_t usi_RxPending(void)
+{
+	uint8_t i;
+	uint8_t slot;
+	RxParam *rxCfg;
+
+	for (i = 0; i < usiCfgNumPorts; i++) {
+		rxCfg = &usiCfgRxParam[i];
+		if (rxCfg->readyCount) {
+			return(TRUE);
+		}
+
+		if (rxCfg->blkIdx == rxCfg->blkLen) {
+			continue;
+		}
+
+		/* Read chars can only be processed if there is a slot for them */
+		if (rxCfg->fillSlot != USI_RX_NO_SLOT) {
+			return(TRUE);
+		}
+
+		for (slot = 0; slot < USI_RX_FRAME_SLOTS; slot++) {
+			if (__atomic_load_n(&rxCfg->slotRef[slot], __ATOMIC_RELAXED) == 0) {
+				return(TRUE);
+			}
+		}
+	}
+
+	return(FALSE);
+}
+
+/* ************************************************************************** */
+
+/** @brief	Keep a received message after its callback returns
+ *
+ *      @param		frame	Pointer passed to the protocol callback
+ *
+ *      @return		TRUE if the message is retained, FALSE if the pointer
+ *                              does not belong to a received message
+ *
+ * Call it from the protocol callback only. The message stays valid, without
+ * copying it, until usi_RxFrameRelease() is called, from any thread. The
+ * port keeps receiving in its other frame slots meanwhile.
+ **************************************************************************/
+
+uint8_t usi_RxFrameRetain(const uint8_t *frame)
+{
+	uint8_t port;
+	uint8_t slot;
+
+	if (!_rxFindSlot(frame, &port, &slot)) {
+		return(FALSE);
+	}
+
+	__atomic_add_fetch(&usiCfgRxParam[port].slotRef[slot], 1, __ATOMIC_RELAXED);
+	return(TRUE);
+}
+
+/* ************************************************************************** */
+
+/** @brief	Release a message kept with usi_RxFrameRetain()
+ *
+ *      @param		frame	Pointer passed to usi_RxFrameRetain()
+ *
+ **************************************************************************/
+
+void usi_RxFrameRelease(const uint8_t *frame)
+{
+	uint8_t port;
+	uint8_t slot;
+
+	if (_rxFindSlot(frame, &port, &slot)) {
+		_rxPutSlot(port, slot, true);
+	}
+}
+
+/* ************************************************************************** */
+
+/** @brief	Check if a port is waiting for a frame slot
+ *
+ *      @param		port	Port index
+ *
+ *      @return		TRUE if every frame slot of the port is queued or
+ *                              retained, FALSE otherwise
+ *
+ * Chars can not be read from the port meanwhile, so it should not be watched
+ * for reading: releasing a slot wakes the USI thread up.
+ **************************************************************************/
+
+uint8_t usi_RxBlocked(uint8_t port)
+{
+	uint8_t slot;
+
+	if ((port >= usiCfgNumPorts) || (usiCfgRxParam[port].fillSlot != USI_RX_NO_SLOT)) {
+		return(FALSE);
+	}
+
+	for (slot = 0; slot < USI_RX_FRAME_SLOTS; slot++) {
+		if (__atomic_load_n(&usiCfgRxParam[port].slotRef[slot], __ATOMIC_RELAXED) == 0) {
+			return(FALSE);
+		}
+	}
+
+	return(TRUE);
+}
+
+/* ************************************************************************** */
+
+/** @brief	Check pending transmission on a port
+ *
+ *      @param		port	Port index
+ *
+ *      @return		TRUE if there are chars pending to be sent, FALSE otherwise
+ *
+ **************************************************************************/
+
+uint8_t usi_TxPending(uint8_t port)
+{
+	if (port >= usiCfgNumPorts) {
+		return(FALSE);
+	}
+
+	return((__atomic_load_n(&usiCfgTxParam[port].tail, __ATOMIC_ACQUIRE) != usiCfgTxParam[port].out) ? TRUE : FALSE);
+}
+
+/* ************************************************************************** */
+
+/** @brief	Get file descriptor of a port
+ *
+ *      @param		port	Port index
+ *
+ *      @return		File descriptor, -1 if not available
+ *
+ **************************************************************************/
+
+int32_t usi_GetPortFd(uint8_t port)
+{
+	if (port >= usiCfgNumPorts) {
+		return(-1);
+	}
+
+	return(addUsi_GetFd(usiCfgMapPorts[port].sType, usiCfgMapPorts[port].chn));
+}
+
+/* ************************************************************************** */
+
+/** @brief	Get link statistics of a port
+ *
+ *      @param		port	Port index
+ *      @param		stats	Statistics, output
+ *
+ *      @return		TRUE if port exists, FALSE otherwise
+ *
+ **************************************************************************/
+
+uint8_t usi_GetPortStats(uint8_t port, UsiPortStats *stats)
+{
+	if (port >= usiCfgNumPorts) {
+		return(FALSE);
+	}
+
+	memcpy(stats, &usiPortStats[port], sizeof(UsiPortStats));
+	return(TRUE);
+}
+
+/* ************************************************************************** */
+
+/** @brief	Get latency histogram of synchronous requests
+ *
+ *      @param		stats	Histogram, output
+ *
+ **************************************************************************/
+
+void usi_GetLatencyStats(UsiLatencyStats *stats)
+{
+	memcpy(stats, &usiLatencyStats, sizeof(UsiLatencyStats));
+}
+
+/* ************************************************************************** */
+
+/** @brief	Account a synchronous request
+ *
+ *      @param		ms		Milliseconds from request to confirm
+ *      @param		timeout	TRUE if confirm did not arrive
+ *
+ **************************************************************************/
+
+void usi_AddLatency(uint32_t ms, uint8_t timeout)
+{
+	uint8_t bucket = 0;
+
+	if (timeout) {
+		USI_STAT_ADD(usiLatencyStats.timeouts, 1);
+		return;
+	}
+
+	while (ms && (bucket < (USI_STATS_LATENCY_BUCKETS - 1))) {
+		ms >>= 1;
+		bucket++;
+	}
+
+	USI_STAT_ADD(usiLatencyStats.count[bucket], 1);
+}
+
+/* ************************************************************************** */
+
+/** @brief	Clear all link statistics
+ *
+ **************************************************************************/
+
+void usi_ResetStats(void)
+{
+	memset(usiPortStats, 0, sizeof(usiPortStats));
+	memset(&usiLatencyStats, 0, sizeof(usiLatencyStats));
+}
+
+/* ************************************************************************** */
+
+/** @brief	Print link statistics
+ *
+ *      @param		print	Callback printing every line
+ *      @param		ctx		Context passed to print
+ *
+ * Only protocols and latency buckets with some count are printed.
+ **************************************************************************/
+
+void usi_DumpStats(usi_print_cb print, void *ctx)
+{
+	char line[160];
+	int lineLen;
+	uint8_t i;
+	uint8_t j;
+	UsiPortStats stats;
+	UsiLatencyStats latency;
+
+	for (i = 0; i < usiCfgNumPorts; i++) {
+		usi_GetPortStats(i, &stats);
+		snprintf(line, sizeof(line), "USI port %u: rx %u frames %u bytes, tx %u frames %u bytes",
+				i, stats.rxFrames, stats.rxBytes, stats.txFrames, stats.txBytes);
+		print(ctx, line);
+		snprintf(line, sizeof(line), "  crc errors %u, overruns %u, tx full %u, tx escapes %u",
+				stats.crcErrors, stats.overruns, stats.txFull, stats.txEscapes);
+		print(ctx, line);
+		for (j = 0; j < USI_STATS_PROTOCOLS; j++) {
+			if (stats.protoRxFrames[j] || stats.protoTxFrames[j]) {
+				snprintf(line, sizeof(line), "  protocol 0x%02x: rx %u frames %u bytes, tx %u frames %u bytes",
+						j, stats.protoRxFrames[j], stats.protoRxBytes[j], stats.protoTxFrames[j], stats.protoTxBytes[j]);
+				print(ctx, line);
+			}
+		}
+	}
+
+	usi_GetLatencyStats(&latency);
+	lineLen = snprintf(line, sizeof(line), "USI sync latency (ms): timeouts %u", latency.timeouts);
+	for (j = 0; j < USI_STATS_LATENCY_BUCKETS; j++) {
+		/* Leave room for the largest bucket text */
+		if ((latency.count[j] == 0) || (lineLen > ((int)sizeof(line) - 32))) {
+			continue;
+		}
+
+		if (j == 0) {
+			lineLen += snprintf(&line[lineLen], sizeof(line) - lineLen, ", <1: %u", latency.count[j]);
+		} else if (j == (USI_STATS_LATENCY_BUCKETS - 1)) {
+			lineLen += snprintf(&line[lineLen], sizeof(line) - lineLen, ", >=%u: %u", 1u << (j - 1), latency.count[j]);
+		} else {
+			lineLen += snprintf(&line[lineLen], sizeof(line) - lineLen, ", %u-%u: %u", 1u << (j - 1), (1u << j) - 1, latency.count[j]);
+		}
+	}
+
+	print(ctx, line);
+}
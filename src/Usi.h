@@ -70,8 +70,12 @@ extern "C" {
 #define CRC16_LEN       2
 #define CRC32_LEN       4
 
+#ifndef TRUE
 #define TRUE  1
+#endif
+#ifndef FALSE
 #define FALSE 0
+#endif
 
 /****************************************************************************
 **               PROTOCOL INFORMATION FORMAT                                       **
@@ -122,6 +126,37 @@ typedef struct {
 	uint16_t len;                   /* Length of data */
 } CmdParams;
 
+/* Link statistics of a port. Bytes are counted as sent/read on the link */
+#define USI_STATS_PROTOCOLS         64          /* Protocol types, see TYPE_PROTOCOL_MSK */
+
+typedef struct {
+	uint32_t rxFrames;                      /* Frames received with good CRC */
+	uint32_t rxBytes;                       /* Chars read from port */
+	uint32_t txFrames;                      /* Frames queued to be sent */
+	uint32_t txBytes;                       /* Chars written to port */
+	uint32_t txEscapes;                     /* Escape chars added to queued frames */
+	uint32_t crcErrors;                     /* Frames dropped: bad CRC, length or type */
+	uint32_t overruns;                      /* Frames dropped: longer than RX buffer */
+	uint32_t txFull;                        /* Frames rejected: no room in TX buffer */
+	uint32_t protoRxFrames[USI_STATS_PROTOCOLS];    /* Frames received per protocol type */
+	uint32_t protoTxFrames[USI_STATS_PROTOCOLS];    /* Frames queued per protocol type */
+	uint32_t protoRxBytes[USI_STATS_PROTOCOLS];     /* Frame bytes (header, data, CRC) received per protocol type */
+	uint32_t protoTxBytes[USI_STATS_PROTOCOLS];     /* Frame bytes (header, data, CRC) queued per protocol type */
+} UsiPortStats;
+
+/* Request to confirm latency of synchronous requests, log2 histogram.
+ * Bucket 0 counts latencies under 1 ms, bucket n latencies in
+ * [2^(n-1), 2^n) ms. The last bucket also counts longer ones. */
+#define USI_STATS_LATENCY_BUCKETS   16
+
+typedef struct {
+	uint32_t count[USI_STATS_LATENCY_BUCKETS];
+	uint32_t timeouts;                      /* Requests without confirm */
+} UsiLatencyStats;
+
+/* Callback printing one line of statistics, without line end */
+typedef void (*usi_print_cb)(void *ctx, const char *line);
+
 /* *** Functions prototypes ************************************************** */
 
 /* Serial Profile */
@@ -132,6 +167,19 @@ void usi_TxProcess(void);
 uint8_t usi_SendCmd(CmdParams *msg);
 void usi_Flush(void);
 void usi_ConfigurePort(uint8_t logPort, uint8_t port_type, uint8_t commPort, uint32_t speed);
+uint8_t usi_RxPending(void);
+uint8_t usi_RxFrameRetain(const uint8_t *frame);
+void usi_RxFrameRelease(const uint8_t *frame);
+uint8_t usi_RxBlocked(uint8_t port);
+uint8_t usi_TxPending(uint8_t port);
+int32_t usi_GetPortFd(uint8_t port);
+
+/* Link statistics */
+uint8_t usi_GetPortStats(uint8_t port, UsiPortStats *stats);
+void usi_GetLatencyStats(UsiLatencyStats *stats);
+void usi_AddLatency(uint32_t ms, uint8_t timeout);
+void usi_ResetStats(void);
+void usi_DumpStats(usi_print_cb print, void *ctx);
 
 #ifdef __cplusplus
 }
@@ -111,7 +111,7 @@
 #define CONF_PORT(type, channel, speed, txSize, rxSize) {type, channel, speed}
 
 /// Port Mapping. It is configured with the values provided in Header file 
-static MapPorts usiMapPorts[NUM_PORTS+1] =
+static PAN_LOCAL MapPorts usiMapPorts[NUM_PORTS+1] =
 {   // PORT TYPE, PORT CHANNEL, PORT SPEED, TX BUFFER SIZE, RX BUFFER SIZE
 #ifdef PORT_0
 	PORT_0,
@@ -169,41 +169,58 @@ static const MapProtocols usiMapProtocols[NUM_PROTOCOLS + 1] =
     {0xff, 0xff}
 };
 
+#if (NUM_PORTS > USI_MAX_PORTS)
+  #error "USI_CFG: NUM_PORTS greater than USI_MAX_PORTS"
+#endif
+
+/* Every protocol must be mapped to a configured port */
+#if (defined(USE_MNGP_PRIME_PORT) && (USE_MNGP_PRIME_PORT >= NUM_PORTS)) || \
+    (defined(USE_PROTOCOL_PHY_SERIAL_PRIME) && (USE_PROTOCOL_PHY_SERIAL_PRIME >= NUM_PORTS)) || \
+    (defined(USE_PROTOCOL_SNIF_PRIME_PORT) && (USE_PROTOCOL_SNIF_PRIME_PORT >= NUM_PORTS)) || \
+    (defined(USE_PROTOCOL_PRIME_API) && (USE_PROTOCOL_PRIME_API >= NUM_PORTS)) || \
+    (defined(USE_PROTOCOL_SNIF_G3_PORT) && (USE_PROTOCOL_SNIF_G3_PORT >= NUM_PORTS)) || \
+    (defined(USE_PROTOCOL_MAC_G3_PORT) && (USE_PROTOCOL_MAC_G3_PORT >= NUM_PORTS)) || \
+    (defined(USE_PROTOCOL_ADP_G3_PORT) && (USE_PROTOCOL_ADP_G3_PORT >= NUM_PORTS)) || \
+    (defined(USE_PROTOCOL_COORD_G3_PORT) && (USE_PROTOCOL_COORD_G3_PORT >= NUM_PORTS))
+  #error "USI_CFG: protocol mapped to a port index >= NUM_PORTS"
+#endif
+
 
 //--------------------------------------------------------------------------------------
-/// Reception Buffers Mapping
+/// Reception Buffers Mapping. Size is per frame slot
 #undef CONF_PORT 
 #define CONF_PORT(type, channel, speed, txSize, rxSize) rxSize
 
 #ifdef PORT_0
-static uint8_t rxbuf0[PORT_0];
+static PAN_LOCAL uint8_t rxbuf0[USI_RX_FRAME_SLOTS * (PORT_0)];
 #endif
 
 #ifdef PORT_1
-static uint8_t rxbuf1[PORT_1];
+static PAN_LOCAL uint8_t rxbuf1[USI_RX_FRAME_SLOTS * (PORT_1)];
 #endif
 
 #ifdef PORT_2
-static uint8_t rxbuf2[PORT_2];
+static PAN_LOCAL uint8_t rxbuf2[USI_RX_FRAME_SLOTS * (PORT_2)];
 #endif
 
 #ifdef PORT_3
-static uint8_t rxbuf3[PORT_3];
+static PAN_LOCAL uint8_t rxbuf3[USI_RX_FRAME_SLOTS * (PORT_3)];
 #endif
 
-static const MapBuffers usiRxBuf[NUM_PORTS + 1] =
+/* Buffer pointers are set by usiCfg_Init(), buffers can be thread local */
+static PAN_LOCAL MapBuffers usiRxBuf[NUM_PORTS + 1] =
 {
 #ifdef PORT_0
-  	{PORT_0, &rxbuf0[0]},
+  	{PORT_0, NULL},
 #endif
 #ifdef PORT_1
-	{PORT_1, &rxbuf1[0]},
+	{PORT_1, NULL},
 #endif
 #ifdef PORT_2
-	{PORT_2, &rxbuf2[0]},
+	{PORT_2, NULL},
 #endif
 #ifdef PORT_3
-	{PORT_3, &rxbuf3[0]},
+	{PORT_3, NULL},
 #endif
     {0xFF , NULL}
 };
@@ -214,72 +231,39 @@ static const MapBuffers usiRxBuf[NUM_PORTS + 1] =
 #define CONF_PORT(type, channel, speed, txSize, rxSize) txSize
 
 #ifdef PORT_0
-static uint8_t txbuf0[PORT_0];
+static PAN_LOCAL uint8_t txbuf0[PORT_0];
 #endif
 #ifdef PORT_1
-static uint8_t txbuf1[PORT_1];
+static PAN_LOCAL uint8_t txbuf1[PORT_1];
 #endif
 #ifdef PORT_2
-static uint8_t txbuf2[PORT_2];
+static PAN_LOCAL uint8_t txbuf2[PORT_2];
 #endif
 #ifdef PORT_3
-static uint8_t txbuf3[PORT_3];
+static PAN_LOCAL uint8_t txbuf3[PORT_3];
 #endif
 
-static const MapBuffers usiTxBuf[NUM_PORTS + 1] =
+static PAN_LOCAL MapBuffers usiTxBuf[NUM_PORTS + 1] =
 {
 #ifdef PORT_0
-  	{PORT_0, &txbuf0[0]},
+  	{PORT_0, NULL},
 #endif
 #ifdef PORT_1
-  	{PORT_1, &txbuf1[0]},
+  	{PORT_1, NULL},
 #endif
 #ifdef PORT_2
-	{PORT_2, &txbuf2[0]},
+	{PORT_2, NULL},
 #endif
 #ifdef PORT_3
-	{PORT_3, &txbuf3[0]},
+	{PORT_3, NULL},
 #endif
     {0xFF , NULL}
 };
 
-//***************************************************************************
-
-/// Transmission buffers size configuration
-#define TXAUX_SIZE 0
-#ifdef PORT_0
-	#if (PORT_0 > TXAUX_SIZE)
-		#undef TXAUX_SIZE
-		#define TXAUX_SIZE   	PORT_0
-	#endif
-#endif
-#ifdef PORT_1
-	#if (PORT_1 > TXAUX_SIZE)
-		#undef TXAUX_SIZE
-		#define TXAUX_SIZE   	PORT_1
-	#endif
-#endif
-#ifdef PORT_2
-	#if (PORT_2 > TXAUX_SIZE)
-		#undef TXAUX_SIZE
-		#define TXAUX_SIZE   	PORT_2
-	#endif
-#endif
-#ifdef PORT_3
-	#if (PORT_3 > TXAUX_SIZE)
-		#undef TXAUX_SIZE
-		#define TXAUX_SIZE   	PORT_3
-	#endif
-#endif
-
-static uint8_t txauxbuf[TXAUX_SIZE+2];
-static const MapBuffers usiAuxTxBuf = {TXAUX_SIZE+2, &txauxbuf[0]};
-
-
 //--------------------------------------------------------------------------------------
 /// Control parameters in communications
-static RxParam usiRxParam[NUM_PORTS];
-static TxParam usiTxParam[NUM_PORTS];
+static PAN_LOCAL RxParam usiRxParam[NUM_PORTS];
+static PAN_LOCAL TxParam usiTxParam[NUM_PORTS];
 //--------------------------------------------------------------------------------------
 
 //*** Local variables *******************************************************
@@ -287,13 +271,48 @@ static TxParam usiTxParam[NUM_PORTS];
 //*** Public variables ******************************************************
 const uint8_t usiCfgNumProtocols = NUM_PROTOCOLS;
 const uint8_t usiCfgNumPorts = NUM_PORTS;
-MapPorts * const usiCfgMapPorts = &usiMapPorts[0];
 const MapProtocols * const usiCfgMapProtocols = &usiMapProtocols[0];
-const MapBuffers * const usiCfgRxBuf = &usiRxBuf[0];
-const MapBuffers * const usiCfgTxBuf = &usiTxBuf[0];
-const MapBuffers * const usiCfgAuxTxBuf = &usiAuxTxBuf;
-RxParam * const usiCfgRxParam = &usiRxParam[0];
-TxParam * const usiCfgTxParam = &usiTxParam[0];
+/* Tables of the calling thread, set by usiCfg_Init() */
+PAN_LOCAL MapPorts *usiCfgMapPorts;
+PAN_LOCAL MapBuffers *usiCfgRxBuf;
+PAN_LOCAL MapBuffers *usiCfgTxBuf;
+PAN_LOCAL RxParam *usiCfgRxParam;
+PAN_LOCAL TxParam *usiCfgTxParam;
+
+//*** Public functions ******************************************************
+
+/** @brief	Set the port tables and buffers
+ *
+ * Called by usi_Init(), from the thread running the USI.
+ **************************************************************************/
+void usiCfg_Init(void)
+{
+	uint8_t i = 0;
+
+#ifdef PORT_0
+	usiRxBuf[i].buf = &rxbuf0[0];
+	usiTxBuf[i++].buf = &txbuf0[0];
+#endif
+#ifdef PORT_1
+	usiRxBuf[i].buf = &rxbuf1[0];
+	usiTxBuf[i++].buf = &txbuf1[0];
+#endif
+#ifdef PORT_2
+	usiRxBuf[i].buf = &rxbuf2[0];
+	usiTxBuf[i++].buf = &txbuf2[0];
+#endif
+#ifdef PORT_3
+	usiRxBuf[i].buf = &rxbuf3[0];
+	usiTxBuf[i++].buf = &txbuf3[0];
+#endif
+	(void)i;
+
+	usiCfgMapPorts = &usiMapPorts[0];
+	usiCfgRxBuf = &usiRxBuf[0];
+	usiCfgTxBuf = &usiTxBuf[0];
+	usiCfgRxParam = &usiRxParam[0];
+	usiCfgTxParam = &usiTxParam[0];
+}
 
 
 
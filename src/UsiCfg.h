@@ -92,6 +92,23 @@ extern "C" {
 
 /* NOTE: ID 0x3F is reserved for internal messages, do not use it as identifier */
 
+/* Maximum number of ports: PORT_0 to PORT_3 */
+#define USI_MAX_PORTS               4
+
+/* Size of the block read from the port on every reception call */
+#ifndef USI_RX_BLOCK_SIZE
+#define USI_RX_BLOCK_SIZE           256
+#endif
+
+/* Number of received frames each port can hold: while some of them are
+ * dispatched or retained by callbacks, the port keeps deframing into the
+ * others. Every slot has the RX buffer size configured for the port. */
+#ifndef USI_RX_FRAME_SLOTS
+#define USI_RX_FRAME_SLOTS          4
+#endif
+
+#define USI_RX_NO_SLOT              0xFF
+
 /* *************************************************************************** */
 /* *** Types for Function Pointers ******************************************* */
 /* / Type for callback function pointers */
@@ -112,21 +129,32 @@ typedef struct {
 
 typedef struct {
 	uint16_t size;      /* Size of buffer */
-	uint8_t *const buf;     /* Ptr to buffer */
+	uint8_t *buf;           /* Ptr to buffer, set by usiCfg_Init() */
 } MapBuffers;
 
 typedef struct {
 	uint8_t rxStat;                                         /* /< Reception status */
-	uint8_t rcvPktReady;                                    /* /< Complete received packet flag */
+	uint8_t fillSlot;                                       /* /< Frame slot being deframed, USI_RX_NO_SLOT if none */
 	uint16_t idx;                                                   /* /< Index where next received char is to be stored */
+	uint8_t readyHead;                                      /* /< Oldest received frame pending to be dispatched */
+	uint8_t readyCount;                                     /* /< Number of received frames pending to be dispatched */
+	uint8_t readySlot[USI_RX_FRAME_SLOTS];                  /* /< Received frames, in reception order */
+	uint8_t slotRef[USI_RX_FRAME_SLOTS];                    /* /< References to every frame slot, 0 if free */
+	uint16_t blkIdx;                                                /* /< Index of next char to process in blk */
+	uint16_t blkLen;                                                /* /< Number of chars read from port in blk */
+	uint8_t blk[USI_RX_BLOCK_SIZE];                                 /* /< Chars read from port, pending to process */
 } RxParam;
 
+/* Transmission ring: counters run modulo twice the buffer size */
 typedef struct {
-	uint16_t idxIn;                                         /* /< Index to insert Chars */
-	uint16_t idxOut;                                        /* /< Index to transmit chars */
-	uint16_t count;                                         /* /< Number of chars in buffer */
+	uint32_t head;                                          /* /< Chars reserved by senders */
+	uint32_t tail;                                          /* /< Chars committed by senders, ready to transmit */
+	uint32_t out;                                           /* /< Chars transmitted */
 } TxParam;
 
+/* *** Functions prototypes ************************************************** */
+void usiCfg_Init(void);
+
 #ifdef __cplusplus
 }
 #endif
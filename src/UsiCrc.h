@@ -0,0 +1,64 @@
+/**
+ * \file
+ *
+ * \brief USI Host CRC engine
+ *
+ * Copyright (c) 2021 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \asf_license_start
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip
+ * software and any derivatives exclusively with Microchip products.
+ * It is your responsibility to comply with third party license terms applicable
+ * to your use of third party software (including open source software) that
+ * may accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES,
+ * WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE,
+ * INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY,
+ * AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE
+ * LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL
+ * LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND WHATSOEVER RELATED TO THE
+ * SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS BEEN ADVISED OF THE
+ * POSSIBILITY OR THE DAMAGES ARE FORESEEABLE.  TO THE FULLEST EXTENT
+ * ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN ANY WAY
+ * RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+ * THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+ *
+ * \asf_license_stop
+ *
+ */
+
+#ifndef UsiCrcH
+#define UsiCrcH
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* *** Declarations ********************************************************** */
+
+/* Initial values. There is no final step: the running value is the CRC */
+#define USI_CRC32_INIT          0x00000000
+#define USI_CRC16_INIT          0x0000
+#define USI_CRC16_CCITT_INIT    0xFFFF
+#define USI_CRC8_INIT           0x00
+
+/* *** Public Functions ****************************************************** */
+
+uint32_t usi_Crc32(uint32_t crc, const uint8_t *buf, uint32_t len);
+uint16_t usi_Crc16(uint16_t crc, const uint8_t *buf, uint32_t len);
+uint16_t usi_Crc16Ccitt(uint16_t crc, const uint8_t *buf, uint32_t len);
+uint8_t usi_Crc8(uint8_t crc, const uint8_t *buf, uint32_t len);
+bool usi_CrcSelfTest(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UsiCrcH */
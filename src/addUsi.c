@@ -42,11 +42,145 @@ extern "C" {
 /**INDENT-ON**/
 /* / @endcond */
 
+/* clock_gettime(), CLOCK_MONOTONIC and pthread_condattr_setclock() with -std=c99,
+   usleep() is not in POSIX.1-2008 */
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+
 #include "../addUsi.h"
+#include "../userFnc.h"
 #include "Usi.h"
 
 #include <time.h>
 #include <unistd.h>
+#ifdef __linux__
+#include <errno.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
+extern const uint8_t usiCfgNumPorts;                    /* Number of used ports */
+
+#ifdef __linux__
+/* Maximum number of ports watched by the USI event loop */
+#define USI_MAX_EVENT_PORTS     4
+/* Wait timeout when some port has no file descriptor (ms) */
+#define USI_POLL_PERIOD_MS      1
+
+/* Epoll set with the USI ports and the wakeup descriptor */
+static PAN_LOCAL int si_epoll_fd = -1;
+/* Eventfd signalled when a message is queued for transmission */
+static PAN_LOCAL int si_wakeup_fd = -1;
+/* Port file descriptors registered in the epoll set */
+static PAN_LOCAL int32_t si_port_fd[USI_MAX_EVENT_PORTS];
+/* Events currently registered for every port */
+static PAN_LOCAL uint32_t sul_port_events[USI_MAX_EVENT_PORTS];
+/* Some port can not be watched, so it has to be polled */
+static PAN_LOCAL Bool sb_poll_ports;
+/* USI is processed by the application loop of this thread, not by a USI thread */
+static PAN_LOCAL Bool sb_own_loop;
+/* addUsi_Process() running: callbacks can not process USI again */
+static PAN_LOCAL Bool sb_processing;
+
+/* Synchronous requests: flags are activated and checked with the mutex taken */
+static pthread_mutex_t sx_sync_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sx_sync_cond;
+static pthread_once_t sx_sync_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief _init_sync
+ * Initialize the condition used by synchronous requests on monotonic clock
+ */
+static void _init_sync(void)
+{
+	pthread_condattr_t x_attr;
+
+	pthread_condattr_init(&x_attr);
+	pthread_condattr_setclock(&x_attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&sx_sync_cond, &x_attr);
+	pthread_condattr_destroy(&x_attr);
+}
+
+/**
+ * @brief _update_port_events
+ * Watch port for writing only while it has chars pending to be sent, and
+ * for reading only while it has a free frame slot (the port stays readable
+ * while its frames are retained)
+ * @param port: Port index
+ */
+static void _update_port_events(uint8_t port)
+{
+	struct epoll_event x_event;
+	uint32_t ul_events = usi_RxBlocked(port) ? 0 : EPOLLIN;
+
+	if (usi_TxPending(port)) {
+		ul_events |= EPOLLOUT;
+	}
+
+	if ((si_port_fd[port] < 0) || (ul_events == sul_port_events[port])) {
+		return;
+	}
+
+	memset(&x_event, 0, sizeof(x_event));
+	x_event.events = ul_events;
+	x_event.data.u32 = port;
+	if (epoll_ctl(si_epoll_fd, EPOLL_CTL_MOD, si_port_fd[port], &x_event) == 0) {
+		sul_port_events[port] = ul_events;
+	}
+}
+
+/**
+ * @brief _init_events
+ * Create the epoll set watching every USI port and the wakeup descriptor
+ */
+static void _init_events(void)
+{
+	struct epoll_event x_event;
+	uint8_t i;
+
+	si_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	si_wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if ((si_epoll_fd < 0) || (si_wakeup_fd < 0)) {
+		LOG_USI_ERR("Unable to create USI event descriptors\r\n");
+		return;
+	}
+
+	memset(&x_event, 0, sizeof(x_event));
+	x_event.events = EPOLLIN;
+	x_event.data.u32 = USI_MAX_EVENT_PORTS;
+	epoll_ctl(si_epoll_fd, EPOLL_CTL_ADD, si_wakeup_fd, &x_event);
+
+	sb_poll_ports = (usiCfgNumPorts > USI_MAX_EVENT_PORTS);
+	for (i = 0; i < USI_MAX_EVENT_PORTS; i++) {
+		si_port_fd[i] = -1;
+		if (i >= usiCfgNumPorts) {
+			continue;
+		}
+
+		si_port_fd[i] = usi_GetPortFd(i);
+		if (si_port_fd[i] < 0) {
+			sb_poll_ports = true;
+			continue;
+		}
+
+		x_event.events = EPOLLIN;
+		x_event.data.u32 = i;
+		if (epoll_ctl(si_epoll_fd, EPOLL_CTL_ADD, si_port_fd[i], &x_event) < 0) {
+			si_port_fd[i] = -1;
+			sb_poll_ports = true;
+			continue;
+		}
+
+		sul_port_events[i] = EPOLLIN;
+	}
+}
+
+#endif
 
 /**
  * @brief addUsi_Init
@@ -56,17 +190,126 @@ void addUsi_Init(void)
 {
 	usi_Init();
 	usi_Start();
+#ifdef __linux__
+	_init_events();
+#endif
 }
 
 /**
  * @brief addUsi_Process
  * Use this function to process USI messages in TX and RX
- * Call this function periodically
+ * Call this function periodically, or every time the descriptor returned
+ * by addUsi_GetEventFd() is readable
  */
 void addUsi_Process(void)
 {
+#ifdef __linux__
+	uint64_t ull_count;
+	uint8_t i;
+
+	if (si_wakeup_fd >= 0) {
+		/* Clear pending wakeups, messages queued from now on signal it again */
+		if (read(si_wakeup_fd, &ull_count, sizeof(ull_count)) < 0) {
+			ull_count = 0;
+		}
+	}
+
+	sb_processing = true;
+	/* Chars already read from port do not make it readable again */
+	do {
+		usi_RxProcess();
+		usi_TxProcess();
+	} while (usi_RxPending());
+	sb_processing = false;
+
+	if (si_epoll_fd >= 0) {
+		for (i = 0; (i < usiCfgNumPorts) && (i < USI_MAX_EVENT_PORTS); i++) {
+			_update_port_events(i);
+		}
+	}
+#else
 	usi_RxProcess();
 	usi_TxProcess();
+#endif
+}
+
+/**
+ * @brief addUsi_GetEventFd
+ * Get a descriptor which becomes readable when USI has to be processed:
+ * data received on a port, a port ready to send pending chars or a new
+ * message queued. Applications can add it to their own poll set and call
+ * addUsi_Process() when it is readable, instead of using addUsi_RunLoop().
+ * Ports without file descriptor are not covered, they have to be polled.
+ * From then on, synchronous waits of the calling thread process USI
+ * themselves, as there is no USI thread to do it: call it right after
+ * addUsi_Init(), before any synchronous request.
+ * @return Descriptor, -1 if it is not available (call addUsi_Process()
+ * periodically then)
+ */
+int addUsi_GetEventFd(void)
+{
+#ifdef __linux__
+	sb_own_loop = true;
+	return si_epoll_fd;
+#else
+	return -1;
+#endif
+}
+
+/**
+ * @brief addUsi_RunLoop
+ * Process USI messages forever, sleeping while there is nothing to do.
+ * Use it as body of the USI thread instead of calling addUsi_Process()
+ * periodically.
+ */
+void addUsi_RunLoop(void)
+{
+#ifdef __linux__
+	struct epoll_event ax_events[USI_MAX_EVENT_PORTS + 1];
+	int i_timeout;
+
+	while (1) {
+		addUsi_Process();
+		if (si_epoll_fd < 0) {
+			usleep(USI_POLL_PERIOD_MS * 1000);
+			continue;
+		}
+
+		i_timeout = sb_poll_ports ? USI_POLL_PERIOD_MS : -1;
+		epoll_wait(si_epoll_fd, ax_events, USI_MAX_EVENT_PORTS + 1, i_timeout);
+	}
+#else
+	while (1) {
+		addUsi_Process();
+	}
+#endif
+}
+
+/**
+ * @brief addUsi_Wakeup
+ * Wake up USI processing. Called when a message is queued for transmission.
+ */
+void addUsi_Wakeup(void)
+{
+#ifdef __linux__
+	uint64_t ull_count = 1;
+
+	if (si_wakeup_fd >= 0) {
+		if (write(si_wakeup_fd, &ull_count, sizeof(ull_count)) < 0) {
+			/* Counter overflow: wakeup is already pending */
+		}
+	}
+#endif
+}
+
+/**
+ * @brief addUsi_GetFd
+ * Default port descriptor, for ports which do not provide it
+ * @return -1, the port is polled
+ */
+__attribute__((weak)) int32_t addUsi_GetFd(uint8_t port_type, uint8_t port)
+{
+	return -1;
 }
 
 /**
@@ -76,22 +319,118 @@ void addUsi_Process(void)
  * @param flag: Syncronous Flag pointer
   */
 void addUsi_WaitProcessing(uint8_t seconds, Bool *flag)
+{
+	addUsi_WaitProcessingMs((uint32_t)seconds * 1000, flag);
+}
+
+#ifdef __linux__
+/**
+ * @brief _wait_own_loop
+ * Process USI until the flag is activated or the deadline expires, for
+ * threads running their own USI loop
+ * @param x_deadline: Deadline on monotonic clock
+ * @param flag: Syncronous Flag pointer
+ */
+static void _wait_own_loop(const struct timespec *x_deadline, Bool *flag)
+{
+	struct epoll_event ax_events[USI_MAX_EVENT_PORTS + 1];
+	struct timespec x_now;
+	long l_left;
+
+	while (1) {
+		addUsi_Process();
+		if (*flag) {
+			break;
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &x_now);
+		l_left = (x_deadline->tv_sec - x_now.tv_sec) * 1000 + (x_deadline->tv_nsec - x_now.tv_nsec) / 1000000L;
+		if (l_left <= 0) {
+			break;
+		}
+
+		if ((sb_poll_ports || (si_epoll_fd < 0)) && (l_left > USI_POLL_PERIOD_MS)) {
+			l_left = USI_POLL_PERIOD_MS;
+		}
+
+		if (si_epoll_fd < 0) {
+			usleep(l_left * 1000);
+		} else {
+			epoll_wait(si_epoll_fd, ax_events, USI_MAX_EVENT_PORTS + 1, (int)l_left);
+		}
+	}
+}
+
+#endif
+
+/**
+ * @brief addUsi_WaitProcessingMs
+ * Use this function waiting for syncronous requests. The calling thread
+ * sleeps until the flag is activated with addUsi_SignalProcessing(), or
+ * timeout expires. Threads processing USI in their own loop (see
+ * addUsi_GetEventFd()) process it while waiting.
+ * @param ms: Milliseconds waiting for syncronous flag
+ * @param flag: Syncronous Flag pointer
+ */
+void addUsi_WaitProcessingMs(uint32_t ms, Bool *flag)
 {
 #ifdef __linux__
-	static time_t start_t;
-	static time_t end_t;
-	double diff_t = 0;
-
-	time(&start_t);
-	/* Wait for the defined time, or until the referenced flag activates */
-	while ((diff_t < seconds) && !*flag){
-		time(&end_t);
-		/* seconds_elapsed = ((end-start)/CLOCKS_PER_SEC); */
-		diff_t = difftime(end_t, start_t);
-		/* addUsi_Process();  / * Running on thread or ualarm * / */
-		/* 1ms waiting - Same timing than usiProcess() running on thread or ualarm */
-		usleep(1000);
+	struct timespec x_start;
+	struct timespec x_deadline;
+	struct timespec x_end;
+	Bool b_done;
+
+	pthread_once(&sx_sync_once, _init_sync);
+
+	/* Deadline on monotonic clock, not affected by system time changes */
+	clock_gettime(CLOCK_MONOTONIC, &x_start);
+	x_deadline = x_start;
+	x_deadline.tv_sec += ms / 1000;
+	x_deadline.tv_nsec += (long)(ms % 1000) * 1000000L;
+	if (x_deadline.tv_nsec >= 1000000000L) {
+		x_deadline.tv_sec++;
+		x_deadline.tv_nsec -= 1000000000L;
+	}
+
+	if (sb_own_loop && !sb_processing) {
+		/* Confirm is processed by this thread */
+		_wait_own_loop(&x_deadline, flag);
+		b_done = *flag;
+	} else {
+		/* Wait for the defined time, or until the referenced flag activates */
+		pthread_mutex_lock(&sx_sync_mutex);
+		while (!*flag) {
+			if (pthread_cond_timedwait(&sx_sync_cond, &sx_sync_mutex, &x_deadline) == ETIMEDOUT) {
+				break;
+			}
+		}
+		b_done = *flag;
+		pthread_mutex_unlock(&sx_sync_mutex);
 	}
+
+	/* Request to confirm latency */
+	clock_gettime(CLOCK_MONOTONIC, &x_end);
+	usi_AddLatency((uint32_t)((x_end.tv_sec - x_start.tv_sec) * 1000 + (x_end.tv_nsec - x_start.tv_nsec) / 1000000L), !b_done);
+#endif
+}
+
+/**
+ * @brief addUsi_SignalProcessing
+ * Use this function to activate a syncronous flag from the reception
+ * callbacks. Threads waiting on it are woken up.
+ * @param flag: Syncronous Flag pointer
+ */
+void addUsi_SignalProcessing(Bool *flag)
+{
+#ifdef __linux__
+	pthread_once(&sx_sync_once, _init_sync);
+
+	pthread_mutex_lock(&sx_sync_mutex);
+	*flag = true;
+	pthread_cond_broadcast(&sx_sync_cond);
+	pthread_mutex_unlock(&sx_sync_mutex);
+#else
+	*flag = true;
 #endif
 }
 
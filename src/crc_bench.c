@@ -0,0 +1,219 @@
+/**
+ * \file
+ *
+ * \brief crc_bench : USI CRC engine throughput against the byte loop reference
+ *
+ * Copyright (c) 2021 Microchip Technology Inc. and its subsidiaries.
+ *
+ * \asf_license_start
+ *
+ * \page License
+ *
+ * Subject to your compliance with these terms, you may use Microchip
+ * software and any derivatives exclusively with Microchip products.
+ * It is your responsibility to comply with third party license terms applicable
+ * to your use of third party software (including open source software) that
+ * may accompany Microchip software.
+ *
+ * THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES,
+ * WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE,
+ * INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY,
+ * AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT WILL MICROCHIP BE
+ * LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, INCIDENTAL OR CONSEQUENTIAL
+ * LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND WHATSOEVER RELATED TO THE
+ * SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS BEEN ADVISED OF THE
+ * POSSIBILITY OR THE DAMAGES ARE FORESEEABLE.  TO THE FULLEST EXTENT
+ * ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN ANY WAY
+ * RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+ * THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+ *
+ * \asf_license_stop
+ *
+ */
+
+/* Build: make crc_bench (g3coordd_linux). Usage: crc_bench [iterations] */
+/* Known answer tests are run first, then the sliced CRCs are checked and */
+/* timed against the one table, byte at a time loop they replaced. */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "UsiCrc.h"
+
+#define BENCH_DEFAULT_ITERATIONS   20000
+
+/* USI frame sizes: short command, max PRIME MAC frame, max USI buffer */
+static const uint32_t s_aul_sizes[] = {64, 1280, 4096};
+
+static uint32_t s_aul_crc32_table[256];
+static uint16_t s_aus_crc16_table[256];
+
+static uint64_t _now_ns(void)
+{
+	struct timespec x_ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &x_ts);
+	return (uint64_t)x_ts.tv_sec * 1000000000ull + x_ts.tv_nsec;
+}
+
+/* Reference: CRC32 polynomial 0x04C11DB7 and CRC16 polynomial 0x1021, MSB first */
+static void _ref_tables(void)
+{
+	uint32_t ul_crc;
+	uint16_t us_crc;
+	int i, j;
+
+	for (i = 0; i < 256; i++) {
+		ul_crc = (uint32_t)i << 24;
+		us_crc = (uint16_t)(i << 8);
+		for (j = 0; j < 8; j++) {
+			ul_crc = (ul_crc & 0x80000000) ? (ul_crc << 1) ^ 0x04C11DB7 : (ul_crc << 1);
+			us_crc = (us_crc & 0x8000) ? (uint16_t)((us_crc << 1) ^ 0x1021) : (uint16_t)(us_crc << 1);
+		}
+
+		s_aul_crc32_table[i] = ul_crc;
+		s_aus_crc16_table[i] = us_crc;
+	}
+}
+
+static uint32_t _ref_crc32(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+	while (len--) {
+		crc = (crc << 8) ^ s_aul_crc32_table[(uint8_t)(crc >> 24) ^ *buf++];
+	}
+
+	return crc;
+}
+
+static uint16_t _ref_crc16(uint16_t crc, const uint8_t *buf, uint32_t len)
+{
+	while (len--) {
+		crc = (uint16_t)(s_aus_crc16_table[crc >> 8] ^ (crc << 8) ^ *buf++);
+	}
+
+	return crc;
+}
+
+static uint8_t _ref_crc8(uint8_t crc, const uint8_t *buf, uint32_t len)
+{
+	while (len--) {
+		crc ^= *buf++;
+	}
+
+	return crc;
+}
+
+/* Sliced and reference must agree on every length and alignment up to 4 KB */
+static int _known_answer_tests(const uint8_t *puc_data, uint32_t ul_len)
+{
+	uint32_t ul_off, ul_n;
+	int i_errors;
+	int i_mismatch = 0;
+
+	printf("Known answer tests\n");
+	i_errors = usi_CrcSelfTest() ? 0 : 1;
+	printf("  %-28s %s\n", "usi_CrcSelfTest", (i_errors == 0) ? "ok" : "FAILED");
+
+	for (ul_off = 0; ul_off < 8; ul_off++) {
+		for (ul_n = 0; ul_n + ul_off <= ul_len; ul_n += (ul_n < 64) ? 1 : 61) {
+			if ((usi_Crc32(USI_CRC32_INIT, puc_data + ul_off, ul_n) != _ref_crc32(USI_CRC32_INIT, puc_data + ul_off, ul_n)) ||
+			    (usi_Crc16(USI_CRC16_INIT, puc_data + ul_off, ul_n) != _ref_crc16(USI_CRC16_INIT, puc_data + ul_off, ul_n)) ||
+			    (usi_Crc8(USI_CRC8_INIT, puc_data + ul_off, ul_n) != _ref_crc8(USI_CRC8_INIT, puc_data + ul_off, ul_n))) {
+				i_mismatch++;
+			}
+		}
+	}
+
+	printf("  %-28s %s\n", "sliced == byte loop", (i_mismatch == 0) ? "ok" : "FAILED");
+	return i_errors + i_mismatch;
+}
+
+static void _report(const char *sz_name, uint32_t ul_len, uint32_t ul_iterations, uint64_t ull_ns, uint64_t ull_ref_ns)
+{
+	double d_s = (double)ull_ns / 1e9;
+
+	printf("  %-16s %4u bytes %10.2f MB/s %8.0f ns/msg %6.2fx\n", sz_name, (unsigned int)ul_len,
+			(double)ul_len * ul_iterations / d_s / 1e6, (double)ull_ns / ul_iterations,
+			(double)ull_ref_ns / (double)ull_ns);
+}
+
+static void _bench(const uint8_t *puc_data, uint32_t ul_iterations)
+{
+	volatile uint32_t ul_sink = 0;
+	uint64_t ull_start, ull_ref;
+	uint32_t i, ul_len;
+	size_t j;
+
+	printf("%u messages per measure, speedup against the byte loop\n", ul_iterations);
+	for (j = 0; j < sizeof(s_aul_sizes) / sizeof(s_aul_sizes[0]); j++) {
+		ul_len = s_aul_sizes[j];
+
+		ull_start = _now_ns();
+		for (i = 0; i < ul_iterations; i++) {
+			ul_sink += _ref_crc32(i, puc_data, ul_len);
+		}
+		ull_ref = _now_ns() - ull_start;
+		_report("CRC32 byte loop", ul_len, ul_iterations, ull_ref, ull_ref);
+		ull_start = _now_ns();
+		for (i = 0; i < ul_iterations; i++) {
+			ul_sink += usi_Crc32(i, puc_data, ul_len);
+		}
+		_report("CRC32 sliced", ul_len, ul_iterations, _now_ns() - ull_start, ull_ref);
+
+		ull_start = _now_ns();
+		for (i = 0; i < ul_iterations; i++) {
+			ul_sink += _ref_crc16((uint16_t)i, puc_data, ul_len);
+		}
+		ull_ref = _now_ns() - ull_start;
+		_report("CRC16 byte loop", ul_len, ul_iterations, ull_ref, ull_ref);
+		ull_start = _now_ns();
+		for (i = 0; i < ul_iterations; i++) {
+			ul_sink += usi_Crc16((uint16_t)i, puc_data, ul_len);
+		}
+		_report("CRC16 sliced", ul_len, ul_iterations, _now_ns() - ull_start, ull_ref);
+
+		ull_start = _now_ns();
+		for (i = 0; i < ul_iterations; i++) {
+			ul_sink += _ref_crc8((uint8_t)i, puc_data, ul_len);
+		}
+		ull_ref = _now_ns() - ull_start;
+		_report("CRC8 byte loop", ul_len, ul_iterations, ull_ref, ull_ref);
+		ull_start = _now_ns();
+		for (i = 0; i < ul_iterations; i++) {
+			ul_sink += usi_Crc8((uint8_t)i, puc_data, ul_len);
+		}
+		_report("CRC8 sliced", ul_len, ul_iterations, _now_ns() - ull_start, ull_ref);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t ul_iterations = BENCH_DEFAULT_ITERATIONS;
+	static uint8_t auc_data[4096 + 8];
+	uint32_t i;
+
+	if (argc > 1) {
+		ul_iterations = (uint32_t)strtoul(argv[1], NULL, 0);
+		if (ul_iterations == 0) {
+			ul_iterations = BENCH_DEFAULT_ITERATIONS;
+		}
+	}
+
+	srand(1);
+	for (i = 0; i < sizeof(auc_data); i++) {
+		auc_data[i] = (uint8_t)rand();
+	}
+
+	_ref_tables();
+	if (_known_answer_tests(auc_data, sizeof(auc_data)) != 0) {
+		return 1;
+	}
+
+	_bench(auc_data, ul_iterations);
+
+	return 0;
+}
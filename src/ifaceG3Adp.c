@@ -37,6 +37,7 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
+#include <pthread.h>
 
 #include "../addUsi.h"
 #include "../G3.h"
@@ -53,25 +54,213 @@
 #define LOG_IFACE_G3_ADP(X...)
 
 /* Buffer for USI Frame Message Data Field */
-static Uint8 buffTxAdpG3[G3_MACSAP_DATA_SIZE];
+static PAN_LOCAL Uint8 buffTxAdpG3[G3_MACSAP_DATA_SIZE];
 /* Global Command Params for ADP */
-static CmdParams adpG3Msg;
+static PAN_LOCAL CmdParams adpG3Msg;
 
 /* Callbacks */
-struct TAdpNotifications g_adpNotifications;
+PAN_LOCAL struct TAdpNotifications g_adpNotifications;
+
+/* Maximum number of syncronous requests waiting for their confirm at the same time */
+#ifndef ADP_SYNC_MAX_REQUESTS
+#define ADP_SYNC_MAX_REQUESTS   8
+#endif
 
 /* *** Structures ************************************************************ */
+enum adp_sync_type {
+	ADP_SYNC_GET,
+	ADP_SYNC_SET,
+	ADP_SYNC_MAC_GET,
+	ADP_SYNC_MAC_SET
+};
+
 typedef struct {
-	bool f_sync_req;                       /* Flag to indicate syncronous request */
+	bool f_sync_req;                       /* Flag to indicate syncronous request (entry in use) */
 	bool f_sync_res;                       /* Flag to indicate syncronous response */
-	uint32_t m_u32AttributeId;             /* In order to handle correctly syncronous requests */
-	struct TAdpGetConfirm s_GetConfirm;    /* Adp Get Confirm callback struct */
-	struct TAdpSetConfirm s_SetConfirm;    /* Adp Set Confirm callback struct */
-	struct TAdpMacGetConfirm s_MacGetConfirm; /* Adp Mac Get Confirm callback struct */
-	struct TAdpMacSetConfirm s_MacSetConfirm; /* Adp Mac Set Confirm callback struct */
+	uint8_t m_u8Type;                      /* Requested primitive (adp_sync_type) */
+	uint32_t m_u32AttributeId;             /* Attribute Id and Index match the confirm with the request */
+	uint16_t m_u16AttributeIndex;
+	void *m_pConfirm;                      /* Confirm struct of the requester, filled on confirm callback */
+} T_adp_sync_req;
+
+typedef struct {
+	uint8_t m_u8Pending;                   /* Number of requests waiting for confirm */
+	T_adp_sync_req s_req[ADP_SYNC_MAX_REQUESTS];
 } T_adp_sync_mgmt;
 
-T_adp_sync_mgmt g_adp_sync_mgmt;
+PAN_LOCAL T_adp_sync_mgmt g_adp_sync_mgmt;
+/* Protects the request table */
+static PAN_LOCAL pthread_mutex_t s_adp_sync_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**********************************************************************************************************************/
+
+/** Add a syncronous request to the request table.
+ ***********************************************************************************************************************
+ * @param u8Type Requested primitive.
+ * @param u32AttributeId The identifier of the IB attribute.
+ * @param u16AttributeIndex The index within the table of the specified IB attribute.
+ * @param pConfirm Confirm struct to fill when the confirm is received.
+ * @return Request entry, NULL if the table is full.
+ **********************************************************************************************************************/
+static T_adp_sync_req *_adp_sync_add(uint8_t u8Type, uint32_t u32AttributeId, uint16_t u16AttributeIndex, void *pConfirm)
+{
+	T_adp_sync_req *px_req = NULL;
+	uint8_t i;
+
+	pthread_mutex_lock(&s_adp_sync_mutex);
+	for (i = 0; i < ADP_SYNC_MAX_REQUESTS; i++) {
+		if (!g_adp_sync_mgmt.s_req[i].f_sync_req) {
+			px_req = &g_adp_sync_mgmt.s_req[i];
+			px_req->f_sync_req = true;
+			px_req->f_sync_res = false;
+			px_req->m_u8Type = u8Type;
+			px_req->m_u32AttributeId = u32AttributeId;
+			px_req->m_u16AttributeIndex = u16AttributeIndex;
+			px_req->m_pConfirm = pConfirm;
+			g_adp_sync_mgmt.m_u8Pending++;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&s_adp_sync_mutex);
+
+	return(px_req);
+}
+
+/**********************************************************************************************************************/
+
+/** Remove a syncronous request from the request table.
+ ***********************************************************************************************************************
+ * @param px_req Request entry.
+ * @return true if the confirm was received, false otherwise.
+ **********************************************************************************************************************/
+static bool _adp_sync_remove(T_adp_sync_req *px_req)
+{
+	bool b_res;
+
+	pthread_mutex_lock(&s_adp_sync_mutex);
+	b_res = px_req->f_sync_res;
+	px_req->f_sync_req = false;
+	px_req->f_sync_res = false;
+	g_adp_sync_mgmt.m_u8Pending--;
+	pthread_mutex_unlock(&s_adp_sync_mutex);
+
+	return(b_res);
+}
+
+/**********************************************************************************************************************/
+
+/** Deliver a confirm to the syncronous request waiting for it, if any.
+ ***********************************************************************************************************************
+ * @param u8Type Confirmed primitive.
+ * @param u32AttributeId The identifier of the IB attribute.
+ * @param u16AttributeIndex The index within the table of the specified IB attribute.
+ * @param pConfirm Received confirm struct.
+ * @param u16Size Size of the confirm struct.
+ **********************************************************************************************************************/
+static void _adp_sync_confirm(uint8_t u8Type, uint32_t u32AttributeId, uint16_t u16AttributeIndex,
+		const void *pConfirm, uint16_t u16Size)
+{
+	T_adp_sync_req *px_req;
+	uint8_t i;
+
+	pthread_mutex_lock(&s_adp_sync_mutex);
+	for (i = 0; i < ADP_SYNC_MAX_REQUESTS; i++) {
+		px_req = &g_adp_sync_mgmt.s_req[i];
+		if (px_req->f_sync_req && !px_req->f_sync_res && (px_req->m_u8Type == u8Type) &&
+				(px_req->m_u32AttributeId == u32AttributeId) && (px_req->m_u16AttributeIndex == u16AttributeIndex)) {
+			/* Synchronous call -> Store the result */
+			LOG_IFACE_G3_ADP("Synchronous Call pending; copying received structure\r\n");
+			memcpy(px_req->m_pConfirm, pConfirm, u16Size);
+			/* Signaled with the table locked, so the entry cannot be reused meanwhile */
+			addUsi_SignalProcessing((Bool *)&px_req->f_sync_res);
+			break;
+		}
+	}
+	pthread_mutex_unlock(&s_adp_sync_mutex);
+}
+
+/**********************************************************************************************************************/
+
+/** Send a list of requests keeping up to ADP_SYNC_MAX_REQUESTS of them outstanding, and collect their confirms.
+ * The modem answers in order, so the oldest outstanding request is the one waited for, while the confirms of the
+ * following ones are stored as they arrive.
+ ***********************************************************************************************************************
+ * @param u8Type Requested primitive (ADP_SYNC_GET or ADP_SYNC_SET when pbMac is used).
+ * @param pRequests Attributes to request.
+ * @param pbMac Optional, true for the attributes of the MAC information base (mixed list).
+ * @param u16Count Number of attributes.
+ * @param pu8Confirms Array of confirm structs, one per attribute.
+ * @param u16Size Size of each confirm struct.
+ **********************************************************************************************************************/
+static void _adp_sync_request_multi(uint8_t u8Type, const struct TAdpPibRequest *pRequests, const bool *pbMac,
+		uint16_t u16Count, uint8_t *pu8Confirms, uint16_t u16Size)
+{
+	T_adp_sync_req *apx_req[ADP_SYNC_MAX_REQUESTS];
+	const struct TAdpPibRequest *px_pib;
+	uint16_t us_sent = 0;
+	uint16_t us_done = 0;
+	T_adp_sync_req *px_req;
+	uint8_t u8ReqType;
+
+	while (us_done < u16Count) {
+		/* Fill the window of outstanding requests */
+		while ((us_sent < u16Count) && ((us_sent - us_done) < ADP_SYNC_MAX_REQUESTS)) {
+			px_pib = &pRequests[us_sent];
+			u8ReqType = u8Type;
+			if ((pbMac != NULL) && pbMac[us_sent]) {
+				u8ReqType = (u8Type == ADP_SYNC_GET) ? ADP_SYNC_MAC_GET : ADP_SYNC_MAC_SET;
+			}
+
+			px_req = _adp_sync_add(u8ReqType, px_pib->m_u32AttributeId, px_pib->m_u16AttributeIndex, pu8Confirms + (us_sent * u16Size));
+			if (px_req == NULL) {
+				break;
+			}
+
+			apx_req[us_sent % ADP_SYNC_MAX_REQUESTS] = px_req;
+			switch (u8ReqType) {
+			case ADP_SYNC_GET:
+				AdpGetRequest(px_pib->m_u32AttributeId, px_pib->m_u16AttributeIndex);
+				break;
+
+			case ADP_SYNC_SET:
+				AdpSetRequest(px_pib->m_u32AttributeId, px_pib->m_u16AttributeIndex, px_pib->m_u8AttributeLength, px_pib->m_pu8AttributeValue);
+				break;
+
+			case ADP_SYNC_MAC_GET:
+				AdpMacGetRequest(px_pib->m_u32AttributeId, px_pib->m_u16AttributeIndex);
+				break;
+
+			case ADP_SYNC_MAC_SET:
+			default:
+				AdpMacSetRequest(px_pib->m_u32AttributeId, px_pib->m_u16AttributeIndex, px_pib->m_u8AttributeLength, px_pib->m_pu8AttributeValue);
+				break;
+			}
+
+			us_sent++;
+		}
+
+		if (us_sent == us_done) {
+			/* Request table full with requests from other threads */
+			/* m_u8Status is the first field of every confirm struct */
+			pu8Confirms[us_done * u16Size] = G3_BUSY;
+			LOG_IFACE_G3_ADP("ERROR: No room for request 0x%X\r\n", pRequests[us_done].m_u32AttributeId);
+			us_sent++;
+			us_done++;
+			continue;
+		}
+
+		/* Wait for the oldest outstanding request */
+		px_req = apx_req[us_done % ADP_SYNC_MAX_REQUESTS];
+		addUsi_WaitProcessing(G3_SYNC_TIMEOUT, (Bool *)(&px_req->f_sync_res));
+		if (!_adp_sync_remove(px_req)) {
+			/* Confirm not received */
+			pu8Confirms[us_done * u16Size] = G3_TIMEOUT;
+			LOG_IFACE_G3_ADP("ERROR: Confirm for 0x%X not received\r\n", pRequests[us_done].m_u32AttributeId);
+		}
+
+		us_done++;
+	}
+}
 
 /**********************************************************************************************************************/
 
@@ -111,10 +300,6 @@ void AdpInitialize(struct TAdpNotifications *pNotifications, enum TAdpBand band)
 	/* Send USI Frame */
 	result = usi_SendCmd(&adpG3Msg) ? 0 : -1;
 
-	/* Set sync flags to false */
-	g_adp_sync_mgmt.f_sync_req = false;
-	g_adp_sync_mgmt.f_sync_res = false;
-
 	LOG_IFACE_G3_ADP("AdpInitialize result = %d\r\n", result);
 }
 
@@ -487,21 +672,24 @@ void AdpGetRequestSync(uint32_t u32AttributeId, uint16_t u16AttributeIndex,
 {
 	uint8_t result = -1;
 
+	T_adp_sync_req *px_req;
+
 	LOG_IFACE_G3_ADP("AdpGetRequestSync attr = 0x%X; index = 0x%X\r\n", u32AttributeId, u16AttributeIndex);
-	/* Set the sync flags to intercept the callback */
-	g_adp_sync_mgmt.f_sync_req = true;
-	g_adp_sync_mgmt.f_sync_res = false;
-	g_adp_sync_mgmt.m_u32AttributeId = u32AttributeId; /* Used in order to know AttributeId requested on AdpGetConfirm callback */
+	/* Register the request to intercept the callback */
+	px_req = _adp_sync_add(ADP_SYNC_GET, u32AttributeId, u16AttributeIndex, pGetConfirm);
+	if (px_req == NULL) {
+		pGetConfirm->m_u8Status = G3_BUSY;
+		return;
+	}
 
 	/* Send the asynchronous call */
 	AdpGetRequest(u32AttributeId, u16AttributeIndex);
 
 	/* Wait processing until flag activates, or timeout */
-	addUsi_WaitProcessing(G3_SYNC_TIMEOUT, (Bool *)(&g_adp_sync_mgmt.f_sync_res));
+	addUsi_WaitProcessing(G3_SYNC_TIMEOUT, (Bool *)(&px_req->f_sync_res));
 
-	if (g_adp_sync_mgmt.f_sync_res) {
-		/* pGetConfirm = &(g_adp_sync_mgmt.s_GetConfirm); */
-		memcpy(pGetConfirm, &g_adp_sync_mgmt.s_GetConfirm, sizeof(struct TAdpGetConfirm));
+	if (_adp_sync_remove(px_req)) {
+		/* Confirm received, already copied on pGetConfirm */
 		result = 0;
 	} else {
 		/* Confirm not received */
@@ -509,13 +697,27 @@ void AdpGetRequestSync(uint32_t u32AttributeId, uint16_t u16AttributeIndex,
 		LOG_IFACE_G3_ADP("ERROR: Confirm for 0x%X not received\r\n", u32AttributeId);
 	}
 
-	g_adp_sync_mgmt.f_sync_req = false;
-	g_adp_sync_mgmt.f_sync_res = false;
 	LOG_IFACE_G3_ADP("AdpGetRequestSync result = %d\r\n", result);
 }
 
 /**********************************************************************************************************************/
 
+/** The AdpGetRequestMulti primitive allows the upper layer to get several attributes from the ADP information base
+ * synchronously. Requests are sent back-to-back, without waiting for the confirm of the previous one.
+ ***********************************************************************************************************************
+ * @param pRequests The ADP IB attributes to get.
+ * @param u16Count Number of attributes.
+ * @param pGetConfirms Get results, one per attribute.
+ **********************************************************************************************************************/
+void AdpGetRequestMulti(const struct TAdpPibRequest *pRequests, uint16_t u16Count,
+		struct TAdpGetConfirm *pGetConfirms)
+{
+	LOG_IFACE_G3_ADP("AdpGetRequestMulti count = %u\r\n", u16Count);
+	_adp_sync_request_multi(ADP_SYNC_GET, pRequests, NULL, u16Count, (uint8_t *)pGetConfirms, sizeof(struct TAdpGetConfirm));
+}
+
+/**********************************************************************************************************************/
+
 /** The AdpGetConfirm primitive allows the upper layer to be notified of the completion of an AdpGetRequest.
  ***********************************************************************************************************************
  * @param m_u8Status The status of the request.
@@ -575,23 +777,25 @@ void AdpMacGetRequestSync(uint32_t u32AttributeId, uint16_t u16AttributeIndex,
 {
 	uint8_t result = -1;
 
+	T_adp_sync_req *px_req;
+
 	LOG_IFACE_G3_ADP("AdpMacGetRequestSync attr = 0x%X - index = 0x%X\r\n", u32AttributeId, u16AttributeIndex);
 
-	/* Set the sync flags to intercept the callback */
-	g_adp_sync_mgmt.f_sync_req = true;
-	g_adp_sync_mgmt.f_sync_res = false;
-	g_adp_sync_mgmt.m_u32AttributeId = u32AttributeId; /* Used in order to know AttributeId requested on AdpMacGetConfirm callback */
+	/* Register the request to intercept the callback */
+	px_req = _adp_sync_add(ADP_SYNC_MAC_GET, u32AttributeId, u16AttributeIndex, pGetConfirm);
+	if (px_req == NULL) {
+		pGetConfirm->m_u8Status = G3_BUSY;
+		return;
+	}
 
 	/* Send the asynchronous call */
 	AdpMacGetRequest(u32AttributeId, u16AttributeIndex);
 
 	/* Wait processing until flag activates, or timeout */
-	addUsi_WaitProcessing(G3_SYNC_TIMEOUT, (Bool *)(&g_adp_sync_mgmt.f_sync_res));
+	addUsi_WaitProcessing(G3_SYNC_TIMEOUT, (Bool *)(&px_req->f_sync_res));
 
-	if (g_adp_sync_mgmt.f_sync_res) {
-		/* Confirm received */
-		/* pGetConfirm = &g_adp_sync_mgmt.s_MacGetConfirm; */
-		memcpy(pGetConfirm, &g_adp_sync_mgmt.s_MacGetConfirm, sizeof(struct TAdpMacGetConfirm));
+	if (_adp_sync_remove(px_req)) {
+		/* Confirm received, already copied on pGetConfirm */
 		result = 0;
 	} else {
 		/* Confirm not received */
@@ -599,14 +803,27 @@ void AdpMacGetRequestSync(uint32_t u32AttributeId, uint16_t u16AttributeIndex,
 		LOG_IFACE_G3_ADP("ERROR: Confirm for 0x%X not received\r\n", u32AttributeId);
 	}
 
-	g_adp_sync_mgmt.f_sync_req = false;
-	g_adp_sync_mgmt.f_sync_res = false;
-
 	LOG_IFACE_G3_ADP("AdpMacGetRequestSync result = %d\r\n", result);
 }
 
 /**********************************************************************************************************************/
 
+/** The AdpMacGetRequestMulti primitive allows the upper layer to get several attributes from the MAC information base
+ * synchronously. Requests are sent back-to-back, without waiting for the confirm of the previous one.
+ ***********************************************************************************************************************
+ * @param pRequests The MAC IB attributes to get.
+ * @param u16Count Number of attributes.
+ * @param pGetConfirms Get results, one per attribute.
+ **********************************************************************************************************************/
+void AdpMacGetRequestMulti(const struct TAdpPibRequest *pRequests, uint16_t u16Count,
+		struct TAdpMacGetConfirm *pGetConfirms)
+{
+	LOG_IFACE_G3_ADP("AdpMacGetRequestMulti count = %u\r\n", u16Count);
+	_adp_sync_request_multi(ADP_SYNC_MAC_GET, pRequests, NULL, u16Count, (uint8_t *)pGetConfirms, sizeof(struct TAdpMacGetConfirm));
+}
+
+/**********************************************************************************************************************/
+
 /** The AdpMacGetConfirm primitive allows the upper layer to be notified of the completion of an AdpMacGetRequest.
  ***********************************************************************************************************************
  * @param m_u8Status The status of the scan request.
@@ -1135,23 +1352,25 @@ void AdpSetRequestSync(uint32_t u32AttributeId, uint16_t u16AttributeIndex,
 {
 	uint8_t result = -1;
 
+	T_adp_sync_req *px_req;
+
 	LOG_IFACE_G3_ADP("AdpSetRequestSync attr = 0x%X - index = 0x%X\r\n", u32AttributeId, u16AttributeIndex);
 
-	/* Set the sync flags to intercept the callback */
-	g_adp_sync_mgmt.f_sync_req = true;
-	g_adp_sync_mgmt.m_u32AttributeId = u32AttributeId; /* Used in order to know AttributeId requested on AdpSetConfirm callback */
-	g_adp_sync_mgmt.f_sync_res = false;
+	/* Register the request to intercept the callback */
+	px_req = _adp_sync_add(ADP_SYNC_SET, u32AttributeId, u16AttributeIndex, pSetConfirm);
+	if (px_req == NULL) {
+		pSetConfirm->m_u8Status = G3_BUSY;
+		return;
+	}
 
 	/* Send the asynchronous call */
 	AdpSetRequest(u32AttributeId, u16AttributeIndex, u8AttributeLength, pu8AttributeValue);
 
 	/* Wait processing until flag activates, or timeout */
-	addUsi_WaitProcessing(G3_SYNC_TIMEOUT, (Bool *)(&g_adp_sync_mgmt.f_sync_res));
+	addUsi_WaitProcessing(G3_SYNC_TIMEOUT, (Bool *)(&px_req->f_sync_res));
 
-	if (g_adp_sync_mgmt.f_sync_res) {
-		/* Confirm received */
-		/* pSetConfirm = &g_adp_sync_mgmt.s_SetConfirm; */
-		memcpy(pSetConfirm, &g_adp_sync_mgmt.s_SetConfirm, sizeof(struct TAdpSetConfirm));
+	if (_adp_sync_remove(px_req)) {
+		/* Confirm received, already copied on pSetConfirm */
 		result = 0;
 	} else {
 		/* Confirm not received */
@@ -1159,14 +1378,27 @@ void AdpSetRequestSync(uint32_t u32AttributeId, uint16_t u16AttributeIndex,
 		LOG_IFACE_G3_ADP("ERROR: Confirm not received\r\n");
 	}
 
-	g_adp_sync_mgmt.f_sync_req = false;
-	g_adp_sync_mgmt.f_sync_res = false;
-
 	LOG_IFACE_G3_ADP("AdpSetRequestSync result = %u\r\n", result);
 }
 
 /**********************************************************************************************************************/
 
+/** The AdpSetRequestMulti primitive allows the upper layer to set several attributes in the ADP information base
+ * synchronously. Requests are sent back-to-back, without waiting for the confirm of the previous one.
+ ***********************************************************************************************************************
+ * @param pRequests The ADP IB attributes to set.
+ * @param u16Count Number of attributes.
+ * @param pSetConfirms Set results, one per attribute.
+ **********************************************************************************************************************/
+void AdpSetRequestMulti(const struct TAdpPibRequest *pRequests, uint16_t u16Count,
+		struct TAdpSetConfirm *pSetConfirms)
+{
+	LOG_IFACE_G3_ADP("AdpSetRequestMulti count = %u\r\n", u16Count);
+	_adp_sync_request_multi(ADP_SYNC_SET, pRequests, NULL, u16Count, (uint8_t *)pSetConfirms, sizeof(struct TAdpSetConfirm));
+}
+
+/**********************************************************************************************************************/
+
 /* The AdpMacSetRequest primitive allows the upper layer to set the value of an attribute in the MAC information base.
  * The upper layer cannot access directly the MAC layer while ADP is running
  ***********************************************************************************************************************
@@ -2161,37 +2393,71 @@ void AdpMacSetRequestSync(uint32_t u32AttributeId, uint16_t u16AttributeIndex,
 {
 	uint8_t result = -1;
 
+	T_adp_sync_req *px_req;
+
 	LOG_IFACE_G3_ADP("AdpMacSetRequestSync start\r\n");
 
-	/* Set the sync flags to intercept the callback */
-	g_adp_sync_mgmt.f_sync_req = true;
-	g_adp_sync_mgmt.m_u32AttributeId = u32AttributeId; /* Used in order to know AttributeId requested on AdpMacSetConfirm callback */
-	g_adp_sync_mgmt.f_sync_res = false;
+	/* Register the request to intercept the callback */
+	px_req = _adp_sync_add(ADP_SYNC_MAC_SET, u32AttributeId, u16AttributeIndex, pSetConfirm);
+	if (px_req == NULL) {
+		pSetConfirm->m_u8Status = G3_BUSY;
+		return;
+	}
 
 	/* Send the asynchronous call */
 	AdpMacSetRequest(u32AttributeId, u16AttributeIndex, u8AttributeLength, pu8AttributeValue);
 
 	/* Wait processing until flag activates, or timeout */
-	addUsi_WaitProcessing(G3_SYNC_TIMEOUT, (Bool *)(&g_adp_sync_mgmt.f_sync_res));
+	addUsi_WaitProcessing(G3_SYNC_TIMEOUT, (Bool *)(&px_req->f_sync_res));
 
-	if (g_adp_sync_mgmt.f_sync_res) {
-		/* Confirm received */
-		/* pSetConfirm = &g_adp_sync_mgmt.s_MacSetConfirm; */
-		memcpy(pSetConfirm, &g_adp_sync_mgmt.s_MacSetConfirm, sizeof(struct TAdpMacSetConfirm));
+	if (_adp_sync_remove(px_req)) {
+		/* Confirm received, already copied on pSetConfirm */
 		result = 0;
 	} else {
 		/* Confirm not received */
+		pSetConfirm->m_u8Status = G3_TIMEOUT;
 		LOG_IFACE_G3_ADP("ERROR: Confirm for 0x%X not received\r\n", u32AttributeId);
 	}
 
-	g_adp_sync_mgmt.f_sync_req = false;
-	g_adp_sync_mgmt.f_sync_res = false;
-
 	LOG_IFACE_G3_ADP("AdpMacSetRequestSync result = %u\r\n", result);
 }
 
 /**********************************************************************************************************************/
 
+/** The AdpMacSetRequestMulti primitive allows the upper layer to set several attributes in the MAC information base
+ * synchronously. Requests are sent back-to-back, without waiting for the confirm of the previous one.
+ ***********************************************************************************************************************
+ * @param pRequests The MAC IB attributes to set.
+ * @param u16Count Number of attributes.
+ * @param pSetConfirms Set results, one per attribute.
+ **********************************************************************************************************************/
+void AdpMacSetRequestMulti(const struct TAdpPibRequest *pRequests, uint16_t u16Count,
+		struct TAdpMacSetConfirm *pSetConfirms)
+{
+	LOG_IFACE_G3_ADP("AdpMacSetRequestMulti count = %u\r\n", u16Count);
+	_adp_sync_request_multi(ADP_SYNC_MAC_SET, pRequests, NULL, u16Count, (uint8_t *)pSetConfirms, sizeof(struct TAdpMacSetConfirm));
+}
+
+/**********************************************************************************************************************/
+
+/** The AdpMibSetRequestMulti primitive allows the upper layer to set several attributes of the ADP and MAC information
+ * bases synchronously, in a single pipeline. Requests are sent back-to-back in the given order, without waiting for the
+ * confirm of the previous one, also when the layer changes.
+ ***********************************************************************************************************************
+ * @param pRequests The IB attributes to set.
+ * @param pbMac For each attribute, true if it belongs to the MAC information base.
+ * @param u16Count Number of attributes.
+ * @param pSetConfirms Set results, one per attribute (TAdpMacSetConfirm has the same layout).
+ **********************************************************************************************************************/
+void AdpMibSetRequestMulti(const struct TAdpPibRequest *pRequests, const bool *pbMac, uint16_t u16Count,
+		struct TAdpSetConfirm *pSetConfirms)
+{
+	LOG_IFACE_G3_ADP("AdpMibSetRequestMulti count = %u\r\n", u16Count);
+	_adp_sync_request_multi(ADP_SYNC_SET, pRequests, pbMac, u16Count, (uint8_t *)pSetConfirms, sizeof(struct TAdpSetConfirm));
+}
+
+/**********************************************************************************************************************/
+
 /* The AdpNetworkStatusIndication primitive allows the next higher layer of a PAN coordinator or a coordinator to be
  * notified when a particular event occurs on the PAN.
  **********************************************************************************************************************
@@ -2430,13 +2696,11 @@ uint8_t _cl_null_adpDataIndication_cb(uint8_t *ptrMsg, uint16_t len)
 		adpDataIndication.m_u8LinkQualityIndicator = (*ptrMsg++);
 		adpDataIndication.m_u16NsduLength = (*ptrMsg++);
 		adpDataIndication.m_u16NsduLength = (*ptrMsg++) + (adpDataIndication.m_u16NsduLength << 8);
-		/* If the length matches, the NSDU is copied */
+		/* If the length matches, the NSDU is passed in the USI frame, without copying it */
 		if (len == adpDataIndication.m_u16NsduLength + 3) {
-			adpDataIndication.m_pNsdu = (uint8_t *)malloc(adpDataIndication.m_u16NsduLength * sizeof(uint8_t));
-			memcpy((uint8_t *)adpDataIndication.m_pNsdu, ptrMsg, adpDataIndication.m_u16NsduLength);
+			adpDataIndication.m_pNsdu = ptrMsg;
 			/* Trigger the callback */
 			g_adpNotifications.fnctAdpDataIndication(&adpDataIndication); /* lqi, nsdu_len, nsdu); */
-			free((uint8_t *)(adpDataIndication.m_pNsdu));
 		} else {
 			LOG_IFACE_G3_ADP("ERROR: wrong indication length.\r\n");
 			return(false);
@@ -2774,7 +3038,7 @@ uint8_t _cl_null_adpSetConfirm_cb(uint8_t *ptrMsg, uint16_t len)
 		return(false);
 	}
 
-	if (g_adp_sync_mgmt.f_sync_req || g_adpNotifications.fnctAdpSetConfirm) {
+	if (g_adp_sync_mgmt.m_u8Pending || g_adpNotifications.fnctAdpSetConfirm) {
 		struct TAdpSetConfirm adpSetConfirm;
 		adpSetConfirm.m_u8Status = (*ptrMsg++);
 		adpSetConfirm.m_u32AttributeId = (*ptrMsg++);
@@ -2784,12 +3048,8 @@ uint8_t _cl_null_adpSetConfirm_cb(uint8_t *ptrMsg, uint16_t len)
 		adpSetConfirm.m_u16AttributeIndex = (*ptrMsg++);
 		adpSetConfirm.m_u16AttributeIndex = (*ptrMsg++) + (adpSetConfirm.m_u16AttributeIndex << 8);
 		LOG_IFACE_G3_ADP("Status:%d, AttributeId:0x%X,AttributeIndex=0x%X\r\n", adpSetConfirm.m_u8Status, adpSetConfirm.m_u32AttributeId, adpSetConfirm.m_u16AttributeIndex);
-		if (g_adp_sync_mgmt.f_sync_req && (g_adp_sync_mgmt.m_u32AttributeId == adpSetConfirm.m_u32AttributeId)) {
-			/* Synchronous call -> Store the result */
-			LOG_IFACE_G3_ADP("Syncronous Call pending; copying received structure\r\n");
-			memcpy(&g_adp_sync_mgmt.s_SetConfirm, &adpSetConfirm, sizeof(struct TAdpSetConfirm));
-			g_adp_sync_mgmt.f_sync_res = true;
-		}
+		/* Synchronous call -> Store the result */
+		_adp_sync_confirm(ADP_SYNC_SET, adpSetConfirm.m_u32AttributeId, adpSetConfirm.m_u16AttributeIndex, &adpSetConfirm, sizeof(struct TAdpSetConfirm));
 
 		if (g_adpNotifications.fnctAdpSetConfirm) {
 			/* Asynchronous call -> Callback */
@@ -2817,7 +3077,7 @@ uint8_t _cl_null_adpGetConfirm_cb(uint8_t *ptrMsg, uint16_t len)
 		return(false);
 	}
 
-	if (g_adp_sync_mgmt.f_sync_req || g_adpNotifications.fnctAdpGetConfirm) {
+	if (g_adp_sync_mgmt.m_u8Pending || g_adpNotifications.fnctAdpGetConfirm) {
 		struct TAdpGetConfirm adpGetConfirm;
 		adpGetConfirm.m_u8Status = (*ptrMsg++);
 		adpGetConfirm.m_u32AttributeId = (*ptrMsg++);
@@ -3217,12 +3477,8 @@ uint8_t _cl_null_adpGetConfirm_cb(uint8_t *ptrMsg, uint16_t len)
 			break;
 		}
 
-		if (g_adp_sync_mgmt.f_sync_req && (g_adp_sync_mgmt.m_u32AttributeId == adpGetConfirm.m_u32AttributeId)) {
-			/* Synchronous call -> Store the result */
-			LOG_IFACE_G3_ADP("Synchronous Call pending; copying received structure\r\n");
-			memcpy(&g_adp_sync_mgmt.s_GetConfirm, &adpGetConfirm, sizeof(struct TAdpGetConfirm));
-			g_adp_sync_mgmt.f_sync_res = true;
-		}
+		/* Synchronous call -> Store the result */
+		_adp_sync_confirm(ADP_SYNC_GET, adpGetConfirm.m_u32AttributeId, adpGetConfirm.m_u16AttributeIndex, &adpGetConfirm, sizeof(struct TAdpGetConfirm));
 
 		if (g_adpNotifications.fnctAdpGetConfirm) {
 			/* Asynchronous call -> Callback */
@@ -3360,7 +3616,7 @@ uint8_t _cl_null_adpMacSetConfirm_cb(uint8_t *ptrMsg, uint16_t len)
 		return(false);
 	}
 
-	if (g_adp_sync_mgmt.f_sync_req || g_adpNotifications.fnctAdpMacSetConfirm) {
+	if (g_adp_sync_mgmt.m_u8Pending || g_adpNotifications.fnctAdpMacSetConfirm) {
 		struct TAdpMacSetConfirm adpMacSetConfirm;
 		adpMacSetConfirm.m_u8Status = (*ptrMsg++);
 		adpMacSetConfirm.m_u32AttributeId = (*ptrMsg++);
@@ -3371,12 +3627,8 @@ uint8_t _cl_null_adpMacSetConfirm_cb(uint8_t *ptrMsg, uint16_t len)
 		adpMacSetConfirm.m_u16AttributeIndex = (*ptrMsg++) + (adpMacSetConfirm.m_u16AttributeIndex << 8);
 
 		LOG_IFACE_G3_ADP("Status:%d, AttributeId:0x%X,AttributeIndex=0x%X\r\n", adpMacSetConfirm.m_u8Status, adpMacSetConfirm.m_u32AttributeId, adpMacSetConfirm.m_u16AttributeIndex);
-		if (g_adp_sync_mgmt.f_sync_req && (g_adp_sync_mgmt.m_u32AttributeId == adpMacSetConfirm.m_u32AttributeId)) {
-			/* Synchronous call -> Store the result */
-			LOG_IFACE_G3_ADP("Syncronous Call pending; copying received structure\r\n");
-			memcpy(&g_adp_sync_mgmt.s_MacSetConfirm, &adpMacSetConfirm, sizeof(struct TAdpMacSetConfirm));
-			g_adp_sync_mgmt.f_sync_res = true;
-		}
+		/* Synchronous call -> Store the result */
+		_adp_sync_confirm(ADP_SYNC_MAC_SET, adpMacSetConfirm.m_u32AttributeId, adpMacSetConfirm.m_u16AttributeIndex, &adpMacSetConfirm, sizeof(struct TAdpMacSetConfirm));
 
 		if (g_adpNotifications.fnctAdpMacSetConfirm) {
 			/* Asynchronous call -> Callback */
@@ -3403,7 +3655,7 @@ uint8_t _cl_null_adpMacGetConfirm_cb(uint8_t *ptrMsg, uint16_t len)
 		return(false);
 	}
 
-	if (g_adp_sync_mgmt.f_sync_req || g_adpNotifications.fnctAdpMacGetConfirm) {
+	if (g_adp_sync_mgmt.m_u8Pending || g_adpNotifications.fnctAdpMacGetConfirm) {
 		struct TAdpMacGetConfirm adpMacGetConfirm;
 		adpMacGetConfirm.m_u8Status = (*ptrMsg++);
 		adpMacGetConfirm.m_u32AttributeId = (*ptrMsg++);
@@ -4351,12 +4603,8 @@ uint8_t _cl_null_adpMacGetConfirm_cb(uint8_t *ptrMsg, uint16_t len)
 			break;
 		} /* switch */
 
-		if (g_adp_sync_mgmt.f_sync_req && (g_adp_sync_mgmt.m_u32AttributeId == adpMacGetConfirm.m_u32AttributeId)) {
-			/* Synchronous call -> Store the result */
-			LOG_IFACE_G3_ADP("Syncronous Call pending; copying received structure\r\n");
-			memcpy(&g_adp_sync_mgmt.s_MacGetConfirm, &adpMacGetConfirm, sizeof(struct TAdpMacGetConfirm));
-			g_adp_sync_mgmt.f_sync_res = true;
-		}
+		/* Synchronous call -> Store the result */
+		_adp_sync_confirm(ADP_SYNC_MAC_GET, adpMacGetConfirm.m_u32AttributeId, adpMacGetConfirm.m_u16AttributeIndex, &adpMacGetConfirm, sizeof(struct TAdpMacGetConfirm));
 
 		if (g_adpNotifications.fnctAdpMacGetConfirm) {
 			g_adpNotifications.fnctAdpMacGetConfirm(&adpMacGetConfirm);
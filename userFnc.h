@@ -37,6 +37,8 @@
 #ifndef userFnch
 #define userFnch
 
+#include <sys/uio.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -58,6 +60,15 @@ int8_t addUsi_Open(uint8_t port_type, uint8_t port, uint32_t bauds);
 */
 uint16_t addUsi_TxMsg(uint8_t port_type, uint8_t port, uint8_t *msg, uint16_t msglen);
 
+/**@brief Transmit several buffers through the interface in one call
+  @param port: port number configured in PrjCfg.h
+  @param iov: buffers to send, in order
+  @param iovcnt: number of buffers
+  @return the number of bytes written.
+  If the port does not implement it, buffers are sent through addUsi_TxMsg.
+*/
+uint16_t addUsi_TxMsgV(uint8_t port_type, uint8_t port, const struct iovec *iov, uint8_t iovcnt);
+
 /**@brief Read char from port
   @param port: port number configured in PrjCfg.h
   @param c: pointer to a character
@@ -65,6 +76,22 @@ uint16_t addUsi_TxMsg(uint8_t port_type, uint8_t port, uint8_t *msg, uint16_t ms
 */
 int8_t addUsi_RxChar(uint8_t port_type, uint8_t port, uint8_t *c);                     
 
+/**@brief Read a block of chars from port
+  @param port: port number configured in PrjCfg.h
+  @param buf: buffer to store the chars
+  @param maxlen: buffer length
+  @return the number of chars read, 0 if there is nothing to read.
+  If the port does not implement it, chars are read through addUsi_RxChar.
+*/
+uint16_t addUsi_RxBlock(uint8_t port_type, uint8_t port, uint8_t *buf, uint16_t maxlen);
+
+/**@brief Get file descriptor of port
+  @param port: port number configured in PrjCfg.h
+  @return the file descriptor, -1 if the port is not a file descriptor.
+  Ports without descriptor are polled every millisecond by addUsi_RunLoop.
+*/
+int32_t addUsi_GetFd(uint8_t port_type, uint8_t port);
+
 int8_t addUsi_Log(int loglevel, const char *format, ...);
 
 #ifdef __cplusplus